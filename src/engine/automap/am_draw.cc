@@ -37,7 +37,9 @@
 #include "r_sky.h"
 #include "p_local.h"
 #include "r_clipper.h"
+#include "r_cull.h"
 #include "r_drawlist.h"
+#include "r_main.h"
 
 extern fixed_t automappanx;
 extern fixed_t automappany;
@@ -79,6 +81,8 @@ void AM_BeginDraw(angle_t view, fixed_t x, fixed_t y) {
 
     drawlist[DLT_AMAP].index = 0;
 
+    // the frustum is shared with the view being prepared
+    R_PrepFinish();
     R_FrustrumSetup();
     GL_ResetTextures();
 }
@@ -261,7 +261,8 @@ enum {
     COMPATF_COLLISION   = (1 << 0),     // don't use maxradius for mobj position checks
     COMPATF_MOBJPASS    = (1 << 1),     // allow mobjs to stand on top one another
     COMPATF_LIMITPAIN   = (1 << 2),     // pain elemental limited to 17 lost souls?
-    COMPATF_REACHITEMS  = (1 << 3)      // able to grab high items by bumping
+    COMPATF_REACHITEMS  = (1 << 3),     // able to grab high items by bumping
+    COMPATF_NOINTERCEPTLIMIT = (1 << 4) // traces keep every intercept instead of stopping at 128
 };
 
 extern dboolean windowpause;
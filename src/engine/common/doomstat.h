@@ -49,6 +49,8 @@ extern  dboolean    respawnitem;
 extern  dboolean    fastparm;       // checkparm of -fast
 extern  dboolean    nolights;
 extern  dboolean    devparm;        // DEBUG: launched with -devparm
+extern  dboolean    headless;       // no video or audio, for -timedemo
+extern  dboolean    nodrawers;      // checkparm of -nodraw
 
 
 // -------------------------------------------
@@ -254,6 +256,9 @@ extern  dboolean    precache;
 
 #define MAXSENSITIVITY    32
 
+#define BODYQUESIZE 32
+
+extern  mobj_t*     bodyque[BODYQUESIZE];
 extern  int         bodyqueslot;
 
 // Netgame stuff (buffers and pointers, i.e. indices).
@@ -124,6 +124,12 @@ typedef    struct {
     fixed_t         frame_z1[2];
     fixed_t         frame_z2[2];
 
+    // as of the view being prepared; only the renderer writes these
+    word            frame_floorpic;
+    word            frame_ceilingpic;
+    short           frame_lightlevel;
+    word            frame_flags;
+
     // [kex] plane/normal info for ceiling and floor
     plane_t         ceilingplane;
     plane_t         floorplane;
@@ -150,6 +156,11 @@ typedef struct {
     short    bottomtexture;
     short    midtexture;
 
+    // as of the view being prepared; only the renderer writes these
+    short    frame_toptexture;
+    short    frame_bottomtexture;
+    short    frame_midtexture;
+
     // Sector the SideDef is facing.
     sector_t*    sector;
 
@@ -206,6 +217,9 @@ typedef struct line_s {
 
     angle_t         angle;
 
+    // flags as of the view being prepared; only the renderer writes it
+    int             frame_flags;
+
 } line_t;
 
 
@@ -36,6 +36,7 @@
 #include "s_sound.h"
 #include "d_englsh.h"
 #include "r_drawlist.h"
+#include "r_batch.h"
 #include "i_video.h"
 
 static dboolean showstats = true;
@@ -177,12 +178,24 @@ void D_DeveloperDisplay(void) {
     Draw_Text(0, y, WHITE, 0.35f, false, "Draw Indices: %i", statindice);
     y+=16;
 
+    Draw_Text(0, y, WHITE, 0.35f, false, "Static Batches: %i draws, %i uploads, %i fallbacks",
+              batchstats.draws, batchstats.uploads, batchstats.fallbacks);
+    y+=16;
+
     if(gamestate == GS_LEVEL && !automapactive) {
         Draw_Text(0, y, WHITE, 0.35f, false, "PlayerView Render Time: %ims", renderTic);
         y+=16;
 
         Draw_Text(0, y, WHITE, 0.35f, false, "Sprite Render Time: %ims", spriteRenderTic);
         y+=16;
+
+        Draw_Text(0, y, WHITE, 0.35f, false, "Specials: %i anims, %i lines, %i sectors, %i buttons",
+                  specialstats.anims, specialstats.lines, specialstats.sectors, specialstats.buttons);
+        y+=16;
+
+        Draw_Text(0, y, WHITE, 0.35f, false, "Traces: %i, %i intercepts (%i max, %i dropped)",
+                  tracestats.traces, tracestats.intercepts, tracestats.most, tracestats.dropped);
+        y+=16;
     }
 
     Draw_Text(0, y, WHITE, 0.35f, false, "Active Sounds: %i", S_GetActiveSounds());
@@ -61,6 +61,7 @@
 #include "r_wipe.h"
 #include "g_controls.h"
 #include "g_demo.h"
+#include "g_actions.h"
 #include "p_saveg.h"
 #include "gl_draw.h"
 
@@ -92,6 +93,8 @@ dboolean        setWindow       = true;
 int             validcount      = 1;
 dboolean        windowpause     = false;
 dboolean        devparm         = false;    // started game with -devparm
+dboolean        headless        = false;    // started game with -headless
+dboolean        nodrawers       = false;    // started game with -nodraw
 dboolean        nomonsters      = false;    // checkparm of -nomonsters
 dboolean        respawnparm     = false;    // checkparm of -respawn
 dboolean        respawnitem     = false;    // checkparm of -respawnitem
@@ -235,6 +238,50 @@ static void D_FinishDraw(void) {
     }
 }
 
+//
+// D_TimedTic
+// -timedemo runs one tic per pass without waiting on the clock or
+// the network, then draws it. Headless runs only build the view.
+//
+
+static int D_TimedTic(void (*draw)(void), dboolean(*tick)(void)) {
+    int action = 0;
+
+    G_Ticker();
+
+    if(tick) {
+        action = tick();
+    }
+
+    if(gameaction != ga_nothing) {
+        action = gameaction;
+    }
+
+    gametic++;
+    maketic = gametic;
+
+    if(!nodrawers && !action) {
+        if(headless) {
+            if(gamestate == GS_LEVEL && leveltime) {
+                R_PrepPlayerView(&players[displayplayer]);
+            }
+        }
+        else {
+            S_UpdateSounds();
+
+            if(draw) {
+                draw();
+            }
+
+            D_DrawInterface();
+            D_FinishDraw();
+        }
+    }
+
+    Z_FreeAlloca();
+    return action;
+}
+
 int D_MiniLoop(void (*start)(void), void (*stop)(void),
                void (*draw)(void), dboolean(*tick)(void)) {
     int action = gameaction = ga_nothing;
@@ -243,6 +290,10 @@ int D_MiniLoop(void (*start)(void), void (*stop)(void),
         start();
     }
 
+    while(timingdemo && !action) {
+        action = D_TimedTic(draw, tick);
+    }
+
     while(!action) {
         int i = 0;
         int lowtic = 0;
@@ -962,9 +1013,28 @@ static int D_CheckDemo(void) {
         return 1;
     }
 
+    p = M_CheckParm("-timedemo");
+    if(p && p < myargc-1) {
+        G_TimeDemo(myargv[p+1]);
+        return 1;
+    }
+
     return 0;
 }
 
+//
+// CMD_LumpCache
+//
+
+static CMD(LumpCache) {
+    auto stats = wad::cache_stats();
+
+    CON_Printf(WHITE, "Lump cache: %u hits, %u misses, %u evictions\n",
+               (unsigned)stats.hits, (unsigned)stats.misses, (unsigned)stats.evictions);
+    CON_Printf(WHITE, "%u lumps cached, %u kb\n",
+               (unsigned)stats.entries, (unsigned)(stats.bytes >> 10));
+}
+
 //
 // D_DoomMain
 //
@@ -972,6 +1042,12 @@ static int D_CheckDemo(void) {
 [[noreturn]]
 void D_DoomMain(void) {
     devparm = M_CheckParm("-devparm");
+    headless = M_CheckParm("-headless");
+    nodrawers = M_CheckParm("-nodraw");
+
+    if(headless && !M_CheckParm("-timedemo")) {
+        I_Error("D_DoomMain: -headless needs -timedemo");
+    }
 
     // init subsystems
 
@@ -1001,6 +1077,7 @@ void D_DoomMain(void) {
 
     I_Printf("W_Init: Init WADfiles.\n");
     wad::init();
+    G_AddCommand("lumpcache", CMD_LumpCache, 0);
 
     I_Printf("M_Init: Init miscellaneous info.\n");
     M_Init();
@@ -1023,8 +1100,10 @@ void D_DoomMain(void) {
     I_Printf("ST_Init: Init status bar.\n");
     ST_Init();
 
-    I_Printf("GL_Init: Init OpenGL\n");
-    GL_Init();
+    if(!headless) {
+        I_Printf("GL_Init: Init OpenGL\n");
+        GL_Init();
+    }
 
     native_ui::console_show(false);
 
@@ -314,6 +314,21 @@ void D_CheckNetGame(void) {
     {
         net_addr_t *addr = NULL;
 
+        //!
+        // @arg <address>
+        // @category net
+        //
+        // Print the round trip, resend and tic lag histograms of
+        // every player on the server at the given address, then
+        // quit. Only answered for hosts already in the game.
+        //
+
+        i = M_CheckParm("-querystatus");
+
+        if(i > 0 && i < myargc - 1) {
+            NET_QueryStatus(myargv[i+1]);
+        }
+
         //!
         // @category net
         //
@@ -25,15 +25,23 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <deque>
+#include <vector>
+#include <zlib.h>
+
 #include "doomdef.h"
 #include "doomstat.h"
 #include "z_zone.h"
 #include "p_tick.h"
+#include "p_saveg.h"
+#include "p_local.h"
+#include "s_sound.h"
 #include "g_local.h"
 #include "g_demo.h"
 #include "m_misc.h"
 #include "m_random.h"
 #include "con_console.h"
+#include "r_main.h"
 #include <imp/Wad>
 
 #ifdef _MSC_VER
@@ -58,9 +66,50 @@ byte*           demoend;
 dboolean        singledemo      = false;    // quit after playing a demo from cmdline
 dboolean        endDemo;
 dboolean        iwadDemo        = false;
+dboolean        timingdemo      = false;
 
 extern int      starttime;
 
+static uint64_t timedemostart;
+static int      timedemotics;
+static uint64_t phasetime[NUMTDPHASES];
+
+IntProperty demo_snapinterval("demo_snapinterval", "Seconds between the snapshots used to seek in demos", 5);
+IntProperty demo_snapcount("demo_snapcount", "Number of demo seek snapshots kept in memory", 128);
+BoolProperty demo_snapverify("demo_snapverify", "Check that the level after a demo seek matches straight playback", false);
+
+//
+// Seek snapshots. Every DEMOSNAP_KEYFRAME'th one holds the whole
+// archived level, the rest only its XOR against that keyframe, which
+// is mostly zeros and deflates to very little.
+//
+
+#define DEMOSNAP_KEYFRAME   8
+
+typedef struct {
+    int                 tic;        // leveltime it was taken at
+    int                 demopos;    // offset of demo_p into demobuffer
+    dboolean            keyframe;
+    uLong               rawsize;
+    std::vector<byte>   data;       // deflated
+} demosnap_t;
+
+static std::deque<demosnap_t>   demosnaps;
+static std::vector<byte>        snapraw;    // scratch archive
+static std::vector<byte>        snapkey;    // archive of the newest keyframe
+static int                      snapdeltas;
+static int                      demoseektic = -1;
+
+static const char *phasenames[NUMTDPHASES] = {
+    "thinkers",
+    "sight scans",
+    "mobjs",
+    "specials",
+    "macros",
+    "bsp",
+    "draw list"
+};
+
 //
 // DEMO RECORDING
 //
@@ -224,6 +273,10 @@ void G_PlayDemo(const char* name) {
     endDemo = false;
 
     p = M_CheckParm("-playdemo");
+    if(!p) {
+        p = M_CheckParm("-timedemo");
+    }
+
     if(p && p < myargc-1) {
         // 20120107 bkw: add .lmp extension if missing.
         if(dstrrchr(myargv[p+1], '.')) {
@@ -312,10 +365,360 @@ void G_PlayDemo(const char* name) {
     usergame = false;
     demoplayback = true;
 
+    if(timingdemo) {
+        timedemostart = I_GetTimeUS();
+        timedemotics = gametic;
+        dmemset(phasetime, 0, sizeof(phasetime));
+    }
+
     G_RunGame();
     iwadDemo = false;
 }
 
+//
+// G_TimeDemo
+// Plays a demo with every tic run back to back instead of waiting on
+// the clock, then prints the tic rate and where the time went. With
+// -headless there is no window or audio and only the CPU side of the
+// renderer runs; -nodraw skips rendering altogether.
+//
+
+void G_TimeDemo(const char* name) {
+    timingdemo = true;
+    singledemo = true;
+
+    G_PlayDemo(name);
+}
+
+//
+// G_TimeDemoPhase
+// Adds the time since start to a phase and returns the current time,
+// so consecutive phases can be chained. Does nothing outside a
+// timedemo, so the tic and frame loops don't read the clock.
+//
+
+uint64_t G_TimeDemoPhase(int phase, uint64_t start) {
+    uint64_t now;
+
+    if(!timingdemo) {
+        return 0;
+    }
+
+    now = I_GetTimeUS();
+
+    phasetime[phase] += now - start;
+    return now;
+}
+
+//
+// G_TimeDemoReport
+//
+
+static void G_TimeDemoReport(void) {
+    double total;
+    double timed = 0;
+    int tics;
+    int i;
+
+    total = (double)(I_GetTimeUS() - timedemostart) / 1000.0;
+    tics = gametic - timedemotics;
+
+    if(tics <= 0 || total <= 0) {
+        I_Printf("timedemo: no tics were run\n");
+        return;
+    }
+
+    I_Printf("timedemo: %i tics in %.1f ms, %.1f tics/sec\n",
+             tics, total, (double)tics * 1000.0 / total);
+
+    for(i = 0; i < NUMTDPHASES; i++) {
+        double ms = (double)phasetime[i] / 1000.0;
+
+        timed += ms;
+        I_Printf("  %-12s %10.1f ms %8.1f us/tic %5.1f%%\n",
+                 phasenames[i], ms, ms * 1000.0 / tics, ms * 100.0 / total);
+    }
+
+    // the view is built on the prep thread while the next tic runs
+    if(timed > total) {
+        I_Printf("  %-12s %10.1f ms overlapped with the game\n", "prep", timed - total);
+        return;
+    }
+
+    I_Printf("  %-12s %10.1f ms %8.1f us/tic %5.1f%%\n",
+             "other", total - timed, (total - timed) * 1000.0 / tics,
+             (total - timed) * 100.0 / total);
+}
+
+//
+// G_ClearDemoSnapshots
+// The snapshots only cover the current level
+//
+
+void G_ClearDemoSnapshots(void) {
+    demosnaps.clear();
+    snapkey.clear();
+    snapdeltas = 0;
+    demoseektic = -1;
+}
+
+//
+// G_DecodeDemoSnapshot
+// Returns false if the keyframe the snapshot is a delta against is gone
+//
+
+static dboolean G_DecodeDemoSnapshot(int index, std::vector<byte>& raw) {
+    std::vector<byte> key;
+    uLongf length;
+    size_t i;
+    int k;
+
+    for(k = index; k >= 0 && !demosnaps[k].keyframe; k--);
+
+    if(k < 0) {
+        return false;
+    }
+
+    key.resize(demosnaps[k].rawsize);
+    length = key.size();
+
+    if(uncompress(key.data(), &length, demosnaps[k].data.data(), demosnaps[k].data.size()) != Z_OK) {
+        I_Error("G_DecodeDemoSnapshot: Bad snapshot");
+    }
+
+    if(k != index) {
+        raw.resize(demosnaps[index].rawsize);
+        length = raw.size();
+
+        if(uncompress(raw.data(), &length, demosnaps[index].data.data(), demosnaps[index].data.size()) != Z_OK) {
+            I_Error("G_DecodeDemoSnapshot: Bad snapshot");
+        }
+
+        for(i = 0; i < raw.size() && i < key.size(); i++) {
+            raw[i] ^= key[i];
+        }
+    }
+    else {
+        raw.swap(key);
+    }
+
+    return true;
+}
+
+//
+// G_VerifyDemoSnapshot
+// The level has come back around to a tic snapshotted during straight
+// playback, through a seek; the two archives should be identical
+//
+
+static void G_VerifyDemoSnapshot(int index) {
+    std::vector<byte> raw;
+    size_t i;
+
+    if(!G_DecodeDemoSnapshot(index, raw)) {
+        return;
+    }
+
+    P_WriteSnapshot(snapraw);
+
+    for(i = 0; i < raw.size() && i < snapraw.size(); i++) {
+        if(raw[i] != snapraw[i]) {
+            break;
+        }
+    }
+
+    if(i < raw.size() || i < snapraw.size()) {
+        CON_Warnf("Demo seek diverged at tic %i (archive offset %i)\n", leveltime, (int)i);
+    }
+}
+
+//
+// G_DemoSnapshot
+// Archives the level every demo_snapinterval seconds of playback
+//
+
+static void G_DemoSnapshot(void) {
+    demosnap_t snap;
+    uLongf length;
+    size_t i;
+
+    if(demo_snapinterval <= 0 || demo_snapcount <= 0
+            || leveltime % (demo_snapinterval * TICRATE)) {
+        return;
+    }
+
+    // already have it from before a rewind
+    if(!demosnaps.empty() && demosnaps.back().tic >= leveltime) {
+        if(demo_snapverify) {
+            for(i = demosnaps.size(); i-- > 0 && demosnaps[i].tic > leveltime;);
+
+            if(i < demosnaps.size() && demosnaps[i].tic == leveltime) {
+                G_VerifyDemoSnapshot((int)i);
+            }
+        }
+
+        return;
+    }
+
+    P_WriteSnapshot(snapraw);
+
+    snap.tic = leveltime;
+    snap.demopos = demo_p - demobuffer;
+    snap.keyframe = snapkey.empty() || snapdeltas >= DEMOSNAP_KEYFRAME - 1;
+    snap.rawsize = snapraw.size();
+
+    if(snap.keyframe) {
+        snapkey = snapraw;
+        snapdeltas = 0;
+    }
+    else {
+        for(i = 0; i < snapraw.size() && i < snapkey.size(); i++) {
+            snapraw[i] ^= snapkey[i];
+        }
+
+        snapdeltas++;
+    }
+
+    length = compressBound(snapraw.size());
+    snap.data.resize(length);
+
+    if(compress2(snap.data.data(), &length, snapraw.data(), snapraw.size(), Z_BEST_SPEED) != Z_OK) {
+        // a delta against a lost keyframe is useless; start over
+        snapkey.clear();
+        return;
+    }
+
+    snap.data.resize(length);
+    snap.data.shrink_to_fit();
+    demosnaps.push_back(std::move(snap));
+
+    // drop the oldest keyframe along with the deltas against it; always
+    // keep room for one whole group
+    if((int)demosnaps.size() > MAX((int)demo_snapcount, DEMOSNAP_KEYFRAME)) {
+        do {
+            demosnaps.pop_front();
+        }
+        while(!demosnaps.empty() && !demosnaps.front().keyframe);
+    }
+
+    // the keyframe in use went too; the next snapshot has to be one
+    if(demosnaps.empty()) {
+        snapkey.clear();
+        snapdeltas = 0;
+    }
+}
+
+//
+// G_RestoreDemoSnapshot
+// Returns false, leaving the level alone, if the snapshot can't be used
+//
+
+static dboolean G_RestoreDemoSnapshot(int index) {
+    std::vector<byte> raw;
+
+    if(!G_DecodeDemoSnapshot(index, raw)) {
+        return false;
+    }
+
+    P_ReadSnapshot(raw.data(), raw.size());
+    demo_p = demobuffer + demosnaps[index].demopos;
+    return true;
+}
+
+//
+// G_DoDemoSeek
+// Restores the last snapshot at or before tic, if that is closer than
+// where playback is now, then runs the tics in between without drawing
+//
+
+static void G_DoDemoSeek(int tic) {
+    int index;
+    int prev;
+    int i;
+
+    // the prep thread may still be reading the level about to be rewritten
+    R_PrepFinish();
+
+    for(index = (int)demosnaps.size() - 1; index >= 0; index--) {
+        if(demosnaps[index].tic <= tic) {
+            break;
+        }
+    }
+
+    // before the oldest snapshot kept; go as far back as possible
+    if(index < 0 && tic < leveltime && !demosnaps.empty()) {
+        index = 0;
+    }
+
+    if(index >= 0 && (tic < leveltime || demosnaps[index].tic > leveltime)) {
+        G_RestoreDemoSnapshot(index);
+    }
+
+    while(leveltime < tic && gameaction == ga_nothing) {
+        G_DemoSnapshot();
+
+        for(i = 0; i < MAXPLAYERS && gameaction == ga_nothing; i++) {
+            if(playeringame[i]) {
+                G_ReadDemoTiccmd(&players[i].cmd);
+            }
+        }
+
+        if(gameaction != ga_nothing) {
+            break;
+        }
+
+        prev = leveltime;
+        P_Ticker();
+
+        // the tics go by without gametic moving; keep the rng in step
+        basetic--;
+
+        if(leveltime == prev) {
+            break;  // paused
+        }
+    }
+
+    S_ResetSound();
+}
+
+//
+// G_DemoSeek
+// Jumps playback of the current level to the given leveltime at the
+// start of the next tic
+//
+
+void G_DemoSeek(int tic) {
+    if(!demoplayback || iwadDemo || timingdemo) {
+        return;
+    }
+
+    demoseektic = MAX(tic, 0);
+}
+
+//
+// G_DemoTicker
+// Called at the start of each tic of demo playback, before the
+// ticcmds are read
+//
+
+void G_DemoTicker(void) {
+    int tic;
+
+    if(iwadDemo || timingdemo) {
+        return;
+    }
+
+    if(demoseektic >= 0) {
+        tic = demoseektic;
+        demoseektic = -1;
+        G_DoDemoSeek(tic);
+    }
+
+    if(gameaction == ga_nothing) {
+        G_DemoSnapshot();
+    }
+}
+
 //
 // G_CheckDemoStatus
 // Called after a death or level completion to allow demos to be cleaned up
@@ -333,6 +736,11 @@ dboolean G_CheckDemoStatus(void) {
     }
 
     if(demoplayback) {
+        if(timingdemo) {
+            R_PrepFinish();
+            G_TimeDemoReport();
+        }
+
         if(singledemo) {
             I_Quit();
         }
@@ -349,6 +757,8 @@ dboolean G_CheckDemoStatus(void) {
         gameaction      = ga_exitdemo;
         endDemo         = false;
 
+        G_ClearDemoSnapshots();
+
         G_ReloadDefaults();
         return true;
     }
@@ -26,12 +26,34 @@
 
 #define DEMOMARKER      0x80
 
+// how far the arrow keys seek during demo playback
+#define DEMOSEEKSTEP    (10*TICRATE)
+
+//
+// Phases timed by -timedemo
+//
+typedef enum {
+    TDP_THINKERS,
+    TDP_SIGHTS,
+    TDP_MOBJS,
+    TDP_SPECIALS,
+    TDP_MACROS,
+    TDP_BSP,
+    TDP_DRAWLIST,
+    NUMTDPHASES
+} timedemophase_t;
+
 dboolean G_CheckDemoStatus(void);
 
 void G_RecordDemo(const char* name);
 void G_PlayDemo(const char* name);
 void G_ReadDemoTiccmd(ticcmd_t* cmd);
 void G_WriteDemoTiccmd(ticcmd_t* cmd);
+void G_TimeDemo(const char* name);
+uint64_t G_TimeDemoPhase(int phase, uint64_t start);
+void G_DemoSeek(int tic);
+void G_DemoTicker(void);
+void G_ClearDemoSnapshots(void);
 
 extern char             demoname[256];  // name of demo lump
 extern dboolean         demorecording;  // currently recording a demo
@@ -43,5 +65,6 @@ extern byte*            demoend;
 extern dboolean         singledemo;
 extern dboolean         endDemo;        // signal recorder to stop on next tick
 extern dboolean         iwadDemo;       // hide hud, end playback after one level
+extern dboolean         timingdemo;     // run tics back to back and report timings
 
 #endif
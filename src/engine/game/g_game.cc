@@ -123,8 +123,6 @@ char        savedescription[32];
 
 playercontrols_t    Controls;
 
-#define BODYQUESIZE 32
-
 mobj_t*     bodyque[BODYQUESIZE];
 int         bodyqueslot;
 
@@ -155,6 +153,7 @@ BoolProperty compat_collision("compat_collision", "", true, Property::network, G
 BoolProperty compat_mobjpass("compat_mobjpass", "", true, Property::network, G_SetGameFlagsCvarCallback);
 BoolProperty compat_limitpain("compat_limitpain", "", true, Property::network, G_SetGameFlagsCvarCallback);
 BoolProperty compat_grabitems("compat_grabitems", "", true, Property::network, G_SetGameFlagsCvarCallback);
+BoolProperty compat_intercepts("compat_intercepts", "", true, Property::network, G_SetGameFlagsCvarCallback);
 
 extern BoolProperty v_mlook;
 extern BoolProperty v_mlookinvert;
@@ -880,6 +879,10 @@ static void G_SetGameFlags(void) {
 
     if (compat_grabitems)
         compatflags |= COMPATF_REACHITEMS;
+
+    // set when the limit is off, so demos from before the flag keep it
+    if (!compat_intercepts)
+        compatflags |= COMPATF_NOINTERCEPTLIMIT;
 }
 
 //
@@ -899,6 +902,7 @@ void G_DoLoadLevel(void) {
     }
 
     basetic = gametic;
+    G_ClearDemoSnapshots();
 
     // update settings from server cvar
     if(!netgame) {
@@ -977,6 +981,13 @@ dboolean G_Responder(event_t* ev) {
         }
 
         if(demoplayback && gameaction == ga_nothing) {
+            // the arrow keys seek through user demos
+            if(!iwadDemo && ev->type == ev_keydown &&
+                    (ev->data1 == KEY_LEFTARROW || ev->data1 == KEY_RIGHTARROW)) {
+                G_DemoSeek(leveltime + (ev->data1 == KEY_LEFTARROW ? -DEMOSEEKSTEP : DEMOSEEKSTEP));
+                return true;
+            }
+
             if(ev->type == ev_keydown ||
                     ev->type == ev_gamepad) {
                 G_CheckDemoStatus();
@@ -1053,6 +1064,11 @@ void G_Ticker(void) {
         // and build new consistency check
         buf = (gametic / ticdup) % BACKUPTICS;
 
+        // seeks and snapshots happen between tics
+        if(demoplayback && gameaction == ga_nothing) {
+            G_DemoTicker();
+        }
+
         for(i = 0; i < MAXPLAYERS; i++) {
             if(playeringame[i]) {
                 cmd = &players[i].cmd;
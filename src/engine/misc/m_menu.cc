@@ -98,6 +98,11 @@ static char         savegamestrings[10][MENUSTRINGSIZE];
 static dboolean     alphaprevmenu = false;
 static int          menualphacolor = 0xff;
 
+// graphics bound every frame the menu is up, looked up by M_Init
+static int          gfxbuttons;
+static int          gfxsymbols;
+static int          gfxcursor;
+
 static char         inputString[MENUSTRINGSIZE];
 static char         oldInputString[MENUSTRINGSIZE];
 static dboolean     inputEnter = false;
@@ -4295,7 +4300,7 @@ void M_DrawXInputButton(int x, int y, int button) {
         return;
     }
 
-    pic = GL_BindGfxTexture("BUTTONS", true);
+    pic = GL_BindGfx(gfxbuttons, true);
 
     width = (float)gfxwidth[pic];
     height = (float)gfxheight[pic];
@@ -4797,7 +4802,7 @@ static void M_DrawMenuSkull(int x, int y) {
     vtx_t vtx[4];
     const rcolor color = MENUCOLORWHITE;
 
-    pic = GL_BindGfxTexture("SYMBOLS", true);
+    pic = GL_BindGfx(gfxsymbols, true);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
@@ -4852,7 +4857,7 @@ static void M_DrawCursor(int x, int y) {
         float scale;
 
         scale = ((m_cursorscale + 25.0f) / 100.0f);
-        gfxIdx = GL_BindGfxTexture("CURSOR", true);
+        gfxIdx = GL_BindGfx(gfxcursor, true);
         factor = (((float)SCREENHEIGHT * video_ratio) / (float)video_width) / scale;
 
         dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
@@ -5338,6 +5343,10 @@ void M_Init(void) {
     nextmenu = NULL;
     newmenu = false;
 
+    gfxbuttons = GL_GfxLump("BUTTONS");
+    gfxsymbols = GL_GfxLump("SYMBOLS");
+    gfxcursor = GL_GfxLump("CURSOR");
+
     for(i = 0; i < NUM_CONTROL_ITEMS; i++) {
         ControlsItem[i].alphaKey = 0;
         dmemset(ControlsItem[i].name, 0, 64);
@@ -451,6 +451,65 @@ void NET_Conn_Run(net_connection_t *conn)
     }
 }
 
+// Milliseconds until NET_Conn_Run next has something to do for this
+// connection, or -1 if it is only waiting for packets.  The checks in
+// NET_Conn_Run fire once a period has been exceeded, hence the + 1.
+
+int NET_Conn_NextDeadline(net_connection_t *conn)
+{
+    int nowtime;
+    int wait;
+
+    nowtime = I_GetTimeMS();
+    wait = -1;
+
+    if (conn->state == NET_CONN_STATE_CONNECTED)
+    {
+        wait = NET_EarlierDeadline(wait, conn->keepalive_recv_time
+                                       + CONNECTION_TIMEOUT_LEN * 1000
+                                       - nowtime + 1);
+        wait = NET_EarlierDeadline(wait, conn->keepalive_send_time
+                                       + KEEPALIVE_PERIOD * 1000
+                                       - nowtime + 1);
+
+        if (conn->reliable_packets != NULL)
+        {
+            if (conn->reliable_packets->last_send_time < 0)
+            {
+                return 0;
+            }
+
+            wait = NET_EarlierDeadline(wait,
+                        conn->reliable_packets->last_send_time + 1000
+                      - nowtime + 1);
+        }
+    }
+    else if (conn->state == NET_CONN_STATE_WAITING_ACK
+          || conn->state == NET_CONN_STATE_DISCONNECTING)
+    {
+        if (conn->last_send_time < 0)
+        {
+            return 0;
+        }
+
+        wait = NET_EarlierDeadline(wait, conn->last_send_time + 1000
+                                       - nowtime + 1);
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTED_SLEEP)
+    {
+        wait = NET_EarlierDeadline(wait, conn->last_send_time + 5000
+                                       - nowtime + 1);
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTED)
+    {
+        // The owner cleans up disconnected connections when it next runs
+
+        return 0;
+    }
+
+    return wait;
+}
+
 net_packet_t *NET_Conn_NewReliable(net_connection_t *conn, int packet_type)
 {
     net_packet_t *packet;
@@ -511,6 +570,50 @@ unsigned int NET_ExpandTicNum(unsigned int relative, unsigned int b)
     return result;
 }
 
+// Combine a deadline "remaining" milliseconds away with the earliest
+// one found so far (-1 for none).  Overdue deadlines are due now.
+
+int NET_EarlierDeadline(int wait, int remaining)
+{
+    if (remaining < 0)
+    {
+        remaining = 0;
+    }
+
+    if (wait < 0 || remaining < wait)
+    {
+        return remaining;
+    }
+
+    return wait;
+}
+
+// Add a sample to a histogram (see net_histogram_t)
+
+void NET_Histogram_Add(net_histogram_t *hist, int ms)
+{
+    int bucket;
+
+    if (ms < 0)
+    {
+        ms = 0;
+    }
+
+    bucket = 0;
+
+    while (bucket < NET_HISTOGRAM_BUCKETS - 1 && (ms >> bucket) != 0)
+    {
+        ++bucket;
+    }
+
+    ++hist->count[bucket];
+
+    if ((unsigned int) ms > hist->max)
+    {
+        hist->max = ms;
+    }
+}
+
 // "Safe" version of puts, for displaying messages received from the
 // network.
 
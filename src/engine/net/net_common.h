@@ -107,12 +107,15 @@ dboolean NET_Conn_Packet(net_connection_t *conn, net_packet_t *packet,
                         unsigned int *packet_type);
 void NET_Conn_Disconnect(net_connection_t *conn);
 void NET_Conn_Run(net_connection_t *conn);
+int NET_Conn_NextDeadline(net_connection_t *conn);
 net_packet_t *NET_Conn_NewReliable(net_connection_t *conn, int packet_type);
 
 // Other miscellaneous common functions
 
 void NET_SafePuts(const char *msg);
 unsigned int NET_ExpandTicNum(unsigned int relative, unsigned int b);
+int NET_EarlierDeadline(int wait, int remaining);
+void NET_Histogram_Add(net_histogram_t *hist, int ms);
 
 //dboolean NET_ValidGameMode(GameMode_t mode, GameMission_t mission);
 dboolean NET_ValidGameSettings(net_gamesettings_t *settings);
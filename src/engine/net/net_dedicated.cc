@@ -31,6 +31,10 @@
 #include "net_sdl.h"
 #include "net_server.h"
 
+// longest the server sleeps without checking its timers
+
+#define MAX_IDLE_WAIT 1000
+
 // 
 // People can become confused about how dedicated servers work.  Game
 // options are specified to the controlling player who is the first to
@@ -65,6 +69,8 @@ static void CheckForClientOptions(void)
 
 void NET_DedicatedServer(void)
 {
+    int timeout;
+
     CheckForClientOptions();
 
     NET_SV_Init();
@@ -74,7 +80,18 @@ void NET_DedicatedServer(void)
     while (true)
     {
         NET_SV_Run();
-        I_Sleep(10);
+
+        // Sleep until a packet arrives or the server has a timer due.
+        // Wake at least once a second regardless.
+
+        timeout = NET_SV_NextDeadline();
+
+        if (timeout < 0 || timeout > MAX_IDLE_WAIT)
+        {
+            timeout = MAX_IDLE_WAIT;
+        }
+
+        NET_SDL_WaitForPacket(timeout);
     }
 }
 
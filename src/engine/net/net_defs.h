@@ -113,6 +113,8 @@ typedef enum
     NET_PACKET_TYPE_QUERY_RESPONSE,
     NET_PACKET_TYPE_CVAR_UPDATE,
     NET_PACKET_TYPE_CHEAT_REQUEST,
+    NET_PACKET_TYPE_STATUS_QUERY,
+    NET_PACKET_TYPE_STATUS_RESPONSE,
 } net_packet_type_t;
 
 typedef struct 
@@ -173,5 +175,17 @@ typedef struct
     const char *description;
 } net_querydata_t;
 
+// Histogram of times in milliseconds.  Bucket 0 counts samples under
+// 1ms, bucket n counts samples in [2^(n-1), 2^n) ms and the last bucket
+// counts everything longer.
+
+#define NET_HISTOGRAM_BUCKETS 12
+
+typedef struct
+{
+    unsigned int count[NET_HISTOGRAM_BUCKETS];
+    unsigned int max;
+} net_histogram_t;
+
 #endif /* #ifndef NET_DEFS_H */
 
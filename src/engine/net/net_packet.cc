@@ -27,19 +27,49 @@
 #include "net_packet.h"
 #include "z_zone.h"
 
+// Packets up to this size share one allocation with their header and
+// are kept on a free list when released, so the common case of building
+// or receiving a small packet and freeing it again never touches the
+// zone. It is the size of the buffer SDL_net receives datagrams into.
+
+#define NET_PACKETSIZE 1500
+
+// Most packets kept on the free list
+
+#define NET_PACKETPOOL 64
+
 static int total_packet_memory = 0;
 
+static net_packet_t *packet_pool[NET_PACKETPOOL];
+static int packet_pool_count = 0;
+
+static byte *NET_PacketBuffer(net_packet_t *packet)
+{
+    return (byte *) (packet + 1);
+}
+
 net_packet_t *NET_NewPacket(int initial_size)
 {
     net_packet_t *packet;
 
-    packet = (net_packet_t *) Z_Malloc(sizeof(net_packet_t), PU_STATIC, 0);
-    
-    if (initial_size == 0)
-        initial_size = 256;
+    if (initial_size <= NET_PACKETSIZE)
+    {
+        if (packet_pool_count > 0)
+        {
+            packet = packet_pool[--packet_pool_count];
+            packet->len = 0;
+            packet->pos = 0;
+
+            return packet;
+        }
+
+        initial_size = NET_PACKETSIZE;
+    }
+
+    packet = (net_packet_t *) Z_Malloc(sizeof(net_packet_t) + initial_size, PU_STATIC, 0);
 
     packet->alloced = initial_size;
-    packet->data = (byte*) Z_Malloc(initial_size, PU_STATIC, 0);
+    packet->data = NET_PacketBuffer(packet);
     packet->len = 0;
     packet->pos = 0;
 
@@ -58,8 +88,7 @@ net_packet_t *NET_PacketDup(net_packet_t *packet)
     net_packet_t *newpacket;
 
     newpacket = NET_NewPacket(packet->len);
-    memcpy(newpacket->data, packet->data, packet->len);
-    newpacket->len = packet->len;
+    NET_WriteData(newpacket, packet->data, packet->len);
 
     return newpacket;
 }
@@ -67,9 +96,23 @@ net_packet_t *NET_PacketDup(net_packet_t *packet)
 void NET_FreePacket(net_packet_t *packet)
 {
     //printf("%p: destroyed\n", packet);
-    
+
+    // Hand packets that still use their own small buffer back to the pool
+
+    if (packet->data == NET_PacketBuffer(packet)
+     && packet->alloced == NET_PACKETSIZE
+     && packet_pool_count < NET_PACKETPOOL)
+    {
+        packet_pool[packet_pool_count++] = packet;
+        return;
+    }
+
+    if (packet->data != NET_PacketBuffer(packet))
+    {
+        Z_Free(packet->data);
+    }
+
     total_packet_memory -= sizeof(net_packet_t) + packet->alloced;
-    Z_Free(packet->data);
     Z_Free(packet);
 }
 
@@ -177,6 +220,20 @@ dboolean NET_ReadSInt32(net_packet_t *packet, signed int *data)
     }
 }
 
+// Read a block of bytes from the packet, returning true if read
+// successfully
+
+dboolean NET_ReadData(net_packet_t *packet, void *data, size_t len)
+{
+    if (packet->pos + len > packet->len)
+        return false;
+
+    memcpy(data, packet->data + packet->pos, len);
+    packet->pos += len;
+
+    return true;
+}
+
 // Read a string from the packet.  Returns NULL if a terminating 
 // NUL character was not found before the end of the packet.
 
@@ -209,32 +266,42 @@ char *NET_ReadString(net_packet_t *packet)
     return start;
 }
 
-// Dynamically increases the size of a packet
+// Makes room for len more bytes in a packet, growing its buffer once
+// to the first power of two multiple that fits
 
-static void NET_IncreasePacket(net_packet_t *packet)
+static void NET_ReservePacket(net_packet_t *packet, size_t len)
 {
     byte *newdata;
+    size_t alloced;
 
-    total_packet_memory -= packet->alloced;
-   
-    packet->alloced *= 2;
+    if (packet->len + len <= packet->alloced)
+        return;
 
-    newdata = (byte*) Z_Malloc(packet->alloced, PU_STATIC, 0);
+    alloced = packet->alloced;
+
+    while (packet->len + len > alloced)
+        alloced *= 2;
+
+    newdata = (byte*) Z_Malloc(alloced, PU_STATIC, 0);
 
     memcpy(newdata, packet->data, packet->len);
 
-    Z_Free(packet->data);
-    packet->data = newdata;
+    // the first buffer is part of the packet's own allocation
 
-    total_packet_memory += packet->alloced;
+    if (packet->data != NET_PacketBuffer(packet))
+        Z_Free(packet->data);
+
+    total_packet_memory += alloced - packet->alloced;
+
+    packet->data = newdata;
+    packet->alloced = alloced;
 }
 
 // Write a single byte to the packet
 
 void NET_WriteInt8(net_packet_t *packet, unsigned int i)
 {
-    if (packet->len + 1 > packet->alloced)
-        NET_IncreasePacket(packet);
+    NET_ReservePacket(packet, 1);
 
     packet->data[packet->len] = i;
     packet->len += 1;
@@ -246,8 +313,7 @@ void NET_WriteInt16(net_packet_t *packet, unsigned int i)
 {
     byte *p;
     
-    if (packet->len + 2 > packet->alloced)
-        NET_IncreasePacket(packet);
+    NET_ReservePacket(packet, 2);
 
     p = packet->data + packet->len;
 
@@ -264,8 +330,7 @@ void NET_WriteInt32(net_packet_t *packet, unsigned int i)
 {
     byte *p;
 
-    if (packet->len + 4 > packet->alloced)
-        NET_IncreasePacket(packet);
+    NET_ReservePacket(packet, 4);
 
     p = packet->data + packet->len;
 
@@ -277,20 +342,28 @@ void NET_WriteInt32(net_packet_t *packet, unsigned int i)
     packet->len += 4;
 }
 
+// Write a block of bytes to the packet
+
+void NET_WriteData(net_packet_t *packet, const void *data, size_t len)
+{
+    NET_ReservePacket(packet, len);
+
+    memcpy(packet->data + packet->len, data, len);
+    packet->len += len;
+}
+
 void NET_WriteString(net_packet_t *packet, StringView string)
 {
     byte *p;
 
-    // Increase the packet size until large enough to hold the string
-
-    while (packet->len + string.length() + 1 > packet->alloced)
-    {
-        NET_IncreasePacket(packet);
-    }
+    NET_ReservePacket(packet, string.length() + 1);
 
     p = packet->data + packet->len;
 
-    strcpy((char *) p, string.data());
+    // the view isn't necessarily terminated
+
+    memcpy(p, string.data(), string.length());
+    p[string.length()] = '\0';
 
     packet->len += string.length() + 1;
 }
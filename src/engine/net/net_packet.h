@@ -40,12 +40,14 @@ dboolean NET_ReadSInt8(net_packet_t *packet, signed int *data);
 dboolean NET_ReadSInt16(net_packet_t *packet, signed int *data);
 dboolean NET_ReadSInt32(net_packet_t *packet, signed int *data);
 
+dboolean NET_ReadData(net_packet_t *packet, void *data, size_t len);
 char *NET_ReadString(net_packet_t *packet);
 
 void NET_WriteInt8(net_packet_t *packet, unsigned int i);
 void NET_WriteInt16(net_packet_t *packet, unsigned int i);
 void NET_WriteInt32(net_packet_t *packet, unsigned int i);
 
+void NET_WriteData(net_packet_t *packet, const void *data, size_t len);
 void NET_WriteString(net_packet_t *packet, StringView string);
 
 #endif /* #ifndef NET_PACKET_H */
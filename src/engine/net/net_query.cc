@@ -291,3 +291,129 @@ void NET_LANQuery(void)
     exit(0);
 }
 
+static void PrintHistogram(const char *label, net_histogram_t *hist)
+{
+    int i;
+
+    formatted_printf(10, "  %s", label);
+
+    for (i=0; i<NET_HISTOGRAM_BUCKETS; ++i)
+    {
+        formatted_printf(6, "%u", hist->count[i]);
+    }
+
+    printf("max %ums\n", hist->max);
+}
+
+static dboolean NET_Query_ParseStatus(net_packet_t *packet)
+{
+    unsigned int packet_type;
+    unsigned int num_players;
+    unsigned int player;
+    net_histogram_t rtt, resend, ticlag;
+    char *name;
+    unsigned int i;
+    int b;
+
+    if (!NET_ReadInt16(packet, &packet_type)
+     || packet_type != NET_PACKET_TYPE_STATUS_RESPONSE
+     || !NET_ReadInt8(packet, &num_players))
+    {
+        return false;
+    }
+
+    // Bucket lower bounds in milliseconds
+
+    formatted_printf(10, "");
+    formatted_printf(6, "0");
+
+    for (b=1; b<NET_HISTOGRAM_BUCKETS; ++b)
+    {
+        formatted_printf(6, "%i", 1 << (b - 1));
+    }
+
+    putchar('\n');
+
+    for (i=0; i<num_players; ++i)
+    {
+        name = NET_ReadString(packet);
+
+        if (name == NULL
+         || !NET_ReadInt8(packet, &player)
+         || !NET_ReadHistogram(packet, &rtt)
+         || !NET_ReadHistogram(packet, &resend)
+         || !NET_ReadHistogram(packet, &ticlag))
+        {
+            return false;
+        }
+
+        printf("Player %u: ", player + 1);
+        NET_SafePuts(name);
+
+        PrintHistogram("rtt", &rtt);
+        PrintHistogram("resend", &resend);
+        PrintHistogram("ticlag", &ticlag);
+    }
+
+    return true;
+}
+
+// Ask a server for its per-player round trip, resend and tic lag
+// histograms and print them
+
+void NET_QueryStatus(char *addr)
+{
+    net_addr_t *net_addr;
+    net_addr_t *from;
+    net_packet_t *packet;
+    net_packet_t *request;
+    int start_time;
+    int last_send_time;
+
+    NET_Query_Init();
+
+    net_addr = NET_ResolveAddress(query_context, addr);
+
+    if (net_addr == NULL)
+    {
+        I_Error("NET_QueryStatus: Host '%s' not found!", addr);
+    }
+
+    printf("\nQuerying status of '%s'...\n\n", addr);
+
+    last_send_time = -1;
+    start_time = I_GetTimeMS();
+
+    while (I_GetTimeMS() < start_time + 5000)
+    {
+        // Send a request once every second
+
+        if (last_send_time < 0 || I_GetTimeMS() > last_send_time + 1000)
+        {
+            request = NET_NewPacket(10);
+            NET_WriteInt16(request, NET_PACKET_TYPE_STATUS_QUERY);
+            NET_SendPacket(net_addr, request);
+            NET_FreePacket(request);
+            last_send_time = I_GetTimeMS();
+        }
+
+        while (NET_RecvPacket(query_context, &from, &packet))
+        {
+            dboolean done;
+
+            done = from == net_addr && NET_Query_ParseStatus(packet);
+            NET_FreePacket(packet);
+
+            if (done)
+            {
+                exit(0);
+            }
+        }
+
+        // Don't thrash the CPU
+
+        I_Sleep(100);
+    }
+
+    I_Error("No response from '%s'", addr);
+}
@@ -29,6 +29,7 @@
 
 extern void NET_QueryAddress(char *addr);
 extern void NET_LANQuery(void);
+extern void NET_QueryStatus(char *addr);
 extern net_addr_t *NET_FindLANServer(void);
 
 #endif /* #ifndef NET_QUERY_H */
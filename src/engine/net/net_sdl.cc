@@ -47,26 +47,21 @@
 static int port = DEFAULT_PORT;
 static UDPsocket udpsocket;
 static UDPpacket *recvpacket;
+static SDLNet_SocketSet socketset;
 
-typedef struct
+typedef struct addrpair_s
 {
     net_addr_t net_addr;
     IPaddress sdl_addr;
+    struct addrpair_s *next;
 } addrpair_t;
 
-static addrpair_t **addr_table;
-static int addr_table_size = -1;
+// Addresses are hashed on host and port, so that finding the sender of
+// each received datagram doesn't scan every address seen so far
 
-// Initialises the address table
+#define ADDR_HASHSIZE 256
 
-static void NET_SDL_InitAddrTable(void)
-{
-    addr_table_size = 16;
-
-    addr_table = (addrpair_t**) Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
-                          PU_STATIC, 0);
-    memset(addr_table, 0, sizeof(addrpair_t *) * addr_table_size);
-}
+static addrpair_t *addr_table[ADDR_HASHSIZE];
 
 static dboolean AddressesEqual(IPaddress *a, IPaddress *b)
 {
@@ -74,83 +69,64 @@ static dboolean AddressesEqual(IPaddress *a, IPaddress *b)
         && a->port == b->port;
 }
 
+static unsigned int NET_SDL_HashAddress(IPaddress *addr)
+{
+    unsigned int h;
+
+    h = addr->host ^ ((unsigned int) addr->port << 16);
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+
+    return h & (ADDR_HASHSIZE - 1);
+}
+
 // Finds an address by searching the table.  If the address is not found,
 // it is added to the table.
 
 static net_addr_t *NET_SDL_FindAddress(IPaddress *addr)
 {
-    addrpair_t *new_entry;
-    int empty_entry = -1;
-    int i;
+    addrpair_t *entry;
+    unsigned int hash;
 
-    if (addr_table_size < 0)
-    {
-        NET_SDL_InitAddrTable();
-    }
+    hash = NET_SDL_HashAddress(addr);
 
-    for (i=0; i<addr_table_size; ++i)
+    for (entry = addr_table[hash]; entry != NULL; entry = entry->next)
     {
-        if (addr_table[i] != NULL
-         && AddressesEqual(addr, &addr_table[i]->sdl_addr))
+        if (AddressesEqual(addr, &entry->sdl_addr))
         {
-            return &addr_table[i]->net_addr;
+            return &entry->net_addr;
         }
-
-        if (empty_entry < 0 && addr_table[i] == NULL)
-            empty_entry = i;
     }
 
     // Was not found in list.  We need to add it.
 
-    // Is there any space in the table? If not, increase the table size
-
-    if (empty_entry < 0)
-    {
-        addrpair_t **new_addr_table;
-        int new_addr_table_size;
-
-        // after reallocing, we will add this in as the first entry
-        // in the new block of memory
-
-        empty_entry = addr_table_size;
-        
-        // allocate a new array twice the size, init to 0 and copy 
-        // the existing table in.  replace the old table.
-
-        new_addr_table_size = addr_table_size * 2;
-        new_addr_table = (addrpair_t**) Z_Malloc(sizeof(addrpair_t *) * new_addr_table_size,
-                                  PU_STATIC, 0);
-        memset(new_addr_table, 0, sizeof(addrpair_t *) * new_addr_table_size);
-        memcpy(new_addr_table, addr_table, 
-               sizeof(addrpair_t *) * addr_table_size);
-        Z_Free(addr_table);
-        addr_table = new_addr_table;
-        addr_table_size = new_addr_table_size;
-    }
-
-    // Add a new entry
-    
-    new_entry = (addrpair_t*) Z_Malloc(sizeof(addrpair_t), PU_STATIC, 0);
+    entry = (addrpair_t*) Z_Malloc(sizeof(addrpair_t), PU_STATIC, 0);
 
-    new_entry->sdl_addr = *addr;
-    new_entry->net_addr.handle = &new_entry->sdl_addr;
-    new_entry->net_addr.module = &net_sdl_module;
+    entry->sdl_addr = *addr;
+    entry->net_addr.handle = &entry->sdl_addr;
+    entry->net_addr.module = &net_sdl_module;
 
-    addr_table[empty_entry] = new_entry;
+    entry->next = addr_table[hash];
+    addr_table[hash] = entry;
 
-    return &new_entry->net_addr;
+    return &entry->net_addr;
 }
 
 static void NET_SDL_FreeAddress(net_addr_t *addr)
 {
-    int i;
-    
-    for (i=0; i<addr_table_size; ++i)
+    addrpair_t **entry;
+
+    for (entry = &addr_table[NET_SDL_HashAddress((IPaddress *) addr->handle)];
+         *entry != NULL;
+         entry = &(*entry)->next)
     {
-        if (addr == &addr_table[i]->net_addr)
+        if (addr == &(*entry)->net_addr)
         {
-            Z_Free(addr_table[i]);
-            addr_table[i] = NULL;
+            addrpair_t *next = (*entry)->next;
+
+            Z_Free(*entry);
+            *entry = next;
             return;
         }
     }
@@ -285,8 +261,7 @@ static dboolean NET_SDL_RecvPacket(net_addr_t **addr, net_packet_t **packet)
     // Put the data into a new packet structure
 
     *packet = NET_NewPacket(recvpacket->len);
-    memcpy((*packet)->data, recvpacket->data, recvpacket->len);
-    (*packet)->len = recvpacket->len;
+    NET_WriteData(*packet, recvpacket->data, recvpacket->len);
 
     // Address
 
@@ -295,6 +270,49 @@ static dboolean NET_SDL_RecvPacket(net_addr_t **addr, net_packet_t **packet)
     return true;
 }
 
+// Block until a datagram is waiting on the socket or timeout
+// milliseconds have passed.  Returns true if there is something to read.
+
+dboolean NET_SDL_WaitForPacket(int timeout)
+{
+    int result;
+
+    if (timeout < 0)
+    {
+        timeout = 0;
+    }
+
+    if (udpsocket == NULL)
+    {
+        I_Sleep(timeout);
+        return false;
+    }
+
+    if (socketset == NULL)
+    {
+        socketset = SDLNet_AllocSocketSet(1);
+
+        if (socketset == NULL)
+        {
+            I_Error("NET_SDL_WaitForPacket: Unable to allocate socket set: %s",
+                    SDLNet_GetError());
+        }
+
+        SDLNet_UDP_AddSocket(socketset, udpsocket);
+    }
+
+    result = SDLNet_CheckSockets(socketset, (Uint32) timeout);
+
+    if (result < 0)
+    {
+        // select() can be interrupted; the caller runs again either way
+
+        return false;
+    }
+
+    return result > 0;
+}
+
 void NET_SDL_AddrToString(net_addr_t *addr, char *buffer, int buffer_len)
 {
     IPaddress *ip;
@@ -30,5 +30,7 @@
 
 extern net_module_t net_sdl_module;
 
+dboolean NET_SDL_WaitForPacket(int timeout);
+
 #endif /* #ifndef NET_SDL_H */
 
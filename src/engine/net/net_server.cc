@@ -77,10 +77,23 @@ typedef struct
     int sendseq;
     net_full_ticcmd_t sendqueue[BACKUPTICS];
 
+    // Time each tic in the send queue was first sent
+
+    int sendtime[BACKUPTICS];
+
     // Latest acknowledged by the client
 
     unsigned int acknowledged;
 
+    // Tic round trip (first send to acknowledgement), time from a
+    // resend request to the tic arriving, and how long the server held
+    // complete tics for this client waiting on the other players.
+    // Read with a status query.
+
+    net_histogram_t rtt_hist;
+    net_histogram_t resend_hist;
+    net_histogram_t ticlag_hist;
+
     // Observer: receives data but does not participate in the game.
 
     dboolean drone;
@@ -107,6 +120,10 @@ typedef struct
 
     unsigned int resend_time;
 
+    // Time this tic was received
+
+    unsigned int recv_time;
+
     // Tic data itself
 
     net_ticdiff_t diff;
@@ -431,6 +448,11 @@ static void NET_SV_InitNewClient(net_client_t *client,
     client->last_gamedata_time = 0;
 
     memset(client->sendqueue, 0xff, sizeof(client->sendqueue));
+    memset(client->sendtime, 0, sizeof(client->sendtime));
+
+    memset(&client->rtt_hist, 0, sizeof(client->rtt_hist));
+    memset(&client->resend_hist, 0, sizeof(client->resend_hist));
+    memset(&client->ticlag_hist, 0, sizeof(client->ticlag_hist));
 }
 
 // parse a SYN from a client(initiating a connection)
@@ -805,6 +827,38 @@ static void NET_SV_CheckResends(net_client_t *client)
     }
 }
 
+// Advance the point the client has acknowledged receiving up to,
+// sampling the round trip time of the tics newly acknowledged
+
+static void NET_SV_Acknowledge(net_client_t *client, unsigned int ackseq)
+{
+    unsigned int seq;
+    int nowtime;
+
+    if (ackseq <= client->acknowledged)
+    {
+        return;
+    }
+
+    nowtime = I_GetTimeMS();
+    seq = client->acknowledged;
+
+    // Send times of tics older than the send queue are gone
+
+    if (ackseq - seq > BACKUPTICS)
+    {
+        seq = ackseq - BACKUPTICS;
+    }
+
+    for (; seq < ackseq && seq < (unsigned int) client->sendseq; ++seq)
+    {
+        NET_Histogram_Add(&client->rtt_hist,
+                          nowtime - client->sendtime[seq % BACKUPTICS]);
+    }
+
+    client->acknowledged = ackseq;
+}
+
 // Process game data from a client
 
 static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
@@ -873,6 +927,18 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
         }
 
         recvobj = &recvwindow[index][player];
+
+        if (!recvobj->active)
+        {
+            if (recvobj->resend_time != 0)
+            {
+                NET_Histogram_Add(&client->resend_hist,
+                                  nowtime - recvobj->resend_time);
+            }
+
+            recvobj->recv_time = nowtime;
+        }
+
         recvobj->active = true;
         recvobj->diff = diff;
         recvobj->latency = latency;
@@ -882,10 +948,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
 
     // Higher acknowledgement point?
 
-    if (ackseq > client->acknowledged)
-    {
-        client->acknowledged = ackseq;
-    }
+    NET_SV_Acknowledge(client, ackseq);
 
     // Has this been received out of sequence, ie. have we not received
     // all tics before the first tic in this packet?  If so, send a 
@@ -964,10 +1027,7 @@ static void NET_SV_ParseGameDataACK(net_packet_t *packet, net_client_t *client)
 
     // Higher acknowledgement point than we already have?
 
-    if (ackseq > client->acknowledged)
-    {
-        client->acknowledged = ackseq;
-    }
+    NET_SV_Acknowledge(client, ackseq);
 }
 
 static void NET_SV_SendTics(net_client_t *client, 
@@ -1092,6 +1152,110 @@ void NET_SV_SendQueryResponse(net_addr_t *addr)
     NET_FreePacket(reply);
 }
 
+// Status replies are much bigger than the request and list player
+// names, so they only go to this machine or to a host that already
+// has a client in the game, and at most once a second per address
+
+#define STATUS_REPLY_SLOTS 8
+
+static struct
+{
+    net_addr_t *addr;
+    int time;
+} status_replies[STATUS_REPLY_SLOTS];
+
+static dboolean NET_SV_StatusAllowed(net_addr_t *addr)
+{
+    char host[128];
+    int nowtime;
+    int oldest;
+    int i;
+
+    if (addr->module != &net_loop_server_module)
+    {
+        strncpy(host, NET_AddrToString(addr), sizeof(host) - 1);
+        host[sizeof(host) - 1] = '\0';
+
+        if (strncmp(host, "127.", 4) != 0)
+        {
+            for (i=0; i<MAXNETNODES; ++i)
+            {
+                if (ClientConnected(&clients[i])
+                 && !strcmp(NET_AddrToString(clients[i].addr), host))
+                {
+                    break;
+                }
+            }
+
+            if (i == MAXNETNODES)
+            {
+                return false;
+            }
+        }
+    }
+
+    nowtime = I_GetTimeMS();
+    oldest = 0;
+
+    for (i=0; i<STATUS_REPLY_SLOTS; ++i)
+    {
+        if (status_replies[i].addr == addr)
+        {
+            if (nowtime - status_replies[i].time < 1000)
+            {
+                return false;
+            }
+
+            oldest = i;
+            break;
+        }
+
+        if (status_replies[i].time < status_replies[oldest].time)
+        {
+            oldest = i;
+        }
+    }
+
+    status_replies[oldest].addr = addr;
+    status_replies[oldest].time = nowtime;
+
+    return true;
+}
+
+// Send the per-player timing histograms back to whoever asked
+
+static void NET_SV_SendStatusResponse(net_addr_t *addr)
+{
+    net_packet_t *reply;
+    int i;
+
+    if (!NET_SV_StatusAllowed(addr))
+    {
+        return;
+    }
+
+    reply = NET_NewPacket(1024);
+    NET_WriteInt16(reply, NET_PACKET_TYPE_STATUS_RESPONSE);
+    NET_WriteInt8(reply, NET_SV_NumPlayers());
+
+    for (i=0; i<MAXPLAYERS; ++i)
+    {
+        if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+        {
+            continue;
+        }
+
+        NET_WriteString(reply, sv_players[i]->name);
+        NET_WriteInt8(reply, i);
+        NET_WriteHistogram(reply, &sv_players[i]->rtt_hist);
+        NET_WriteHistogram(reply, &sv_players[i]->resend_hist);
+        NET_WriteHistogram(reply, &sv_players[i]->ticlag_hist);
+    }
+
+    NET_SendPacket(addr, reply);
+    NET_FreePacket(reply);
+}
+
 static void NET_SV_ParseCheatRequest(net_packet_t* packet, net_client_t *client)
 {
     int player;
@@ -1150,6 +1314,10 @@ static void NET_SV_Packet(net_packet_t *packet, net_addr_t *addr)
     {
         NET_SV_SendQueryResponse(addr);
     }
+    else if (packet_type == NET_PACKET_TYPE_STATUS_QUERY)
+    {
+        NET_SV_SendStatusResponse(addr);
+    }
     else if (client == NULL)
     {
         // Must come from a valid client; ignore otherwise
@@ -1264,19 +1432,20 @@ static void NET_SV_SendWaitingData(net_client_t *client)
     NET_FreePacket(packet);
 }
 
-static void NET_SV_PumpSendQueue(net_client_t *client)
+// Check if we can generate a new entry for the send queue
+// using the data in recvwindow.
+
+static dboolean NET_SV_TicReady(net_client_t *client)
 {
-    net_full_ticcmd_t cmd;
     int recv_index;
     int i;
-    int starttic, endtic;
 
     // If a client has not sent any acknowledgments for a while,
     // wait until they catch up.
 
     if (client->sendseq - NET_SV_LatestAcknowledged() > 40)
     {
-        return;
+        return false;
     }
     
     // Work out the index into the receive window
@@ -1285,12 +1454,9 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
     if (recv_index < 0 || recv_index >= BACKUPTICS)
     {
-        return;
+        return false;
     }
 
-    // Check if we can generate a new entry for the send queue
-    // using the data in recvwindow.
-
     for (i=0; i<MAXPLAYERS; ++i)
     {
         if (sv_players[i] == client)
@@ -1310,10 +1476,33 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
             // We do not have this player's ticcmd, so we cannot
             // generate a complete command yet.
 
-            return;
+            return false;
         }
     }
 
+    return true;
+}
+
+// Send the next tic to a client if the data from all the other players
+// has arrived.  Returns true if a tic was sent.
+
+static dboolean NET_SV_PumpSendQueue(net_client_t *client)
+{
+    net_full_ticcmd_t cmd;
+    int recv_index;
+    int i;
+    int starttic, endtic;
+    int nowtime;
+    unsigned int first_recv_time;
+    dboolean have_recv_time;
+
+    if (!NET_SV_TicReady(client))
+    {
+        return false;
+    }
+
+    recv_index = client->sendseq - recvwindow_start;
+
     //printf("SV: have complete ticcmd for %i\n", client->sendseq);
 
     // We have all data we need to generate a command for this tic.
@@ -1323,6 +1512,8 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     // Add ticcmds from all players
 
     cmd.latency = 0;
+    first_recv_time = 0;
+    have_recv_time = false;
 
     for (i=0; i<MAXPLAYERS; ++i)
     {
@@ -1350,6 +1541,21 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
         if (recvobj->latency > cmd.latency)
             cmd.latency = recvobj->latency;
+
+        if (!have_recv_time || recvobj->recv_time < first_recv_time)
+        {
+            first_recv_time = recvobj->recv_time;
+            have_recv_time = true;
+        }
+    }
+
+    nowtime = I_GetTimeMS();
+
+    // Time the first part of this tic spent waiting for the rest
+
+    if (have_recv_time)
+    {
+        NET_Histogram_Add(&client->ticlag_hist, nowtime - first_recv_time);
     }
 
     //printf("SV: %i: latency %i\n", client->player_number, cmd.latency);
@@ -1357,6 +1563,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     // Add into the queue
 
     client->sendqueue[client->sendseq % BACKUPTICS] = cmd;
+    client->sendtime[client->sendseq % BACKUPTICS] = nowtime;
 
     // Transmit the new tic to the client
 
@@ -1369,6 +1576,8 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     NET_SV_SendTics(client, starttic, endtic);
 
     ++client->sendseq;
+
+    return true;
 }
 
 // Prevent against deadlock: resend requests are usually only
@@ -1496,7 +1705,11 @@ static void NET_SV_RunClient(net_client_t *client)
 
     if (server_state == SERVER_IN_GAME)
     {
-        NET_SV_PumpSendQueue(client);
+        // Send everything that is complete now, rather than a tic per
+        // call, so that nothing waits for the next NET_SV_Run.
+
+        while (NET_SV_PumpSendQueue(client));
+
         NET_SV_CheckDeadlock(client);
     }
 }
@@ -1578,6 +1791,93 @@ void NET_SV_Run(void)
     }
 }
 
+// Milliseconds until NET_SV_Run next has work to do other than handling
+// received packets, or -1 if it only needs to wait for packets.  The
+// 1000ms/300ms periods match those in NET_SV_RunClient and
+// NET_SV_CheckResends.
+
+int NET_SV_NextDeadline(void)
+{
+    net_client_t *client;
+    int nowtime;
+    int wait;
+    int i, j;
+
+    if (!server_initialised)
+    {
+        return -1;
+    }
+
+    nowtime = I_GetTimeMS();
+    wait = -1;
+
+    for (i=0; i<MAXNETNODES; ++i)
+    {
+        client = &clients[i];
+
+        if (!client->active)
+        {
+            continue;
+        }
+
+        wait = NET_EarlierDeadline(wait,
+                                   NET_Conn_NextDeadline(&client->connection));
+
+        if (!ClientConnected(client))
+        {
+            continue;
+        }
+
+        if (server_state == SERVER_WAITING_START)
+        {
+            if (client->last_send_time < 0)
+            {
+                return 0;
+            }
+
+            wait = NET_EarlierDeadline(wait, client->last_send_time + 1000
+                                           - nowtime + 1);
+        }
+        else if (server_state == SERVER_IN_GAME)
+        {
+            if (NET_SV_TicReady(client))
+            {
+                return 0;
+            }
+
+            if (!client->drone)
+            {
+                wait = NET_EarlierDeadline(wait, client->last_gamedata_time
+                                               + 1000 - nowtime + 1);
+            }
+        }
+    }
+
+    if (server_state == SERVER_IN_GAME)
+    {
+        for (i=0; i<MAXPLAYERS; ++i)
+        {
+            if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+            {
+                continue;
+            }
+
+            for (j=0; j<BACKUPTICS; ++j)
+            {
+                net_client_recv_t *recvobj = &recvwindow[j][i];
+
+                if (!recvobj->active && recvobj->resend_time != 0)
+                {
+                    wait = NET_EarlierDeadline(wait,
+                                (int) (recvobj->resend_time + 300 - nowtime) + 1);
+                }
+            }
+        }
+    }
+
+    return wait;
+}
+
 void NET_SV_Shutdown(void)
 {
     int i;
@@ -34,6 +34,11 @@ void NET_SV_Init(void);
 
 void NET_SV_Run(void);
 
+// milliseconds until NET_SV_Run must be called again if no packets
+// arrive, or -1 if there are no pending timers
+
+int NET_SV_NextDeadline(void);
+
 // Shut down the server
 // Blocks until all clients disconnect, or until a 5 second timeout
 
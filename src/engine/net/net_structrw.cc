@@ -315,25 +315,32 @@ void NET_WriteFullTiccmd(net_packet_t *packet, net_full_ticcmd_t *cmd, dboolean
 }
 
 dboolean NET_ReadMD5Sum(net_packet_t *packet, md5_digest_t digest) {
-    unsigned int b;
+    return NET_ReadData(packet, digest, sizeof(md5_digest_t));
+}
+
+void NET_WriteMD5Sum(net_packet_t *packet, md5_digest_t digest) {
+    NET_WriteData(packet, digest, sizeof(md5_digest_t));
+}
+
+
+dboolean NET_ReadHistogram(net_packet_t *packet, net_histogram_t *hist) {
     int i;
 
-    for (i = 0; i < 16; ++i) {
-        if (!NET_ReadInt8(packet, &b)) {
+    for (i = 0; i < NET_HISTOGRAM_BUCKETS; ++i) {
+        if (!NET_ReadInt32(packet, &hist->count[i])) {
             return false;
         }
-
-        digest[i] = b;
     }
 
-    return true;
+    return NET_ReadInt32(packet, &hist->max);
 }
 
-void NET_WriteMD5Sum(net_packet_t *packet, md5_digest_t digest) {
+void NET_WriteHistogram(net_packet_t *packet, net_histogram_t *hist) {
     int i;
 
-    for (i = 0; i < 16; ++i) {
-        NET_WriteInt8(packet, digest[i]);
+    for (i = 0; i < NET_HISTOGRAM_BUCKETS; ++i) {
+        NET_WriteInt32(packet, hist->count[i]);
     }
-}
 
+    NET_WriteInt32(packet, hist->max);
+}
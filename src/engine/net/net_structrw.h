@@ -43,5 +43,8 @@ void NET_WriteFullTiccmd(net_packet_t *packet, net_full_ticcmd_t *cmd, dboolean
 dboolean NET_ReadMD5Sum(net_packet_t *packet, md5_digest_t digest);
 void NET_WriteMD5Sum(net_packet_t *packet, md5_digest_t digest);
 
+dboolean NET_ReadHistogram(net_packet_t *packet, net_histogram_t *hist);
+void NET_WriteHistogram(net_packet_t *packet, net_histogram_t *hist);
+
 #endif /* #ifndef NET_STRUCTRW_H */
 
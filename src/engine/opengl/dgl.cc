@@ -24,6 +24,8 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <stddef.h>
+
 #include "doomdef.h"
 #include "doomstat.h"
 #include "gl_main.h"
@@ -189,6 +191,40 @@ void dglDrawGeometry(dword count, vtx_t *vtx) {
     indicecnt = 0;
 }
 
+//
+// dglDrawBatch
+// Draws from a persistent vertex buffer when one is given. Colors are
+// always read from client memory since they are relit every frame.
+//
+
+void dglDrawBatch(dword buffer, vtx_t *vtx, word *indices, int count) {
+#ifdef LOG_GLFUNC_CALLS
+    I_Printf("dglDrawBatch(buffer=%i, vtx=0x%p, count=0x%x)\n", buffer, vtx, count);
+#endif
+
+    if(buffer) {
+        dglBindBufferARB(GL_ARRAY_BUFFER_ARB, buffer);
+        dglTexCoordPointer(2, GL_FLOAT, sizeof(vtx_t), (void*)offsetof(vtx_t, tu));
+        dglVertexPointer(3, GL_FLOAT, sizeof(vtx_t), (void*)offsetof(vtx_t, x));
+        dglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    }
+    else {
+        dglTexCoordPointer(2, GL_FLOAT, sizeof(vtx_t), &vtx->tu);
+        dglVertexPointer(3, GL_FLOAT, sizeof(vtx_t), vtx);
+    }
+
+    dglColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vtx_t), &vtx->r);
+
+    // pointers no longer match whatever dglSetVertex set last
+    dgl_prevptr = NULL;
+
+    dglDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, indices);
+
+    if(devparm) {
+        statindice += count;
+    }
+}
+
 //
 // dglViewFrustum
 //
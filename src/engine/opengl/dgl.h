@@ -45,6 +45,7 @@ void dglLogError(const char *message, const char *file, int line);
 void dglSetVertex(vtx_t *vtx);
 void dglTriangle(int v0, int v1, int v2);
 void dglDrawGeometry(dword count, vtx_t *vtx);
+void dglDrawBatch(dword buffer, vtx_t *vtx, word *indices, int count);
 void dglViewFrustum(int width, int height, rfloat fovy, rfloat znear);
 void dglSetVertexColor(vtx_t *v, rcolor c, word count);
 void dglGetColorf(rcolor color, float* argb);
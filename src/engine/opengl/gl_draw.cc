@@ -28,18 +28,48 @@
 #include <stdarg.h>
 #include "doomtype.h"
 #include "doomstat.h"
+#include "i_system.h"
 #include "dgl.h"
 #include "r_things.h"
 #include "gl_texture.h"
 #include "gl_draw.h"
 #include "r_main.h"
 
+// fonts bound by every text draw, looked up once by Draw_Init
+static int gfxfont;
+static int gfxsymbols;
+static int gfxconfont;
+
+//
+// Draw_Init
+//
+
+void Draw_Init(void) {
+    gfxfont     = GL_GfxLump("SFONT");
+    gfxsymbols  = GL_GfxLump("SYMBOLS");
+    gfxconfont  = GL_GfxLump("CONFONT");
+}
+
 //
 // Draw_GfxImage
 //
 
 void Draw_GfxImage(int x, int y, const char* name, rcolor color, dboolean alpha) {
-    int gfxIdx = GL_BindGfxTexture(name, alpha);
+    int gfxIdx = GL_GfxLump(name);
+
+    if(gfxIdx < 0) {
+        I_Error("Draw_GfxImage: %s not found", name);
+    }
+
+    Draw_Gfx(x, y, gfxIdx, color, alpha);
+}
+
+//
+// Draw_Gfx
+//
+
+void Draw_Gfx(int x, int y, int gfx, rcolor color, dboolean alpha) {
+    int gfxIdx = GL_BindGfx(gfx, alpha);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
@@ -140,7 +170,7 @@ int Draw_Text(int x, int y, rcolor color, float scale,
         fill = true;
     }
 
-    GL_BindGfxTexture("SFONT", true);
+    GL_BindGfx(gfxfont, true);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
@@ -421,7 +451,7 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
 
     y += 14;
 
-    pic = GL_BindGfxTexture("SYMBOLS", true);
+    pic = GL_BindGfx(gfxsymbols, true);
 
     smbwidth = (float)gfxwidth[pic];
     smbheight = (float)gfxheight[pic];
@@ -909,7 +939,7 @@ float Draw_ConsoleText(float x, float y, rcolor color,
     vsprintf(msg, string, va);
     va_end(va);
 
-    pic = GL_BindGfxTexture("CONFONT", true);
+    pic = GL_BindGfx(gfxconfont, true);
 
     width = (float)gfxwidth[pic];
     height = (float)gfxheight[pic];
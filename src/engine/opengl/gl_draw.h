@@ -25,8 +25,10 @@
 
 #include "gl_main.h"
 
+void Draw_Init(void);
 void Draw_GfxImage(int x, int y, const char* name,
                    rcolor color, dboolean alpha);
+void Draw_Gfx(int x, int y, int gfx, rcolor color, dboolean alpha);
 void Draw_Sprite2D(int type, int rot, int frame, int x, int y,
                    float scale, int pal, rcolor c);
 
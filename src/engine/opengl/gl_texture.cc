@@ -35,7 +35,13 @@
 #include "p_local.h"
 #include "con_console.h"
 #include "g_actions.h"
+#include "m_misc.h"
 #include <imp/Wad>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #define GL_MAX_TEX_UNITS    4
 
@@ -90,6 +96,8 @@ static int curunit = 0;
 extern BoolProperty r_texnonpowresize;
 extern BoolProperty r_fillmode;
 
+IntProperty r_precachethreads("r_precachethreads", "Image decode threads for level precaching (0 = auto)", 0);
+
 BoolProperty r_texturecombiner("r_texturecombiner", "", true, 0,
                                [](const BoolProperty &, bool, bool&) {
                                    int i;
@@ -117,6 +125,151 @@ static CMD(ResetTextures) {
     GL_ResetTextures();
 }
 
+//
+// TEXTURE INFO CACHE
+// Sizes and offsets of every texture, graphic and sprite are kept in
+// a file keyed by the MD5 of the mounted wads, so later launches
+// don't have to open a single image to set up the texture tables.
+// The wads are only hashed when their paths, sizes or modification
+// times no longer match the stamp stored next to the MD5.
+//
+
+#define TEXINFO_FILE        "texinfo.cache"
+#define TEXINFO_MAGIC       0x32465854  // "TXF2"
+
+typedef struct {
+    int     magic;
+    int     count;
+    byte    stamp[16];
+    byte    checksum[16];
+} texinfoheader_t;
+
+typedef struct {
+    int     width;
+    int     height;
+    int     offset[2];
+} texinfo_t;
+
+static texinfoheader_t  texinfoheader;
+static texinfo_t*       texinfo;
+static dboolean         texinfocached;
+static dboolean         texinfostale;   // contents are good but the stamp changed
+
+//
+// GL_LoadTexInfo
+//
+
+static void GL_LoadTexInfo(int count) {
+    auto stamp = wad::stamp();
+    texinfoheader_t cached;
+    dboolean hashed = false;
+    char* path;
+    byte* data;
+    int length;
+
+    dmemset(&texinfoheader, 0, sizeof(texinfoheader_t));
+    texinfoheader.magic = TEXINFO_MAGIC;
+    texinfoheader.count = count;
+    dmemcpy(texinfoheader.stamp, stamp.data(), sizeof(texinfoheader.stamp));
+
+    texinfo = (texinfo_t*)Z_Calloc(MAX(count, 1) * sizeof(texinfo_t), PU_STATIC, 0);
+    texinfocached = false;
+    texinfostale = false;
+
+    if((path = I_GetUserFile(TEXINFO_FILE))) {
+        length = M_ReadFile(path, &data);
+        free(path);
+    }
+    else {
+        length = -1;
+    }
+
+    if(length != -1) {
+        if(length == (int)(sizeof(texinfoheader_t) + count * sizeof(texinfo_t))) {
+            dmemcpy(&cached, data, sizeof(texinfoheader_t));
+
+            if(cached.magic == TEXINFO_MAGIC && cached.count == count) {
+                if(!memcmp(cached.stamp, texinfoheader.stamp, sizeof(cached.stamp))) {
+                    dmemcpy(texinfoheader.checksum, cached.checksum, sizeof(cached.checksum));
+                    texinfocached = true;
+                }
+                else {
+                    // files were touched; only a change in contents counts
+                    auto checksum = wad::checksum();
+
+                    dmemcpy(texinfoheader.checksum, checksum.data(), sizeof(texinfoheader.checksum));
+                    hashed = true;
+                    texinfocached = texinfostale =
+                        !memcmp(cached.checksum, texinfoheader.checksum, sizeof(cached.checksum));
+                }
+            }
+
+            if(texinfocached) {
+                dmemcpy(texinfo, data + sizeof(texinfoheader_t), count * sizeof(texinfo_t));
+            }
+        }
+
+        Z_Free(data);
+    }
+
+    // the cache will be rewritten, so it needs the real checksum
+    if(!texinfocached && !hashed) {
+        auto checksum = wad::checksum();
+
+        dmemcpy(texinfoheader.checksum, checksum.data(), sizeof(texinfoheader.checksum));
+    }
+}
+
+//
+// GL_GetTexInfo
+// Returns the cached size and offsets of an image, or reads
+// them from the image's header and records them
+//
+
+static void GL_GetTexInfo(int slot, int lump, int* w, int* h, int* offset) {
+    texinfo_t* info = &texinfo[slot];
+
+    if(!texinfocached) {
+        I_PNGReadInfo(lump, &info->width, &info->height, info->offset);
+    }
+
+    *w = info->width;
+    *h = info->height;
+
+    if(offset) {
+        offset[0] = info->offset[0];
+        offset[1] = info->offset[1];
+    }
+}
+
+//
+// GL_SaveTexInfo
+//
+
+static void GL_SaveTexInfo(void) {
+    char* path;
+    byte* data;
+    int length;
+
+    if((!texinfocached || texinfostale) && (path = I_GetUserFile(TEXINFO_FILE))) {
+        length = sizeof(texinfoheader_t) + texinfoheader.count * sizeof(texinfo_t);
+        data = (byte*)Z_Malloc(length, PU_STATIC, 0);
+
+        dmemcpy(data, &texinfoheader, sizeof(texinfoheader_t));
+        dmemcpy(data + sizeof(texinfoheader_t), texinfo, texinfoheader.count * sizeof(texinfo_t));
+
+        if(!M_WriteFile(path, data, length)) {
+            CON_Warnf("GL_SaveTexInfo: Couldn't write %s\n", path);
+        }
+
+        Z_Free(data);
+        free(path);
+    }
+
+    Z_Free(texinfo);
+    texinfo = NULL;
+}
+
 //
 // InitWorldTextures
 //
@@ -147,8 +300,8 @@ static void InitWorldTextures(void) {
         texturetranslation[i] = i;
         palettetranslation[i] = 0;
 
-        // read PNG and setup global width and heights
-        free(I_PNGReadData(lump.lump_index(), true, true, false, &w, &h, NULL, 0));
+        // setup global width and heights
+        GL_GetTexInfo(i, lump.lump_index(), &w, &h, NULL);
 
         textureptr[i][0] = 0;
         texturewidth[i] = w;
@@ -158,6 +311,28 @@ static void InitWorldTextures(void) {
     CON_DPrintf("%i world textures initialized\n", numtextures);
 }
 
+//
+// GL_UploadWorldTexture
+// Creates the texture for texnum's current palette from decoded RGBA
+// pixels and leaves it bound
+//
+
+static void GL_UploadWorldTexture(int texnum, void *image, int w, int h) {
+    dglGenTextures(1, &textureptr[texnum][palettetranslation[texnum]]);
+    dglBindTexture(GL_TEXTURE_2D, textureptr[texnum][palettetranslation[texnum]]);
+    dglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    GL_CheckFillMode();
+    GL_SetTextureFilter();
+
+    // update global width and heights
+    texturewidth[texnum] = w;
+    textureheight[texnum] = h;
+}
+
 //
 // GL_BindWorldTexture
 //
@@ -202,19 +377,7 @@ void GL_BindWorldTexture(int texnum, int *width, int *height) {
     image = I_PNGReadData(wad::find(wad::Section::textures, texnum)->lump_index(), false, true, true,
                           &w, &h, NULL, palettetranslation[texnum]);
 
-    dglGenTextures(1, &textureptr[texnum][palettetranslation[texnum]]);
-    dglBindTexture(GL_TEXTURE_2D, textureptr[texnum][palettetranslation[texnum]]);
-    dglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    GL_CheckFillMode();
-    GL_SetTextureFilter();
-
-    // update global width and heights
-    texturewidth[texnum] = w;
-    textureheight[texnum] = h;
+    GL_UploadWorldTexture(texnum, image, w, h);
 
     if(width) {
         *width = texturewidth[texnum];
@@ -308,39 +471,67 @@ static void InitGfxTextures(void) {
     for(auto section = wad::section(wad::Section::graphics); section; ++section) {
         auto& lump = *section;
         auto i = lump.section_index();
-        void *image;
         int w;
         int h;
 
-        image = I_PNGReadData(lump.lump_index(), true, true, false, &w, &h, NULL, 0);
+        GL_GetTexInfo(numtextures + i, lump.lump_index(), &w, &h, NULL);
 
         gfxptr[i] = 0;
         gfxwidth[i] = w;
         gfxorigwidth[i] = w;
         gfxorigheight[i] = h;
         gfxheight[i] = h;
-
-        free(image);
     }
 
     CON_DPrintf("%i generic textures initialized\n", numgfx);
 }
 
+//
+// GL_GfxLump
+// Looks up the index GL_BindGfx takes for a graphic, or -1. Callers
+// that draw every frame resolve their names once, at init or level
+// setup, so nothing on the render path searches the wad.
+//
+
+int GL_GfxLump(const char* name) {
+    auto index = wad::find_index(wad::Section::graphics, name);
+
+    if(!index.have_value()) {
+        return -1;
+    }
+
+    return (int)*index;
+}
+
 //
 // GL_BindGfxTexture
 //
 
 int GL_BindGfxTexture(const char* name, dboolean alpha) {
+    int gfxid = GL_GfxLump(name);
+
+    if(gfxid < 0) {
+        I_Error("GL_BindGfxTexture: %s not found", name);
+    }
+
+    return GL_BindGfx(gfxid, alpha);
+}
+
+//
+// GL_BindGfx
+//
+
+int GL_BindGfx(int gfxid, dboolean alpha) {
     void *image;
     dboolean npot;
     int width;
     int height;
     int format;
     int type;
-    int gfxid;
 
-    auto lump = wad::find(name);
-    gfxid = lump->section_index();
+    if(gfxid < 0 || gfxid >= numgfx) {
+        I_Error("GL_BindGfx: graphic %i out of range", gfxid);
+    }
 
     if(gfxid == curgfx) {
         return gfxid;
@@ -357,7 +548,8 @@ int GL_BindGfxTexture(const char* name, dboolean alpha) {
         return gfxid;
     }
 
-    image = I_PNGReadData(lump->lump_index(), false, true, alpha, &width, &height, NULL, 0);
+    image = I_PNGReadData(wad::find(wad::Section::graphics, gfxid)->lump_index(), false, true, alpha,
+                          &width, &height, NULL, 0);
 
     // check for non-power of two textures
     npot = GLAD_GL_ARB_texture_non_power_of_two;
@@ -435,23 +627,48 @@ static void InitSpriteTextures(void) {
     section = wad::section(wad::Section::sprites);
     for(i = 0; section; ++section, ++i) {
         auto& lump = *section;
-        void *image;
         int w;
         int h;
 
         // allocate # of sprites per pointer
         spriteptr[i] = (dtexture*)Z_Calloc(spritecount[i] * sizeof(dtexture), PU_STATIC, 0);
 
-        // read data and setup globals
-        image = I_PNGReadData(lump.lump_index(), true, true, false, &w, &h, offset, 0);
+        // setup globals
+        GL_GetTexInfo(numtextures + numgfx + i, lump.lump_index(), &w, &h, offset);
 
         spritewidth[i]      = w;
         spriteheight[i]     = h;
         spriteoffset[i]     = (float)offset[0];
         spritetopoffset[i]  = (float)offset[1];
+    }
+}
+
+//
+// GL_UploadSpriteTexture
+// Creates the texture for a sprite palette from decoded RGBA pixels and
+// leaves it bound
+//
+
+static void GL_UploadSpriteTexture(int spritenum, int pal, void *image, int w, int h) {
+    dboolean npot;
+
+    // check for non-power of two textures
+    npot = GLAD_GL_ARB_texture_non_power_of_two;
 
-        free(image);
+    if(!npot && r_texnonpowresize <= 0) {
+        r_texnonpowresize = 1;
     }
+
+    dglGenTextures(1, &spriteptr[spritenum][pal]);
+    dglBindTexture(GL_TEXTURE_2D, spriteptr[spritenum][pal]);
+
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
+
+    SetTextureImage((byte*) image, 4, &w, &h, GL_RGBA8, GL_RGBA);
+
+    spritewidth[spritenum] = w;
+    spriteheight[spritenum] = h;
 }
 
 //
@@ -460,7 +677,6 @@ static void InitSpriteTextures(void) {
 
 void GL_BindSpriteTexture(int spritenum, int pal) {
     void *image;
-    dboolean npot;
     int w;
     int h;
 
@@ -493,28 +709,134 @@ void GL_BindSpriteTexture(int spritenum, int pal) {
 
     image = I_PNGReadData(wad::find(wad::Section::sprites, spritenum)->lump_index(), false, true, true, &w, &h, NULL, pal);
 
-    // check for non-power of two textures
-    npot = GLAD_GL_ARB_texture_non_power_of_two;
+    GL_UploadSpriteTexture(spritenum, pal, image, w, h);
+    free(image);
 
-    if(!npot && r_texnonpowresize <= 0) {
-        r_texnonpowresize = 1;
+    if(devparm) {
+        glBindCalls++;
     }
+}
 
-    dglGenTextures(1, &spriteptr[spritenum][pal]);
-    dglBindTexture(GL_TEXTURE_2D, spriteptr[spritenum][pal]);
+//
+// GL_PrecacheTextures
+// Decodes the given world textures and sprites on worker threads. This
+// thread only does the uploads, in list order, as each image comes in.
+//
 
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
+typedef struct {
+    int                 num;
+    int                 lump;
+    int                 pal;
+    dboolean            sprite;
+    void*               image;
+    int                 width;
+    int                 height;
+    bool                ready;
+} precachejob_t;
+
+void GL_PrecacheTextures(const int *textures, int texcount, const int *sprites, int sprcount) {
+    std::vector<precachejob_t> jobs;
+    std::vector<std::thread> workers;
+    std::vector<bool> texqueued(numtextures);
+    std::vector<bool> sprqueued(numsprtex);
+    std::atomic<int> next { 0 };
+    std::mutex mutex;
+    std::condition_variable cv;
+    int numthreads;
+    int i;
 
-    SetTextureImage((byte*) image, 4, &w, &h, GL_RGBA8, GL_RGBA);
-    free(image);
+    if(r_fillmode <= 0) {
+        return;
+    }
 
-    spritewidth[spritenum] = w;
-    spriteheight[spritenum] = h;
+    jobs.reserve(texcount + sprcount);
 
-    if(devparm) {
-        glBindCalls++;
+    for(i = 0; i < texcount; i++) {
+        int texnum = texturetranslation[textures[i]];
+        int pal = palettetranslation[texnum];
+
+        if(texqueued[texnum] || textureptr[texnum][pal]) {
+            continue;
+        }
+
+        texqueued[texnum] = true;
+        jobs.push_back({ texnum, (int)wad::find(wad::Section::textures, texnum)->lump_index(), pal, false });
+    }
+
+    for(i = 0; i < sprcount; i++) {
+        if(sprqueued[sprites[i]] || spriteptr[sprites[i]][0]) {
+            continue;
+        }
+
+        sprqueued[sprites[i]] = true;
+        jobs.push_back({ sprites[i], (int)wad::find(wad::Section::sprites, sprites[i])->lump_index(), 0, true });
+    }
+
+    if(jobs.empty()) {
+        return;
+    }
+
+    numthreads = r_precachethreads;
+    if(numthreads <= 0) {
+        numthreads = MAX((int)std::thread::hardware_concurrency() - 1, 1);
     }
+    numthreads = MIN(numthreads, (int)jobs.size());
+
+    for(i = 0; i < numthreads; i++) {
+        workers.emplace_back([&] {
+            int j;
+
+            while((j = next++) < (int)jobs.size()) {
+                precachejob_t *job = &jobs[j];
+                void *image;
+                int w = 0;
+                int h = 0;
+
+                // leave anything that fails to decode to the normal bind path
+                try {
+                    image = I_PNGReadData(job->lump, false, true, true, &w, &h, NULL, job->pal);
+                }
+                catch(...) {
+                    image = NULL;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                job->image = image;
+                job->width = w;
+                job->height = h;
+                job->ready = true;
+                cv.notify_one();
+            }
+        });
+    }
+
+    for(auto &job : jobs) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return job.ready; });
+        }
+
+        if(!job.image) {
+            continue;
+        }
+
+        if(job.sprite) {
+            GL_UploadSpriteTexture(job.num, 0, job.image, job.width, job.height);
+        }
+        else {
+            GL_UploadWorldTexture(job.num, job.image, job.width, job.height);
+        }
+
+        free(job.image);
+        job.image = NULL;
+    }
+
+    for(auto &worker : workers) {
+        worker.join();
+    }
+
+    // the uploads left whatever they made last bound
+    curtexture = cursprite = -1;
 }
 
 //
@@ -871,10 +1193,16 @@ void GL_SetCombineOperandAlpha(int operand, int target) {
 void GL_InitTextures(void) {
     CON_DPrintf("--------Initializing textures--------\n");
 
+    GL_LoadTexInfo(wad::section_size(wad::Section::textures) +
+                   wad::section_size(wad::Section::graphics) +
+                   wad::section_size(wad::Section::sprites));
+
     InitWorldTextures();
     InitGfxTextures();
     InitSpriteTextures();
 
+    GL_SaveTexInfo();
+
     G_AddCommand("dumptextures", CMD_DumpTextures, 0);
     G_AddCommand("resettextures", CMD_ResetTextures, 0);
 }
@@ -917,10 +1245,8 @@ void GL_DumpTextures(void) {
         GL_UnloadTexture(&textureptr[i][0]);
 
         for(p = 0; p < numanimdef; p++) {
-            int lump = wad::find(animdefs[p].name)->section_index();
-
-            if(lump != i) {
-                 continue;
+            if(animdefs[p].texnum != i) {
+                continue;
             }
 
             if(animdefs[p].palette) {
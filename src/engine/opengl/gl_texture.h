@@ -65,6 +65,9 @@ void        GL_SetCombineOperandRGB(int operand, int target);
 void        GL_SetCombineOperandAlpha(int operand, int target);
 void        GL_BindWorldTexture(int texnum, int *width, int *height);
 void        GL_BindSpriteTexture(int spritenum, int pal);
+void        GL_PrecacheTextures(const int *textures, int texcount, const int *sprites, int sprcount);
+int         GL_GfxLump(const char* name);
+int         GL_BindGfx(int gfxid, dboolean alpha);
 int         GL_BindGfxTexture(const char* name, dboolean alpha);
 int         GL_PadTextureDims(int size);
 void        GL_SetNewPalette(int id, byte palID);
@@ -57,7 +57,7 @@ static void SC_Open(const char* name) {
         }
     }
     else {
-        auto bytes = lump->as_bytes();
+        auto bytes = lump->as_view();
         auto memory = new char[bytes.size()];
         std::copy(bytes.begin(), bytes.end(), memory);
         sc_parser.buffer = reinterpret_cast<byte*>(memory);
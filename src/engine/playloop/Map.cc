@@ -1,14 +1,8 @@
-#include <sstream>
 #include <imp/Wad>
 #include "Map.hh"
+#include "md5.h"
 
 namespace {
-  template <class T>
-  void read_into(std::istream& s, T& x)
-  {
-      s.read(reinterpret_cast<char*>(&x), sizeof(T));
-  }
-
   struct Header {
       char id[4];
       uint32 numlumps;
@@ -21,53 +15,83 @@ namespace {
       char name[8];
   };
 
-  std::vector<String> _lumps;
+  // The MAPxx lump is kept alive while the level loads, and the sub-lumps
+  // are views into it rather than copies.
+  Optional<wad::Lump> _map;
+  std::vector<ArrayView<char>> _lumps;
+
+  template <class T>
+  bool read_at(ArrayView<char> data, std::size_t offset, T& x)
+  {
+      if (offset > data.size() || sizeof(T) > data.size() - offset)
+          return false;
+      memcpy(&x, data.data() + offset, sizeof(T));
+      return true;
+  }
+}
+
+const void* W_GetMapLump(int lump)
+{
+    return W_GetMapLumpView(lump).data();
 }
 
-void* W_GetMapLump(int lump)
+ArrayView<char> W_GetMapLumpView(int lump)
 {
-    return &_lumps[lump][0];
+    if (lump < 0 || static_cast<std::size_t>(lump) >= _lumps.size())
+        return {};
+    return _lumps[lump];
 }
 
 void W_CacheMapLump(int map)
 {
-    auto file = wad::find(format("MAP{:02d}", map));
+    _lumps.clear();
+    _map = wad::find(format("MAP{:02d}", map));
 
-    if (!file) {
+    if (!_map) {
         fatal("Could not find MAP{:02d}", map);
     }
 
-    _lumps.clear();
-
-    std::istringstream ss(file->as_bytes());
+    auto data = _map->as_view();
 
     Header header;
-    read_into(ss, header);
-
-    if (memcmp(header.id, "IWAD", 4) != 0 && memcmp(header.id, "PWAD", 4)) {
+    if (!read_at(data, 0, header) ||
+        (memcmp(header.id, "IWAD", 4) != 0 && memcmp(header.id, "PWAD", 4))) {
         fatal("MAP{:02d} is an invalid WAD", map);
     }
 
     std::size_t numlumps = header.numlumps;
-    ss.seekg(header.infotableofs);
-    for (std::size_t i = 0; !ss.eof() && i < numlumps; ++i) {
+    for (std::size_t i = 0; i < numlumps; ++i) {
         Directory dir;
-        read_into(ss, dir);
+        if (!read_at(data, header.infotableofs + i * sizeof(Directory), dir))
+            break;
+
+        if (dir.filepos > data.size() || dir.size > data.size() - dir.filepos) {
+            fatal("MAP{:02d} has a lump past the end of the file", map);
+        }
 
-        auto pos = ss.tellg();
-        ss.seekg(dir.filepos);
-        _lumps.emplace_back(dir.size, 0);
-        ss.read(&_lumps.back()[0], dir.size);
-        ss.seekg(pos);
+        _lumps.emplace_back(data.data() + dir.filepos, dir.size);
     }
 }
 
+void W_MapChecksum(unsigned char digest[16])
+{
+    md5_context_t md5;
+
+    MD5_Init(&md5);
+    for (const auto& lump : _lumps) {
+        MD5_UpdateInt32(&md5, lump.size());
+        MD5_Update(&md5, reinterpret_cast<const byte*>(lump.data()), lump.size());
+    }
+    MD5_Final(digest, &md5);
+}
+
 void W_FreeMapLump()
 {
-    // nop
+    _lumps.clear();
+    _map = nullopt;
 }
 
 int W_MapLumpLength(int lump)
 {
-    return _lumps[lump].size();
+    return static_cast<int>(W_GetMapLumpView(lump).size());
 }
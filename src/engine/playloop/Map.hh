@@ -2,9 +2,12 @@
 #ifndef __DOOM64EX_MAP__59976677
 #define __DOOM64EX_MAP__59976677
 
+#include <cstring>
 #include <imp/Wad>
 
-void* W_GetMapLump(int lump);
+const void* W_GetMapLump(int lump);
+
+ArrayView<char> W_GetMapLumpView(int lump);
 
 void W_CacheMapLump(int map);
 
@@ -12,4 +15,36 @@ void W_FreeMapLump();
 
 int W_MapLumpLength(int lump);
 
+/*!
+ * MD5 of the lumps of the map held by W_CacheMapLump, for keying data
+ * built from the map.
+ */
+void W_MapChecksum(unsigned char digest[16]);
+
+/*!
+ * Records of a map lump, read straight out of the map data held by
+ * W_CacheMapLump. Each record is copied out on access since the lump
+ * may sit at any alignment inside a mapped WAD.
+ */
+template <class T>
+class MapLump {
+    ArrayView<char> view_;
+
+public:
+    explicit MapLump(int lump):
+        view_(W_GetMapLumpView(lump)) {}
+
+    std::size_t size() const
+    { return view_.size() / sizeof(T); }
+
+    T operator[](std::size_t index) const
+    {
+        T x {};
+        if (index >= size())
+            return x;
+        std::memcpy(&x, view_.data() + index * sizeof(T), sizeof(T));
+        return x;
+    }
+};
+
 #endif //__DOOM64EX_MAP__59976677
@@ -936,13 +936,12 @@ void A_OnDeathTrigger(mobj_t* actor) {
 
     A_Fall(actor);
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+    for(mo = P_FindMobjFromTID(actor->tid, NULL); mo; mo = P_FindMobjFromTID(actor->tid, mo)) {
         if(mo->player) {
             continue;
         }
 
-        if(mo != actor && mo->tid == actor->tid &&
-                mo->flags & MF_SHOOTABLE && mo->health > 0) {
+        if(mo != actor && mo->flags & MF_SHOOTABLE && mo->health > 0) {
             return;
         }
     }
@@ -1179,7 +1178,7 @@ void A_CyberAttack(mobj_t* actor) {
 void A_CyberDeathEvent(mobj_t* actor) {
     mobjexp_t *exp;
 
-    exp = (mobjexp_t*) Z_Calloc(sizeof(*exp), PU_LEVSPEC, 0);
+    exp = (mobjexp_t*) Z_PoolAlloc(sizeof(*exp));
     P_AddThinker(&exp->thinker);
 
     exp->thinker.function.acp1 = (actionf_p1)T_MobjExplode;
@@ -1411,7 +1410,7 @@ void A_MoveGroundFire(mobj_t* fire) {
 void A_RectDeathEvent(mobj_t* actor) {
     mobjexp_t *exp;
 
-    exp = (mobjexp_t*) Z_Calloc(sizeof(*exp), PU_LEVSPEC, 0);
+    exp = (mobjexp_t*) Z_PoolAlloc(sizeof(*exp));
     P_AddThinker(&exp->thinker);
 
     exp->thinker.function.acp1 = (actionf_p1)T_MobjExplode;
@@ -1846,12 +1845,9 @@ void A_TargetCamera(mobj_t* actor) {
 
     actor->threshold = D_MAXINT;
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
-        if(actor->tid+1 == mo->tid) {
-            P_SetTarget(&actor->target, mo);
-            P_SetMobjState(actor, actor->info->missilestate);
-            return;
-        }
+    if((mo = P_FindMobjFromTID(actor->tid+1, NULL))) {
+        P_SetTarget(&actor->target, mo);
+        P_SetMobjState(actor, actor->info->missilestate);
     }
 }
 
@@ -49,6 +49,8 @@ result_e T_MovePlane(sector_t* sector, fixed_t speed, fixed_t dest,
     dboolean flag;
     fixed_t lastpos;
 
+    P_InvalidateSights();
+
     switch(floorOrCeiling) {
     case 0:
         // FLOOR
@@ -218,7 +220,7 @@ int EV_DoFloor(line_t* line, floor_e floortype, fixed_t speed) {
 
         // new floor thinker
         rtn = 1;
-        floor = (floormove_t*) Z_Malloc(sizeof(*floor), PU_LEVSPEC, 0);
+        floor = (floormove_t*) Z_PoolAlloc(sizeof(*floor));
         P_AddThinker(&floor->thinker);
         sec->specialdata = floor;
         // Midway assumed that ceiling->instant is true only if the
@@ -368,7 +370,7 @@ int EV_BuildStairs(line_t* line, stair_e type) {
         rtn = 1;
 
         // new floor thinker
-        floor = (floormove_t*) Z_Malloc(sizeof(*floor), PU_LEVSPEC, 0);
+        floor = (floormove_t*) Z_PoolAlloc(sizeof(*floor));
         P_AddThinker(&floor->thinker);
 
         sec->specialdata = floor;
@@ -430,7 +432,7 @@ int EV_BuildStairs(line_t* line, stair_e type) {
                 sec = tsec;
                 secnum = newsecnum;
 
-                floor = (floormove_t*) Z_Malloc(sizeof(*floor), PU_LEVSPEC, 0);
+                floor = (floormove_t*) Z_PoolAlloc(sizeof(*floor));
                 P_AddThinker(&floor->thinker);
 
                 sec->specialdata = floor;
@@ -467,6 +469,8 @@ void T_MoveSplitPlane(void *data) {
     dboolean cdone      = false;
     dboolean fdone      = false;
 
+    P_InvalidateSights();
+
     if(split->ceildir == -1) {
         lastceilpos = sector->ceilingheight;
 
@@ -543,7 +547,7 @@ int EV_SplitSector(line_t *line, dboolean sync) {
         }
 
         rtn = 1;
-        split = (splitmove_t*) Z_Malloc(sizeof(*split), PU_LEVSPEC, 0);
+        split = (splitmove_t*) Z_PoolAlloc(sizeof(*split));
         P_AddThinker(&split->thinker);
         sec->specialdata = split;
 
@@ -73,7 +73,7 @@ void P_SpawnFireFlicker(void *data) {
     sector_t* sector = (sector_t*) data;
     fireflicker_t*    flick;
 
-    flick = (fireflicker_t*) Z_Malloc(sizeof(*flick), PU_LEVSPEC, 0);
+    flick = (fireflicker_t*) Z_PoolAlloc(sizeof(*flick));
 
     P_AddThinker(&flick->thinker);
 
@@ -126,7 +126,7 @@ void P_SpawnLightFlash(void *data) {
     sector_t* sector = (sector_t*) data;
     lightflash_t*    flash;
 
-    flash = (lightflash_t*) Z_Malloc(sizeof(*flash), PU_LEVSPEC, 0);
+    flash = (lightflash_t*) Z_PoolAlloc(sizeof(*flash));
 
     P_AddThinker(&flash->thinker);
 
@@ -181,7 +181,7 @@ void T_StrobeFlash(void *data) {
 void P_SpawnStrobeFlash(sector_t* sector, int speed) {
     strobe_t* flash;
 
-    flash = (strobe_t*) Z_Malloc(sizeof(*flash), PU_LEVSPEC, 0);
+    flash = (strobe_t*) Z_PoolAlloc(sizeof(*flash));
 
     P_AddThinker(&flash->thinker);
 
@@ -202,7 +202,7 @@ void P_SpawnStrobeFlash(sector_t* sector, int speed) {
 void P_SpawnStrobeAltFlash(sector_t* sector, int speed) {      // 0x80015C44
     strobe_t* flash;
 
-    flash = (strobe_t*) Z_Malloc(sizeof(*flash), PU_LEVSPEC, 0);
+    flash = (strobe_t*) Z_PoolAlloc(sizeof(*flash));
 
     P_AddThinker(&flash->thinker);
 
@@ -304,7 +304,7 @@ void T_Glow(void *data) {
 void P_SpawnGlowingLight(sector_t*    sector, byte type) {
     glow_t*    g;
 
-    g = (glow_t*) Z_Malloc(sizeof(*g), PU_LEVSPEC, 0);
+    g = (glow_t*) Z_PoolAlloc(sizeof(*g));
 
     P_AddThinker(&g->thinker);
     g->count = 2;
@@ -446,7 +446,7 @@ void P_SpawnSequenceLight(sector_t* sector, dboolean first) {
         }
     }
 
-    seq = (sequenceGlow_t*) Z_Malloc(sizeof(*seq), PU_LEVSPEC, 0);
+    seq = (sequenceGlow_t*) Z_PoolAlloc(sizeof(*seq));
 
     P_AddThinker(&seq->thinker);
 
@@ -526,7 +526,7 @@ void P_CombineLightSpecials(void *data) {
             continue;
         }
 
-        combine = (combine_t*) Z_Malloc(sizeof(*combine), PU_LEVSPEC, 0);
+        combine = (combine_t*) Z_PoolAlloc(sizeof(*combine));
 
         P_AddThinker(&combine->thinker);
 
@@ -578,7 +578,7 @@ void T_LightMorph(void *data) {
 void P_UpdateLightThinker(light_t* destlight, light_t* srclight) {
     lightmorph_t* lt;
 
-    lt = (lightmorph_t*) Z_Malloc(sizeof(*lt), PU_LEVSPEC, 0);
+    lt = (lightmorph_t*) Z_PoolAlloc(sizeof(*lt));
     P_AddThinker(&lt->thinker);
     lt->thinker.function.acp1 = (actionf_p1)T_LightMorph;
 
@@ -678,18 +678,15 @@ dboolean P_ChangeLightByTag(int tag1, int tag2) {
 //
 //------------------------------------------------------------------------
 
-typedef struct {
-    thinker_t thinker;
-    float factor;
-} fadebright_t;
-
 extern FloatProperty i_brightness;
 
 //
 // T_FadeInBrightness
 //
 
-void T_FadeInBrightness(fadebright_t* fb) {
+void T_FadeInBrightness(void *data) {
+    fadebright_t* fb = (fadebright_t*) data;
+
     fb->factor += 2;
     if(fb->factor < (i_brightness + 100)) {
         R_SetLightFactor(fb->factor);
@@ -706,7 +703,7 @@ void T_FadeInBrightness(fadebright_t* fb) {
 void P_FadeInBrightness(void) {
     fadebright_t* fb;
 
-    fb = (fadebright_t*) Z_Malloc(sizeof(*fb), PU_LEVSPEC, 0);
+    fb = (fadebright_t*) Z_PoolAlloc(sizeof(*fb));
     P_AddThinker(&fb->thinker);
     fb->thinker.function.acp1 = (actionf_p1)T_FadeInBrightness;
     fb->factor = 0;
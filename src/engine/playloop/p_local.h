@@ -87,6 +87,9 @@ void P_AddThinker(void* thinker);
 void P_RemoveThinker(void* thinker);
 void P_LinkMobj(void* mobj);
 void P_UnlinkMobj(void* mobj);
+void P_ClearMobjTIDs(void);
+void P_SetMobjTID(mobj_t* mobj, int tid);
+mobj_t* P_FindMobjFromTID(int tid, mobj_t* start);
 
 extern angle_t frame_angle;
 extern angle_t frame_pitch;
@@ -196,11 +199,27 @@ typedef struct {
     }            d;
 } intercept_t;
 
+// [d64] intercepts a trace keeps with compat_intercepts set;
+// otherwise the list grows as needed
 #define MAXINTERCEPTS    128
 
-extern intercept_t    intercepts[MAXINTERCEPTS];
+extern intercept_t*    intercepts;
 extern intercept_t*    intercept_p;
 
+//
+// Path traversal statistics for the last tic
+//
+typedef struct {
+    int     traces;         // P_PathTraverse calls
+    int     intercepts;     // intercepts gathered by those traces
+    int     most;           // intercepts in the largest trace
+    int     dropped;        // intercepts past MAXINTERCEPTS
+} tracestats_t;
+
+extern tracestats_t tracestats;
+
+void P_ResetTraceStats(void);
+
 typedef dboolean(*traverser_t)(intercept_t *in);
 
 fixed_t P_AproxDistance(fixed_t dx, fixed_t dy);
@@ -249,6 +268,7 @@ dboolean    P_TeleportMove(mobj_t* thing, fixed_t x, fixed_t y);
 void        P_SlideMove(mobj_t* mo);
 dboolean    P_CheckSight(mobj_t* t1, mobj_t* t2);
 void        P_ScanSights(void);
+void        P_InvalidateSights(void);
 dboolean    P_UseLines(player_t* player, dboolean showcontext);
 dboolean    P_ChangeSector(sector_t* sector, dboolean crunch);
 mobj_t*     P_CheckOnMobj(mobj_t *thing);
@@ -272,8 +292,8 @@ void    P_RadiusAttack(mobj_t* spot, mobj_t* source, int damage);
 // P_SETUP
 //
 extern byte*        rejectmatrix;    // for fast sight rejection
-extern short*        blockmaplump;    // offsets in blockmap are from here
-extern short*        blockmap;
+extern int*          blockmaplump;    // offsets in blockmap are from here
+extern int*          blockmap;
 extern int            bmapwidth;
 extern int            bmapheight;    // in mapblocks
 extern fixed_t        bmaporgx;
@@ -453,7 +453,7 @@ P_BlockLinesIterator
  int            y,
  dboolean(*func)(line_t*)) {
     int            offset;
-    short*        list;
+    int*           list;
     line_t*        ld;
 
     if(x<0
@@ -521,13 +521,54 @@ P_BlockThingsIterator
 //
 // INTERCEPT ROUTINES
 //
-intercept_t    intercepts[MAXINTERCEPTS];
+intercept_t*    intercepts;
 intercept_t*    intercept_p;
 
+static int      maxintercepts;
+
+tracestats_t    tracestats;
+static tracestats_t curtracestats;
+
 divline_t     trace;
 dboolean     earlyout;
 int        ptflags;
 
+//
+// P_ResetTraceStats
+// Keeps the counts of the tic that just ran for the stats display
+//
+
+void P_ResetTraceStats(void) {
+    tracestats = curtracestats;
+    dmemset(&curtracestats, 0, sizeof(curtracestats));
+}
+
+//
+// P_NewIntercept
+// Returns the next free intercept, growing the list when it is full.
+// Returns NULL once a trace has MAXINTERCEPTS, unless compat_intercepts
+// is off (COMPATF_NOINTERCEPTLIMIT).
+//
+
+static intercept_t* P_NewIntercept(void) {
+    int count = intercept_p - intercepts;
+
+    // [d64] exit out if max intercepts has been hit
+    if(!(compatflags & COMPATF_NOINTERCEPTLIMIT) && count >= MAXINTERCEPTS) {
+        curtracestats.dropped++;
+        return NULL;
+    }
+
+    if(count >= maxintercepts) {
+        maxintercepts = maxintercepts ? maxintercepts * 2 : MAXINTERCEPTS;
+        intercepts = (intercept_t*)Z_Realloc(intercepts,
+                                             maxintercepts * sizeof(intercept_t), PU_STATIC, 0);
+        intercept_p = intercepts + count;
+    }
+
+    return intercept_p++;
+}
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -544,6 +585,7 @@ PIT_AddLineIntercepts(line_t* ld) {
     int            s2;
     fixed_t        frac;
     divline_t        dl;
+    intercept_t*    in;
 
     // avoid precision problems with two routines
     if(trace.dx > FRACUNIT*16
@@ -577,16 +619,13 @@ PIT_AddLineIntercepts(line_t* ld) {
         return false;    // stop checking
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!(in = P_NewIntercept())) {
         return true;
     }
 
-
-    intercept_p->frac = frac;
-    intercept_p->isaline = true;
-    intercept_p->d.line = ld;
-    intercept_p++;
+    in->frac = frac;
+    in->isaline = true;
+    in->d.line = ld;
 
     return true;    // continue
 }
@@ -611,6 +650,8 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
 
     fixed_t        frac;
 
+    intercept_t*    in;
+
     tracepositive = (trace.dx ^ trace.dy)>0;
 
     // check a corner to corner crossection for hit
@@ -647,15 +688,13 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
         return true;    // behind source
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!(in = P_NewIntercept())) {
         return true;
     }
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = false;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    in->frac = frac;
+    in->isaline = false;
+    in->d.thing = thing;
 
     return true;        // keep going
 }
@@ -666,50 +705,39 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
 // Returns true if the traverser function returns true
 // for all lines.
 //
+// The intercepts are sorted by frac once, then walked in order. The
+// sort is stable, so intercepts at the same frac are still visited in
+// the order they were added, same as the old nearest-first rescan.
+// Blocks are gathered along the trace, so the list is nearly sorted
+// already and an insertion sort stays close to linear.
+//
 dboolean
 P_TraverseIntercepts
 (traverser_t    func,
  fixed_t    maxfrac) {
     int            count;
-    fixed_t        dist;
-    intercept_t*    scan;
-    intercept_t*    in;
+    int            i;
+    int            j;
+    intercept_t    in;
 
     count = intercept_p - intercepts;
 
-    in = 0;            // shut up compiler warning
-
-    while(count--) {
-        dist = D_MAXINT;
-        for(scan = intercepts ; scan<intercept_p ; scan++) {
-            if(scan->frac < dist) {
-                dist = scan->frac;
-                in = scan;
-            }
+    for(i = 1; i < count; i++) {
+        in = intercepts[i];
+        for(j = i; j > 0 && intercepts[j - 1].frac > in.frac; j--) {
+            intercepts[j] = intercepts[j - 1];
         }
+        intercepts[j] = in;
+    }
 
-        if(dist > maxfrac) {
+    for(i = 0; i < count; i++) {
+        if(intercepts[i].frac > maxfrac) {
             return true;    // checked everything in range
         }
 
-#if 0  // UNUSED
-        {
-            // don't check these yet, there may be others inserted
-            in = scan = intercepts;
-            for(scan = intercepts ; scan<intercept_p ; scan++)
-                if(scan->frac > maxfrac) {
-                    *in++ = *scan;
-                }
-            intercept_p = in;
-            return false;
-        }
-#endif
-
-        if(!func(in)) {
+        if(!func(&intercepts[i])) {
             return false;    // don't bother going farther
         }
-
-        in->frac = D_MAXINT;
     }
 
     return true;        // everything was traversed
@@ -760,7 +788,7 @@ P_PathTraverse
     if(r_drawtrace) {
         tracedrawer_t* tdrawer;
 
-        tdrawer = (tracedrawer_t*) Z_Malloc(sizeof(*tdrawer), PU_LEVSPEC, 0);
+        tdrawer = (tracedrawer_t*) Z_PoolAlloc(sizeof(*tdrawer));
         P_AddThinker(&tdrawer->thinker);
         tdrawer->thinker.function.acp1 = (actionf_p1)T_TraceDrawer;
         tdrawer->tic = gametic + 32;
@@ -776,6 +804,7 @@ P_PathTraverse
 
     D_IncValidCount();
     intercept_p = intercepts;
+    curtracestats.traces++;
 
     if(((x1-bmaporgx)&(MAPBLOCKSIZE-1)) == 0) {
         x1 += FRACUNIT;    // don't side exactly on a line
@@ -870,6 +899,11 @@ P_PathTraverse
         }
 
     }
+
+    count = intercept_p - intercepts;
+    curtracestats.intercepts += count;
+    curtracestats.most = MAX(curtracestats.most, count);
+
     // go through the sorted list
     return P_TraverseIntercepts(trav, FRACUNIT);
 }
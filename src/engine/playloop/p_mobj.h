@@ -164,6 +164,10 @@ typedef struct mobj_s {
     // [d64] mobj tag
     int                 tid;
 
+    // Links in the tid hash chain, if tid is set
+    struct mobj_s*      tidnext;
+    struct mobj_s*      tidprev;
+
     // More list: links in sector (if needed)
     struct mobj_s*      snext;
     struct mobj_s*      sprev;
@@ -1113,7 +1113,7 @@ void A_FireLaser(player_t *player, pspdef_t *psp) {
 
         P_LaserCrossBSP(numnodes - 1, laser[i]);
 
-        laserthinker[i] = (laserthinker_t*) Z_Malloc(sizeof(*laserthinker[i]), PU_LEVSPEC, 0);
+        laserthinker[i] = (laserthinker_t*) Z_PoolAlloc(sizeof(*laserthinker[i]));
         P_AddThinker(&laserthinker[i]->thinker);
 
         laserthinker[i]->thinker.function.acp1 = (actionf_p1)T_LaserThinker;
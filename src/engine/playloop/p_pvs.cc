@@ -0,0 +1,1079 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//    Potentially visible sets. For every subsector, the subsectors a
+//    straight line from anywhere inside it could reach without crossing
+//    a one-sided line. Heights are ignored, so doors and lifts can move
+//    freely; the sets only depend on the map's 2D layout.
+//
+//    The openings between subsectors (minisegs and two-sided segs) are
+//    portals. A subsector sees through a chain of portals if a line can
+//    pass through all of them, which is found the way Quake's vis does:
+//    each portal further down the chain is clipped to the lines that
+//    separate the source portal from the last portal passed. Clipping
+//    errs towards visible, so the sets may hold too much but never too
+//    little.
+//
+//    Rows are stored run length encoded and cached on disk by the MD5
+//    of the map, since building them can take a while on open maps.
+//
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "md5.h"
+#include "p_local.h"
+#include "p_pvs.h"
+#include "r_local.h"
+#include "z_zone.h"
+#include "con_console.h"
+#include "Map.hh"
+
+#define PVS_FILE        "pvs_%s.cache"
+#define PVS_MAGIC       0x32535650  // "PVS2"
+
+// portal steps one subsector's flow may take before settling for the
+// coarse sets, which keeps very open maps from stalling the load
+#define PVS_MAXSTEPS    0x40000
+
+// map units; clipping keeps whatever is this close to a plane
+#define PVS_EPSILON     0.05
+
+// vertex grid used to find where other subsectors' corners split an edge
+#define PVS_CELLSHIFT   (FRACBITS + 7)
+
+#define PVS_TESTBIT(bits, n)    ((bits)[(n) >> 6] & (1ULL << ((n) & 63)))
+#define PVS_SETBIT(bits, n)     ((bits)[(n) >> 6] |= (1ULL << ((n) & 63)))
+
+typedef struct {
+    int     magic;
+    int     numsubsectors;
+    int     datasize;
+    byte    checksum[16];
+} pvsheader_t;
+
+static byte*    pvsdata = NULL;
+static int*     pvsoffsets = NULL;
+static int      pvsdatasize = 0;
+static int      pvsrowbytes = 0;
+
+// P_CheckPVS keeps the last row it expanded
+static byte*    sightrow = NULL;
+static int      sightrowsub = -1;
+
+//
+// The rest is only used while building
+//
+
+typedef struct {
+    double  x1;
+    double  y1;
+    double  x2;
+    double  y2;
+} pvsseg_t;
+
+typedef struct {
+    pvsseg_t    seg;
+    double      nx;     // nx * x + ny * y - d > 0 is past the portal,
+    double      ny;     // on the 'to' side
+    double      d;
+    int         from;
+    int         to;
+} portal_t;
+
+typedef struct {
+    int         leaf;
+    int         portal;     // next of leaf's portals to look through
+    pvsseg_t    source;
+    pvsseg_t    pass;
+    dboolean    haspass;
+} pvsframe_t;
+
+typedef struct {
+    std::vector<uint64_t>   visible;
+    std::vector<uint64_t>   might;      // one row per flow depth
+    std::vector<pvsframe_t> frames;     // one per flow depth
+    std::vector<byte>       onstack;
+    std::vector<int>        todo;
+    int                     steps;
+    dboolean                overflow;
+} pvsworker_t;
+
+static std::vector<portal_t>                portals;
+static std::vector<int>                     firstportal;    // per subsector, into portals
+static std::vector<uint64_t>                mightsee;       // per portal, pvswords each
+static std::vector<std::vector<byte> >      pvsrows;
+static std::vector<byte>                    pvsdegenerate;  // subsectors without a polygon
+static std::vector<uint64_t>                degeneratebits;
+static std::atomic<int>                     pvsfallbacks;
+static int                                  pvswords;
+
+//
+// P_LeafVertex
+//
+
+static void P_LeafVertex(leaf_t* leaf, double* x, double* y) {
+    *x = (double)leaf->vertex->x / FRACUNIT;
+    *y = (double)leaf->vertex->y / FRACUNIT;
+}
+
+//
+// P_LeafArea
+// Signed; positive when the leafs run counter-clockwise
+//
+
+static double P_LeafArea(subsector_t* sub) {
+    double area = 0;
+    double x1, y1, x2, y2;
+    int i;
+
+    for(i = 0; i < sub->numleafs; i++) {
+        P_LeafVertex(&leafs[sub->leaf + i], &x1, &y1);
+        P_LeafVertex(&leafs[sub->leaf + (i + 1) % sub->numleafs], &x2, &y2);
+        area += x1 * y2 - x2 * y1;
+    }
+
+    return area / 2;
+}
+
+//
+// P_ClipSeg
+// Keeps the part of the seg in front of the plane. Returns false if
+// there is nothing left.
+//
+
+static dboolean P_ClipSeg(pvsseg_t* s, double nx, double ny, double d) {
+    double d1 = nx * s->x1 + ny * s->y1 - d + PVS_EPSILON;
+    double d2 = nx * s->x2 + ny * s->y2 - d + PVS_EPSILON;
+    double f;
+
+    if(d1 < 0 && d2 < 0) {
+        return false;
+    }
+
+    if(d1 >= 0 && d2 >= 0) {
+        return true;
+    }
+
+    f = d1 / (d1 - d2);
+
+    if(d1 < 0) {
+        s->x1 += (s->x2 - s->x1) * f;
+        s->y1 += (s->y2 - s->y1) * f;
+    }
+    else {
+        s->x2 = s->x1 + (s->x2 - s->x1) * f;
+        s->y2 = s->y1 + (s->y2 - s->y1) * f;
+    }
+
+    return true;
+}
+
+//
+// P_ClipToSeparators
+// A line through first and then second can only reach the far side of
+// second on second's side of every line that has first and second on
+// opposite sides. Clips s to that side. Lines the two segs only touch
+// are skipped, which can only leave more of s.
+//
+
+static dboolean P_ClipToSeparators(const pvsseg_t* first, const pvsseg_t* second, pvsseg_t* s) {
+    double fx[2] = { first->x1, first->x2 };
+    double fy[2] = { first->y1, first->y2 };
+    double sx[2] = { second->x1, second->x2 };
+    double sy[2] = { second->y1, second->y2 };
+    int i;
+    int j;
+
+    for(i = 0; i < 2; i++) {
+        for(j = 0; j < 2; j++) {
+            double nx = fy[i] - sy[j];
+            double ny = sx[j] - fx[i];
+            double len = sqrt(nx * nx + ny * ny);
+            double d;
+            double df;
+            double ds;
+
+            if(len < PVS_EPSILON) {
+                continue;
+            }
+
+            nx /= len;
+            ny /= len;
+            d = nx * fx[i] + ny * fy[i];
+
+            df = nx * fx[i ^ 1] + ny * fy[i ^ 1] - d;
+            ds = nx * sx[j ^ 1] + ny * sy[j ^ 1] - d;
+
+            if(fabs(df) < PVS_EPSILON || fabs(ds) < PVS_EPSILON || (df > 0) == (ds > 0)) {
+                continue;
+            }
+
+            if(ds < 0) {
+                nx = -nx;
+                ny = -ny;
+                d = -d;
+            }
+
+            if(!P_ClipSeg(s, nx, ny, d)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// P_PortalNeighbor
+// The subsector just past (x, y) along the outward normal
+//
+
+static int P_PortalNeighbor(int from, double x, double y, double nx, double ny) {
+    static const double offsets[] = { 0.125, 0.5, 2.0 };
+    subsector_t* sub;
+    int i;
+
+    for(i = 0; i < 3; i++) {
+        sub = R_PointInSubsector((fixed_t)((x + nx * offsets[i]) * FRACUNIT),
+                                 (fixed_t)((y + ny * offsets[i]) * FRACUNIT));
+
+        if(sub - subsectors != from) {
+            return sub - subsectors;
+        }
+    }
+
+    return -1;
+}
+
+//
+// P_BuildPortals
+// One portal per stretch of open edge with a single subsector behind
+// it. An edge can border several subsectors on the other side; their
+// corners on it split it. Returns false if a portal leads into a
+// subsector without a polygon, which the flow couldn't pass through,
+// or if no subsector can be found behind an open stretch.
+//
+
+static dboolean P_BuildPortals(void) {
+    std::vector<int> cellstart;
+    std::vector<int> cellverts;
+    std::vector<double> splits;
+    std::vector<byte>& degenerate = pvsdegenerate;
+    fixed_t minx = D_MAXINT;
+    fixed_t miny = D_MAXINT;
+    fixed_t maxx = D_MININT;
+    fixed_t maxy = D_MININT;
+    int cellsw;
+    int cellsh;
+    int i;
+    int j;
+
+    if(!numvertexes) {
+        return false;
+    }
+
+    //
+    // bucket the vertexes
+    //
+    for(i = 0; i < numvertexes; i++) {
+        minx = MIN(minx, vertexes[i].x);
+        miny = MIN(miny, vertexes[i].y);
+        maxx = MAX(maxx, vertexes[i].x);
+        maxy = MAX(maxy, vertexes[i].y);
+    }
+
+    cellsw = (int)(((int64_t)maxx - minx) >> PVS_CELLSHIFT) + 1;
+    cellsh = (int)(((int64_t)maxy - miny) >> PVS_CELLSHIFT) + 1;
+    cellstart.assign(cellsw * cellsh + 1, 0);
+    cellverts.resize(numvertexes);
+
+    for(i = 0; i < numvertexes; i++) {
+        int cx = (int)(((int64_t)vertexes[i].x - minx) >> PVS_CELLSHIFT);
+        int cy = (int)(((int64_t)vertexes[i].y - miny) >> PVS_CELLSHIFT);
+
+        cellstart[cy * cellsw + cx + 1]++;
+    }
+
+    for(i = 0; i < cellsw * cellsh; i++) {
+        cellstart[i + 1] += cellstart[i];
+    }
+
+    {
+        std::vector<int> fill(cellstart.begin(), cellstart.end() - 1);
+
+        for(i = 0; i < numvertexes; i++) {
+            int cx = (int)(((int64_t)vertexes[i].x - minx) >> PVS_CELLSHIFT);
+            int cy = (int)(((int64_t)vertexes[i].y - miny) >> PVS_CELLSHIFT);
+
+            cellverts[fill[cy * cellsw + cx]++] = i;
+        }
+    }
+
+    degenerate.assign(numsubsectors, 0);
+    degeneratebits.assign((numsubsectors + 63) >> 6, 0);
+
+    for(i = 0; i < numsubsectors; i++) {
+        degenerate[i] = (subsectors[i].numleafs < 3 || fabs(P_LeafArea(&subsectors[i])) < 1);
+    }
+
+    portals.clear();
+    firstportal.assign(numsubsectors + 1, 0);
+
+    for(i = 0; i < numsubsectors; i++) {
+        subsector_t* sub = &subsectors[i];
+        double orient;
+
+        firstportal[i] = (int)portals.size();
+
+        if(degenerate[i]) {
+            PVS_SETBIT(degeneratebits.data(), i);
+            continue;
+        }
+
+        orient = P_LeafArea(sub) > 0 ? 1 : -1;
+
+        for(j = 0; j < sub->numleafs; j++) {
+            leaf_t* leaf = &leafs[sub->leaf + j];
+            leaf_t* next = &leafs[sub->leaf + (j + 1) % sub->numleafs];
+            double x1, y1, x2, y2;
+            double dx, dy, len;
+            double nx, ny;
+            int cx1, cy1, cx2, cy2;
+            int cx, cy;
+            int k;
+
+            // one-sided walls block everything
+            if(leaf->seg && !leaf->seg->backsector) {
+                continue;
+            }
+
+            P_LeafVertex(leaf, &x1, &y1);
+            P_LeafVertex(next, &x2, &y2);
+
+            dx = x2 - x1;
+            dy = y2 - y1;
+            len = sqrt(dx * dx + dy * dy);
+
+            if(len < PVS_EPSILON) {
+                continue;
+            }
+
+            // facing out of the subsector
+            nx = orient * dy / len;
+            ny = -orient * dx / len;
+
+            //
+            // find the corners on this edge
+            //
+            splits.clear();
+            splits.push_back(0);
+            splits.push_back(1);
+
+            cx1 = (int)(((int64_t)MIN(leaf->vertex->x, next->vertex->x) - minx) >> PVS_CELLSHIFT);
+            cy1 = (int)(((int64_t)MIN(leaf->vertex->y, next->vertex->y) - miny) >> PVS_CELLSHIFT);
+            cx2 = (int)(((int64_t)MAX(leaf->vertex->x, next->vertex->x) - minx) >> PVS_CELLSHIFT);
+            cy2 = (int)(((int64_t)MAX(leaf->vertex->y, next->vertex->y) - miny) >> PVS_CELLSHIFT);
+
+            for(cy = cy1; cy <= cy2; cy++) {
+                for(cx = cx1; cx <= cx2; cx++) {
+                    for(k = cellstart[cy * cellsw + cx]; k < cellstart[cy * cellsw + cx + 1]; k++) {
+                        vertex_t* v = &vertexes[cellverts[k]];
+                        double vx = (double)v->x / FRACUNIT - x1;
+                        double vy = (double)v->y / FRACUNIT - y1;
+                        double t = (vx * dx + vy * dy) / (len * len);
+
+                        if(fabs(vx * dy - vy * dx) / len < 0.5 && t * len > PVS_EPSILON &&
+                                (1 - t) * len > PVS_EPSILON) {
+                            splits.push_back(t);
+                        }
+                    }
+                }
+            }
+
+            std::sort(splits.begin(), splits.end());
+
+            //
+            // a portal for each stretch, merging stretches that lead to
+            // the same subsector
+            //
+            for(k = 0; k + 1 < (int)splits.size(); k++) {
+                double t1 = splits[k];
+                double t2 = splits[k + 1];
+                double mx;
+                double my;
+                int to;
+
+                if((t2 - t1) * len < PVS_EPSILON) {
+                    continue;
+                }
+
+                mx = x1 + dx * (t1 + t2) / 2;
+                my = y1 + dy * (t1 + t2) / 2;
+                to = P_PortalNeighbor(i, mx, my, nx, ny);
+
+                // an open stretch with nothing found behind it would let
+                // the flow miss whatever is there
+                if(to == -1) {
+                    CON_DPrintf("P_BuildPortals: subsector %i has an open edge to nowhere\n", i);
+                    return false;
+                }
+
+                if(degenerate[to]) {
+                    CON_DPrintf("P_BuildPortals: subsector %i has no polygon\n", to);
+                    return false;
+                }
+
+                if((int)portals.size() > firstportal[i] && portals.back().to == to &&
+                        portals.back().nx == nx && portals.back().ny == ny &&
+                        fabs(portals.back().seg.x2 - (x1 + dx * t1)) < PVS_EPSILON &&
+                        fabs(portals.back().seg.y2 - (y1 + dy * t1)) < PVS_EPSILON) {
+                    portals.back().seg.x2 = x1 + dx * t2;
+                    portals.back().seg.y2 = y1 + dy * t2;
+                    continue;
+                }
+
+                portals.push_back(portal_t());
+                portals.back().seg.x1 = x1 + dx * t1;
+                portals.back().seg.y1 = y1 + dy * t1;
+                portals.back().seg.x2 = x1 + dx * t2;
+                portals.back().seg.y2 = y1 + dy * t2;
+                portals.back().nx = nx;
+                portals.back().ny = ny;
+                portals.back().d = nx * x1 + ny * y1;
+                portals.back().from = i;
+                portals.back().to = to;
+            }
+        }
+    }
+
+    firstportal[numsubsectors] = (int)portals.size();
+    return true;
+}
+
+//
+// P_PortalDist
+//
+
+static d_inline double P_PortalDist(const portal_t* p, double x, double y) {
+    return p->nx * x + p->ny * y - p->d;
+}
+
+//
+// P_BasePortalVis
+// Floods out from the portal through every portal partly in front of
+// it that it is partly behind. Any line through the portal crosses
+// only such portals, so this holds all it can see and more.
+//
+
+static void P_BasePortalVis(int pnum, pvsworker_t* w) {
+    const portal_t* p = &portals[pnum];
+    uint64_t* might = &mightsee[(size_t)pnum * pvswords];
+    int i;
+
+    w->todo.clear();
+    w->todo.push_back(p->to);
+    PVS_SETBIT(might, p->to);
+
+    while(!w->todo.empty()) {
+        int leaf = w->todo.back();
+
+        w->todo.pop_back();
+
+        for(i = firstportal[leaf]; i < firstportal[leaf + 1]; i++) {
+            const portal_t* q = &portals[i];
+
+            if(PVS_TESTBIT(might, q->to)) {
+                continue;
+            }
+
+            if(P_PortalDist(p, q->seg.x1, q->seg.y1) < -PVS_EPSILON &&
+                    P_PortalDist(p, q->seg.x2, q->seg.y2) < -PVS_EPSILON) {
+                continue;
+            }
+
+            if(P_PortalDist(q, p->seg.x1, p->seg.y1) > PVS_EPSILON &&
+                    P_PortalDist(q, p->seg.x2, p->seg.y2) > PVS_EPSILON) {
+                continue;
+            }
+
+            PVS_SETBIT(might, q->to);
+            w->todo.push_back(q->to);
+        }
+    }
+}
+
+//
+// P_PushFlow
+//
+
+static void P_PushFlow(pvsworker_t* w, int leaf, const pvsseg_t* source, const pvsseg_t* pass) {
+    pvsframe_t f;
+    size_t depth = w->frames.size();
+
+    w->onstack[leaf] = 1;
+
+    if(w->might.size() < (depth + 2) * pvswords) {
+        w->might.resize((depth + 2) * pvswords);
+    }
+
+    f.leaf = leaf;
+    f.portal = firstportal[leaf];
+    f.source = *source;
+    f.haspass = (pass != NULL);
+
+    if(pass) {
+        f.pass = *pass;
+    }
+
+    w->frames.push_back(f);
+}
+
+//
+// P_PortalFlow
+// Marks what can be seen from base through the portals past it. Each
+// frame is a subsector reached through source and pass; the first,
+// just past base, has no pass and all of its portals can be looked
+// through. The frames are kept on the heap since the flow can go as
+// deep as there are subsectors.
+//
+
+static void P_PortalFlow(pvsworker_t* w, const portal_t* base) {
+    int j;
+
+    w->frames.clear();
+    P_PushFlow(w, base->to, &base->seg, NULL);
+
+    while(!w->frames.empty() && !w->overflow) {
+        size_t depth = w->frames.size() - 1;
+        pvsframe_t* f = &w->frames.back();
+        const portal_t* q;
+        const uint64_t* qmight;
+        uint64_t* cur;
+        uint64_t* next;
+        uint64_t more = 0;
+        pvsseg_t target;
+        pvsseg_t newsource;
+
+        if(f->portal >= firstportal[f->leaf + 1]) {
+            w->onstack[f->leaf] = 0;
+            w->frames.pop_back();
+            continue;
+        }
+
+        q = &portals[f->portal];
+        qmight = &mightsee[(size_t)f->portal * pvswords];
+        cur = &w->might[depth * pvswords];
+        next = cur + pvswords;
+        f->portal++;
+
+        if(w->onstack[q->to] || !PVS_TESTBIT(cur, q->to)) {
+            continue;
+        }
+
+        if(++w->steps > PVS_MAXSTEPS) {
+            w->overflow = true;
+            break;
+        }
+
+        for(j = 0; j < pvswords; j++) {
+            next[j] = cur[j] & qmight[j];
+            more |= next[j] & ~w->visible[j];
+        }
+
+        // nothing new could be seen past it
+        if(!more && PVS_TESTBIT(w->visible.data(), q->to)) {
+            continue;
+        }
+
+        target = q->seg;
+        newsource = f->source;
+
+        if(f->haspass) {
+            if(!P_ClipSeg(&target, base->nx, base->ny, base->d) ||
+                    !P_ClipToSeparators(&f->source, &f->pass, &target) ||
+                    !P_ClipToSeparators(&target, &f->pass, &newsource)) {
+                continue;
+            }
+        }
+
+        PVS_SETBIT(w->visible.data(), q->to);
+        P_PushFlow(w, q->to, &newsource, &target);
+    }
+
+    // cut short; unwind what is left
+    while(!w->frames.empty()) {
+        w->onstack[w->frames.back().leaf] = 0;
+        w->frames.pop_back();
+    }
+}
+
+//
+// P_CompressRow
+// Zero bytes are stored as a zero and a count
+//
+
+static void P_CompressRow(const uint64_t* bits, std::vector<byte>& out) {
+    int i;
+
+    out.clear();
+
+    for(i = 0; i < pvsrowbytes; i++) {
+        byte b = (byte)(bits[i >> 3] >> ((i & 7) * 8));
+        int count;
+
+        if(b) {
+            out.push_back(b);
+            continue;
+        }
+
+        for(count = 1; count < 255 && i + count < pvsrowbytes; count++) {
+            if((byte)(bits[(i + count) >> 3] >> (((i + count) & 7) * 8))) {
+                break;
+            }
+        }
+
+        out.push_back(0);
+        out.push_back((byte)count);
+        i += count - 1;
+    }
+}
+
+//
+// P_SubsectorVis
+// Builds one subsector's row
+//
+
+static void P_SubsectorVis(int num, pvsworker_t* w) {
+    int i;
+    int j;
+
+    // no portal leads into a subsector without a polygon, so there is
+    // no telling what it sees; let it see, and be seen by, everything
+    if(pvsdegenerate[num]) {
+        std::fill(w->visible.begin(), w->visible.end(), ~0ULL);
+        P_CompressRow(w->visible.data(), pvsrows[num]);
+        return;
+    }
+
+    std::copy(degeneratebits.begin(), degeneratebits.end(), w->visible.begin());
+    PVS_SETBIT(w->visible.data(), num);
+
+    w->steps = 0;
+    w->overflow = false;
+    w->onstack[num] = 1;
+
+    for(i = firstportal[num]; i < firstportal[num + 1] && !w->overflow; i++) {
+        PVS_SETBIT(w->visible.data(), portals[i].to);
+
+        if(w->might.size() < (size_t)pvswords) {
+            w->might.resize(pvswords);
+        }
+
+        std::copy(&mightsee[(size_t)i * pvswords], &mightsee[(size_t)(i + 1) * pvswords], w->might.begin());
+        P_PortalFlow(w, &portals[i]);
+    }
+
+    w->onstack[num] = 0;
+
+    // too many ways to look; settle for everything that might be seen
+    if(w->overflow) {
+        std::fill(w->onstack.begin(), w->onstack.end(), 0);
+
+        for(i = firstportal[num]; i < firstportal[num + 1]; i++) {
+            for(j = 0; j < pvswords; j++) {
+                w->visible[j] |= mightsee[(size_t)i * pvswords + j];
+            }
+        }
+
+        pvsfallbacks++;
+    }
+
+    P_CompressRow(w->visible.data(), pvsrows[num]);
+}
+
+//
+// P_RunPVSJobs
+// Runs job for 0 to count - 1 on every core
+//
+
+static void P_RunPVSJobs(int count, void (*job)(int, pvsworker_t*)) {
+    std::vector<pvsworker_t> workers(MAX((int)std::thread::hardware_concurrency(), 1));
+    std::vector<std::thread> threads;
+    std::atomic<int> next(0);
+    size_t i;
+
+    auto run = [&](pvsworker_t* w) {
+        int j;
+
+        while((j = next++) < count) {
+            job(j, w);
+        }
+    };
+
+    for(i = 0; i < workers.size(); i++) {
+        workers[i].visible.resize(pvswords);
+        workers[i].onstack.resize(numsubsectors);
+    }
+
+    for(i = 1; i < workers.size(); i++) {
+        threads.emplace_back(run, &workers[i]);
+    }
+
+    run(&workers[0]);
+
+    for(auto& t : threads) {
+        t.join();
+    }
+}
+
+//
+// P_BuildPVS
+//
+
+static dboolean P_BuildPVS(void) {
+    int starttime = I_GetTimeMS();
+    int size;
+    int i;
+
+    if(!P_BuildPortals()) {
+        portals.clear();
+        firstportal.clear();
+        return false;
+    }
+
+    pvswords = (numsubsectors + 63) >> 6;
+    mightsee.assign((size_t)portals.size() * pvswords, 0);
+    pvsrows.assign(numsubsectors, std::vector<byte>());
+    pvsfallbacks = 0;
+
+    P_RunPVSJobs((int)portals.size(), P_BasePortalVis);
+    P_RunPVSJobs(numsubsectors, P_SubsectorVis);
+
+    size = 0;
+    for(i = 0; i < numsubsectors; i++) {
+        size += (int)pvsrows[i].size();
+    }
+
+    pvsoffsets = (int*)Z_Malloc(numsubsectors * sizeof(int), PU_LEVEL, &pvsoffsets);
+    pvsdata = (byte*)Z_Malloc(MAX(size, 1), PU_LEVEL, &pvsdata);
+
+    size = 0;
+    for(i = 0; i < numsubsectors; i++) {
+        pvsoffsets[i] = size;
+        dmemcpy(pvsdata + size, pvsrows[i].data(), pvsrows[i].size());
+        size += (int)pvsrows[i].size();
+    }
+
+    pvsdatasize = size;
+
+    CON_DPrintf("P_BuildPVS: %i portals, %i bytes, %i coarse rows, %i ms\n",
+                (int)portals.size(), size, (int)pvsfallbacks, I_GetTimeMS() - starttime);
+
+    // hand the memory back
+    std::vector<portal_t>().swap(portals);
+    std::vector<int>().swap(firstportal);
+    std::vector<uint64_t>().swap(mightsee);
+    std::vector<std::vector<byte> >().swap(pvsrows);
+    std::vector<byte>().swap(pvsdegenerate);
+    std::vector<uint64_t>().swap(degeneratebits);
+
+    return true;
+}
+
+//
+// P_PVSCacheFile
+//
+
+static char* P_PVSCacheFile(const byte* checksum) {
+    char name[64];
+    char hex[33];
+    int i;
+
+    for(i = 0; i < 16; i++) {
+        snprintf(hex + i * 2, 3, "%02x", checksum[i]);
+    }
+
+    snprintf(name, sizeof(name), PVS_FILE, hex);
+    return I_GetUserFile(name);
+}
+
+//
+// P_CheckPVSRow
+// True if the compressed row fills exactly a row without running past
+// size bytes, so P_DecompressPVS can trust it
+//
+
+static dboolean P_CheckPVSRow(const byte* in, int size) {
+    int pos = 0;
+    int out = 0;
+
+    while(out < pvsrowbytes) {
+        if(pos >= size) {
+            return false;
+        }
+
+        if(in[pos]) {
+            pos++;
+            out++;
+            continue;
+        }
+
+        if(pos + 1 >= size || !in[pos + 1] || out + in[pos + 1] > pvsrowbytes) {
+            return false;
+        }
+
+        out += in[pos + 1];
+        pos += 2;
+    }
+
+    return true;
+}
+
+//
+// P_ReadPVSCache
+//
+
+static dboolean P_ReadPVSCache(const pvsheader_t* header) {
+    pvsheader_t cached;
+    char* path;
+    byte* data;
+    int length;
+    int i;
+
+    if(!(path = P_PVSCacheFile(header->checksum))) {
+        return false;
+    }
+
+    length = M_ReadFile(path, &data);
+    free(path);
+
+    if(length == -1) {
+        return false;
+    }
+
+    if(length < (int)sizeof(pvsheader_t)) {
+        Z_Free(data);
+        return false;
+    }
+
+    dmemcpy(&cached, data, sizeof(pvsheader_t));
+
+    if(cached.magic != header->magic || cached.numsubsectors != header->numsubsectors ||
+            memcmp(cached.checksum, header->checksum, sizeof(cached.checksum)) ||
+            cached.datasize <= 0 ||
+            length != (int)(sizeof(pvsheader_t) + numsubsectors * sizeof(int)) + cached.datasize) {
+        Z_Free(data);
+        return false;
+    }
+
+    pvsoffsets = (int*)Z_Malloc(numsubsectors * sizeof(int), PU_LEVEL, &pvsoffsets);
+    pvsdata = (byte*)Z_Malloc(cached.datasize, PU_LEVEL, &pvsdata);
+
+    dmemcpy(pvsoffsets, data + sizeof(pvsheader_t), numsubsectors * sizeof(int));
+    dmemcpy(pvsdata, data + sizeof(pvsheader_t) + numsubsectors * sizeof(int), cached.datasize);
+    pvsdatasize = cached.datasize;
+    Z_Free(data);
+
+    for(i = 0; i < numsubsectors; i++) {
+        if(pvsoffsets[i] < 0 || pvsoffsets[i] >= cached.datasize ||
+                !P_CheckPVSRow(pvsdata + pvsoffsets[i], cached.datasize - pvsoffsets[i])) {
+            Z_Free(pvsoffsets);
+            Z_Free(pvsdata);
+            pvsoffsets = NULL;
+            pvsdata = NULL;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// P_WritePVSCache
+//
+
+static void P_WritePVSCache(pvsheader_t* header) {
+    char* path;
+    byte* data;
+    int length;
+
+    if(!(path = P_PVSCacheFile(header->checksum))) {
+        return;
+    }
+
+    header->datasize = pvsdatasize;
+    length = sizeof(pvsheader_t) + numsubsectors * sizeof(int) + pvsdatasize;
+    data = (byte*)Z_Malloc(length, PU_STATIC, 0);
+
+    dmemcpy(data, header, sizeof(pvsheader_t));
+    dmemcpy(data + sizeof(pvsheader_t), pvsoffsets, numsubsectors * sizeof(int));
+    dmemcpy(data + sizeof(pvsheader_t) + numsubsectors * sizeof(int), pvsdata, pvsdatasize);
+
+    if(!M_WriteFile(path, data, length)) {
+        CON_Warnf("P_WritePVSCache: Couldn't write %s\n", path);
+    }
+
+    Z_Free(data);
+    free(path);
+}
+
+//
+// P_LoadPVS
+//
+
+void P_LoadPVS(void) {
+    pvsheader_t header;
+
+    pvsoffsets = NULL;
+    pvsdata = NULL;
+    sightrow = NULL;
+    sightrowsub = -1;
+    pvsrowbytes = (numsubsectors + 7) >> 3;
+
+    if(numsubsectors <= 0) {
+        return;
+    }
+
+    dmemset(&header, 0, sizeof(header));
+    header.magic = PVS_MAGIC;
+    header.numsubsectors = numsubsectors;
+    W_MapChecksum(header.checksum);
+
+    if(!P_ReadPVSCache(&header)) {
+        if(!P_BuildPVS()) {
+            CON_DPrintf("P_LoadPVS: no PVS for this map\n");
+            return;
+        }
+
+        P_WritePVSCache(&header);
+    }
+
+    sightrow = (byte*)Z_Malloc(pvsrowbytes, PU_LEVEL, &sightrow);
+}
+
+//
+// P_HavePVS
+//
+
+dboolean P_HavePVS(void) {
+    return pvsoffsets != NULL;
+}
+
+//
+// P_DecompressPVS
+//
+
+void P_DecompressPVS(int subsector, byte* row) {
+    const byte* in = pvsdata + pvsoffsets[subsector];
+    byte* out = row;
+    byte* end = row + pvsrowbytes;
+
+    while(out < end) {
+        int count;
+
+        if(*in) {
+            *out++ = *in++;
+            continue;
+        }
+
+        count = MIN(in[1], end - out);
+        dmemset(out, 0, count);
+        out += count;
+        in += 2;
+    }
+}
+
+//
+// P_CheckPVS
+//
+
+dboolean P_CheckPVS(subsector_t* from, subsector_t* to) {
+    int num;
+
+    if(!pvsoffsets) {
+        return true;
+    }
+
+    if(from - subsectors != sightrowsub) {
+        sightrowsub = from - subsectors;
+        P_DecompressPVS(sightrowsub, sightrow);
+    }
+
+    num = to - subsectors;
+    return (sightrow[num >> 3] & (1 << (num & 7))) != 0;
+}
+
+//
+// P_PointInLeafs
+//
+
+dboolean P_PointInLeafs(subsector_t* sub, fixed_t x, fixed_t y) {
+    double px = (double)x / FRACUNIT;
+    double py = (double)y / FRACUNIT;
+    dboolean front = false;
+    dboolean back = false;
+    int i;
+
+    if(sub->numleafs < 3) {
+        return false;
+    }
+
+    for(i = 0; i < sub->numleafs; i++) {
+        double x1, y1, x2, y2;
+        double dx, dy, len, dist;
+
+        P_LeafVertex(&leafs[sub->leaf + i], &x1, &y1);
+        P_LeafVertex(&leafs[sub->leaf + (i + 1) % sub->numleafs], &x2, &y2);
+
+        dx = x2 - x1;
+        dy = y2 - y1;
+        len = sqrt(dx * dx + dy * dy);
+
+        if(len < PVS_EPSILON) {
+            continue;
+        }
+
+        dist = (dx * (py - y1) - dy * (px - x1)) / len;
+
+        // the same slack the portals were clipped with
+        if(dist > PVS_EPSILON) {
+            front = true;
+        }
+        else if(dist < -PVS_EPSILON) {
+            back = true;
+        }
+    }
+
+    return !(front && back);
+}
@@ -0,0 +1,53 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __P_PVS__
+#define __P_PVS__
+
+
+#ifdef __GNUG__
+#pragma interface
+#endif
+
+#include "doomtype.h"
+#include "t_bsp.h"
+
+// Builds the level's PVS, or reads it from the cache. Called by
+// P_SetupLevel while the map lump is still loaded.
+void        P_LoadPVS(void);
+
+// False when the level has no PVS; everything is then potentially visible
+dboolean    P_HavePVS(void);
+
+// Expands a subsector's row: bit n is set if subsector n might be seen
+// from somewhere inside it. row needs (numsubsectors + 7) / 8 bytes.
+void        P_DecompressPVS(int subsector, byte* row);
+
+// True if any point of to might be seen from any point of from
+dboolean    P_CheckPVS(subsector_t* from, subsector_t* to);
+
+// True if (x, y) is inside the subsector's polygon. The PVS only holds
+// for views from inside the map.
+dboolean    P_PointInLeafs(subsector_t* sub, fixed_t x, fixed_t y);
+
+#endif
@@ -29,6 +29,11 @@
 
 
 #include <time.h> // [kex] - for saving the date and time
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
 #include "i_system.h"
 #include "g_game.h"
 #include "z_zone.h"
@@ -40,6 +45,10 @@
 #include "p_saveg.h"
 #include "d_englsh.h"
 #include "m_misc.h"
+#include "m_random.h"
+#include "s_sound.h"
+#include "con_console.h"
+#include "wad/WadFormat.hh"
 #include "doomdef.h" // added just so MSVC would shut up about warning C4761
 
 void G_DoLoadLevel(void);
@@ -50,12 +59,23 @@ void G_DoLoadLevel(void);
 
 #define SAVEGAME_EOF    0x464F45
 #define SAVEGAME_MOBJ   0x4A424F4D
+#define SAVEGAME_ZLIB   0x5A475344  // body after the header is deflated
 
-static FILE*    save_stream;
-static byte*    savebuffer;
+// largest inflated body a savegame may claim
+#define SAVEGAME_MAXBODY    0x4000000
+
+BoolProperty m_compresssaves("m_compresssaves", "Compress savegames", true);
+
+static std::vector<byte>    savewrite;      // archive being written
+static const byte*          savebuffer;     // archive being read
+static unsigned long        savesize;
 
 static unsigned long save_offset = 0;
 
+// savegames are written to disk on their own thread
+static std::thread          save_thread;
+static std::atomic<bool>    save_failed;
+
 //
 // P_GetSaveGameName
 //
@@ -76,13 +96,18 @@ char *P_GetSaveGameName(int num) {
 static byte saveg_read8(void) {
     byte result;
 
+    // past the end of a truncated file; the markers will catch it
+    if(save_offset >= savesize) {
+        return 0;
+    }
+
     result = savebuffer[save_offset++];
 
     return result;
 }
 
 static void saveg_write8(byte value) {
-    fwrite(&value, 1, 1, save_stream);
+    savewrite.push_back(value);
     save_offset++;
 }
 
@@ -170,6 +195,8 @@ typedef struct {
 static savegmobj_t* savegmobj;
 static int          savegmobjnum;
 
+static std::unordered_map<mobj_t*, int> savegmobjindex;
+
 static void saveg_setup_mobjwrite(void) {
     mobj_t* mobj;
     int i;
@@ -188,6 +215,8 @@ static void saveg_setup_mobjwrite(void) {
 
     // allocate ref table
     savegmobj = (savegmobj_t*)Z_Alloca(sizeof(savegmobj_t) * savegmobjnum);
+    savegmobjindex.clear();
+    savegmobjindex.reserve(savegmobjnum);
     i = 0;
 
     // store index and mobj
@@ -199,6 +228,7 @@ static void saveg_setup_mobjwrite(void) {
 
         savegmobj[i].index = i + 1;
         savegmobj[i].mobj = mobj;
+        savegmobjindex[mobj] = i + 1;
         i++;
     }
 }
@@ -213,36 +243,22 @@ static void saveg_setup_mobjread(void) {
     // read and add mobjs
     for(i = 0; i < savegmobjnum; i++) {
         savegmobj[i].index = i + 1;
-        savegmobj[i].mobj = (mobj_t*) Z_Calloc(sizeof(mobj_t), PU_LEVEL, NULL);
+        savegmobj[i].mobj = (mobj_t*) Z_PoolAlloc(sizeof(mobj_t));
     }
 }
 
 static void saveg_write_mobjindex(mobj_t* mobj) {
-    int i;
+    auto it = savegmobjindex.find(mobj);
 
-    for(i = 0; i < savegmobjnum; i++) {
-        if(savegmobj[i].mobj != mobj) {
-            continue;
-        }
-
-        saveg_write32(savegmobj[i].index);
-        return;
-    }
-
-    saveg_write32(0);
+    saveg_write32(it != savegmobjindex.end() ? it->second : 0);
 }
 
 static mobj_t* saveg_read_mobjindex(void) {
     int index = saveg_read32();
 
-    if(index) {
-        int i;
-
-        for(i = 0; i < savegmobjnum; i++) {
-            if(savegmobj[i].index == index) {
-                return savegmobj[i].mobj;
-            }
-        }
+    // indices are handed out in order, starting at 1
+    if(index > 0 && index <= savegmobjnum) {
+        return savegmobj[index - 1].mobj;
     }
 
     return NULL;
@@ -892,6 +908,20 @@ static void saveg_read_lightmorph_t(void *data) {
     morph->inc  = saveg_read32();
 }
 
+//
+// fadebright_t
+//
+
+static void saveg_write_fadebright_t(void *data) {
+    fadebright_t* fb = (fadebright_t*) data;
+    saveg_write32((int)fb->factor);
+}
+
+static void saveg_read_fadebright_t(void *data) {
+    fadebright_t* fb = (fadebright_t*) data;
+    fb->factor = (float)saveg_read32();
+}
+
 //
 // delay_t
 //
@@ -1245,25 +1275,133 @@ static void saveg_write_marker(int marker) {
     saveg_write32(marker);
 }
 
+//
+// saveg_flush
+// Runs on the save thread. The header is stored as is so the menu
+// can read it without inflating anything; the rest is deflated
+// behind a SAVEGAME_ZLIB marker and its inflated size.
+//
+
+static void saveg_flush(FILE* fp, std::vector<byte> data, size_t headersize, bool compress) {
+    size_t bodysize = data.size() - headersize;
+    bool ok;
+
+    ok = fwrite(data.data(), 1, headersize, fp) == headersize;
+
+    if(compress) {
+        uLongf length = compressBound(bodysize);
+        std::vector<byte> packed(8 + length);
+        int i;
+
+        for(i = 0; i < 4; i++) {
+            packed[i] = (SAVEGAME_ZLIB >> (i * 8)) & 0xff;
+            packed[4 + i] = (bodysize >> (i * 8)) & 0xff;
+        }
+
+        if(compress2(&packed[8], &length, &data[headersize], bodysize, Z_BEST_SPEED) == Z_OK) {
+            ok = ok && fwrite(packed.data(), 1, 8 + length, fp) == 8 + length;
+            bodysize = 0;
+        }
+    }
+
+    if(bodysize) {
+        ok = ok && fwrite(&data[headersize], 1, bodysize, fp) == bodysize;
+    }
+
+    if(fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if(!ok) {
+        save_failed = true;
+    }
+}
+
+//
+// P_FlushSaveGame
+// Waits for the last savegame to reach the disk
+//
+
+void P_FlushSaveGame(void) {
+    if(save_thread.joinable()) {
+        save_thread.join();
+    }
+
+    if(save_failed.exchange(false)) {
+        CON_Warnf("P_FlushSaveGame: Couldn't write savegame\n");
+    }
+}
+
+//
+// saveg_inflate_body
+// Called right after the header is read. If the rest of the file
+// is compressed, it is inflated and reading carries on from there;
+// *body is then the inflated buffer, which the caller frees.
+// Returns false if the compressed body is truncated or corrupt.
+//
+
+static dboolean saveg_inflate_body(byte** body) {
+    unsigned long start = save_offset;
+    uLongf length;
+    uLong packed;
+    dword size;
+
+    *body = NULL;
+
+    if(saveg_read32() != SAVEGAME_ZLIB) {
+        save_offset = start;
+        return true;
+    }
+
+    size = (dword)saveg_read32();
+    packed = save_offset < savesize ? savesize - save_offset : 0;
+
+    // deflate can't do better than about 1032:1
+    if(size == 0 || size > SAVEGAME_MAXBODY || size / 1032 > packed) {
+        CON_Warnf("saveg_inflate_body: Bad inflated size %u\n", size);
+        return false;
+    }
+
+    length = size;
+    *body = (byte*)Z_Malloc(length, PU_STATIC, 0);
+
+    if(uncompress(*body, &length, savebuffer + save_offset, packed) != Z_OK || length != size) {
+        CON_Warnf("saveg_inflate_body: Savegame is truncated or corrupt\n");
+        Z_Free(*body);
+        *body = NULL;
+        return false;
+    }
+
+    savebuffer = *body;
+    savesize = length;
+    save_offset = 0;
+
+    return true;
+}
+
 //
 // P_WriteSaveGame
 //
 
 dboolean P_WriteSaveGame(char* description, int slot) {
-    //char name[256];
+    FILE* fp;
+    size_t headersize;
+
+    P_FlushSaveGame();
 
     // setup game save file
-    // sprintf(name, SAVEGAMENAME"%d.dsg", slot);
-    save_stream = fopen(P_GetSaveGameName(slot), "wb");
+    fp = fopen(P_GetSaveGameName(slot), "wb");
 
     // success?
-    if(save_stream == NULL) {
+    if(fp == NULL) {
         return false;
     }
 
+    savewrite.clear();
     save_offset = 0;
 
     saveg_write_header(description);
+    headersize = savewrite.size();
 
     P_ArchiveMobjs();
     P_ArchivePlayers();
@@ -1273,8 +1411,9 @@ dboolean P_WriteSaveGame(char* description, int slot) {
 
     saveg_write_marker(SAVEGAME_EOF);
 
-    // close out file
-    fclose(save_stream);
+    // hand the archive off; the thread closes the file
+    save_thread = std::thread(saveg_flush, fp, std::move(savewrite), headersize, (bool)m_compresssaves);
+    savewrite = std::vector<byte>();
 
     return true;
 }
@@ -1284,11 +1423,27 @@ dboolean P_WriteSaveGame(char* description, int slot) {
 //
 
 dboolean P_ReadSaveGame(char* name) {
-    M_ReadFile(name, &savebuffer);
+    byte* body;
+
+    P_FlushSaveGame();
+
+    imp::wad::MappedFile file(name);
+
+    if(!file.is_open()) {
+        return false;
+    }
+
+    savebuffer = (const byte*)file.view(0, file.size()).data();
+    savesize = file.size();
     save_offset = 0;
 
     saveg_read_header();
 
+    if(!saveg_inflate_body(&body)) {
+        savebuffer = NULL;
+        return false;
+    }
+
     // load a base level
     G_InitNew(gameskill, gamemap);
     G_DoLoadLevel();
@@ -1303,7 +1458,11 @@ dboolean P_ReadSaveGame(char* name) {
         I_Error("Bad savegame");
     }
 
-    Z_Free(savebuffer);
+    if(body) {
+        Z_Free(body);
+    }
+
+    savebuffer = NULL;
 
     return true;
 }
@@ -1317,10 +1476,16 @@ dboolean P_QuickReadSaveHeader(char* name, char* date,
     int i;
     int size;
 
-    if(M_ReadFile(name, &savebuffer) == -1) {
+    P_FlushSaveGame();
+
+    imp::wad::MappedFile file(name);
+
+    if(!file.is_open()) {
         return 0;
     }
 
+    savebuffer = (const byte*)file.view(0, file.size()).data();
+    savesize = file.size();
     save_offset = 0;
 
     // skip the description field
@@ -1346,7 +1511,7 @@ dboolean P_QuickReadSaveHeader(char* name, char* date,
     *skill  = saveg_read8();
     *map    = saveg_read8();
 
-    Z_Free(savebuffer);
+    savebuffer = NULL;
 
     return 1;
 }
@@ -1465,6 +1630,8 @@ void P_UnArchiveWorld(void) {
     light_t     *light;
     side_t      *si;
 
+    P_InvalidateSights();
+
     // do sectors
     for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
         sec->floorheight    = INT2F(saveg_read16());
@@ -1522,6 +1689,9 @@ void P_UnArchiveWorld(void) {
         saveg_read_pad();
         light->tag          = saveg_read16();
     }
+
+    P_InitTagLists();
+    P_InitScrollSectors();
 }
 
 
@@ -1571,6 +1741,7 @@ void P_UnArchiveMobjs(void) {
 
     saveg_setup_mobjread();
     mobjhead.next = mobjhead.prev = &mobjhead;
+    P_ClearMobjTIDs();
 
     for(i = 0; i < savegmobjnum; i++) {
         mobj = savegmobj[i].mobj;
@@ -1612,7 +1783,11 @@ enum {
     tc_split,
     tc_morph,
     tc_exp,
-    tc_endthinkers
+    tc_endthinkers,
+
+    // after the terminator so older savegames still read
+    tc_fadebright,
+    NUMTHINKERCLASSES
 };
 
 struct {
@@ -1773,6 +1948,14 @@ struct {
         sizeof(mobjexp_t)
     },
 
+    {
+        T_FadeInBrightness,
+        tc_fadebright,
+        saveg_write_fadebright_t,
+        saveg_read_fadebright_t,
+        sizeof(fadebright_t)
+    },
+
     {
         NULL,
         tc_endthinkers,
@@ -1838,7 +2021,7 @@ void P_UnArchiveSpecials(void) {
     currentthinker = thinkercap.next;
     while(currentthinker != &thinkercap) {
         next = currentthinker->next;
-        Z_Free(currentthinker);
+        Z_PoolFree(currentthinker);
 
         currentthinker = next;
     }
@@ -1852,14 +2035,14 @@ void P_UnArchiveSpecials(void) {
             return;
         }
 
-        if(tclass > tc_endthinkers) {
+        if(tclass >= NUMTHINKERCLASSES) {
             I_Error("P_UnarchiveSpecials: Unknown tclass %i in savegame", tclass);
         }
 
         for(i = 0; saveg_specials[i].type != tc_endthinkers; i++) {
             if(tclass == saveg_specials[i].type) {
                 saveg_read_pad();
-                thinker = Z_Malloc(saveg_specials[i].structsize, PU_LEVEL, NULL);
+                thinker = Z_PoolAlloc(saveg_specials[i].structsize);
                 saveg_specials[i].readfunc(thinker);
 
                 ((thinker_t*)thinker)->function.acp1 = saveg_specials[i].function;
@@ -1974,4 +2157,210 @@ void P_UnArchiveMacros(void) {
     }
 }
 
+//------------------------------------------------------------------------
+//
+// In-memory snapshots for demo seeking
+//
+//------------------------------------------------------------------------
+
+//
+// saveg_clear_mobjs
+// Frees every mobj and empties the sector and blockmap chains, so a
+// snapshot can be restored over the running level without reloading it
+//
+
+static void saveg_clear_mobjs(void) {
+    mobj_t* mobj;
+    mobj_t* next;
+    int i;
+
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = next) {
+        next = mobj->next;
+        S_RemoveOrigin(mobj);
+        Z_PoolFree(mobj);
+    }
+
+    mobjhead.next = mobjhead.prev = &mobjhead;
+
+    for(i = 0; i < numsectors; i++) {
+        sectors[i].thinglist = NULL;
+    }
+
+    dmemset(blocklinks, 0, sizeof(*blocklinks) * bmapwidth * bmapheight);
+}
+
+//
+// saveg_write_buttons
+// Savegames don't keep the switches waiting to pop back out, but a
+// snapshot has to or they never would
+//
+
+static void saveg_write_buttons(void) {
+    int i;
+
+    for(i = 0; i < MAXBUTTONS; i++) {
+        if(!buttonlist[i].btimer) {
+            saveg_write32(-1);
+            continue;
+        }
+
+        saveg_write32(buttonlist[i].line - lines);
+        saveg_write32(buttonlist[i].where);
+        saveg_write32(buttonlist[i].btexture);
+        saveg_write32(buttonlist[i].btimer);
+    }
+}
+
+//
+// saveg_read_buttons
+//
+
+static void saveg_read_buttons(void) {
+    int i;
+    int num;
+    line_t* line;
+
+    dmemset(buttonlist, 0, sizeof(buttonlist));
+    numactivebuttons = 0;
+
+    for(i = 0; i < MAXBUTTONS; i++) {
+        num = saveg_read32();
+
+        if(num == -1) {
+            continue;
+        }
+
+        line = &lines[num];
+
+        buttonlist[i].line      = line;
+        buttonlist[i].where     = saveg_read32();
+        buttonlist[i].btexture  = saveg_read32();
+        buttonlist[i].btimer    = saveg_read32();
+
+        if(SWITCHMASK(line->flags)) {
+            buttonlist[i].soundorg = (mobj_t *)&line->frontsector->soundorg;
+        }
+
+        numactivebuttons++;
+    }
+}
+
+//
+// P_WriteSnapshot
+// Archives the level into out, reusing its storage. There is no
+// savegame header; the random number state and every macro's enabled
+// flag are kept instead so demo playback stays in sync after a restore.
+//
+
+void P_WriteSnapshot(std::vector<byte>& out) {
+    int i;
+
+    savewrite.swap(out);
+    savewrite.clear();
+    save_offset = 0;
+
+    saveg_write32(leveltime);
+    saveg_write32(gametic - basetic);
+    saveg_write32(totalkills);
+    saveg_write32(totalitems);
+    saveg_write32(totalsecret);
+    saveg_write16(globalint);
+    saveg_write_pad();
+
+    for(i = 0; i < NUMPRCLASS; i++) {
+        saveg_write32(rng.seed[i]);
+    }
+
+    saveg_write32(rng.rndindex);
+    saveg_write32(rng.prndindex);
+
+    P_ArchiveMobjs();
+    P_ArchivePlayers();
+    P_ArchiveWorld();
+    P_ArchiveSpecials();
+    P_ArchiveMacros();
+
+    saveg_write_pad();
+
+    for(i = 0; i < macros.macrocount; i++) {
+        saveg_write16(macros.def[i].data[0].id);
+    }
+
+    saveg_write_buttons();
+
+    for(i = 0; i < BODYQUESIZE; i++) {
+        saveg_write_mobjindex(bodyque[i]);
+    }
+
+    saveg_write32(bodyqueslot);
+
+    saveg_write_marker(SAVEGAME_EOF);
+
+    savewrite.swap(out);
+}
+
+//
+// P_ReadSnapshot
+// Restores a snapshot of the current level written by P_WriteSnapshot
+//
+
+void P_ReadSnapshot(const byte* data, size_t size) {
+    int i;
 
+    savebuffer = data;
+    savesize = size;
+    save_offset = 0;
+
+    leveltime   = saveg_read32();
+    basetic     = gametic - saveg_read32();
+    totalkills  = saveg_read32();
+    totalitems  = saveg_read32();
+    totalsecret = saveg_read32();
+    globalint   = saveg_read16();
+    saveg_read_pad();
+
+    for(i = 0; i < NUMPRCLASS; i++) {
+        rng.seed[i] = saveg_read32();
+    }
+
+    rng.rndindex = saveg_read32();
+    rng.prndindex = saveg_read32();
+
+    // a fresh level would have none of these
+    saveg_clear_mobjs();
+    dmemset(activeceilings, 0, sizeof(activeceilings));
+    dmemset(activeplats, 0, sizeof(activeplats));
+    P_InitMacroVars();
+
+    P_UnArchiveMobjs();
+    P_UnArchivePlayers();
+    P_UnArchiveWorld();
+    P_UnArchiveSpecials();
+    P_UnArchiveMacros();
+
+    saveg_read_pad();
+
+    for(i = 0; i < macros.macrocount; i++) {
+        macros.def[i].data[0].id = saveg_read16();
+    }
+
+    saveg_read_buttons();
+
+    for(i = 0; i < BODYQUESIZE; i++) {
+        bodyque[i] = saveg_read_mobjindex();
+    }
+
+    bodyqueslot = saveg_read32();
+
+    if(!saveg_read_marker(SAVEGAME_EOF)) {
+        I_Error("P_ReadSnapshot: Bad snapshot");
+    }
+
+    savebuffer = NULL;
+
+    // nothing may keep pointing at the freed mobjs, and cached sights
+    // were worked out for the level as it was
+    linetarget = NULL;
+    blockthing = NULL;
+    P_InvalidateSights();
+}
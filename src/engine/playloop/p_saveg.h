@@ -31,11 +31,14 @@
 #pragma interface
 #endif
 
+#include <vector>
+
 #define SAVEGAMESIZE    0x60000
 #define SAVEGAMETBSIZE  0xC000
 #define SAVESTRINGSIZE  16
 
 char *P_GetSaveGameName(int num);
+void P_FlushSaveGame(void);
 dboolean P_WriteSaveGame(char* description, int slot);
 dboolean P_ReadSaveGame(char* name);
 dboolean P_QuickReadSaveHeader(char* name, char* date, int* thumbnail, int* skill, int* map);
@@ -53,4 +56,8 @@ void P_UnArchiveSpecials(void);
 void P_ArchiveMacros(void);
 void P_UnArchiveMacros(void);
 
+// In-memory snapshots of the running level, used for demo seeking
+void P_WriteSnapshot(std::vector<byte>& out);
+void P_ReadSnapshot(const byte* data, size_t size);
+
 #endif
@@ -50,6 +50,7 @@
 #include "m_random.h"
 #include "z_zone.h"
 #include "sc_main.h"
+#include "p_pvs.h"
 #include <map>
 #include <imp/Wad>
 #include "Map.hh"
@@ -118,9 +119,9 @@ static skydef_t*    skydefs;
 // Blockmap size.
 int                 bmapwidth;
 int                 bmapheight;     // size in mapblocks
-short*              blockmap;       // int for larger maps
+int*                blockmap;
 // offsets in blockmap are from here
-short*              blockmaplump;
+int*                blockmaplump;
 // origin of block map
 fixed_t             bmaporgx;
 fixed_t             bmaporgy;
@@ -172,23 +173,24 @@ static word P_GetTextureHashKey(int hash) {
 //
 void P_LoadVertexes(int lump) {
     int                 i;
-    mapvertex_t*        ml;
+    MapLump<mapvertex_t> ml(lump);
     vertex_t*           li;
 
-    numvertexes = W_MapLumpLength(lump) / sizeof(mapvertex_t);
+    numvertexes = ml.size();
     CON_DPrintf("%i vertexes\n", numvertexes);
 
     // Allocate zone memory for buffer.
     vertexes = (vertex_t*) Z_Malloc(numvertexes * sizeof(vertex_t),PU_LEVEL,0);
 
-    ml = (mapvertex_t *)W_GetMapLump(lump);
     li = vertexes;
 
     // Copy and convert vertex coordinates,
     // internal representation as fixed.
-    for(i = 0; i < numvertexes; i++, li++, ml++) {
-        li->x = LONG(ml->x);
-        li->y = LONG(ml->y);
+    for(i = 0; i < numvertexes; i++, li++) {
+        mapvertex_t mv = ml[i];
+
+        li->x = LONG(mv.x);
+        li->y = LONG(mv.y);
         li->validcount = -1;
         li->clipspan = ANGLE_MAX;
     }
@@ -200,7 +202,7 @@ void P_LoadVertexes(int lump) {
 
 void P_LoadSegs(int lump) {
     int                 i;
-    mapseg_t*            ml;
+    MapLump<mapseg_t>   ml(lump);
     seg_t*              li;
     line_t*             ldef;
     int                 linedef;
@@ -208,24 +210,25 @@ void P_LoadSegs(int lump) {
     float               x;
     float               y;
 
-    numsegs = W_MapLumpLength(lump) / sizeof(mapseg_t);
+    numsegs = ml.size();
     segs = (seg_t*) Z_Malloc(numsegs*sizeof(seg_t),PU_LEVEL,0);
     dmemset(segs, 0, numsegs*sizeof(seg_t));
 
     CON_DPrintf("%i segs\n", numsegs);
 
-    ml = (mapseg_t *)W_GetMapLump(lump);
     li = segs;
 
-    for(i = 0; i < numsegs; i++, li++, ml++) {
-        li->v1 = &vertexes[(word)SHORT(ml->v1)];
-        li->v2 = &vertexes[(word)SHORT(ml->v2)];
-        li->angle = INT2F(SHORT(ml->angle));
-        li->offset = INT2F(SHORT(ml->offset));
-        linedef = (word)SHORT(ml->linedef);
+    for(i = 0; i < numsegs; i++, li++) {
+        mapseg_t ms = ml[i];
+
+        li->v1 = &vertexes[(word)SHORT(ms.v1)];
+        li->v2 = &vertexes[(word)SHORT(ms.v2)];
+        li->angle = INT2F(SHORT(ms.angle));
+        li->offset = INT2F(SHORT(ms.offset));
+        linedef = (word)SHORT(ms.linedef);
         ldef = &lines[linedef];
         li->linedef = ldef;
-        side = SHORT(ml->side);
+        side = SHORT(ms.side);
         li->sidedef = &sides[ldef->sidenum[side]];
         li->frontsector = sides[ldef->sidenum[side]].sector;
         if(ldef->flags & ML_TWOSIDED) {
@@ -251,21 +254,22 @@ void P_LoadSegs(int lump) {
 
 void P_LoadSubsectors(int lump) {
     int                 i;
-    mapsubsector_t*     ms;
+    MapLump<mapsubsector_t> ms(lump);
     subsector_t*        ss;
 
-    numsubsectors = W_MapLumpLength(lump) / sizeof(mapsubsector_t);
+    numsubsectors = ms.size();
     subsectors = (subsector_t*) Z_Malloc(numsubsectors*sizeof(subsector_t),PU_LEVEL,0);
 
     CON_DPrintf("%i subsectors\n", numsubsectors);
 
-    ms = (mapsubsector_t *)W_GetMapLump(lump);
     dmemset(subsectors,0, numsubsectors*sizeof(subsector_t));
     ss = subsectors;
 
-    for(i=0 ; i<numsubsectors ; i++, ss++, ms++) {
-        ss->numlines = (word)SHORT(ms->numsegs);
-        ss->firstline = (word)SHORT(ms->firstseg);
+    for(i=0 ; i<numsubsectors ; i++, ss++) {
+        mapsubsector_t mss = ms[i];
+
+        ss->numlines = (word)SHORT(mss.numsegs);
+        ss->firstline = (word)SHORT(mss.firstseg);
         ss->leaf = 0;
         ss->numleafs = 0;
     }
@@ -279,30 +283,31 @@ void P_LoadSubsectors(int lump) {
 
 void P_LoadSectors(int lump) {
     int                 i, j;
-    mapsector_t*        ms;
+    MapLump<mapsector_t> ms(lump);
     sector_t*           ss;
 
-    numsectors = W_MapLumpLength(lump) / sizeof(mapsector_t);
+    numsectors = ms.size();
     sectors = (sector_t*) Z_Malloc(numsectors*sizeof(sector_t),PU_LEVEL,0);
     dmemset(sectors, 0, numsectors*sizeof(sector_t));
 
     CON_DPrintf("%i sectors\n", numsectors);
 
-    ms = (mapsector_t *)W_GetMapLump(lump);
     ss = sectors;
-    for(i = 0; i < numsectors; i++, ss++, ms++) {
-        ss->floorheight = INT2F(SHORT(ms->floorheight));
-        ss->ceilingheight = INT2F(SHORT(ms->ceilingheight));
-        ss->floorpic = P_GetTextureHashKey(ms->floorpic);
-        ss->ceilingpic = P_GetTextureHashKey(ms->ceilingpic);
-        ss->special = SHORT(ms->special);
-        ss->flags = SHORT(ms->flags);
+    for(i = 0; i < numsectors; i++, ss++) {
+        mapsector_t msec = ms[i];
+
+        ss->floorheight = INT2F(SHORT(msec.floorheight));
+        ss->ceilingheight = INT2F(SHORT(msec.ceilingheight));
+        ss->floorpic = P_GetTextureHashKey(msec.floorpic);
+        ss->ceilingpic = P_GetTextureHashKey(msec.ceilingpic);
+        ss->special = SHORT(msec.special);
+        ss->flags = SHORT(msec.flags);
 
         for(j = 0; j < 5; j++) {
-            ss->colors[j] = SHORT(ms->colors[j]);
+            ss->colors[j] = SHORT(msec.colors[j]);
         }
 
-        ss->tag = SHORT(ms->tag);
+        ss->tag = SHORT(msec.tag);
         ss->thinglist = NULL;
         ss->frame_z1[0] = ss->floorheight;
         ss->frame_z1[1] = ss->floorheight;
@@ -323,18 +328,16 @@ void P_LoadSectors(int lump) {
 //
 
 void P_LoadLights(int lump) {
-    maplights_t* ml;
+    MapLump<maplights_t> ml(lump);
     light_t* l;
     int i;
 
-    numlights = (W_MapLumpLength(lump) / sizeof(maplights_t)) + 256;
+    numlights = ml.size() + 256;
     lights = (light_t*) Z_Malloc(numlights * sizeof(light_t), PU_LEVEL, NULL);
     dmemset(lights, 0, numlights * sizeof(light_t));
 
     CON_DPrintf("%i lights\n", numlights);
 
-    ml = (maplights_t*)W_GetMapLump(lump);
-
     l = lights;
 
     for(i = 0; i < numlights; i++, l++) {
@@ -346,12 +349,12 @@ void P_LoadLights(int lump) {
             l->r = l->g = l->b = i;
         }
         else {
-            l->r = ml->r;
-            l->g = ml->g;
-            l->b = ml->b;
-            l->tag = ml->tag;
+            maplights_t mlt = ml[i - 256];
 
-            ml++;
+            l->r = mlt.r;
+            l->g = mlt.g;
+            l->b = mlt.b;
+            l->tag = mlt.tag;
         }
     }
 
@@ -363,7 +366,8 @@ void P_LoadLights(int lump) {
 //
 
 void P_LoadMacros(int lump) {
-    short* data;
+    MapLump<short> data(lump);
+    int d = 0;
     short count;
     int size = 0;
     int i = 0;
@@ -379,10 +383,8 @@ void P_LoadMacros(int lump) {
         return;
     }
 
-    data = (short*)W_GetMapLump(lump);
-
-    macros.macrocount = SHORT(*data++);
-    macros.specialcount = SHORT(*data++);
+    macros.macrocount = SHORT(data[d++]);
+    macros.specialcount = SHORT(data[d++]);
     macros.def = (macrodef_t*) Z_Calloc(macros.macrocount * sizeof(macrodef_t), PU_LEVEL, NULL);
 
     CON_DPrintf("%i macros\n", macros.macrocount);
@@ -390,16 +392,16 @@ void P_LoadMacros(int lump) {
     for(i = 0; i < macros.macrocount; i++) {
         macrodata_t* mdata;
 
-        macros.def[i].count = SHORT(*data++);
+        macros.def[i].count = SHORT(data[d++]);
         count = macros.def[i].count + 1;
 
         macros.def[i].data = (macrodata_t*) Z_Calloc(sizeof(macrodata_t) * count, PU_LEVEL, NULL);
         mdata = macros.def[i].data;
 
         for(j = 0; j < count; j++) {
-            mdata[j].id = SHORT(*data++);
-            mdata[j].tag = SHORT(*data++);
-            mdata[j].special = SHORT(*data++);
+            mdata[j].id = SHORT(data[d++]);
+            mdata[j].tag = SHORT(data[d++]);
+            mdata[j].special = SHORT(data[d++]);
         }
     }
 
@@ -415,26 +417,27 @@ void P_LoadNodes(int lump) {
     int         i;
     int         j;
     int         k;
-    mapnode_t*  mn;
+    MapLump<mapnode_t> mn(lump);
     node_t*     no;
 
-    numnodes = W_MapLumpLength(lump) / sizeof(mapnode_t);
+    numnodes = mn.size();
     nodes = (node_t*) Z_Malloc(numnodes*sizeof(node_t),PU_LEVEL,0);
 
     CON_DPrintf("%i nodes\n", numnodes);
 
-    mn = (mapnode_t *)W_GetMapLump(lump);
     no = nodes;
 
-    for(i=0 ; i<numnodes ; i++, no++, mn++) {
-        no->x = INT2F(SHORT(mn->x));
-        no->y = INT2F(SHORT(mn->y));
-        no->dx = INT2F(SHORT(mn->dx));
-        no->dy = INT2F(SHORT(mn->dy));
+    for(i=0 ; i<numnodes ; i++, no++) {
+        mapnode_t mnode = mn[i];
+
+        no->x = INT2F(SHORT(mnode.x));
+        no->y = INT2F(SHORT(mnode.y));
+        no->dx = INT2F(SHORT(mnode.dx));
+        no->dy = INT2F(SHORT(mnode.dy));
         for(j=0 ; j<2 ; j++) {
-            no->children[j] = SHORT(mn->children[j]);
+            no->children[j] = SHORT(mnode.children[j]);
             for(k=0 ; k<4 ; k++) {
-                no->bbox[j][k] = INT2F(SHORT(mn->bbox[j][k]));
+                no->bbox[j][k] = INT2F(SHORT(mnode.bbox[j][k]));
             }
         }
     }
@@ -447,27 +450,27 @@ void P_LoadNodes(int lump) {
 void P_LoadLeafs(int lump) {
     int         i;
     int         j;
-    short       *mlf;
+    MapLump<short> mlf(lump);
+    int         m;
     leaf_t      *lf;
     int         length;
     int         size;
     int         count;
     subsector_t *ss;
 
-    length = W_MapLumpLength(lump);
-    mlf = (short*) W_GetMapLump(lump);
+    length = mlf.size();
 
     count = 0;
     size = 0;
 
     if(length) {
-        short   *src = mlf;
+        int     src = 0;
         int     next;
 
-        while(((byte*)src - (byte*)mlf) < length) {
+        while(src < length) {
             count++;
-            size += (word)SHORT(*src);
-            next = (*src << 2) + 2;
+            size += (word)SHORT(mlf[src]);
+            next = (mlf[src] << 2) + 2;
             src += (next >> 1);
         }
     }
@@ -486,9 +489,10 @@ void P_LoadLeafs(int lump) {
     lf = leafs;
     ss = subsectors;
     count = 0;
+    m = 0;
 
     for(i = 0; i < numleafs; i++, ss++) {
-        ss->numleafs = (word)SHORT(*mlf++);
+        ss->numleafs = (word)SHORT(mlf[m++]);
         ss->leaf = (lf - leafs);
 
         if(ss->numleafs) {
@@ -496,14 +500,14 @@ void P_LoadLeafs(int lump) {
             int seg;
 
             for(j = 0; j < ss->numleafs; j++, lf++) {
-                vertex = (word)SHORT(*mlf++);
+                vertex = (word)SHORT(mlf[m++]);
                 if(vertex > numvertexes) {
                     I_Error("P_LoadLeafs: vertex out of range: %i - %i\n", vertex, numvertexes);
                 }
 
                 lf->vertex = &vertexes[vertex];
 
-                seg = SHORT(*mlf++);
+                seg = SHORT(mlf[m++]);
                 if(seg == -1) {
                     lf->seg = NULL;
                 }
@@ -531,7 +535,8 @@ void P_LoadLeafs(int lump) {
 void P_LoadThings(int lump) {
     int             i;
     int             j;
-    mapthing_t*     mt;
+    MapLump<mapthing_t> things(lump);
+    mapthing_t      mt;
     int             numthings;
     dboolean        p2start = false;
     dboolean        p3start = false;
@@ -541,71 +546,74 @@ void P_LoadThings(int lump) {
     dmemset(playerstarts,0,sizeof(playerstarts));
     deathmatch_p = deathmatchstarts;
 
-    numthings = W_MapLumpLength(lump) / sizeof(mapthing_t);
-    mt = (mapthing_t *)W_GetMapLump(lump);
+    numthings = things.size();
 
     CON_DPrintf("%i things\n", numthings);
 
     for(i = 0, j = 0; i < numthings; i++) {
-        if(SHORT(mt[i].options) & MTF_SPAWN) {
+        mt = things[i];
+
+        if(SHORT(mt.options) & MTF_SPAWN) {
             j++;
         }
 
         // 20120122 villsa - check if co-op starts exist
-        if(SHORT(mt[i].type) == 2) {
+        if(SHORT(mt.type) == 2) {
             p2start = true;
         }
 
-        if(SHORT(mt[i].type) == 3) {
+        if(SHORT(mt.type) == 3) {
             p3start = true;
         }
 
-        if(SHORT(mt[i].type) == 4) {
+        if(SHORT(mt.type) == 4) {
             p4start = true;
         }
     }
 
     spawnlist = (mapthing_t*) Z_Malloc(sizeof(mapthing_t) * j, PU_LEVEL, 0);
 
-    for(i = 0; i < numthings; i++, mt++) {
-        mt->x = SHORT(mt->x);
-        mt->y = SHORT(mt->y);
-        mt->z = SHORT(mt->z);
-        mt->angle = SHORT(mt->angle);
-        mt->type = SHORT(mt->type);
-        mt->options = SHORT(mt->options);
-        mt->tid = SHORT(mt->tid);
+    for(i = 0; i < numthings; i++) {
+        mt = things[i];
 
-        P_SpawnMapThing(mt);
+        mt.x = SHORT(mt.x);
+        mt.y = SHORT(mt.y);
+        mt.z = SHORT(mt.z);
+        mt.angle = SHORT(mt.angle);
+        mt.type = SHORT(mt.type);
+        mt.options = SHORT(mt.options);
+        mt.tid = SHORT(mt.tid);
+
+        P_SpawnMapThing(&mt);
 
         // [kex] Hack to force-spawn co-op player starts on top of player 1
         // 20120122 villsa - updated to spawn co-op players away from
         // player 1 by radius
-        if(netgame && mt->type == 1) {
-            short x = mt->x;
-            short y = mt->y;
+        if(netgame && mt.type == 1) {
+            short x = mt.x;
+            short y = mt.y;
 
             if(!p2start) {
-                mt->type = 2;
-                mt->x = x;
-                mt->y = y;
-                P_SpawnMapThing(mt);
+                mt.type = 2;
+                mt.x = x;
+                mt.y = y;
+                P_SpawnMapThing(&mt);
                 CON_Warnf("No free spot for player 2\n");
             }
 
             if(!p3start) {
-                mt->type = 3;
-                mt->x = x;
-                mt->y = y;
-                P_SpawnMapThing(mt);
+                mt.type = 3;
+                mt.x = x;
+                mt.y = y;
+                P_SpawnMapThing(&mt);
                 CON_Warnf("No free spot for player 3\n");
             }
 
             if(!p4start) {
-                mt->type = 4;
-                mt->x = x;
-                mt->y = y;
-                P_SpawnMapThing(mt);
+                mt.type = 4;
+                mt.x = x;
+                mt.y = y;
+                P_SpawnMapThing(&mt);
                 CON_Warnf("No free spot for player 4\n");
             }
         }
@@ -620,25 +628,27 @@ void P_LoadThings(int lump) {
 
 void P_LoadLineDefs(int lump) {
     int                 i;
-    maplinedef_t*       mld;
+    MapLump<maplinedef_t> mlds(lump);
+    maplinedef_t        mld;
     line_t*             ld;
     vertex_t*           v1;
     vertex_t*           v2;
 
-    numlines = W_MapLumpLength(lump) / sizeof(maplinedef_t);
+    numlines = mlds.size();
     lines = (line_t*) Z_Malloc(numlines*sizeof(line_t),PU_LEVEL,0);
     dmemset(lines, 0, numlines*sizeof(line_t));
 
     CON_DPrintf("%i linedefs\n", numlines);
 
-    mld = (maplinedef_t *)W_GetMapLump(lump);
     ld = lines;
-    for(i=0 ; i<numlines ; i++, mld++, ld++) {
-        ld->flags = mld->flags;
-        ld->special = mld->special;
-        ld->tag = SHORT(mld->tag);
-        v1 = ld->v1 = &vertexes[(word)SHORT(mld->v1)];
-        v2 = ld->v2 = &vertexes[(word)SHORT(mld->v2)];
+    for(i=0 ; i<numlines ; i++, ld++) {
+        mld = mlds[i];
+
+        ld->flags = mld.flags;
+        ld->special = mld.special;
+        ld->tag = SHORT(mld.tag);
+        v1 = ld->v1 = &vertexes[(word)SHORT(mld.v1)];
+        v2 = ld->v2 = &vertexes[(word)SHORT(mld.v2)];
         ld->dx = v2->x - v1->x;
         ld->dy = v2->y - v1->y;
 
@@ -681,8 +691,8 @@ void P_LoadLineDefs(int lump) {
             ld->bbox[BOXTOP] = v1->y;
         }
 
-        ld->sidenum[0] = (word)SHORT(mld->sidenum[0]);
-        ld->sidenum[1] = (word)SHORT(mld->sidenum[1]);
+        ld->sidenum[0] = (word)SHORT(mld.sidenum[0]);
+        ld->sidenum[1] = (word)SHORT(mld.sidenum[1]);
 
         if(ld->sidenum[0] != NO_SIDE_INDEX) {
             ld->frontsector = sides[ld->sidenum[0]].sector;
@@ -707,24 +717,26 @@ void P_LoadLineDefs(int lump) {
 
 void P_LoadSideDefs(int lump) {
     int                 i;
-    mapsidedef_t*       msd;
+    MapLump<mapsidedef_t> msds(lump);
+    mapsidedef_t        msd;
     side_t*             sd;
 
-    numsides = W_MapLumpLength(lump) / sizeof(mapsidedef_t);
+    numsides = msds.size();
     sides = (side_t*) Z_Malloc(numsides*sizeof(side_t),PU_LEVEL,0);
     dmemset(sides, 0, numsides*sizeof(side_t));
 
     CON_DPrintf("%i sidedefs\n", numsides);
 
-    msd = (mapsidedef_t *)W_GetMapLump(lump);
     sd = sides;
-    for(i=0 ; i<numsides ; i++, msd++, sd++) {
-        sd->textureoffset = INT2F(SHORT(msd->textureoffset));
-        sd->rowoffset = INT2F(SHORT(msd->rowoffset));
-        sd->toptexture = P_GetTextureHashKey(msd->toptexture);
-        sd->bottomtexture = P_GetTextureHashKey(msd->bottomtexture);
-        sd->midtexture = P_GetTextureHashKey(msd->midtexture);
-        sd->sector = &sectors[SHORT(msd->sector)];
+    for(i=0 ; i<numsides ; i++, sd++) {
+        msd = msds[i];
+
+        sd->textureoffset = INT2F(SHORT(msd.textureoffset));
+        sd->rowoffset = INT2F(SHORT(msd.rowoffset));
+        sd->toptexture = P_GetTextureHashKey(msd.toptexture);
+        sd->bottomtexture = P_GetTextureHashKey(msd.bottomtexture);
+        sd->midtexture = P_GetTextureHashKey(msd.midtexture);
+        sd->sector = &sectors[SHORT(msd.sector)];
     }
 }
 
@@ -737,8 +749,7 @@ void P_LoadReject(int lump) {
 
     size = W_MapLumpLength(lump);
     rejectmatrix = (byte*)Z_Malloc(size, PU_LEVEL, 0);
-    dmemset(rejectmatrix, 0, size);
-    dmemcpy(rejectmatrix, (byte*)W_GetMapLump(lump), size);
+    dmemcpy(rejectmatrix, W_GetMapLump(lump), size);
 }
 
 static const char *bmaperrormsg;
@@ -748,18 +759,24 @@ static const char *bmaperrormsg;
 //
 // haleyjd 03/04/10: do verification on validity of blockmap.
 //
+
 static dboolean P_VerifyBlockMap(int count) {
     dboolean isvalid = true;
     int x, y;
-    short *maxoffs = blockmaplump + count;
+    int *maxoffs = blockmaplump + count;
 
     bmaperrormsg = NULL;
 
+    if(count < 4 || bmapwidth <= 0 || bmapheight <= 0) {
+        bmaperrormsg = "bad header";
+        return false;
+    }
+
     for(y = 0; y < bmapheight; ++y) {
         for(x = 0; x < bmapwidth; ++x) {
             int offset;
-            short *list, *tmplist;
-            short *blockoffset;
+            int *list, *tmplist;
+            int *blockoffset;
 
             offset = y * bmapwidth + x;
             blockoffset = blockmaplump + offset + 4;
@@ -772,6 +789,13 @@ static dboolean P_VerifyBlockMap(int count) {
             }
 
             offset = *blockoffset;
+
+            if(offset < 4 || offset >= count) {
+                isvalid = false;
+                bmaperrormsg = "offset out of range";
+                break;
+            }
+
             list   = blockmaplump + offset;
 
             // scan forward for a -1 terminator before maxoffs
@@ -812,43 +836,264 @@ static dboolean P_VerifyBlockMap(int count) {
     return isvalid;
 }
 
+//
+// P_AddLineToBlocks
+// Adds the line to every block it passes through or touches. Each block
+// column the line crosses gets the span of rows the line covers within
+// that column, so corner cases err on the side of an extra block. With
+// no cells, only the counts are bumped.
+//
+
+static void P_AddLineToBlocks(line_t *line, int orgx, int orgy,
+                              int *starts, int *cells, int *counts) {
+    double x1, y1, x2, y2;
+    int bx1, bx2;
+    int bx;
+
+    x1 = (double)(line->v1->x >> FRACBITS) - orgx;
+    y1 = (double)(line->v1->y >> FRACBITS) - orgy;
+    x2 = (double)(line->v2->x >> FRACBITS) - orgx;
+    y2 = (double)(line->v2->y >> FRACBITS) - orgy;
+
+    if(x2 < x1) {
+        double t;
+
+        t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+    }
+
+    bx1 = (int)x1 / MAPBLOCKUNITS;
+    bx2 = (int)x2 / MAPBLOCKUNITS;
+
+    for(bx = bx1; bx <= bx2; bx++) {
+        double xa = MAX(x1, (double)(bx * MAPBLOCKUNITS));
+        double xb = MIN(x2, (double)((bx + 1) * MAPBLOCKUNITS));
+        double ya;
+        double yb;
+        int by1;
+        int by2;
+        int by;
+
+        if(x2 == x1) {
+            ya = y1;
+            yb = y2;
+        }
+        else {
+            ya = y1 + (xa - x1) * (y2 - y1) / (x2 - x1);
+            yb = y1 + (xb - x1) * (y2 - y1) / (x2 - x1);
+        }
+
+        by1 = (int)MIN(ya, yb) / MAPBLOCKUNITS;
+        by2 = (int)MAX(ya, yb) / MAPBLOCKUNITS;
+
+        for(by = by1; by <= by2; by++) {
+            int block;
+
+            if(bx >= bmapwidth || by >= bmapheight) {
+                continue;
+            }
+
+            block = by * bmapwidth + bx;
+
+            if(cells) {
+                cells[starts[block] + counts[block]] = line - lines;
+            }
+
+            counts[block]++;
+        }
+    }
+}
+
+//
+// P_CreateBlockMap
+// Builds a blockmap from the linedefs, for maps without a usable BLOCKMAP.
+// Every block list starts with line 0 like the ones made by the map tools,
+// and blocks with identical lists share them.
+//
+
+static void P_CreateBlockMap(void) {
+    fixed_t minx;
+    fixed_t miny;
+    fixed_t maxx;
+    fixed_t maxy;
+    int orgx;
+    int orgy;
+    int numblocks;
+    int *counts;
+    int *starts;
+    int *cells;
+    int *hashes;
+    int *offsets;
+    int hashsize;
+    int total;
+    int size;
+    int i;
+
+    minx = miny = D_MAXINT;
+    maxx = maxy = D_MININT;
+
+    for(i = 0; i < numvertexes; i++) {
+        minx = MIN(minx, vertexes[i].x);
+        miny = MIN(miny, vertexes[i].y);
+        maxx = MAX(maxx, vertexes[i].x);
+        maxy = MAX(maxy, vertexes[i].y);
+    }
+
+    orgx = minx >> FRACBITS;
+    orgy = miny >> FRACBITS;
+    bmapwidth = (((maxx >> FRACBITS) - orgx) / MAPBLOCKUNITS) + 1;
+    bmapheight = (((maxy >> FRACBITS) - orgy) / MAPBLOCKUNITS) + 1;
+    numblocks = bmapwidth * bmapheight;
+
+    //
+    // count the lines in each block, then fill the lists in a second pass
+    //
+    counts = (int*)Z_Calloc(numblocks * sizeof(int), PU_STATIC, 0);
+
+    for(i = 0; i < numlines; i++) {
+        P_AddLineToBlocks(&lines[i], orgx, orgy, NULL, NULL, counts);
+    }
+
+    starts = (int*)Z_Malloc((numblocks + 1) * sizeof(int), PU_STATIC, 0);
+    total = 0;
+
+    for(i = 0; i < numblocks; i++) {
+        starts[i] = total;
+        total += counts[i];
+        counts[i] = 0;
+    }
+
+    starts[numblocks] = total;
+    cells = (int*)Z_Malloc(MAX(total, 1) * sizeof(int), PU_STATIC, 0);
+
+    for(i = 0; i < numlines; i++) {
+        P_AddLineToBlocks(&lines[i], orgx, orgy, starts, cells, counts);
+    }
+
+    //
+    // assign list offsets, sharing identical lists through a hash table
+    //
+    for(hashsize = 1; hashsize < numblocks * 2; hashsize <<= 1);
+
+    hashes = (int*)Z_Malloc(hashsize * sizeof(int), PU_STATIC, 0);
+    offsets = (int*)Z_Malloc(numblocks * sizeof(int), PU_STATIC, 0);
+
+    for(i = 0; i < hashsize; i++) {
+        hashes[i] = -1;
+    }
+
+    size = 4 + numblocks;
+
+    for(i = 0; i < numblocks; i++) {
+        unsigned int hash = 2166136261u;
+        int *list = cells + starts[i];
+        int j;
+        int h;
+
+        for(j = 0; j < counts[i]; j++) {
+            hash = (hash ^ list[j]) * 16777619u;
+        }
+
+        for(h = hash & (hashsize - 1); hashes[h] != -1; h = (h + 1) & (hashsize - 1)) {
+            int other = hashes[h];
+
+            if(counts[other] == counts[i] &&
+                    !memcmp(cells + starts[other], list, counts[i] * sizeof(int))) {
+                break;
+            }
+        }
+
+        if(hashes[h] != -1) {
+            offsets[i] = offsets[hashes[h]];
+            continue;
+        }
+
+        hashes[h] = i;
+        offsets[i] = size;
+        size += counts[i] + 2;
+    }
+
+    blockmaplump = (int*)Z_Malloc(size * sizeof(int), PU_LEVEL, NULL);
+    blockmaplump[0] = orgx;
+    blockmaplump[1] = orgy;
+    blockmaplump[2] = bmapwidth;
+    blockmaplump[3] = bmapheight;
+
+    for(i = 0; i < numblocks; i++) {
+        int *list = blockmaplump + offsets[i];
+
+        blockmaplump[4 + i] = offsets[i];
+
+        list[0] = 0;
+        dmemcpy(list + 1, cells + starts[i], counts[i] * sizeof(int));
+        list[counts[i] + 1] = -1;
+    }
+
+    bmaporgx = INT2F(orgx);
+    bmaporgy = INT2F(orgy);
+
+    Z_Free(counts);
+    Z_Free(starts);
+    Z_Free(cells);
+    Z_Free(hashes);
+    Z_Free(offsets);
+
+    CON_DPrintf("P_CreateBlockMap: %ix%i blocks, %i entries\n", bmapwidth, bmapheight, size);
+}
 
 //
 // P_LoadBlockMap
+// Offsets and line numbers in the lump are read as unsigned, so lumps up
+// to 64k entries work. Anything missing, bigger or broken gets rebuilt.
 //
 
 void P_LoadBlockMap(int lump) {
     int         i;
     int         count;
-    void*       mapdata;
-    size_t      len;
-
-    mapdata = W_GetMapLump(lump);
-    len = W_MapLumpLength(lump);
+    MapLump<short> mapdata(lump);
 
-    //
-    // GhostlyDeath <10/3/11> -- Reallocate and copy since
-    // W_GetMapLump() doesn't quite work like we want it to on 64-bit
-    // it works, just the way it is laid out
-    //
-    blockmaplump = (short*) Z_Malloc(len, PU_LEVEL, NULL);
-    memmove(blockmaplump, mapdata, len);
-    blockmap = blockmaplump + 4;
-    count = len / 2;
+    count = mapdata.size();
 
-    for(i = 0; i < count; i++) {
-        blockmaplump[i] = SHORT(blockmaplump[i]);
+    if(M_CheckParm("-blockmap") || count < 4 || count > 0x10000) {
+        P_CreateBlockMap();
     }
+    else {
+        //
+        // Swap straight from the map data into zone memory
+        //
+        blockmaplump = (int*) Z_Malloc(count * sizeof(int), PU_LEVEL, NULL);
+
+        blockmaplump[0] = SHORT(mapdata[0]);
+        blockmaplump[1] = SHORT(mapdata[1]);
+        blockmaplump[2] = (word)SHORT(mapdata[2]);
+        blockmaplump[3] = (word)SHORT(mapdata[3]);
+
+        bmapwidth = blockmaplump[2];
+        bmapheight = blockmaplump[3];
 
-    bmaporgx = INT2F(blockmaplump[0]);
-    bmaporgy = INT2F(blockmaplump[1]);
-    bmapwidth = blockmaplump[2];
-    bmapheight = blockmaplump[3];
+        for(i = 4; i < count; i++) {
+            int v = (word)SHORT(mapdata[i]);
 
-    if(!P_VerifyBlockMap(count)) {
-        I_Error("P_LoadBlockMap: Bad blockmap - %s", bmaperrormsg);
+            // past the offset table, 0xffff ends a list
+            if(v == 0xffff && i >= 4 + bmapwidth * bmapheight) {
+                v = -1;
+            }
+
+            blockmaplump[i] = v;
+        }
+
+        bmaporgx = INT2F(blockmaplump[0]);
+        bmaporgy = INT2F(blockmaplump[1]);
+
+        if(!P_VerifyBlockMap(count)) {
+            CON_Warnf("P_LoadBlockMap: Bad blockmap (%s), rebuilding\n", bmaperrormsg);
+            Z_Free(blockmaplump);
+            P_CreateBlockMap();
+        }
     }
 
+    blockmap = blockmaplump + 4;
+
     // clear out mobj chains
     count = sizeof(*blocklinks)* bmapwidth*bmapheight;
     blocklinks = (mobj_t**) Z_Malloc(count,PU_LEVEL, 0);
@@ -969,11 +1214,11 @@ void P_SetupSky(void) {
     skyflatnum  = wad::find(sky->flat)->section_index();
 
     if(sky->pic[0]) {
-        skypicnum = wad::find(sky->pic)->lump_index();
+        skypicnum = GL_GfxLump(sky->pic);
     }
 
     if(sky->backdrop[0]) {
-        skybackdropnum = wad::find(sky->backdrop)->lump_index();
+        skybackdropnum = GL_GfxLump(sky->backdrop);
     }
 
     if(sky->flags & SKF_FIRE) {
@@ -1017,6 +1262,9 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
 
     CON_DPrintf("--------P_SetupLevel--------\n");
 
+    // the level is about to change under the prep thread
+    R_PrepFinish();
+
     // [kex] 12/26/11 - don't reset total stats when loading a savegame
     if(gameaction != ga_loadgame) {
         totalkills = totalitems = totalsecret = 0;
@@ -1035,6 +1283,7 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     M_ClearRandom();
 
     P_InitThinkers();
+    P_InvalidateSights();
 
     // [kex] 12/26/11 - don't reset leveltime when loading a savegame
     if(gameaction != ga_loadgame) {
@@ -1052,6 +1301,7 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     P_LoadSectors(ML_SECTORS);
     P_LoadSideDefs(ML_SIDEDEFS);
     P_LoadLineDefs(ML_LINEDEFS);
+    P_InitTagLists();
     P_LoadSubsectors(ML_SSECTORS);
     P_LoadBlockMap(ML_BLOCKMAP);
     P_LoadNodes(ML_NODES);
@@ -1060,6 +1310,7 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     P_LoadReject(ML_REJECT);
     P_LoadLights(ML_LIGHTS);
     P_GroupLines();
+    P_LoadPVS();
     P_LoadThings(ML_THINGS);
     W_FreeMapLump();
 
@@ -27,11 +27,17 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <functional>
+
 #include "doomdef.h"
 #include "m_fixed.h"
 #include "i_system.h"
 #include "p_local.h"
 #include "doomstat.h"
+#include "z_zone.h"
+#include "p_pvs.h"
+#include "con_console.h"
 
 //
 // P_CheckSight
@@ -44,7 +50,45 @@ divline_t   strace;             // from t1 to t2
 fixed_t     t2x;
 fixed_t     t2y;
 
-int         sightcounts[2];
+int         sightcounts[3];     // rejected, traced, cached
+
+BoolProperty p_pvssightcheck("p_pvssightcheck", "Report sights the PVS would wrongly reject", false);
+
+//
+// Sight results only depend on where the two things are and on the
+// sector heights, so they are cached by position. sightgeneration bumps
+// whenever a plane moves or the level changes, which drops every entry.
+//
+
+#define SIGHTCACHESIZE  4096
+
+typedef struct {
+    fixed_t     x1;
+    fixed_t     y1;
+    fixed_t     z1;
+    fixed_t     h1;
+    fixed_t     x2;
+    fixed_t     y2;
+    fixed_t     z2;
+    fixed_t     h2;
+    unsigned    generation;
+    dboolean    result;
+} sightcache_t;
+
+static sightcache_t sightcache[SIGHTCACHESIZE];
+static unsigned     sightgeneration = 1;
+
+//
+// While tracing a batch of sights towards the same target, which side of
+// each node and line the target is on doesn't change, so it is kept
+// here for the whole batch. targetstamp changes per target.
+//
+
+static byte         *nodesides = NULL;
+static unsigned     *nodestamps = NULL;
+static byte         *linesides = NULL;
+static unsigned     *linestamps = NULL;
+static unsigned     targetstamp = 0;
 
 
 //
@@ -189,7 +233,13 @@ dboolean P_CrossSubsector(int num) {
         divl.dx = v2->x - v1->x;
         divl.dy = v2->y - v1->y;
         s1 = P_DivlineSide(strace.x, strace.y, &divl);
-        s2 = P_DivlineSide(t2x, t2y, &divl);
+
+        if(linestamps[line - lines] != targetstamp) {
+            linestamps[line - lines] = targetstamp;
+            linesides[line - lines] = P_DivlineSide(t2x, t2y, &divl);
+        }
+
+        s2 = linesides[line - lines];
 
         // line isn't crossed?
         if(s1 == s2) {
@@ -292,8 +342,13 @@ dboolean P_CrossBSPNode(int bspnum) {
         return false;
     }
 
+    if(nodestamps[bspnum] != targetstamp) {
+        nodestamps[bspnum] = targetstamp;
+        nodesides[bspnum] = P_DivlineSide(t2x, t2y, (divline_t *)bsp);
+    }
+
     // the partition plane is crossed here
-    if(side == P_DivlineSide(t2x, t2y,(divline_t *)bsp)) {
+    if(side == nodesides[bspnum]) {
         // the line doesn't touch the other side
         return true;
     }
@@ -304,17 +359,67 @@ dboolean P_CrossBSPNode(int bspnum) {
 
 
 //
-// P_CheckSight
+// P_InvalidateSights
+// Called when sector planes move or the level changes
+//
+
+void P_InvalidateSights(void) {
+    sightgeneration++;
+}
+
+//
+// P_NewSightTarget
+// Starts a batch of sight checks towards a new target
+//
+
+static void P_NewSightTarget(void) {
+    if(!nodestamps) {
+        Z_Calloc(numnodes * sizeof(unsigned), PU_LEVEL, &nodestamps);
+        Z_Malloc(numnodes, PU_LEVEL, &nodesides);
+        Z_Calloc(numlines * sizeof(unsigned), PU_LEVEL, &linestamps);
+        Z_Malloc(numlines, PU_LEVEL, &linesides);
+        targetstamp = 0;
+    }
+
+    if(++targetstamp == 0) {
+        dmemset(nodestamps, 0, numnodes * sizeof(unsigned));
+        dmemset(linestamps, 0, numlines * sizeof(unsigned));
+        targetstamp = 1;
+    }
+}
+
+//
+// P_SightCacheEntry
+//
+
+static sightcache_t *P_SightCacheEntry(mobj_t* t1, mobj_t* t2) {
+    unsigned hash;
+
+    hash = (unsigned)t1->x * 31 + (unsigned)t1->y;
+    hash = hash * 31 + (unsigned)t1->z;
+    hash = hash * 31 + (unsigned)t2->x;
+    hash = hash * 31 + (unsigned)t2->y;
+    hash = hash * 31 + (unsigned)t2->z;
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6d;
+    hash ^= hash >> 12;
+
+    return &sightcache[hash & (SIGHTCACHESIZE - 1)];
+}
+
+//
+// P_TraceSight
 // Returns true if a straight line between t1 and t2 is unobstructed.
 // Uses REJECT.
 //
 
-dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
-    int     s1;
-    int     s2;
-    int     pnum;
-    int     bytenum;
-    int     bitnum;
+static dboolean P_TraceSight(mobj_t* t1, mobj_t* t2) {
+    int         s1;
+    int         s2;
+    int         pnum;
+    int         bytenum;
+    int         bitnum;
+    dboolean    result;
 
     // First check for trivial rejection.
 
@@ -351,18 +456,77 @@ dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode(numnodes-1);
+    result = P_CrossBSPNode(numnodes-1);
+
+    // the PVS doesn't decide sight until it is known never to hide
+    // something the trace can see; this looks for cases where it would
+    if(p_pvssightcheck && result && P_HavePVS() &&
+            !P_CheckPVS(t2->subsector, t1->subsector) &&
+            P_PointInLeafs(t1->subsector, t1->x, t1->y) &&
+            P_PointInLeafs(t2->subsector, t2->x, t2->y)) {
+        CON_Warnf("P_TraceSight: PVS of subsector %i hides subsector %i, which is in sight\n",
+                  (int)(t2->subsector - subsectors), (int)(t1->subsector - subsectors));
+    }
+
+    return result;
+}
+
+//
+// P_CachedSight
+// Checks the cache before tracing. The caller sets up the target batch.
+//
+
+static dboolean P_CachedSight(mobj_t* t1, mobj_t* t2) {
+    sightcache_t *c = P_SightCacheEntry(t1, t2);
+
+    if(c->generation == sightgeneration &&
+            c->x1 == t1->x && c->y1 == t1->y && c->z1 == t1->z && c->h1 == t1->height &&
+            c->x2 == t2->x && c->y2 == t2->y && c->z2 == t2->z && c->h2 == t2->height) {
+        sightcounts[2]++;
+        return c->result;
+    }
+
+    c->x1 = t1->x;
+    c->y1 = t1->y;
+    c->z1 = t1->z;
+    c->h1 = t1->height;
+    c->x2 = t2->x;
+    c->y2 = t2->y;
+    c->z2 = t2->z;
+    c->h2 = t2->height;
+    c->generation = sightgeneration;
+    c->result = P_TraceSight(t1, t2);
+
+    return c->result;
+}
+
+//
+// P_CheckSight
+// Returns true if a straight line between t1 and t2 is unobstructed.
+//
+
+dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
+    P_NewSightTarget();
+    return P_CachedSight(t1, t2);
 }
 
 //
 // P_ScanSights
 // Optimal mobj sight checking that check sights
 // in main tick loop rather from multiple
-// mobj action routines
+// mobj action routines. Checks are batched by
+// target so they share the target's side of
+// every node and line they cross.
 //
 
 void P_ScanSights(void) {
+    static mobj_t** scan = NULL;
+    static int maxscan = 0;
     mobj_t* mobj;
+    int numscan;
+    int i;
+
+    numscan = 0;
 
     for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
         // must be killable
@@ -382,11 +546,29 @@ void P_ScanSights(void) {
             continue;
         }
 
-        if(!P_CheckSight(mobj, mobj->target)) {
-            continue;
+        if(numscan == maxscan) {
+            maxscan = maxscan ? maxscan * 2 : 64;
+            scan = (mobj_t**)Z_Realloc(scan, maxscan * sizeof(mobj_t*), PU_STATIC, NULL);
         }
 
-        mobj->flags |= MF_SEETARGET;
+        scan[numscan++] = mobj;
     }
-}
 
+    // group by target in one sort; the results don't depend on the
+    // order, only on the positions
+    std::stable_sort(scan, scan + numscan, [](const mobj_t* a, const mobj_t* b) {
+        return std::less<const mobj_t*>()(a->target, b->target);
+    });
+
+    for(i = 0; i < numscan; i++) {
+        mobj = scan[i];
+
+        if(i == 0 || mobj->target != scan[i - 1]->target) {
+            P_NewSightTarget();
+        }
+
+        if(P_CachedSight(mobj, mobj->target)) {
+            mobj->flags |= MF_SEETARGET;
+        }
+    }
+}
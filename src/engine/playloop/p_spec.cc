@@ -155,6 +155,16 @@ static void P_InitAnimdef(void) {
 
 animinfo_t* animinfo;
 
+// animinfo indices whose base texture the level uses
+static int* activeanims;
+static int  numactiveanims;
+
+// sectors with MS_SCROLLFLOOR or MS_SCROLLCEILING set
+static sector_t**   scrollsectors;
+static int          numscrollsectors;
+
+specialstats_t specialstats;
+
 //
 //      Animating line specials
 //
@@ -177,6 +187,7 @@ void P_InitPicAnims(void) {
         animinfo[i].tic = 0;
         animinfo[i].isreverse = false;
         animinfo[i].texnum = wad::find(animdefs[i].name)->section_index();
+        animdefs[i].texnum = animinfo[i].texnum;
         animinfo[i].frame = -1;
 
         // reallocate texture pointers if they contain multiple palettes
@@ -201,9 +212,9 @@ void P_CyclePicAnims(void) {
     int i = 0;
     int lastpic = 0;
 
-    for(i = 0; i < numanimdef; i++) {
-        anim = &animdefs[i];
-        info = &animinfo[i];
+    for(i = 0; i < numactiveanims; i++) {
+        anim = &animdefs[activeanims[i]];
+        info = &animinfo[activeanims[i]];
 
         if(info->delay) {
             info->delay--;
@@ -253,6 +264,59 @@ void P_CyclePicAnims(void) {
 }
 
 
+//
+// P_InitActiveAnims
+// Only animations of textures the level can show need to run.
+// Sides, sectors and the other state of a switch cover every
+// texture a line or sector special can swap in.
+//
+
+static void P_MarkAnimTexture(byte* used, int texnum) {
+    if(texnum < 0 || texnum >= numtextures) {
+        return;
+    }
+
+    used[texnum] = 1;
+
+    if(swx_start != -1 && texnum >= swx_start) {
+        texnum = swx_start + ((texnum - swx_start) ^ 1);
+
+        if(texnum < numtextures) {
+            used[texnum] = 1;
+        }
+    }
+}
+
+static void P_InitActiveAnims(void) {
+    byte* used;
+    int i;
+
+    used = (byte*)Z_Calloc(MAX(numtextures, 1), PU_STATIC, 0);
+
+    for(i = 0; i < numsides; i++) {
+        P_MarkAnimTexture(used, sides[i].toptexture);
+        P_MarkAnimTexture(used, sides[i].midtexture);
+        P_MarkAnimTexture(used, sides[i].bottomtexture);
+    }
+
+    for(i = 0; i < numsectors; i++) {
+        P_MarkAnimTexture(used, sectors[i].floorpic);
+        P_MarkAnimTexture(used, sectors[i].ceilingpic);
+    }
+
+    activeanims = (int*)Z_Malloc(MAX(numanimdef, 1) * sizeof(int), PU_LEVEL, &activeanims);
+    numactiveanims = 0;
+
+    for(i = 0; i < numanimdef; i++) {
+        if(animinfo[i].texnum < numtextures && used[animinfo[i].texnum]) {
+            activeanims[numactiveanims++] = i;
+        }
+    }
+
+    Z_Free(used);
+}
+
+
 //
 // UTILITIES
 //
@@ -471,53 +535,186 @@ fixed_t    P_FindHighestCeilingSurrounding(sector_t* sec) {
 
 
 //
-// P_FindSectorFromLineTag
-// RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
+// TAG LISTS
+// Sector and line numbers grouped by tag, each group in index
+// order, so the tag lookups below only visit matching entries.
+// No special changes a tag at runtime; the lists are rebuilt
+// when a savegame restores them.
 //
 
-int P_FindSectorFromLineTag(line_t* line, int start) {
-    int    i;
+typedef struct {
+    int     tag;
+    int     first;      // into members
+    int     count;
+} tagentry_t;
 
-    for(i = start + 1; i < numsectors; i++) {
-        if(sectors[i].tag == line->tag) {
-            return i;
-        }
+typedef struct {
+    tagentry_t* entries;
+    int*        members;
+    int         numentries;
+} taglist_t;
+
+static taglist_t sectortags;
+static taglist_t linetags;
+
+//
+// P_CompareTagPairs
+// Sorts tag, index pairs by tag, then index
+//
+
+static int P_CompareTagPairs(const void* a, const void* b) {
+    const int* x = (const int*)a;
+    const int* y = (const int*)b;
+
+    if(x[0] != y[0]) {
+        return x[0] < y[0] ? -1 : 1;
     }
-    return -1;
+
+    return x[1] - y[1];
 }
 
+//
+// P_BuildTagList
+// pairs holds count tag, index pairs and is sorted in place
+//
+
+static void P_BuildTagList(taglist_t* list, int* pairs, int count) {
+    tagentry_t* entry;
+    int i;
+
+    if(list->entries) {
+        Z_Free(list->entries);
+    }
+    if(list->members) {
+        Z_Free(list->members);
+    }
+
+    qsort(pairs, count, sizeof(int) * 2, P_CompareTagPairs);
+
+    list->entries = (tagentry_t*)Z_Malloc(MAX(count, 1) * sizeof(tagentry_t), PU_LEVEL, &list->entries);
+    list->members = (int*)Z_Malloc(MAX(count, 1) * sizeof(int), PU_LEVEL, &list->members);
+    list->numentries = 0;
+
+    entry = NULL;
+    for(i = 0; i < count; i++) {
+        if(!entry || entry->tag != pairs[i * 2]) {
+            entry = &list->entries[list->numentries++];
+            entry->tag = pairs[i * 2];
+            entry->first = i;
+            entry->count = 0;
+        }
+
+        list->members[i] = pairs[i * 2 + 1];
+        entry->count++;
+    }
+}
 
 //
-// P_FindLinedefFromTag
+// P_InitTagLists
+// Called once the level's sectors and lines are loaded,
+// and again after a savegame restores their tags
 //
 
-int P_FindLinedefFromTag(int tag) {
-    int i = 0;
+void P_InitTagLists(void) {
+    int* pairs;
+    int i;
+
+    pairs = (int*)Z_Malloc(MAX(MAX(numsectors, numlines), 1) * sizeof(int) * 2, PU_STATIC, 0);
+
+    for(i = 0; i < numsectors; i++) {
+        pairs[i * 2] = sectors[i].tag;
+        pairs[i * 2 + 1] = i;
+    }
+
+    P_BuildTagList(&sectortags, pairs, numsectors);
 
     for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == tag) {
-            return i;
-        }
+        pairs[i * 2] = lines[i].tag;
+        pairs[i * 2 + 1] = i;
     }
 
-    return -1;
+    P_BuildTagList(&linetags, pairs, numlines);
+
+    Z_Free(pairs);
 }
 
 //
-// P_FindSectorFromTag
-// Simplier version of P_FindSectorFromLineTag
+// P_NextTagged
+// Returns the lowest index above start with the given tag, or -1
 //
 
-int P_FindSectorFromTag(int tag) {
-    int i = 0;
+static int P_NextTagged(taglist_t* list, int tag, int start) {
+    tagentry_t* entry;
+    int* members;
+    int lo;
+    int hi;
+    int mid;
 
-    for(i = 0; i < numsectors; i++) {
-        if(sectors[i].tag == tag) {
-            return i;
+    lo = 0;
+    hi = list->numentries;
+    entry = NULL;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+
+        if(list->entries[mid].tag < tag) {
+            lo = mid + 1;
+        }
+        else if(list->entries[mid].tag > tag) {
+            hi = mid;
+        }
+        else {
+            entry = &list->entries[mid];
+            break;
+        }
+    }
+
+    if(!entry) {
+        return -1;
+    }
+
+    members = list->members + entry->first;
+    lo = 0;
+    hi = entry->count;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+
+        if(members[mid] <= start) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
         }
     }
 
-    return -1;
+    return lo < entry->count ? members[lo] : -1;
+}
+
+//
+// P_FindSectorFromLineTag
+// RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
+//
+
+int P_FindSectorFromLineTag(line_t* line, int start) {
+    return P_NextTagged(&sectortags, line->tag, start);
+}
+
+//
+// P_FindLinedefFromTag
+//
+
+int P_FindLinedefFromTag(int tag) {
+    return P_NextTagged(&linetags, tag, -1);
+}
+
+//
+// P_FindSectorFromTag
+// Simplier version of P_FindSectorFromLineTag
+//
+
+int P_FindSectorFromTag(int tag) {
+    return P_NextTagged(&sectortags, tag, -1);
 }
 
 //
@@ -527,10 +724,8 @@ int P_FindSectorFromTag(int tag) {
 dboolean P_ActivateLineByTag(int tag, mobj_t* activator) {
     int i;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == tag) {
-            return P_UseSpecialLine(activator, &lines[i], 0);
-        }
+    if((i = P_NextTagged(&linetags, tag, -1)) >= 0) {
+        return P_UseSpecialLine(activator, &lines[i], 0);
     }
 
     return 1;
@@ -559,57 +754,55 @@ static int P_ModifyLine(int tag1, int tag2, int type) {
     
     line2 = &lines[linenum];
 
-    for(i = 0; i < numlines; i++) {
+    for(i = P_NextTagged(&linetags, tag1, -1); i >= 0; i = P_NextTagged(&linetags, tag1, i)) {
         line1 = &lines[i];
-        if(line1->tag == tag1) {
-            switch(type) {
-            case modl_flags:
-                if(line1->flags & ML_TWOSIDED) {
-                    line1->flags = (line2->flags | ML_TWOSIDED);
-                }
-                else {
-                    line1->flags = line2->flags;
-                    line1->flags &= ~ML_TWOSIDED;
-                }
-                break;
-            case modl_texture:
-                sides[line1->sidenum[0]].bottomtexture = sides[line2->sidenum[0]].bottomtexture;
-                sides[line1->sidenum[0]].midtexture = sides[line2->sidenum[0]].midtexture;
-                sides[line1->sidenum[0]].toptexture = sides[line2->sidenum[0]].toptexture;
-
-                if(line1->flags & ML_TWOSIDED || line1->sidenum[1] != NO_SIDE_INDEX) {
-                    sides[line1->sidenum[1]].bottomtexture = sides[line2->sidenum[1]].bottomtexture;
-                    sides[line1->sidenum[1]].midtexture = sides[line2->sidenum[1]].midtexture;
-                    sides[line1->sidenum[1]].toptexture = sides[line2->sidenum[1]].toptexture;
-                }
-
-                if(line1->flags & ML_SWITCHX02 &&
-                        !sides[line1->sidenum[0]].toptexture) {
-                    line1->flags &= ~ML_SWITCHX02;
-                }
+        switch(type) {
+        case modl_flags:
+            if(line1->flags & ML_TWOSIDED) {
+                line1->flags = (line2->flags | ML_TWOSIDED);
+            }
+            else {
+                line1->flags = line2->flags;
+                line1->flags &= ~ML_TWOSIDED;
+            }
+            break;
+        case modl_texture:
+            sides[line1->sidenum[0]].bottomtexture = sides[line2->sidenum[0]].bottomtexture;
+            sides[line1->sidenum[0]].midtexture = sides[line2->sidenum[0]].midtexture;
+            sides[line1->sidenum[0]].toptexture = sides[line2->sidenum[0]].toptexture;
+
+            if(line1->flags & ML_TWOSIDED || line1->sidenum[1] != NO_SIDE_INDEX) {
+                sides[line1->sidenum[1]].bottomtexture = sides[line2->sidenum[1]].bottomtexture;
+                sides[line1->sidenum[1]].midtexture = sides[line2->sidenum[1]].midtexture;
+                sides[line1->sidenum[1]].toptexture = sides[line2->sidenum[1]].toptexture;
+            }
 
-                if(line1->flags & (ML_SWITCHX04 | ML_SWITCHX08) &&
-                        !sides[line1->sidenum[0]].bottomtexture) {
-                    line1->flags &= ~(ML_SWITCHX04 | ML_SWITCHX08);
-                }
+            if(line1->flags & ML_SWITCHX02 &&
+                    !sides[line1->sidenum[0]].toptexture) {
+                line1->flags &= ~ML_SWITCHX02;
+            }
 
-                if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX04) &&
-                        !sides[line1->sidenum[0]].midtexture) {
-                    line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX04);
-                }
+            if(line1->flags & (ML_SWITCHX04 | ML_SWITCHX08) &&
+                    !sides[line1->sidenum[0]].bottomtexture) {
+                line1->flags &= ~(ML_SWITCHX04 | ML_SWITCHX08);
+            }
 
-                if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX08) &&
-                        !sides[line1->sidenum[0]].toptexture) {
-                    line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX08);
-                }
+            if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX04) &&
+                    !sides[line1->sidenum[0]].midtexture) {
+                line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX04);
+            }
 
-                break;
-            case modl_data:
-                line1->special = line2->special;
-                break;
-            default:
-                break;
+            if(line1->flags & (ML_SWITCHX02 | ML_SWITCHX08) &&
+                    !sides[line1->sidenum[0]].toptexture) {
+                line1->flags &= ~(ML_SWITCHX02 | ML_SWITCHX08);
             }
+
+            break;
+        case modl_data:
+            line1->special = line2->special;
+            break;
+        default:
+            break;
         }
     }
 
@@ -665,6 +858,7 @@ static int P_ModifySector(line_t *line, int tag, int type) {
                 break;
             case mods_flags:
                 sec1->flags = sec2->flags;
+                P_UpdateScrollSector(sec1);
                 break;
             default:
                 break;
@@ -725,9 +919,8 @@ int P_RandomLineTrigger(line_t* line, mobj_t* thing, int side) {
     int i = 0;
     int count = 0;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == line->tag &&
-                SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
+    for(i = P_NextTagged(&linetags, line->tag, -1); i >= 0; i = P_NextTagged(&linetags, line->tag, i)) {
+        if(SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
             count++;
         }
     }
@@ -738,9 +931,8 @@ int P_RandomLineTrigger(line_t* line, mobj_t* thing, int side) {
     linelist = (line_t **)Z_Malloc(count*sizeof(line_t *), PU_LEVEL, NULL);
     randLine = linelist;
 
-    for(i = 0; i < numlines; i++) {
-        if(lines[i].tag == line->tag &&
-                SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
+    for(i = P_NextTagged(&linetags, line->tag, -1); i >= 0; i = P_NextTagged(&linetags, line->tag, i)) {
+        if(SPECIALMASK(lines[i].special) != SPECIALMASK(line->special)) {
             *randLine++ = &lines[i];
         }
     }
@@ -774,7 +966,7 @@ void T_CountdownTimer(void *data) {
 void P_SpawnDelayTimer(line_t* line, void (*func)(void)) {
     delay_t* timer;
 
-    timer = (delay_t*) Z_Malloc(sizeof(*timer), PU_LEVSPEC, 0);
+    timer = (delay_t*) Z_PoolAlloc(sizeof(*timer));
     P_AddThinker(&timer->thinker);
     timer->thinker.function.acp1 = (actionf_p1)T_CountdownTimer;
     timer->tics = line->tag;
@@ -807,7 +999,7 @@ static void P_SpawnQuake(void *data) {
     line_t* line = (line_t*) data;
     quake_t* quake;
 
-    quake = (quake_t*) Z_Malloc(sizeof(*quake), PU_LEVSPEC, 0);
+    quake = (quake_t*) Z_PoolAlloc(sizeof(*quake));
     P_AddThinker(&quake->thinker);
     quake->thinker.function.acp1 = (actionf_p1)T_Quake;
     quake->tics = line->tag;
@@ -824,12 +1016,7 @@ static void P_AlertTaggedMobj(mobj_t *activator, int tid) {
     player_t *player;
     state_t* st;
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
-        // not matching the tid
-        if(mo->tid != tid) {
-            continue;
-        }
-
+    for(mo = P_FindMobjFromTID(tid, NULL); mo; mo = P_FindMobjFromTID(tid, mo)) {
         if(!mo->info->seestate) {
             continue;
         }
@@ -912,12 +1099,7 @@ int P_SetAimCamera(player_t* player, line_t* line, dboolean aim) {
     P_ClearUserCamera(player);
     player->cheats |= CF_LOCKCAM;
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
-        // not matching the tid
-        if(mo->tid != line->tag) {
-            continue;
-        }
-
+    for(mo = P_FindMobjFromTID(line->tag, NULL); mo; mo = P_FindMobjFromTID(line->tag, mo)) {
         // skip if cameratarget matches tag
         if(player->cameratarget->tid == line->tag) {
             continue;
@@ -942,7 +1124,7 @@ int P_SetAimCamera(player_t* player, line_t* line, dboolean aim) {
 
         mo->angle = R_PointToAngle2(mo->x, mo->y, player->mo->x, player->mo->y);
 
-        camera = (aimcamera_t*) Z_Malloc(sizeof(*camera), PU_LEVSPEC, 0);
+        camera = (aimcamera_t*) Z_PoolAlloc(sizeof(*camera));
         P_AddThinker(&camera->thinker);
         camera->thinker.function.acp1 = (actionf_p1)T_LookAtCamera;
         camera->viewmobj = mo;
@@ -1002,17 +1184,12 @@ void T_MovingCamera(void *data) {
     //
     // jump to next camera spot
     //
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+    for(mo = P_FindMobjFromTID(camera->current, NULL); mo; mo = P_FindMobjFromTID(camera->current, mo)) {
         // not a camera
         if(mo->type != MT_CAMERA) {
             continue;
         }
 
-        // must match tid
-        if(mo->tid != camera->current) {
-            continue;
-        }
-
         camera->slopex = (mo->x - camtarget->x) / CAMMOVESPEED;
         camera->slopey = (mo->y - camtarget->y) / CAMMOVESPEED;
         camera->slopez = (mo->z - camtarget->z) / CAMMOVESPEED;
@@ -1043,7 +1220,7 @@ void P_SetMovingCamera(player_t* player, line_t* line) {
         return;
     }
 
-    camera = (movecamera_t*) Z_Malloc(sizeof(*camera), PU_LEVSPEC, 0);
+    camera = (movecamera_t*) Z_PoolAlloc(sizeof(*camera));
     P_AddThinker(&camera->thinker);
     camera->thinker.function.acp1 = (actionf_p1)T_MovingCamera;
 
@@ -1052,12 +1229,7 @@ void P_SetMovingCamera(player_t* player, line_t* line) {
         player->cheats |= CF_LOCKCAM;
     }
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
-        // not matching the tid
-        if(mo->tid != line->tag) {
-            continue;
-        }
-
+    for(mo = P_FindMobjFromTID(line->tag, NULL); mo; mo = P_FindMobjFromTID(line->tag, mo)) {
         // setup moving camera
         camera->x = mo->x;
         camera->y = mo->y;
@@ -1092,12 +1264,7 @@ static dboolean P_ModifyMobjFlags(int tid, int flags) {
     mobj_t* mo;
     dboolean ok = false;
 
-    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
-        // not matching the tid
-        if(mo->tid != tid) {
-            continue;
-        }
-
+    for(mo = P_FindMobjFromTID(tid, NULL); mo; mo = P_FindMobjFromTID(tid, mo)) {
         ok = true;
 
         mo->flags &= ~flags;
@@ -1855,6 +2022,7 @@ extern short    numlinespecials;
 
 void P_UpdateSpecials(void) {
     int         i;
+    int         pending;
     line_t*     line;
     sector_t*   sector;
 
@@ -1869,6 +2037,11 @@ void P_UpdateSpecials(void) {
     // ANIMATE FLATS AND TEXTURES GLOBALLY
     P_CyclePicAnims();
 
+    specialstats.anims = numactiveanims;
+    specialstats.lines = numlinespecials;
+    specialstats.sectors = numscrollsectors;
+    specialstats.buttons = numactivebuttons;
+
     // ANIMATE LINE SPECIALS
     for(i = 0; i < numlinespecials; i++) {
         line = linespeciallist[i];
@@ -1890,33 +2063,30 @@ void P_UpdateSpecials(void) {
     }
 
     // UPDATE SCROLLING FLATS
-    for(i = 0; i < numsectors; i++) {
-        sector = &sectors[i];
-
-        if(sector->flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
-            fixed_t speed;
+    for(i = 0; i < numscrollsectors; i++) {
+        fixed_t speed;
 
-            if(sector->flags & MS_SCROLLFAST) {
-                speed = 3*FRACUNIT;
-            }
-            else {
-                speed = FRACUNIT;
-            }
+        sector = scrollsectors[i];
 
-            if(sector->flags & MS_SCROLLLEFT) {
-                sector->xoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLRIGHT) {
-                sector->xoffset -= speed;
-            }
-            if(sector->flags & MS_SCROLLUP) {
-                sector->yoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLDOWN) {
-                sector->yoffset -= speed;
-            }
+        if(sector->flags & MS_SCROLLFAST) {
+            speed = 3*FRACUNIT;
+        }
+        else {
+            speed = FRACUNIT;
         }
 
+        if(sector->flags & MS_SCROLLLEFT) {
+            sector->xoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLRIGHT) {
+            sector->xoffset -= speed;
+        }
+        if(sector->flags & MS_SCROLLUP) {
+            sector->yoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLDOWN) {
+            sector->yoffset -= speed;
+        }
     }
 
     // SKY TICKER
@@ -1925,10 +2095,13 @@ void P_UpdateSpecials(void) {
     }
 
     // DO BUTTONS
-    for(i = 0; i < MAXBUTTONS; i++) {
+    for(i = 0, pending = numactivebuttons; i < MAXBUTTONS && pending; i++) {
         if(buttonlist[i].btimer) {
+            pending--;
             buttonlist[i].btimer--;
             if(!buttonlist[i].btimer) {
+                numactivebuttons--;
+
                 switch(buttonlist[i].where) {
                 case top:
                     sides[buttonlist[i].line->sidenum[0]].toptexture =
@@ -1970,6 +2143,52 @@ void P_UpdateSpecials(void) {
 line_t**    linespeciallist;
 short       numlinespecials;
 
+//
+// P_UpdateScrollSector
+// Adds or removes a sector from the scrolling set after its flags change
+//
+
+void P_UpdateScrollSector(sector_t* sector) {
+    int i;
+
+    for(i = 0; i < numscrollsectors; i++) {
+        if(scrollsectors[i] == sector) {
+            break;
+        }
+    }
+
+    if(sector->flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
+        if(i == numscrollsectors) {
+            scrollsectors[numscrollsectors++] = sector;
+        }
+    }
+    else if(i < numscrollsectors) {
+        scrollsectors[i] = scrollsectors[--numscrollsectors];
+    }
+}
+
+//
+// P_InitScrollSectors
+// Called when specials are spawned and after a savegame
+// restores sector flags
+//
+
+void P_InitScrollSectors(void) {
+    int i;
+
+    if(!scrollsectors) {
+        scrollsectors = (sector_t**)Z_Malloc(MAX(numsectors, 1) * sizeof(sector_t*), PU_LEVEL, &scrollsectors);
+    }
+
+    numscrollsectors = 0;
+
+    for(i = 0; i < numsectors; i++) {
+        if(sectors[i].flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
+            scrollsectors[numscrollsectors++] = &sectors[i];
+        }
+    }
+}
+
 void P_AddSectorSpecial(sector_t* sector) {
     if(!sector->special) {
         return;
@@ -2085,6 +2304,8 @@ void P_SpawnSpecials(void) {
         animinfo[i].isreverse = false;
     }
 
+    P_InitActiveAnims();
+
     // Init special sectors
     // Might as well count all the secrets while we're at it..
     sector = sectors;
@@ -2158,5 +2379,9 @@ void P_SpawnSpecials(void) {
     for(i = 0; i < MAXBUTTONS; i++) {
         dmemset(&buttonlist[i],0,sizeof(button_t));
     }
+
+    numactivebuttons = 0;
+
+    P_InitScrollSectors();
 }
 
@@ -42,14 +42,29 @@ typedef struct {
     int         speed;
     bool        reverse;
     bool        palette;
+    int         texnum;     // first frame, set by P_InitPicAnims
 } animdef_t;
 
 extern int          numanimdef;
 extern animdef_t*   animdefs;
 
+//
+// Work done by P_UpdateSpecials on the last tic
+//
+typedef struct {
+    int     anims;          // animated textures used by the level
+    int     lines;          // scrolling lines
+    int     sectors;        // scrolling sectors
+    int     buttons;        // pending button timers
+} specialstats_t;
+
+extern specialstats_t specialstats;
+
 void        P_InitPicAnims(void);       // at game start
 void        P_SpawnSpecials(void);      // at map load
 void        P_UpdateSpecials(void);     // every tic
+void        P_InitScrollSectors(void);
+void        P_UpdateScrollSector(sector_t* sector);
 int         P_DoSpecialLine(mobj_t* thing, line_t* line, int side);
 void        P_AddSectorSpecial(sector_t* sector);
 void        P_SpawnDelayTimer(line_t* line, void (*func)(void));
@@ -68,6 +83,7 @@ fixed_t     P_FindHighestFloorSurrounding(sector_t* sec);
 fixed_t     P_FindNextHighestFloor(sector_t* sec, int currentheight);
 fixed_t     P_FindLowestCeilingSurrounding(sector_t* sec);
 fixed_t     P_FindHighestCeilingSurrounding(sector_t* sec);
+void        P_InitTagLists(void);
 int         P_FindSectorFromLineTag(line_t* line, int start);
 dboolean    P_ActivateLineByTag(int tag, mobj_t* activator);
 
@@ -146,6 +162,11 @@ typedef struct {
     int inc;
 } lightmorph_t;
 
+typedef struct {
+    thinker_t thinker;
+    float factor;
+} fadebright_t;
+
 #define GLOWSPEED           2
 #define STROBEBRIGHT        1
 #define SUPERFAST           10
@@ -172,6 +193,7 @@ void        P_CombineLightSpecials(void* sector);
 void        T_Combine(void* combine);
 dboolean    P_ChangeLightByTag(int tag1, int tag2);
 int         P_DoSectorLightChange(line_t* line, short tag);
+void        T_FadeInBrightness(void* fb);
 void        P_FadeInBrightness(void);
 
 
@@ -204,6 +226,7 @@ typedef struct {
 #define BUTTONTIME      15
 
 extern button_t    buttonlist[MAXBUTTONS];
+extern int         numactivebuttons;
 
 void P_ChangeSwitchTexture(line_t* line, int useAgain);
 
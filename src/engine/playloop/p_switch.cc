@@ -39,6 +39,7 @@
 
 
 button_t buttonlist[MAXBUTTONS];
+int      numactivebuttons;   // slots with btimer set
 
 
 //
@@ -62,6 +63,7 @@ void P_StartButton(line_t* line, bwhere_e w, int texture, int time) {
             buttonlist[i].where = w;
             buttonlist[i].btexture = texture;
             buttonlist[i].btimer = time;
+            numactivebuttons++;
 
             if(SWITCHMASK(line->flags)) {
                 buttonlist[i].soundorg = (mobj_t *)&line->frontsector->soundorg;
@@ -67,6 +67,17 @@ mobj_t      mobjhead;        // Both the head and tail of the mobj list.
 mobj_t      *currentmobj;
 thinker_t   *currentthinker;
 
+//
+// Mobjs with a tid are also chained by tid hash, in the same order
+// as the mobj list, so tid lookups only visit matching mobjs
+//
+
+#define TIDHASHSIZE     128
+#define TIDHASH(tid)    ((unsigned int)(tid) & (TIDHASHSIZE - 1))
+
+static mobj_t   *tidhead[TIDHASHSIZE];
+static mobj_t   *tidtail[TIDHASHSIZE];
+
 
 //
 // P_InitThinkers
@@ -75,6 +86,7 @@ thinker_t   *currentthinker;
 void P_InitThinkers(void) {
     thinkercap.prev = thinkercap.next  = &thinkercap;
     mobjhead.next = mobjhead.prev = &mobjhead;
+    P_ClearMobjTIDs();
 }
 
 //
@@ -99,7 +111,7 @@ static void P_UnlinkThinker(void *data) {
     thinker_t* next = currentthinker->next;
     (next->prev = currentthinker = thinker->prev)->next = next;
 
-    Z_Free(thinker);
+    Z_PoolFree(thinker);
 }
 
 //
@@ -114,6 +126,106 @@ void P_RemoveThinker(void *data) {
     P_MacroDetachThinker(thinker);
 }
 
+//
+// P_LinkTID
+//
+
+static void P_LinkTID(mobj_t* mobj) {
+    unsigned int hash = TIDHASH(mobj->tid);
+
+    mobj->tidnext = NULL;
+    mobj->tidprev = tidtail[hash];
+
+    if(tidtail[hash]) {
+        tidtail[hash]->tidnext = mobj;
+    }
+    else {
+        tidhead[hash] = mobj;
+    }
+
+    tidtail[hash] = mobj;
+}
+
+//
+// P_UnlinkTID
+//
+
+static void P_UnlinkTID(mobj_t* mobj) {
+    unsigned int hash = TIDHASH(mobj->tid);
+
+    if(mobj->tidprev) {
+        mobj->tidprev->tidnext = mobj->tidnext;
+    }
+    else {
+        tidhead[hash] = mobj->tidnext;
+    }
+
+    if(mobj->tidnext) {
+        mobj->tidnext->tidprev = mobj->tidprev;
+    }
+    else {
+        tidtail[hash] = mobj->tidprev;
+    }
+
+    mobj->tidnext = mobj->tidprev = NULL;
+}
+
+//
+// P_ClearMobjTIDs
+//
+
+void P_ClearMobjTIDs(void) {
+    dmemset(tidhead, 0, sizeof(tidhead));
+    dmemset(tidtail, 0, sizeof(tidtail));
+}
+
+//
+// P_SetMobjTID
+// Chains are kept in mobj list order by appending, so this
+// should be called right after the mobj is spawned
+//
+
+void P_SetMobjTID(mobj_t* mobj, int tid) {
+    if(mobj->tid) {
+        P_UnlinkTID(mobj);
+    }
+
+    mobj->tid = tid;
+
+    if(tid) {
+        P_LinkTID(mobj);
+    }
+}
+
+//
+// P_FindMobjFromTID
+// Returns the next mobj after start (or the first one if start
+// is NULL) with a matching tid, in mobj list order
+//
+
+mobj_t* P_FindMobjFromTID(int tid, mobj_t* start) {
+    mobj_t* mo;
+
+    // untagged mobjs aren't chained
+    if(!tid) {
+        for(mo = start ? start->next : mobjhead.next; mo != &mobjhead; mo = mo->next) {
+            if(!mo->tid) {
+                return mo;
+            }
+        }
+
+        return NULL;
+    }
+
+    for(mo = start ? start->tidnext : tidhead[TIDHASH(tid)]; mo; mo = mo->tidnext) {
+        if(mo->tid == tid) {
+            return mo;
+        }
+    }
+
+    return NULL;
+}
+
 //
 // P_LinkMobj
 //
@@ -124,6 +236,10 @@ void P_LinkMobj(void *data) {
     mobj->next = &mobjhead;
     mobj->prev = mobjhead.prev;
     mobjhead.prev = mobj;
+
+    if(mobj->tid) {
+        P_LinkTID(mobj);
+    }
 }
 
 //
@@ -140,6 +256,10 @@ void P_UnlinkMobj(void *data) {
     * point it to mobj->prev, so the iterator will correctly move on to
     * mobj->prev->next = mobj->next */
     (next->prev = currentmobj = mobj->prev)->next = next;
+
+    if(mobj->tid) {
+        P_UnlinkTID(mobj);
+    }
 }
 
 //
@@ -246,8 +366,6 @@ static void P_UpdateFrameStates(void) {
 
         sector->frame_z1[0] = sector->floorheight;
         sector->frame_z2[0] = sector->ceilingheight;
-        sector->frame_z1[1] = sector->frame_z1[0];
-        sector->frame_z2[1] = sector->frame_z1[0];
     }
 
     //
@@ -337,6 +455,9 @@ void P_Stop(void) {
         ST_ClearDamageMarkers();
     }
 
+    // the prep thread may still be reading the level
+    R_PrepFinish();
+
     // free level tags
     Z_FreeTags(PU_LEVEL, PU_PURGELEVEL-1);
 
@@ -356,7 +477,7 @@ void P_Stop(void) {
     }
 
     // do wipe/melt effect
-    if(gameaction != ga_loadgame) {
+    if(gameaction != ga_loadgame && !timingdemo) {
         if(r_wipe) {
             if(gameaction != ga_warpquick) {
                 WIPE_MeltScreen();
@@ -412,6 +533,7 @@ void P_Drawer(void) {
 //
 
 bool P_Ticker(void) {
+    uint64_t phasetic;
     int i;
 
     if(i_interpolateframes) {
@@ -439,11 +561,19 @@ bool P_Ticker(void) {
         }
     }
 
+    P_ResetTraceStats();
+
+    phasetic = timingdemo ? I_GetTimeUS() : 0;
     P_RunThinkers();
+    phasetic = G_TimeDemoPhase(TDP_THINKERS, phasetic);
     P_ScanSights();
+    phasetic = G_TimeDemoPhase(TDP_SIGHTS, phasetic);
     P_RunMobjs();
+    phasetic = G_TimeDemoPhase(TDP_MOBJS, phasetic);
     P_UpdateSpecials();
+    phasetic = G_TimeDemoPhase(TDP_SPECIALS, phasetic);
     P_RunMacros();
+    G_TimeDemoPhase(TDP_MACROS, phasetic);
 
     ST_Ticker();
     AM_Ticker();
@@ -0,0 +1,588 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Static geometry batches.
+// Every wall piece and flat of the level gets a fixed slot in a per-texture
+// vertex array when the level is set up. Visible slots only have their
+// colors refreshed and their indices queued each frame; geometry is
+// rewritten (and re-uploaded to the vertex buffer) only when a sector
+// moves or a side's texture offsets change.
+//
+//-----------------------------------------------------------------------------
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "r_local.h"
+#include "r_lights.h"
+#include "r_sky.h"
+#include "r_batch.h"
+#include "gl_main.h"
+#include "dgl.h"
+#include "con_console.h"
+#include "i_system.h"
+#include "z_zone.h"
+
+BoolProperty r_staticbatch("r_staticbatch", "Draw level geometry from static batches", true);
+BoolProperty r_batchstats("r_batchstats", "Print static batch counts every frame", false);
+
+extern BoolProperty r_drawtris;
+
+#define MAXBATCHVERTS   0x10000
+
+typedef struct {
+    int         texid;
+    int         numverts;
+    vtx_t       *verts;
+    dword       buffer;         // vertex buffer object, 0 if drawn from verts
+    int         dirtylo;
+    int         dirtyhi;
+    word        *indices;
+    int         numindices;
+    int         maxindices;
+    int         drawverts;
+    dboolean    pending;
+} batch_t;
+
+typedef struct {
+    int         batch;          // -1 if this wall piece/flat has no slot
+    int         first;
+    int         texid;
+    fixed_t     z;              // plane height the flat was last written at
+    dboolean    valid;          // wall geometry has been written once
+} batchslot_t;
+
+batchstats_t batchstats;
+
+static batchstats_t curstats;
+
+static batch_t      *batches = NULL;
+static int          numbatches = 0;
+static batchslot_t  *batchslots = NULL;
+static int          *pendingbatches = NULL;
+static int          numpending = 0;
+
+// buffer names are kept out of PU_LEVEL so they can be deleted on the next level
+static dword        *batchbuffers = NULL;
+static int          numbatchbuffers = 0;
+
+//
+// FlatHeight
+// Height as of the view snapshot (see R_InterpolateSectors)
+//
+
+static fixed_t FlatHeight(sector_t *sector, dboolean ceiling) {
+    return ceiling ? sector->frame_z2[1] : sector->frame_z1[1];
+}
+
+//
+// BatchActive
+//
+
+static dboolean BatchActive(void) {
+    return batchslots != NULL && r_staticbatch && !r_drawtris;
+}
+
+//
+// WallTexture
+// Returns the texture of a seg piece (0 = lower, 1 = upper, 2 = middle)
+// or -1 if it never gets drawn
+//
+
+static int WallTexture(seg_t *line, int sidetype) {
+    int texid;
+
+    if(!line->linedef) {
+        return -1;
+    }
+
+    switch(sidetype) {
+    case 0:
+        texid = line->backsector ? line->sidedef->bottomtexture : 1;
+        break;
+    case 1:
+        texid = line->backsector ? line->sidedef->toptexture : 1;
+        break;
+    default:
+        texid = line->sidedef->midtexture;
+        break;
+    }
+
+    return texid == 1 ? -1 : texid;
+}
+
+//
+// FlatTexture
+//
+
+static int FlatTexture(subsector_t *sub, dboolean ceiling) {
+    int texid;
+
+    if(sub->numleafs < 3) {
+        return -1;
+    }
+
+    texid = ceiling ? sub->sector->ceilingpic : sub->sector->floorpic;
+    return texid == skyflatnum ? -1 : texid;
+}
+
+//
+// AssignSlot
+// Reserves count vertices for a slot in the current batch of its texture,
+// starting a new batch when the texture's batch would overflow word indices
+//
+
+static void AssignSlot(batchslot_t *slot, int *texbatch, int texid, int count, int numindices) {
+    batch_t *batch;
+    int b = texbatch[texid];
+
+    if(b == -1 || batches[b].numverts + count > MAXBATCHVERTS) {
+        b = numbatches++;
+        Z_Realloc(batches, numbatches * sizeof(batch_t), PU_LEVEL, &batches);
+        dmemset(&batches[b], 0, sizeof(batch_t));
+        batches[b].texid = texid;
+        texbatch[texid] = b;
+    }
+
+    batch = &batches[b];
+
+    slot->batch = b;
+    slot->first = batch->numverts;
+    slot->texid = texid;
+    slot->valid = false;
+
+    batch->numverts += count;
+    batch->maxindices += numindices;
+}
+
+//
+// FillFlat
+// Same mapping as ProcessFlats, minus lighting and scrolling
+//
+
+static void FillFlat(batchslot_t *slot, subsector_t *sub, dboolean ceiling) {
+    vtx_t *v;
+    leaf_t *leaf;
+    fixed_t tx;
+    fixed_t ty;
+    int j;
+
+    v = &batches[slot->batch].verts[slot->first];
+    leaf = &leafs[sub->leaf];
+
+    tx = (leaf->vertex->x >> 6) & ~(FRACUNIT - 1);
+    ty = (leaf->vertex->y >> 6) & ~(FRACUNIT - 1);
+
+    slot->z = FlatHeight(sub->sector, ceiling);
+
+    for(j = 0; j < sub->numleafs; j++, v++) {
+        if(ceiling) {
+            leaf = &leafs[(sub->leaf + (sub->numleafs - 1)) - j];
+        }
+        else {
+            leaf = &leafs[sub->leaf + j];
+        }
+
+        v->x = F2D3D(leaf->vertex->x);
+        v->y = F2D3D(leaf->vertex->y);
+        v->z = F2D3D(slot->z);
+        v->tu = F2D3D((leaf->vertex->x >> 6) - tx);
+        v->tv = -F2D3D((leaf->vertex->y >> 6) - ty);
+        v->a = 0xff;
+    }
+
+    slot->valid = true;
+}
+
+//
+// R_BuildLevelBatches
+//
+
+void R_BuildLevelBatches(void) {
+    int i;
+    int j;
+    int maxtex;
+    int texid;
+    int *texbatch;
+    int numslots;
+    int staticverts;
+
+    // buffers from the previous level
+    if(numbatchbuffers) {
+        dglDeleteBuffersARB(numbatchbuffers, batchbuffers);
+        Z_Free(batchbuffers);
+        batchbuffers = NULL;
+        numbatchbuffers = 0;
+    }
+
+    batches = NULL;
+    numbatches = 0;
+    numpending = 0;
+    dmemset(&batchstats, 0, sizeof(batchstats));
+    dmemset(&curstats, 0, sizeof(curstats));
+
+    // walls take three slots per seg, flats two per subsector
+    numslots = numsegs * 3 + numsubsectors * 2;
+    Z_Malloc(numslots * sizeof(batchslot_t), PU_LEVEL, &batchslots);
+
+    maxtex = 0;
+    for(i = 0; i < numsegs; i++) {
+        for(j = 0; j < 3; j++) {
+            maxtex = MAX(maxtex, WallTexture(&segs[i], j) + 1);
+        }
+    }
+    for(i = 0; i < numsubsectors; i++) {
+        for(j = 0; j < 2; j++) {
+            maxtex = MAX(maxtex, FlatTexture(&subsectors[i], j) + 1);
+        }
+    }
+
+    texbatch = (int*)Z_Malloc(MAX(maxtex, 1) * sizeof(int), PU_STATIC, NULL);
+    for(i = 0; i < maxtex; i++) {
+        texbatch[i] = -1;
+    }
+
+    for(i = 0; i < numslots; i++) {
+        batchslots[i].batch = -1;
+    }
+
+    for(i = 0; i < numsegs; i++) {
+        for(j = 0; j < 3; j++) {
+            if((texid = WallTexture(&segs[i], j)) >= 0) {
+                AssignSlot(&batchslots[i * 3 + j], texbatch, texid, 4, 6);
+            }
+        }
+    }
+
+    for(i = 0; i < numsubsectors; i++) {
+        for(j = 0; j < 2; j++) {
+            if((texid = FlatTexture(&subsectors[i], j)) >= 0) {
+                AssignSlot(&batchslots[numsegs * 3 + i * 2 + j], texbatch, texid,
+                           subsectors[i].numleafs, (subsectors[i].numleafs - 2) * 3);
+            }
+        }
+    }
+
+    Z_Free(texbatch);
+
+    staticverts = 0;
+    for(i = 0; i < numbatches; i++) {
+        batches[i].verts = (vtx_t*)Z_Calloc(batches[i].numverts * sizeof(vtx_t), PU_LEVEL, 0);
+        batches[i].indices = (word*)Z_Malloc(batches[i].maxindices * sizeof(word), PU_LEVEL, 0);
+        staticverts += batches[i].numverts;
+    }
+
+    Z_Malloc(MAX(numbatches, 1) * sizeof(int), PU_LEVEL, &pendingbatches);
+
+    for(i = 0; i < numsubsectors; i++) {
+        for(j = 0; j < 2; j++) {
+            batchslot_t *slot = &batchslots[numsegs * 3 + i * 2 + j];
+
+            if(slot->batch != -1) {
+                FillFlat(slot, &subsectors[i], j);
+            }
+        }
+    }
+
+    //
+    // wall pieces are filled in the first time they are drawn, since
+    // their texture mapping comes from the seg generators in r_bsp
+    //
+    if(GLAD_GL_ARB_vertex_buffer_object && numbatches) {
+        numbatchbuffers = numbatches;
+        batchbuffers = (dword*)Z_Malloc(numbatches * sizeof(dword), PU_STATIC, NULL);
+        dglGenBuffersARB(numbatches, batchbuffers);
+
+        for(i = 0; i < numbatches; i++) {
+            batches[i].buffer = batchbuffers[i];
+            dglBindBufferARB(GL_ARRAY_BUFFER_ARB, batches[i].buffer);
+            dglBufferDataARB(GL_ARRAY_BUFFER_ARB, batches[i].numverts * sizeof(vtx_t),
+                             batches[i].verts, GL_DYNAMIC_DRAW_ARB);
+        }
+
+        dglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    }
+
+    batchstats.numbatches = curstats.numbatches = numbatches;
+    batchstats.staticverts = curstats.staticverts = staticverts;
+
+    CON_DPrintf("R_BuildLevelBatches: %i batches, %i vertices\n", numbatches, staticverts);
+}
+
+//
+// R_BatchWallSlot
+//
+
+int R_BatchWallSlot(seg_t *line, int sidetype) {
+    int slot;
+
+    if(!batchslots || sidetype < 0 || sidetype > 2) {
+        return -1;
+    }
+
+    slot = (line - segs) * 3 + sidetype;
+    return batchslots[slot].batch == -1 ? -1 : slot;
+}
+
+//
+// R_BatchFlatSlot
+//
+
+int R_BatchFlatSlot(subsector_t *sub, dboolean ceiling) {
+    int slot;
+
+    if(!batchslots) {
+        return -1;
+    }
+
+    slot = numsegs * 3 + (sub - subsectors) * 2 + (ceiling ? 1 : 0);
+    return batchslots[slot].batch == -1 ? -1 : slot;
+}
+
+//
+// MarkDirty
+//
+
+static void MarkDirty(batch_t *batch, int first, int count) {
+    if(batch->dirtyhi <= batch->dirtylo) {
+        batch->dirtylo = first;
+        batch->dirtyhi = first + count;
+        return;
+    }
+
+    batch->dirtylo = MIN(batch->dirtylo, first);
+    batch->dirtyhi = MAX(batch->dirtyhi, first + count);
+}
+
+//
+// AddTriangle
+//
+
+static void AddTriangle(batch_t *batch, int v0, int v1, int v2) {
+    if(batch->numindices + 3 > batch->maxindices) {
+        I_Error("AddTriangle: Batch indice overflow (texture %i)", batch->texid);
+    }
+
+    batch->indices[batch->numindices++] = v0;
+    batch->indices[batch->numindices++] = v1;
+    batch->indices[batch->numindices++] = v2;
+}
+
+//
+// QueueBatch
+//
+
+static void QueueBatch(int b, int count) {
+    batch_t *batch = &batches[b];
+
+    if(!batch->pending) {
+        batch->pending = true;
+        pendingbatches[numpending++] = b;
+    }
+
+    batch->drawverts += count;
+    curstats.verts += count;
+}
+
+//
+// R_BatchWall
+// Called with the vertices just produced by the seg generator. Returns
+// false if the piece still has to be drawn from drawVertex.
+//
+
+dboolean R_BatchWall(vtxlist_t *vl, vtx_t *v) {
+    batchslot_t *slot;
+    batch_t *batch;
+    vtx_t *bv;
+    dboolean changed;
+    int i;
+
+    if(!BatchActive()) {
+        return false;
+    }
+
+    if(vl->batch < 0) {
+        curstats.fallbacks++;
+        return false;
+    }
+
+    slot = &batchslots[vl->batch];
+
+    // switches swap side textures at runtime
+    if(slot->texid != (int)(vl->texid & 0xffff)) {
+        curstats.fallbacks++;
+        return false;
+    }
+
+    batch = &batches[slot->batch];
+    bv = &batch->verts[slot->first];
+    changed = !slot->valid;
+
+    for(i = 0; i < 4 && !changed; i++) {
+        if(bv[i].x != v[i].x || bv[i].y != v[i].y || bv[i].z != v[i].z ||
+                bv[i].tu != v[i].tu || bv[i].tv != v[i].tv) {
+            changed = true;
+        }
+    }
+
+    dmemcpy(bv, v, sizeof(vtx_t) * 4);
+
+    if(changed) {
+        MarkDirty(batch, slot->first, 4);
+        slot->valid = true;
+    }
+
+    AddTriangle(batch, slot->first + 0, slot->first + 1, slot->first + 2);
+    AddTriangle(batch, slot->first + 3, slot->first + 2, slot->first + 1);
+    QueueBatch(slot->batch, 4);
+
+    return true;
+}
+
+//
+// R_BatchFlat
+// Returns false if the flat still has to be built into drawVertex
+//
+
+dboolean R_BatchFlat(vtxlist_t *vl) {
+    subsector_t *sub;
+    sector_t *sector;
+    batchslot_t *slot;
+    batch_t *batch;
+    dboolean ceiling;
+    fixed_t z;
+    vtx_t *v;
+    int j;
+
+    if(!BatchActive()) {
+        return false;
+    }
+
+    if(vl->batch < 0) {
+        curstats.fallbacks++;
+        return false;
+    }
+
+    sub = (subsector_t*)vl->data;
+    sector = sub->sector;
+    ceiling = (vl->flags & DLF_CEILING) != 0;
+    slot = &batchslots[vl->batch];
+
+    // liquid and scrolling planes change their mapping every frame
+    if(slot->texid != (int)(vl->texid & 0xffff) ||
+            (vl->flags & (DLF_WATER1|DLF_WATER2)) ||
+            (sector->flags & (ceiling ? MS_SCROLLCEILING : MS_SCROLLFLOOR))) {
+        curstats.fallbacks++;
+        return false;
+    }
+
+    batch = &batches[slot->batch];
+    v = &batch->verts[slot->first];
+    z = FlatHeight(sector, ceiling);
+
+    if(z != slot->z) {
+        slot->z = z;
+
+        for(j = 0; j < sub->numleafs; j++) {
+            v[j].z = F2D3D(z);
+        }
+
+        MarkDirty(batch, slot->first, sub->numleafs);
+    }
+
+    R_LightToVertex(v, sector->colors[ceiling ? LIGHT_CEILING : LIGHT_FLOOR], sub->numleafs);
+
+    for(j = 0; j < sub->numleafs - 2; j++) {
+        AddTriangle(batch, slot->first, slot->first + 1 + j, slot->first + 2 + j);
+    }
+
+    QueueBatch(slot->batch, sub->numleafs);
+
+    return true;
+}
+
+//
+// R_FlushBatches
+// Uploads changed vertices and draws every batch queued since the last
+// flush. The texture and env color for them are already bound.
+//
+
+void R_FlushBatches(void) {
+    int i;
+
+    if(!numpending) {
+        return;
+    }
+
+    for(i = 0; i < numpending; i++) {
+        batch_t *batch = &batches[pendingbatches[i]];
+
+        if(batch->dirtyhi > batch->dirtylo) {
+            if(batch->buffer) {
+                dglBindBufferARB(GL_ARRAY_BUFFER_ARB, batch->buffer);
+                dglBufferSubDataARB(GL_ARRAY_BUFFER_ARB,
+                                    batch->dirtylo * sizeof(vtx_t),
+                                    (batch->dirtyhi - batch->dirtylo) * sizeof(vtx_t),
+                                    &batch->verts[batch->dirtylo]);
+                dglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+                curstats.uploads += batch->dirtyhi - batch->dirtylo;
+            }
+
+            batch->dirtylo = batch->dirtyhi = 0;
+        }
+
+        dglDrawBatch(batch->buffer, batch->verts, batch->indices, batch->numindices);
+
+        if(devparm) {
+            vertCount += batch->drawverts;
+        }
+
+        curstats.draws++;
+
+        batch->numindices = 0;
+        batch->drawverts = 0;
+        batch->pending = false;
+    }
+
+    numpending = 0;
+
+    // the draw list keeps drawing from drawVertex
+    dglSetVertex(drawVertex);
+}
+
+//
+// R_BatchFrameEnd
+//
+
+void R_BatchFrameEnd(void) {
+    batchstats = curstats;
+
+    if(r_batchstats) {
+        I_Printf("batches: %i (%i verts), draws: %i, verts: %i, uploaded: %i, fallback: %i\n",
+                 batchstats.numbatches, batchstats.staticverts, batchstats.draws,
+                 batchstats.verts, batchstats.uploads, batchstats.fallbacks);
+    }
+
+    curstats.draws = 0;
+    curstats.verts = 0;
+    curstats.uploads = 0;
+    curstats.fallbacks = 0;
+}
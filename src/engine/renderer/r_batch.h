@@ -0,0 +1,51 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _R_BATCH_H_
+#define _R_BATCH_H_
+
+#include "r_local.h"
+#include "r_drawlist.h"
+
+//
+// Per-frame batch statistics, also printed every frame with r_batchstats
+//
+typedef struct {
+    int     numbatches;     // batches built for the level
+    int     staticverts;    // vertices stored in those batches
+    int     draws;          // batch draw calls this frame
+    int     verts;          // batch vertices referenced this frame
+    int     uploads;        // vertices re-uploaded this frame
+    int     fallbacks;      // items drawn through drawVertex instead
+} batchstats_t;
+
+extern batchstats_t batchstats;
+
+void R_BuildLevelBatches(void);
+int R_BatchWallSlot(seg_t *line, int sidetype);
+int R_BatchFlatSlot(subsector_t *sub, dboolean ceiling);
+dboolean R_BatchWall(vtxlist_t *vl, vtx_t *v);
+dboolean R_BatchFlat(vtxlist_t *vl);
+void R_FlushBatches(void);
+void R_BatchFrameEnd(void);
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "r_local.h"
 #include "r_clipper.h"
+#include "r_cull.h"
 #include "i_system.h"
 #include "doomstat.h"
 #include "d_main.h"
@@ -36,39 +37,70 @@
 #include "z_zone.h"
 #include "r_sky.h"
 #include "r_drawlist.h"
+#include "r_batch.h"
 #include "con_console.h"
 #include "p_local.h"
 #include "gl_texture.h"
+#include "p_pvs.h"
 
 sector_t    *frontsector;
 
 static vtx_t  *subsector_buffer = NULL;
 
+//
+// A visible seg of the subsector being added and the batch
+// indices of its lower, upper and middle quads (-1 for none)
+//
+typedef struct {
+    seg_t*  seg;
+    int     quad[3];
+} wallseg_t;
+
+static wallseg_t    *wallsegs = NULL;
+static cullbatch_t  wallbatch;
+
+// stamps the vertex clipspan cache. Kept apart from validcount, which
+// the game keeps bumping while the view is built on the prep thread
+static int          clipcount = 0;
+
+// lines seen this frame, flagged ML_MAPPED by R_MarkMappedLines on the
+// main thread since the game writes linedef flags too
+static line_t       **mappedlines = NULL;
+static int          nummappedlines = 0;
+
+// the view subsector's PVS row, and per node whether any subsector
+// under it is in that row
+static byte         *pvsrow = NULL;
+static byte         *pvsnodes = NULL;
+static int          pvssub = -1;
+static dboolean     pvsactive = false;
+
+BoolProperty r_pvs("r_pvs", "Skip BSP subtrees outside the view subsector's PVS", true);
+
 static void R_AddLeaf(subsector_t *sub);
-static void R_AddLine(seg_t *line);
+static void R_QueueLine(seg_t *line, wallseg_t *wall);
 static void AddSegToDrawlist(drawlist_t *dl, seg_t *line, int texid, int sidetype);
 
-extern BoolProperty i_interpolateframes;
 extern BoolProperty r_texturecombiner;
 
 //
 // R_AddClipLine
-// Clips the given segment
-// and adds any visible pieces to the line list.
+// Clips the given segment against the angle clipper.
+// Returns true if any of it is visible.
 //
 
-void R_AddClipLine(seg_t* line) {
+static dboolean R_AddClipLine(seg_t* line) {
     angle_t angle1;
     angle_t angle2;
 
-    if(line->v1->validcount != validcount) {
+    if(line->v1->validcount != clipcount) {
         line->v1->clipspan = R_PointToAngle2(line->v1->x, line->v1->y, viewx, viewy);
-        line->v1->validcount = validcount;
+        line->v1->validcount = clipcount;
     }
 
-    if(line->v2->validcount != validcount) {
+    if(line->v2->validcount != clipcount) {
         line->v2->clipspan = R_PointToAngle2(line->v2->x, line->v2->y, viewx, viewy);
-        line->v2->validcount = validcount;
+        line->v2->validcount = clipcount;
     }
 
     angle1 = line->v1->clipspan;
@@ -76,22 +108,22 @@ void R_AddClipLine(seg_t* line) {
 
     // Back side, i.e. backface culling    - read: endAngle >= startAngle!
     if(angle2 - angle1 < ANG180 || !line->linedef) {
-        return;
+        return false;
     }
 
     if(!R_Clipper_SafeCheckRange(angle2, angle1)) {
-        return;
+        return false;
     }
 
-    if(!(line->linedef->flags & (ML_DRAWMIDTEXTURE|ML_DONTOCCLUDE))) {
+    if(!(line->linedef->frame_flags & (ML_DRAWMIDTEXTURE|ML_DONTOCCLUDE))) {
         if(line->backsector) {
-            if((line->frontsector->ceilingpic != skyflatnum &&
-                    line->frontsector->floorpic != skyflatnum) &&
-                    (line->backsector->ceilingpic != skyflatnum &&
-                     line->backsector->floorpic != skyflatnum)) {
-                if((line->backsector->floorheight == line->backsector->ceilingheight) ||
-                        line->backsector->ceilingheight <= line->frontsector->floorheight ||
-                        line->backsector->floorheight >= line->frontsector->ceilingheight) {
+            if((line->frontsector->frame_ceilingpic != skyflatnum &&
+                    line->frontsector->frame_floorpic != skyflatnum) &&
+                    (line->backsector->frame_ceilingpic != skyflatnum &&
+                     line->backsector->frame_floorpic != skyflatnum)) {
+                if((line->backsector->frame_z1[1] == line->backsector->frame_z2[1]) ||
+                        line->backsector->frame_z2[1] <= line->frontsector->frame_z1[1] ||
+                        line->backsector->frame_z1[1] >= line->frontsector->frame_z2[1]) {
                     R_Clipper_SafeAddClipRange(angle2, angle1);
                 }
             }
@@ -101,9 +133,11 @@ void R_AddClipLine(seg_t* line) {
         }
     }
 
-    line->linedef->flags |= ML_MAPPED;
+    if(!(line->linedef->frame_flags & ML_MAPPED)) {
+        mappedlines[nummappedlines++] = line->linedef;
+    }
 
-    R_AddLine(line);
+    return true;
 }
 
 int checkcoord[12][4] = {
@@ -154,22 +188,22 @@ dboolean R_CheckBBox(fixed_t* bspcoord) {
 static void AddSwitchQuad(seg_t *line) {
     int texid = 0;
 
-    if(!SWITCHMASK(line->linedef->flags)) {
+    if(!SWITCHMASK(line->linedef->frame_flags)) {
         return;
     }
 
-    if(SWITCHMASK(line->linedef->flags) == ML_SWITCHX02) {
-        texid = line->sidedef->toptexture;
+    if(SWITCHMASK(line->linedef->frame_flags) == ML_SWITCHX02) {
+        texid = line->sidedef->frame_toptexture;
     }
-    else if(SWITCHMASK(line->linedef->flags) == ML_SWITCHX04) {
-        texid = line->sidedef->bottomtexture;
+    else if(SWITCHMASK(line->linedef->frame_flags) == ML_SWITCHX04) {
+        texid = line->sidedef->frame_bottomtexture;
     }
     else {
         if(!line->backsector) {
             return;
         }
 
-        texid = line->sidedef->midtexture;
+        texid = line->sidedef->frame_midtexture;
     }
 
     AddSegToDrawlist(&drawlist[DLT_WALL], line, texid, 3);
@@ -177,6 +211,7 @@ static void AddSwitchQuad(seg_t *line) {
 
 //
 // R_GenerateSwitchPlane
+// Heights as of the view snapshot, same as the walls it sits on
 //
 
 dboolean R_GenerateSwitchPlane(void *data, vtx_t *v) {
@@ -230,40 +265,40 @@ dboolean R_GenerateSwitchPlane(void *data, vtx_t *v) {
 
     R_LightToVertex(v, line->frontsector->colors[LIGHT_THING], 4);
 
-    if(SWITCHMASK(line->linedef->flags) == ML_SWITCHX02) {
+    if(SWITCHMASK(line->linedef->frame_flags) == ML_SWITCHX02) {
         if(line->backsector) {
             offset = 16*FRACUNIT - (line->sidedef->rowoffset);
-            top = line->backsector->floorheight - offset;
+            top = line->backsector->frame_z1[1] - offset;
             bottom = top - (32*FRACUNIT);
         }
         else {
             offset = 16*FRACUNIT + (line->sidedef->rowoffset);
-            bottom = line->frontsector->floorheight + offset;
+            bottom = line->frontsector->frame_z1[1] + offset;
             top = bottom + (32*FRACUNIT);
         }
     }
-    else if(SWITCHMASK(line->linedef->flags) == ML_SWITCHX04) {
+    else if(SWITCHMASK(line->linedef->frame_flags) == ML_SWITCHX04) {
         if(line->backsector) {
             offset = 16*FRACUNIT + (line->sidedef->rowoffset);
-            bottom = line->backsector->ceilingheight + offset;
+            bottom = line->backsector->frame_z2[1] + offset;
             top = bottom + (32*FRACUNIT);
         }
         else {
             offset = 16*FRACUNIT + (line->sidedef->rowoffset);
-            bottom = line->frontsector->floorheight + offset;
+            bottom = line->frontsector->frame_z1[1] + offset;
             top = bottom + (32*FRACUNIT);
         }
     }
     else {
         if(line->backsector) {
-            if(line->backsector->floorheight > line->frontsector->floorheight) {
+            if(line->backsector->frame_z1[1] > line->frontsector->frame_z1[1]) {
                 offset = 16*FRACUNIT - (line->sidedef->rowoffset);
-                top = line->backsector->floorheight - offset;
+                top = line->backsector->frame_z1[1] - offset;
                 bottom = top - (32*FRACUNIT);
             }
-            else if(line->backsector->ceilingheight < line->frontsector->ceilingheight) {
+            else if(line->backsector->frame_z2[1] < line->frontsector->frame_z2[1]) {
                 offset = 16*FRACUNIT + (line->sidedef->rowoffset);
-                bottom = line->backsector->ceilingheight + offset;
+                bottom = line->backsector->frame_z2[1] + offset;
                 top = bottom + (32*FRACUNIT);
             }
         }
@@ -280,18 +315,14 @@ dboolean R_GenerateSwitchPlane(void *data, vtx_t *v) {
     return true;
 }
 
-d_inline static void GetSideTopBottom(sector_t* sector, rfloat *top, rfloat *bottom) {
-    if(i_interpolateframes) {
-        fixed_t frame_c = sector->frame_z2[1];
-        fixed_t frame_f = sector->frame_z1[1];
+//
+// GetSideTopBottom
+// Heights as of the view snapshot (see R_InterpolateSectors)
+//
 
-        *bottom = F2D3D(frame_f);
-        *top = F2D3D(frame_c);
-    }
-    else {
-        *top = F2D3D(sector->ceilingheight);
-        *bottom = F2D3D(sector->floorheight);
-    }
+d_inline static void GetSideTopBottom(sector_t* sector, rfloat *top, rfloat *bottom) {
+    *top = F2D3D(sector->frame_z2[1]);
+    *bottom = F2D3D(sector->frame_z1[1]);
 }
 
 //
@@ -331,7 +362,7 @@ static dboolean R_GenerateLowerSegPlane(void *data, vtx_t* v) {
     GetSideTopBottom(line->frontsector, &top, &bottom);
     GetSideTopBottom(line->backsector, &btop, &bbottom);
 
-    if((line->frontsector->ceilingpic == skyflatnum) && (line->backsector->ceilingpic == skyflatnum)) {
+    if((line->frontsector->frame_ceilingpic == skyflatnum) && (line->backsector->frame_ceilingpic == skyflatnum)) {
         btop = top;
     }
 
@@ -341,8 +372,8 @@ static dboolean R_GenerateLowerSegPlane(void *data, vtx_t* v) {
 
         R_SetSegLineColor(line, v, 2);
 
-        width = texturewidth[sidedef->bottomtexture];
-        height = textureheight[sidedef->bottomtexture];
+        width = texturewidth[sidedef->frame_bottomtexture];
+        height = textureheight[sidedef->frame_bottomtexture];
 
         rowoffs = F2D3D(sidedef->rowoffset) / height;
         coloffs = F2D3D(sidedef->textureoffset + line->offset) / width;
@@ -350,7 +381,7 @@ static dboolean R_GenerateLowerSegPlane(void *data, vtx_t* v) {
         v[0].tu = v[2].tu = coloffs;
         v[1].tu = v[3].tu = length / width + coloffs;
 
-        if(linedef->flags & ML_DONTPEGBOTTOM) {
+        if(linedef->frame_flags & ML_DONTPEGBOTTOM) {
             v[0].tv = v[1].tv = rowoffs + (top - bbottom) / height;
             v[2].tv = v[3].tv = rowoffs + (top - bottom) / height;
         }
@@ -402,7 +433,7 @@ static dboolean R_GenerateUpperSegPlane(void *data, vtx_t* v) {
     GetSideTopBottom(line->frontsector, &top, &bottom);
     GetSideTopBottom(line->backsector, &btop, &bbottom);
 
-    if((line->frontsector->ceilingpic == skyflatnum) && (line->backsector->ceilingpic == skyflatnum)) {
+    if((line->frontsector->frame_ceilingpic == skyflatnum) && (line->backsector->frame_ceilingpic == skyflatnum)) {
         btop = top;
     }
 
@@ -412,8 +443,8 @@ static dboolean R_GenerateUpperSegPlane(void *data, vtx_t* v) {
 
         R_SetSegLineColor(line, v, 1);
 
-        width = texturewidth[sidedef->toptexture];
-        height = textureheight[sidedef->toptexture];
+        width = texturewidth[sidedef->frame_toptexture];
+        height = textureheight[sidedef->frame_toptexture];
 
         rowoffs = F2D3D(sidedef->rowoffset) / height;
         coloffs = F2D3D(sidedef->textureoffset + line->offset) / width;
@@ -421,11 +452,11 @@ static dboolean R_GenerateUpperSegPlane(void *data, vtx_t* v) {
         v[0].tu = v[2].tu = coloffs;
         v[1].tu = v[3].tu = length / width + coloffs;
 
-        if(line->linedef->flags & ML_VMIRROR) {
+        if(line->linedef->frame_flags & ML_VMIRROR) {
             rowoffs = F2D3D(sidedef->rowoffset + (height * FRACUNIT)) / height;
         }
 
-        if(linedef->flags & ML_DONTPEGTOP) {
+        if(linedef->frame_flags & ML_DONTPEGTOP) {
             v[0].tv = v[1].tv = 1 + rowoffs;
             v[2].tv = v[3].tv = 1 + rowoffs + (top - btop) / height;
         }
@@ -483,7 +514,7 @@ static dboolean R_GenerateMiddleSegPlane(void *data, vtx_t* v) {
     if(line->backsector) {
         GetSideTopBottom(line->backsector, &btop, &bbottom);
 
-        if((line->frontsector->ceilingpic == skyflatnum) && (line->backsector->ceilingpic == skyflatnum)) {
+        if((line->frontsector->frame_ceilingpic == skyflatnum) && (line->backsector->frame_ceilingpic == skyflatnum)) {
             btop = top;
         }
 
@@ -503,8 +534,8 @@ static dboolean R_GenerateMiddleSegPlane(void *data, vtx_t* v) {
         R_SetSegLineColor(line, v, 3);
     }
 
-    width = texturewidth[sidedef->midtexture];
-    height = textureheight[sidedef->midtexture];
+    width = texturewidth[sidedef->frame_midtexture];
+    height = textureheight[sidedef->frame_midtexture];
 
     rowoffs = F2D3D(sidedef->rowoffset) / height;
     coloffs = F2D3D(sidedef->textureoffset + line->offset) / width;
@@ -512,20 +543,20 @@ static dboolean R_GenerateMiddleSegPlane(void *data, vtx_t* v) {
     v[0].tu = v[2].tu = coloffs;
     v[1].tu = v[3].tu = length / width + coloffs;
 
-    if(!(line->linedef->flags & ML_SWITCHX02 && line->linedef->flags & ML_SWITCHX04)) {
+    if(!(line->linedef->frame_flags & ML_SWITCHX02 && line->linedef->frame_flags & ML_SWITCHX04)) {
         // ML_DONTPEGMID is extremly hacky and it appears to be used only once in the entire game
-        if(linedef->flags & ML_DONTPEGMID && line->backsector) {
+        if(linedef->frame_flags & ML_DONTPEGMID && line->backsector) {
             v[0].tv = v[1].tv = 1 + rowoffs - ((top - btop) / height);
             v[2].tv = v[3].tv = 1 + rowoffs + (((top + btop) - (bottom + bbottom)) / height)/2;
         }
-        else if(linedef->flags & ML_DONTPEGTOP && !line->backsector) {
+        else if(linedef->frame_flags & ML_DONTPEGTOP && !line->backsector) {
             rowoffs = ((F2D3D(sidedef->rowoffset) - bottom) - (top - bottom)) / height;
 
             v[0].tv = v[1].tv = rowoffs;
             v[2].tv = v[3].tv = rowoffs + (top - bottom) / height;
         }
-        else if(linedef->flags & ML_DONTPEGBOTTOM) {
-            if(line->linedef->flags & ML_VMIRROR) {
+        else if(linedef->frame_flags & ML_DONTPEGBOTTOM) {
+            if(line->linedef->frame_flags & ML_VMIRROR) {
                 rowoffs = F2D3D(sidedef->rowoffset + (height * FRACUNIT)) / height;
             }
 
@@ -550,6 +581,7 @@ static void AddSegToDrawlist(drawlist_t *dl, seg_t *line, int texid, int sidetyp
 
     list = DL_AddVertexList(dl);
     list->data = (seg_t*)line;
+    list->batch = R_BatchWallSlot(line, sidetype);
 
     switch(sidetype) {
     case 0:
@@ -568,60 +600,58 @@ static void AddSegToDrawlist(drawlist_t *dl, seg_t *line, int texid, int sidetyp
         return;
     }
 
-    if(line->linedef->flags & ML_HMIRROR) {
+    if(line->linedef->frame_flags & ML_HMIRROR) {
         list->flags |= DLF_MIRRORS;
     }
 
-    if(line->linedef->flags & ML_VMIRROR) {
+    if(line->linedef->frame_flags & ML_VMIRROR) {
         list->flags |= DLF_MIRRORT;
     }
 
-    if(line->frontsector->lightlevel) {
+    if(line->frontsector->frame_lightlevel) {
         // add seg's gamma glow values
 
         list->flags |= DLF_GLOW;
-        list->params = line->frontsector->lightlevel;
+        list->params = line->frontsector->frame_lightlevel;
     }
 
     list->texid = (list->flags << 16) | texid;
 }
 
 //
-// R_AddLine
+// R_QueueLine
+// Queues the seg's wall quads for R_CullBatch
 //
 
-static void R_AddLine(seg_t *line) {
-    vtx_t       v[4];
+static void R_QueueLine(seg_t *line, wallseg_t *wall) {
     line_t*     linedef;
     side_t*     sidedef;
     rfloat      top;
     rfloat      bottom;
     rfloat      btop;
     rfloat      bbottom;
-    float       x;
-    float       y;
-
-    x = F2D3D(line->v1->x);
-    y = F2D3D(line->v1->y);
+    float       x1;
+    float       y1;
+    float       x2;
+    float       y2;
 
     linedef = line->linedef;
     sidedef = line->sidedef;
 
-    if(!linedef) {
-        return;
-    }
+    wall->seg = line;
+    wall->quad[0] = wall->quad[1] = wall->quad[2] = -1;
 
-    v[0].x = v[2].x = x;
-    v[0].y = v[2].y = y;
-    v[1].x = v[3].x = F2D3D(line->v2->x);
-    v[1].y = v[3].y = F2D3D(line->v2->y);
+    x1 = F2D3D(line->v1->x);
+    y1 = F2D3D(line->v1->y);
+    x2 = F2D3D(line->v2->x);
+    y2 = F2D3D(line->v2->y);
 
     GetSideTopBottom(line->frontsector, &top, &bottom);
 
     if(line->backsector) {
         GetSideTopBottom(line->backsector, &btop, &bbottom);
 
-        if((line->frontsector->ceilingpic == skyflatnum) && (line->backsector->ceilingpic == skyflatnum)) {
+        if((line->frontsector->frame_ceilingpic == skyflatnum) && (line->backsector->frame_ceilingpic == skyflatnum)) {
             btop = top;
         }
 
@@ -629,14 +659,8 @@ static void R_AddLine(seg_t *line) {
         // botom side line
         //
         if(bottom < bbottom) {
-            v[0].z = v[1].z = bbottom;
-            v[2].z = v[3].z = bottom;
-
-            if(line->sidedef[0].bottomtexture != 1) {
-                if(R_FrustrumTestVertex(v, 4)) {
-                    AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->bottomtexture, 0);
-                    AddSwitchQuad(line);
-                }
+            if(sidedef->frame_bottomtexture != 1) {
+                wall->quad[0] = R_CullBatchAdd(&wallbatch, x1, y1, x2, y2, bbottom, bottom);
             }
 
             bottom = bbottom;
@@ -646,14 +670,8 @@ static void R_AddLine(seg_t *line) {
         // upper side line
         //
         if(top > btop) {
-            v[0].z = v[1].z = top;
-            v[2].z = v[3].z = btop;
-
-            if(line->sidedef[0].toptexture != 1) {
-                if(R_FrustrumTestVertex(v, 4)) {
-                    AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->toptexture, 1);
-                    AddSwitchQuad(line);
-                }
+            if(sidedef->frame_toptexture != 1) {
+                wall->quad[1] = R_CullBatchAdd(&wallbatch, x1, y1, x2, y2, top, btop);
             }
 
             top = btop;
@@ -663,23 +681,51 @@ static void R_AddLine(seg_t *line) {
     //
     // middle side line
     //
-    if(sidedef->midtexture != 1) {
-        v[0].z = v[1].z = top;
-        v[2].z = v[3].z = bottom;
-
-        if(!R_FrustrumTestVertex(v, 4)) {
+    if(sidedef->frame_midtexture != 1) {
+        if(line->backsector && !(linedef->frame_flags & ML_DRAWMIDTEXTURE)) {
             return;
         }
 
-        if(line->backsector) {
-            if(!(line->linedef->flags & ML_DRAWMIDTEXTURE)) {
-                return;
-            }
+        if(!(linedef->frame_flags & ML_SWITCHX02 && linedef->frame_flags & ML_SWITCHX04)) {
+            wall->quad[2] = R_CullBatchAdd(&wallbatch, x1, y1, x2, y2, top, bottom);
         }
+    }
+}
 
-        if(!(line->linedef->flags & ML_SWITCHX02 && line->linedef->flags & ML_SWITCHX04)) {
-            AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->midtexture, 2);
-            AddSwitchQuad(line);
+//
+// R_AddLines
+// Frustum tests all the queued wall quads of a subsector
+// in one go, then adds the visible ones in seg order
+//
+
+static void R_AddLines(int count) {
+    wallseg_t*  wall;
+    int         texid;
+    int         i;
+    int         side;
+
+    R_CullBatch(&wallbatch);
+
+    for(i = 0, wall = wallsegs; i < count; i++, wall++) {
+        for(side = 0; side < 3; side++) {
+            if(wall->quad[side] == -1 || !wallbatch.visible[wall->quad[side]]) {
+                continue;
+            }
+
+            switch(side) {
+            case 0:
+                texid = wall->seg->sidedef->frame_bottomtexture;
+                break;
+            case 1:
+                texid = wall->seg->sidedef->frame_toptexture;
+                break;
+            default:
+                texid = wall->seg->sidedef->frame_midtexture;
+                break;
+            }
+
+            AddSegToDrawlist(&drawlist[DLT_WALL], wall->seg, texid, side);
+            AddSwitchQuad(wall->seg);
         }
     }
 }
@@ -698,6 +744,105 @@ void R_Subsector(int num) {
     R_AddSprites(sub);
 }
 
+//
+// R_PVSMarkNodes
+// Returns true if any subsector under bspnum is in pvsrow
+//
+
+static dboolean R_PVSMarkNodes(int bspnum) {
+    node_t* bsp;
+    int num;
+
+    if(bspnum & NF_SUBSECTOR) {
+        num = (bspnum == -1) ? 0 : (bspnum & ~NF_SUBSECTOR);
+        return (pvsrow[num >> 3] & (1 << (num & 7))) != 0;
+    }
+
+    bsp = &nodes[bspnum];
+
+    // both sides are needed by the nodes below
+    num = R_PVSMarkNodes(bsp->children[0]);
+    num |= R_PVSMarkNodes(bsp->children[1]);
+
+    pvsnodes[bspnum] = num;
+    return num;
+}
+
+//
+// R_PVSSetup
+// Only views from inside the map can use the PVS; a view in the void
+// or in a subsector without a polygon walks the whole tree.
+//
+
+static void R_PVSSetup(void) {
+    subsector_t* sub;
+
+    pvsactive = false;
+
+    if(!r_pvs || !P_HavePVS() || numnodes <= 0 || !pvsrow) {
+        return;
+    }
+
+    sub = R_PointInSubsector(viewx, viewy);
+
+    if(!P_PointInLeafs(sub, viewx, viewy)) {
+        return;
+    }
+
+    if(sub - subsectors != pvssub) {
+        pvssub = sub - subsectors;
+        P_DecompressPVS(pvssub, pvsrow);
+        R_PVSMarkNodes(numnodes-1);
+    }
+
+    pvsactive = true;
+}
+
+//
+// R_PVSVisible
+//
+
+static d_inline dboolean R_PVSVisible(int bspnum) {
+    int num;
+
+    if(!pvsactive) {
+        return true;
+    }
+
+    if(!(bspnum & NF_SUBSECTOR)) {
+        return pvsnodes[bspnum];
+    }
+
+    num = (bspnum == -1) ? 0 : (bspnum & ~NF_SUBSECTOR);
+    return (pvsrow[num >> 3] & (1 << (num & 7))) != 0;
+}
+
+//
+// R_RenderBSP
+// Walks the whole tree for the current view
+//
+
+void R_RenderBSP(void) {
+    clipcount++;
+    R_PVSSetup();
+    R_RenderBSPNode(numnodes-1);
+}
+
+//
+// R_MarkMappedLines
+// Reveals the lines the last R_RenderBSP saw on the automap
+//
+
+void R_MarkMappedLines(void) {
+    int i;
+
+    for(i = 0; i < nummappedlines; i++) {
+        mappedlines[i]->flags |= ML_MAPPED;
+    }
+
+    nummappedlines = 0;
+}
+
 //
 // R_RenderBSPNode
 //
@@ -713,12 +858,14 @@ void R_RenderBSPNode(int bspnum) {
         side = R_PointOnSide(viewx, viewy, bsp);
 
         // check the front space
-        if(R_CheckBBox(bsp->bbox[side])) {
+        if(R_PVSVisible(bsp->children[side]) &&
+                R_CullBox(bsp->bbox[side]) && R_CheckBBox(bsp->bbox[side])) {
             R_RenderBSPNode(bsp->children[side]);
         }
 
         // continue down the back space
-        if(!R_CheckBBox(bsp->bbox[side^1])) {
+        if(!R_PVSVisible(bsp->children[side^1]) ||
+                !R_CullBox(bsp->bbox[side^1]) || !R_CheckBBox(bsp->bbox[side^1])) {
             return;
         }
 
@@ -764,7 +911,24 @@ void R_AllocSubsectorBuffer(void) {
 
         subsector_buffer = (vtx_t *)Z_Malloc(numverts * sizeof(vtx_t), PU_STATIC, NULL);
         maxSubVerts = numverts;
+
+        // each leaf has at most one seg, with up to three wall parts
+        if(wallsegs) {
+            Z_Free(wallsegs);
+        }
+
+        wallsegs = (wallseg_t *)Z_Malloc(numverts * sizeof(wallseg_t), PU_STATIC, NULL);
+        R_CullBatchAlloc(&wallbatch, numverts * 3);
     }
+
+    // a seg is clipped once per frame at most
+    mappedlines = (line_t **)Z_Malloc(MAX(numsegs, 1) * sizeof(line_t*), PU_LEVEL, &mappedlines);
+    nummappedlines = 0;
+
+    pvsrow = (byte *)Z_Malloc((numsubsectors + 7) >> 3, PU_LEVEL, &pvsrow);
+    pvsnodes = (byte *)Z_Malloc(MAX(numnodes, 1), PU_LEVEL, &pvsnodes);
+    pvssub = -1;
+    pvsactive = false;
 }
 
 //
@@ -781,11 +945,11 @@ static void AddLeafToDrawlist(drawlist_t *dl, subsector_t *sub, int texid) {
 
     sector = sub->sector;
 
-    if(sector->lightlevel) {
+    if(sector->frame_lightlevel) {
         // add subsector's gamma glow values
 
         list->flags |= DLF_GLOW;
-        list->params = sector->lightlevel;
+        list->params = sector->frame_lightlevel;
     }
 
     list->texid = (list->flags << 16) | texid;
@@ -800,6 +964,7 @@ static void R_AddLeaf(subsector_t *sub) {
     int             count;
     float           x;
     float           y;
+    int             numwalls;
     vtx_t*          v;
     leaf_t*         leaf;
 
@@ -810,6 +975,8 @@ static void R_AddLeaf(subsector_t *sub) {
     count = sub->numleafs;
     v = subsector_buffer;
     i = 0;
+    numwalls = 0;
+    wallbatch.count = 0;
 
     while(count--) {
         leaf = &leafs[sub->leaf + i];
@@ -818,32 +985,37 @@ static void R_AddLeaf(subsector_t *sub) {
         y = F2D3D(leaf->vertex->y);
         v->x = x;
         v->y = y;
-        v->z = F2D3D(sub->sector->floorheight);
+        v->z = F2D3D(sub->sector->frame_z1[1]);
         v++;
 
-        if(leaf->seg != NULL) {
-            R_AddClipLine(leaf->seg);
+        if(leaf->seg != NULL && R_AddClipLine(leaf->seg)) {
+            R_QueueLine(leaf->seg, &wallsegs[numwalls++]);
         }
 
         i++;
     }
 
+    if(numwalls) {
+        R_AddLines(numwalls);
+    }
+
     // FLOOR
 
-    if(sub->sector->floorpic != skyflatnum) {
+    if(sub->sector->frame_floorpic != skyflatnum) {
         if(R_FrustrumTestVertex(subsector_buffer, sub->numleafs) &&
-                viewz > sub->sector->floorheight) {
+                viewz > sub->sector->frame_z1[1]) {
             drawlist_t *dl = &drawlist[DLT_FLAT];
 
-            if(sub->sector->flags & MS_LIQUIDFLOOR) {
-                AddLeafToDrawlist(dl, sub, sub->sector->floorpic);
+            if(sub->sector->frame_flags & MS_LIQUIDFLOOR) {
+                AddLeafToDrawlist(dl, sub, sub->sector->frame_floorpic);
                 dl->list[dl->index - 1].flags |= DLF_WATER1;
 
-                AddLeafToDrawlist(dl, sub, sub->sector->floorpic + 1);
+                AddLeafToDrawlist(dl, sub, sub->sector->frame_floorpic + 1);
                 dl->list[dl->index - 1].flags |= DLF_WATER2;
             }
             else {
-                AddLeafToDrawlist(dl, sub, sub->sector->floorpic);
+                AddLeafToDrawlist(dl, sub, sub->sector->frame_floorpic);
+                dl->list[dl->index - 1].batch = R_BatchFlatSlot(sub, false);
             }
         }
     }
@@ -853,21 +1025,22 @@ static void R_AddLeaf(subsector_t *sub) {
 
     // CEILING
 
-    if(sub->sector->ceilingpic != skyflatnum) {
+    if(sub->sector->frame_ceilingpic != skyflatnum) {
         for(i = 0; i < sub->numleafs; i++) {
             leaf = &leafs[(sub->leaf + (sub->numleafs - 1)) - i];
 
-            subsector_buffer[i].z = F2D3D(sub->sector->ceilingheight);
+            subsector_buffer[i].z = F2D3D(sub->sector->frame_z2[1]);
             subsector_buffer[i].x = F2D3D(leaf->vertex->x);
             subsector_buffer[i].y = F2D3D(leaf->vertex->y);
         }
 
         if(R_FrustrumTestVertex(subsector_buffer, sub->numleafs) &&
-                viewz < sub->sector->ceilingheight) {
+                viewz < sub->sector->frame_z2[1]) {
             drawlist_t *dl = &drawlist[DLT_FLAT];
 
-            AddLeafToDrawlist(dl, sub, sub->sector->ceilingpic);
+            AddLeafToDrawlist(dl, sub, sub->sector->frame_ceilingpic);
             dl->list[dl->index - 1].flags |= DLF_CEILING;
+            dl->list[dl->index - 1].batch = R_BatchFlatSlot(sub, true);
         }
     }
     else {
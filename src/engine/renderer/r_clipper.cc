@@ -25,50 +25,58 @@
 //
 //-----------------------------------------------------------------------------
 
+#include "doomstat.h"
+#include "i_system.h"
 #include "r_local.h"
+#include "r_cull.h"
 #include "tables.h"
 #include "m_fixed.h"
 #include "z_zone.h"
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 static GLdouble viewMatrix[16];
 static GLdouble projMatrix[16];
 float frustum[6][4];
 
-typedef struct clipnode_s {
-    struct clipnode_s *prev, *next;
-    angle_t start, end;
-} clipnode_t;
-
 //
-// GhostlyDeath <10/3/11>
+// Occluded angle ranges, sorted and disjoint. Both ends are inclusive;
+// ranges that touch are merged.
 //
-clipnode_t *freelist    = NULL;
-clipnode_t *clipnodes   = NULL;
-clipnode_t *cliphead    = NULL;
+typedef struct {
+    angle_t start;
+    angle_t end;
+} cliprange_t;
+
+static cliprange_t  *clipranges = NULL;
+static int          numclipranges = 0;
+static int          maxclipranges = 0;
 
-static clipnode_t * R_Clipnode_NewRange(angle_t start, angle_t end);
 static dboolean R_Clipper_IsRangeVisible(angle_t startAngle, angle_t endAngle);
 static void R_Clipper_AddClipRange(angle_t start, angle_t end);
-static void R_Clipper_RemoveRange(clipnode_t * range);
-static void R_Clipnode_Free(clipnode_t *node);
-
-static clipnode_t *R_Clipnode_GetNew(void) {
-    if(freelist) {
-        clipnode_t *p = freelist;
-        freelist = p->next;
-        return p;
-    }
 
-    return (clipnode_t*) malloc(sizeof(clipnode_t));
-}
+//
+// R_Clipper_Search
+// Index of the first range ending at or after angle
+//
 
-static clipnode_t * R_Clipnode_NewRange(angle_t start, angle_t end) {
-    clipnode_t *c = R_Clipnode_GetNew();
-    c->start = start;
-    c->end = end;
-    c->next = c->prev=NULL;
-    return c;
+static d_inline int R_Clipper_Search(angle_t angle) {
+    int lo = 0;
+    int hi = numclipranges;
+
+    while(lo < hi) {
+        int mid = (lo + hi) >> 1;
+
+        if(clipranges[mid].end < angle) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
 }
 
 //
@@ -84,46 +92,16 @@ dboolean R_Clipper_SafeCheckRange(angle_t startAngle, angle_t endAngle) {
 }
 
 static dboolean R_Clipper_IsRangeVisible(angle_t startAngle, angle_t endAngle) {
-    clipnode_t *ci;
-    ci = cliphead;
+    int i = R_Clipper_Search(startAngle);
 
-    if(endAngle == 0 && ci && ci->start == 0) {
+    if(i < numclipranges && clipranges[i].start <= startAngle &&
+            clipranges[i].end >= endAngle) {
         return false;
     }
 
-    while(ci != NULL && ci->start < endAngle) {
-        if(startAngle >= ci->start && endAngle <= ci->end) {
-            return false;
-        }
-
-        ci = ci->next;
-    }
-
     return true;
 }
 
-static void R_Clipnode_Free(clipnode_t *node) {
-    node->next = freelist;
-    freelist = node;
-}
-
-static void R_Clipper_RemoveRange(clipnode_t *range) {
-    if(range == cliphead) {
-        cliphead = cliphead->next;
-    }
-    else {
-        if(range->prev) {
-            range->prev->next = range->next;
-        }
-
-        if(range->next) {
-            range->next->prev = range->prev;
-        }
-    }
-
-    R_Clipnode_Free(range);
-}
-
 //
 // R_Clipper_SafeAddClipRange
 //
@@ -141,88 +119,46 @@ void R_Clipper_SafeAddClipRange(angle_t startangle, angle_t endangle) {
 }
 
 static void R_Clipper_AddClipRange(angle_t start, angle_t end) {
-    clipnode_t *node, *temp, *prevNode;
-    if(cliphead) {
-        //check to see if range contains any old ranges
-        node = cliphead;
-        while(node != NULL && node->start < end) {
-            if(node->start >= start && node->end <= end) {
-                temp = node;
-                node = node->next;
-                R_Clipper_RemoveRange(temp);
-            }
-            else {
-                if(node->start <= start && node->end >= end) {
-                    return;
-                }
-                else {
-                    node = node->next;
-                }
-            }
-        }
-        //check to see if range overlaps a range (or possibly 2)
-        node = cliphead;
-        while(node != NULL) {
-            if(node->start >= start && node->start <= end) {
-                node->start = start;
-                return;
-            }
-            if(node->end >= start && node->end <= end) {
-                // check for possible merger
-                if(node->next && node->next->start <= end) {
-                    node->end = node->next->end;
-                    R_Clipper_RemoveRange(node->next);
-                }
-                else {
-                    node->end = end;
-                }
-
-                return;
-            }
+    int first;
+    int last;
 
-            node = node->next;
-        }
+    // ranges from first up to last overlap or touch the new one
+    first = (start > 0) ? R_Clipper_Search(start - 1) : 0;
+    last = first;
 
-        //just add range
-        node = cliphead;
-        prevNode = NULL;
+    while(last < numclipranges && (end == ANGLE_MAX || clipranges[last].start <= end + 1)) {
+        last++;
+    }
 
-        temp = R_Clipnode_NewRange(start, end);
+    if(first == last) {
+        if(numclipranges == maxclipranges) {
+            // plain realloc, the zone is not safe to use from the prep thread
+            maxclipranges = maxclipranges ? maxclipranges * 2 : 256;
+            clipranges = (cliprange_t*)realloc(clipranges, maxclipranges * sizeof(cliprange_t));
 
-        while(node != NULL && node->start < end) {
-            prevNode = node;
-            node = node->next;
+            if(!clipranges) {
+                I_Error("R_Clipper_AddClipRange: out of memory (%i ranges)", maxclipranges);
+            }
         }
 
-        temp->next = node;
+        memmove(&clipranges[first + 1], &clipranges[first],
+                (numclipranges - first) * sizeof(cliprange_t));
 
-        if(node == NULL) {
-            temp->prev = prevNode;
+        clipranges[first].start = start;
+        clipranges[first].end = end;
+        numclipranges++;
+        return;
+    }
 
-            if(prevNode) {
-                prevNode->next = temp;
-            }
+    // merge them into the first
+    clipranges[first].start = MIN(start, clipranges[first].start);
+    clipranges[first].end = MAX(end, clipranges[last - 1].end);
 
-            if(!cliphead) {
-                cliphead = temp;
-            }
-        }
-        else {
-            if(node == cliphead) {
-                cliphead->prev = temp;
-                cliphead = temp;
-            }
-            else {
-                temp->prev = prevNode;
-                prevNode->next = temp;
-                node->prev = temp;
-            }
-        }
-    }
-    else {
-        temp = R_Clipnode_NewRange(start, end);
-        cliphead = temp;
-        return;
+    if(last - first > 1) {
+        memmove(&clipranges[first + 1], &clipranges[last],
+                (numclipranges - last) * sizeof(cliprange_t));
+
+        numclipranges -= last - first - 1;
     }
 }
 
@@ -231,16 +167,7 @@ static void R_Clipper_AddClipRange(angle_t start, angle_t end) {
 //
 
 void R_Clipper_Clear(void) {
-    clipnode_t *node = cliphead;
-    clipnode_t *temp;
-
-    while(node != NULL) {
-        temp = node;
-        node = node->next;
-        R_Clipnode_Free(temp);
-    }
-
-    cliphead = NULL;
+    numclipranges = 0;
 }
 
 //
@@ -272,20 +199,83 @@ angle_t R_FrustumAngle(void) {
 }
 
 //
-// R_FrustrumSetup
+// R_ViewMatrices
+// The matrices R_SetViewMatrix loads, worked out on the CPU for when
+// there is no GL context (-headless)
 //
 
+static void R_ViewMatrices(void) {
+    double aspect;
+    double top;
+    double pc, ps;
+    double ac, as;
+    double tx, ty, tz;
+    double a;
+    int i;
+
+    aspect = (video_width > 0 && video_height > 0) ?
+             (double)video_width / (double)video_height : 4.0 / 3.0;
+    top = 0.1 * tan((double)r_fov * M_PI / 360.0);
+
+    for(i = 0; i < 16; i++) {
+        projMatrix[i] = viewMatrix[i] = 0;
+    }
+
+    projMatrix[0]  = 0.1 / (top * aspect);
+    projMatrix[5]  = 0.1 / top;
+    projMatrix[10] = -1;
+    projMatrix[11] = -1;
+    projMatrix[14] = -2 * 0.1;
+
+    // rotate by -pitch around x, then by 90 - angle around z
+    a = -TRUEANGLES(viewpitch) * M_PI / 180.0;
+    pc = cos(a);
+    ps = sin(a);
+
+    a = (90.0 - TRUEANGLES(viewangle)) * M_PI / 180.0;
+    ac = cos(a);
+    as = sin(a);
+
+    viewMatrix[0]  = ac;
+    viewMatrix[1]  = pc * as;
+    viewMatrix[2]  = ps * as;
+    viewMatrix[4]  = -as;
+    viewMatrix[5]  = pc * ac;
+    viewMatrix[6]  = ps * ac;
+    viewMatrix[9]  = -ps;
+    viewMatrix[10] = pc;
+    viewMatrix[15] = 1;
+
+    // then translate by -view
+    tx = -fviewx;
+    ty = -fviewy;
+    tz = -fviewz;
+
+    for(i = 0; i < 3; i++) {
+        viewMatrix[12 + i] = viewMatrix[i] * tx + viewMatrix[4 + i] * ty + viewMatrix[8 + i] * tz;
+    }
+}
+
 #define CALCMATRIX(a, b, c, d, e, f, g, h)\
 (float)(viewMatrix[a] * projMatrix[b] + \
 viewMatrix[c] * projMatrix[d] + \
 viewMatrix[e] * projMatrix[f] + \
 viewMatrix[g] * projMatrix[h])
 
+//
+// R_FrustrumSetup
+//
+
 void R_FrustrumSetup(void) {
     float clip[16];
 
-    dglGetDoublev(GL_PROJECTION_MATRIX, projMatrix);
-    dglGetDoublev(GL_MODELVIEW_MATRIX, viewMatrix);
+    if(usingGL) {
+        dglGetDoublev(GL_PROJECTION_MATRIX, projMatrix);
+        dglGetDoublev(GL_MODELVIEW_MATRIX, viewMatrix);
+    }
+    else {
+        R_ViewMatrices();
+    }
 
     clip[0]  = CALCMATRIX(0, 0, 1, 4, 2, 8, 3, 12);
     clip[1]  = CALCMATRIX(0, 1, 1, 5, 2, 9, 3, 13);
@@ -342,33 +332,6 @@ void R_FrustrumSetup(void) {
     frustum[5][1] = clip[ 7] + clip[ 6];
     frustum[5][2] = clip[11] + clip[10];
     frustum[5][3] = clip[15] + clip[14];
-}
-
-//
-// R_FrustrumTestVertex
-// Returns false if polygon is not within the view frustrum
-//
-
-dboolean R_FrustrumTestVertex(vtx_t* vertex, int count) {
-    int p;
-    int i;
-
-    for(p = 0; p < 6; p++) {
-        for(i = 0; i < count; i++) {
-            if(frustum[p][0] * vertex[i].x +
-                    frustum[p][1] * vertex[i].y +
-                    frustum[p][2] * vertex[i].z +
-                    frustum[p][3] > 0) {
-                break;
-            }
-        }
-
-        if(i != count) {
-            continue;
-        }
 
-        return false;
-    }
-
-    return true;
+    R_CullSetup();
 }
@@ -32,6 +32,5 @@ extern float frustum[6][4];
 
 angle_t     R_FrustumAngle(void);
 void        R_FrustrumSetup(void);
-dboolean    R_FrustrumTestVertex(vtx_t* vertex, int count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Frustum culling of polygons, node boxes and wall quads.
+// Single polygons and boxes are tested against all six planes at once;
+// wall batches are tested several quads at a time against each plane.
+// Uses AVX or SSE when the compiler targets them, plain C otherwise.
+//
+//-----------------------------------------------------------------------------
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CULL_SSE
+#endif
+
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_misc.h"
+#include "r_local.h"
+#include "r_clipper.h"
+#include "r_cull.h"
+#include "z_zone.h"
+
+#if defined(CULL_AVX)
+
+typedef __m256 cullvec_t;
+
+#define CULL_WIDTH      8
+#define VLOAD(p)        _mm256_loadu_ps(p)
+#define VSET(f)         _mm256_set1_ps(f)
+#define VZERO()         _mm256_setzero_ps()
+#define VADD(a, b)      _mm256_add_ps(a, b)
+#define VMUL(a, b)      _mm256_mul_ps(a, b)
+#define VMAX(a, b)      _mm256_max_ps(a, b)
+#define VOR(a, b)       _mm256_or_ps(a, b)
+#define VGT(a, b)       _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define VMASK(a)        _mm256_movemask_ps(a)
+
+#elif defined(CULL_SSE)
+
+typedef __m128 cullvec_t;
+
+#define CULL_WIDTH      4
+#define VLOAD(p)        _mm_loadu_ps(p)
+#define VSET(f)         _mm_set1_ps(f)
+#define VZERO()         _mm_setzero_ps()
+#define VADD(a, b)      _mm_add_ps(a, b)
+#define VMUL(a, b)      _mm_mul_ps(a, b)
+#define VMAX(a, b)      _mm_max_ps(a, b)
+#define VOR(a, b)       _mm_or_ps(a, b)
+#define VGT(a, b)       _mm_cmpgt_ps(a, b)
+#define VMASK(a)        _mm_movemask_ps(a)
+
+#else
+
+#define CULL_WIDTH      1
+
+#endif
+
+// the six frustum planes by component, padded to eight with two planes
+// everything is in front of
+#define CULL_PLANES     8
+#define CULL_ALLPLANES  ((1 << CULL_PLANES) - 1)
+
+static float planea[CULL_PLANES];
+static float planeb[CULL_PLANES];
+static float planec[CULL_PLANES];
+static float planed[CULL_PLANES];
+
+// node boxes have no height; use the lowest floor and highest ceiling
+static float boxzmin;
+static float boxzmax;
+
+//
+// R_CullSetup
+// Called by R_FrustrumSetup once the planes are built
+//
+
+void R_CullSetup(void) {
+    fixed_t lo;
+    fixed_t hi;
+    int i;
+
+    for(i = 0; i < CULL_PLANES; i++) {
+        if(i < 6) {
+            planea[i] = frustum[i][0];
+            planeb[i] = frustum[i][1];
+            planec[i] = frustum[i][2];
+            planed[i] = frustum[i][3];
+        }
+        else {
+            planea[i] = planeb[i] = planec[i] = 0;
+            planed[i] = 1;
+        }
+    }
+
+    if(!numsectors) {
+        boxzmin = boxzmax = 0;
+        return;
+    }
+
+    lo = D_MAXINT;
+    hi = D_MININT;
+
+    // the heights the view is built from
+    for(i = 0; i < numsectors; i++) {
+        sector_t* s = &sectors[i];
+
+        lo = MIN(lo, s->frame_z1[1]);
+        hi = MAX(hi, s->frame_z2[1]);
+    }
+
+    boxzmin = F2D3D(lo);
+    boxzmax = F2D3D(hi);
+}
+
+//
+// R_CullPoint
+// Bit p is set if the point is in front of plane p
+//
+
+static d_inline int R_CullPoint(float x, float y, float z) {
+    int mask = 0;
+    int p;
+
+#if CULL_WIDTH > 1
+    cullvec_t vx = VSET(x);
+    cullvec_t vy = VSET(y);
+    cullvec_t vz = VSET(z);
+
+    for(p = 0; p < CULL_PLANES; p += CULL_WIDTH) {
+        cullvec_t d;
+
+        d = VADD(VADD(VADD(VMUL(VLOAD(planea + p), vx),
+                           VMUL(VLOAD(planeb + p), vy)),
+                      VMUL(VLOAD(planec + p), vz)),
+                 VLOAD(planed + p));
+
+        mask |= VMASK(VGT(d, VZERO())) << p;
+    }
+#else
+    for(p = 0; p < CULL_PLANES; p++) {
+        if(planea[p] * x + planeb[p] * y + planec[p] * z + planed[p] > 0) {
+            mask |= 1 << p;
+        }
+    }
+#endif
+
+    return mask;
+}
+
+//
+// R_FrustrumTestVertex
+// Returns false if polygon is not within the view frustrum
+//
+
+dboolean R_FrustrumTestVertex(vtx_t* vertex, int count) {
+    int mask = 0;
+    int i;
+
+    for(i = 0; i < count; i++) {
+        mask |= R_CullPoint(vertex[i].x, vertex[i].y, vertex[i].z);
+
+        if(mask == CULL_ALLPLANES) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// R_CullBox
+// Returns false if a node's bounding box is behind any frustum plane.
+// Only the box corner farthest in front of each plane is tested.
+//
+
+dboolean R_CullBox(fixed_t* bbox) {
+    float xmin = F2D3D(bbox[BOXLEFT]);
+    float xmax = F2D3D(bbox[BOXRIGHT]);
+    float ymin = F2D3D(bbox[BOXBOTTOM]);
+    float ymax = F2D3D(bbox[BOXTOP]);
+    int mask = 0;
+    int p;
+
+#if CULL_WIDTH > 1
+    for(p = 0; p < CULL_PLANES; p += CULL_WIDTH) {
+        cullvec_t a = VLOAD(planea + p);
+        cullvec_t b = VLOAD(planeb + p);
+        cullvec_t c = VLOAD(planec + p);
+        cullvec_t d;
+
+        d = VADD(VADD(VADD(VMAX(VMUL(a, VSET(xmin)), VMUL(a, VSET(xmax))),
+                           VMAX(VMUL(b, VSET(ymin)), VMUL(b, VSET(ymax)))),
+                      VMAX(VMUL(c, VSET(boxzmin)), VMUL(c, VSET(boxzmax)))),
+                 VLOAD(planed + p));
+
+        mask |= VMASK(VGT(d, VZERO())) << p;
+    }
+#else
+    for(p = 0; p < CULL_PLANES; p++) {
+        if(MAX(planea[p] * xmin, planea[p] * xmax) +
+                MAX(planeb[p] * ymin, planeb[p] * ymax) +
+                MAX(planec[p] * boxzmin, planec[p] * boxzmax) + planed[p] > 0) {
+            mask |= 1 << p;
+        }
+    }
+#endif
+
+    return mask == CULL_ALLPLANES;
+}
+
+//
+// R_CullBatchAlloc
+// Room for max quads, rounded up to whole vectors
+//
+
+void R_CullBatchAlloc(cullbatch_t* batch, int max) {
+    size_t size;
+    float* f;
+
+    if(batch->x1) {
+        Z_Free(batch->x1);
+    }
+
+    max = (max + 7) & ~7;
+    size = (sizeof(float) * 6 + 1) * max;
+
+    f = (float*)Z_Malloc(size, PU_STATIC, NULL);
+    dmemset(f, 0, size);
+
+    batch->x1 = f;
+    batch->y1 = f + max;
+    batch->x2 = f + max * 2;
+    batch->y2 = f + max * 3;
+    batch->top = f + max * 4;
+    batch->bottom = f + max * 5;
+    batch->visible = (byte*)(f + max * 6);
+    batch->count = 0;
+    batch->max = max;
+}
+
+//
+// R_CullBatchAdd
+// Returns the quad's index in the batch
+//
+
+int R_CullBatchAdd(cullbatch_t* batch, float x1, float y1, float x2, float y2,
+                   float top, float bottom) {
+    int i = batch->count;
+
+    if(i >= batch->max) {
+        I_Error("R_CullBatchAdd: batch is full (%i quads)", batch->max);
+    }
+
+    batch->x1[i] = x1;
+    batch->y1[i] = y1;
+    batch->x2[i] = x2;
+    batch->y2[i] = y2;
+    batch->top[i] = top;
+    batch->bottom[i] = bottom;
+    batch->count++;
+
+    return i;
+}
+
+//
+// R_CullBatch
+// Sets visible[i] for every queued quad with a corner in front of all
+// six planes, same as R_FrustrumTestVertex on its four vertices
+//
+
+void R_CullBatch(cullbatch_t* batch) {
+    int i;
+    int j;
+    int p;
+
+    for(i = 0; i < batch->count; i += CULL_WIDTH) {
+        int vis = (1 << CULL_WIDTH) - 1;
+
+#if CULL_WIDTH > 1
+        cullvec_t x1 = VLOAD(batch->x1 + i);
+        cullvec_t y1 = VLOAD(batch->y1 + i);
+        cullvec_t x2 = VLOAD(batch->x2 + i);
+        cullvec_t y2 = VLOAD(batch->y2 + i);
+        cullvec_t top = VLOAD(batch->top + i);
+        cullvec_t bottom = VLOAD(batch->bottom + i);
+        cullvec_t zero = VZERO();
+
+        for(p = 0; p < 6 && vis; p++) {
+            cullvec_t a = VSET(planea[p]);
+            cullvec_t b = VSET(planeb[p]);
+            cullvec_t c = VSET(planec[p]);
+            cullvec_t d = VSET(planed[p]);
+            cullvec_t s1 = VADD(VMUL(a, x1), VMUL(b, y1));
+            cullvec_t s2 = VADD(VMUL(a, x2), VMUL(b, y2));
+            cullvec_t ct = VMUL(c, top);
+            cullvec_t cb = VMUL(c, bottom);
+            cullvec_t in;
+
+            in = VOR(VOR(VGT(VADD(VADD(s1, ct), d), zero),
+                         VGT(VADD(VADD(s1, cb), d), zero)),
+                     VOR(VGT(VADD(VADD(s2, ct), d), zero),
+                         VGT(VADD(VADD(s2, cb), d), zero)));
+
+            vis &= VMASK(in);
+        }
+#else
+        for(p = 0; p < 6 && vis; p++) {
+            float s1 = planea[p] * batch->x1[i] + planeb[p] * batch->y1[i];
+            float s2 = planea[p] * batch->x2[i] + planeb[p] * batch->y2[i];
+            float ct = planec[p] * batch->top[i];
+            float cb = planec[p] * batch->bottom[i];
+
+            if(!(s1 + ct + planed[p] > 0 || s1 + cb + planed[p] > 0 ||
+                    s2 + ct + planed[p] > 0 || s2 + cb + planed[p] > 0)) {
+                vis = 0;
+            }
+        }
+#endif
+
+        for(j = 0; j < CULL_WIDTH && i + j < batch->count; j++) {
+            batch->visible[i + j] = (vis >> j) & 1;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _R_CULL_H_
+#define _R_CULL_H_
+
+#include "doomtype.h"
+#include "m_fixed.h"
+#include "gl_main.h"
+
+//
+// Wall quads queued by R_AddLeaf and tested against the frustum in one
+// call. Each quad is a seg's two end points and a top and bottom height,
+// kept in separate arrays so several quads are tested per instruction.
+//
+typedef struct {
+    float*  x1;
+    float*  y1;
+    float*  x2;
+    float*  y2;
+    float*  top;
+    float*  bottom;
+    byte*   visible;
+    int     count;
+    int     max;
+} cullbatch_t;
+
+void        R_CullSetup(void);
+dboolean    R_CullBox(fixed_t* bbox);
+dboolean    R_FrustrumTestVertex(vtx_t* vertex, int count);
+
+void        R_CullBatchAlloc(cullbatch_t* batch, int max);
+int         R_CullBatchAdd(cullbatch_t* batch, float x1, float y1, float x2, float y2,
+                           float top, float bottom);
+void        R_CullBatch(cullbatch_t* batch);
+
+#endif
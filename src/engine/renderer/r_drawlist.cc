@@ -32,14 +32,26 @@
 #include "gl_texture.h"
 #include "gl_main.h"
 #include "r_drawlist.h"
+#include "r_batch.h"
+#include "r_drawsort.h"
 #include "i_system.h"
 #include "z_zone.h"
+#include "con_console.h"
 
 static float envcolor[4] = { 0, 0, 0, 0 };
 
 drawlist_t drawlist[NUMDRAWLISTS];
 vtx_t drawVertex[MAXDLDRAWCOUNT];
 
+// sort scratch, one set per list so the prep thread can sort the world
+// lists while the automap sorts its own
+static drawkey_t *sortkeys[NUMDRAWLISTS];
+static drawkey_t *sorttmp[NUMDRAWLISTS];
+static vtxlist_t *sortlist[NUMDRAWLISTS];
+static int sortmax[NUMDRAWLISTS];
+
+static FILE *recordfile = NULL;
+
 extern BoolProperty r_texturecombiner;
 
 //
@@ -68,30 +80,111 @@ vtxlist_t *DL_AddVertexList(drawlist_t *dl) {
     list->flags = 0;
     list->texid = 0;
     list->params = 0;
+    list->batch = -1;
 
     return &dl->list[dl->index++];
 }
 
+//
+// GrowSortBuffers
+//
+
+static void GrowSortBuffers(int tag, int count) {
+    if(count <= sortmax[tag]) {
+        return;
+    }
+
+    sortmax[tag] = count;
+    sortkeys[tag] = (drawkey_t*)Z_Realloc(sortkeys[tag], count * sizeof(drawkey_t), PU_STATIC, NULL);
+    sorttmp[tag] = (drawkey_t*)Z_Realloc(sorttmp[tag], count * sizeof(drawkey_t), PU_STATIC, NULL);
+    sortlist[tag] = (vtxlist_t*)Z_Realloc(sortlist[tag], count * sizeof(vtxlist_t), PU_STATIC, NULL);
+}
+
 //
 // SortDrawList
+// Radix sorts the list by draw key and gathers the entries into that order
 //
 
-static int SortDrawList(const void *a, const void *b) {
-    vtxlist_t *xa = (vtxlist_t *)a;
-    vtxlist_t *xb = (vtxlist_t *)b;
+static void SortDrawList(drawlist_t *dl, int tag) {
+    drawkey_t *keys;
+    vtxlist_t *gather;
+    int i;
+
+    if(dl->index > sortmax[tag]) {
+        GrowSortBuffers(tag, dl->index * 2);
+    }
+
+    keys = sortkeys[tag];
+    gather = sortlist[tag];
+
+    for(i = 0; i < dl->index; i++) {
+        vtxlist_t *vl = &dl->list[i];
+
+        if(tag == DLT_SPRITE) {
+            keys[i].key = DL_SpriteKey(((visspritelist_t*)vl->data)->dist);
+        }
+        else {
+            keys[i].key = DL_WorldKey(vl->texid, vl->params);
+        }
+
+        keys[i].index = i;
+    }
 
-    return xb->texid - xa->texid;
+    DL_RadixSort(keys, sorttmp[tag], dl->index);
+
+    for(i = 0; i < dl->index; i++) {
+        gather[i] = dl->list[keys[i].index];
+    }
+
+    dmemcpy(dl->list, gather, dl->index * sizeof(vtxlist_t));
 }
 
 //
-// SortSprites
+// RecordDrawList
+// Appends the unsorted list to drawlists.txt for r_drawsort_test
 //
 
-static int SortSprites(const void *a, const void *b) {
-    visspritelist_t *xa = (visspritelist_t *)((const vtxlist_t *)a)->data;
-    visspritelist_t *xb = (visspritelist_t *)((const vtxlist_t *)b)->data;
+static void RecordDrawList(drawlist_t *dl, int tag) {
+    int i;
+
+    for(i = 0; i < dl->index; i++) {
+        vtxlist_t *vl = &dl->list[i];
+        int dist = tag == DLT_SPRITE ? ((visspritelist_t*)vl->data)->dist : 0;
 
-    return xb->dist - xa->dist;
+        fprintf(recordfile, "%i %i %i %i\n", tag, vl->texid, vl->params, dist);
+    }
+}
+
+//
+// DL_RecordNextFrame
+//
+
+void DL_RecordNextFrame(void) {
+    if(recordfile) {
+        return;
+    }
+
+    if(!(recordfile = fopen("drawlists.txt", "a"))) {
+        CON_Warnf("DL_RecordNextFrame: couldn't open drawlists.txt\n");
+        return;
+    }
+
+    fprintf(recordfile, "frame\n");
+}
+
+//
+// DL_FinishRecording
+// Called by R_RenderWorld once every list of the frame is drawn
+//
+
+void DL_FinishRecording(void) {
+    if(!recordfile) {
+        return;
+    }
+
+    fclose(recordfile);
+    recordfile = NULL;
+    CON_Printf(WHITE, "Draw lists written to drawlists.txt\n");
 }
 
 //
@@ -115,11 +208,12 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
     if(dl->max > 0) {
         int palette = 0;
 
-        if(tag != DLT_SPRITE) {
-            qsort(dl->list, dl->index, sizeof(vtxlist_t), SortDrawList);
+        if(recordfile && tag != DLT_AMAP) {
+            RecordDrawList(dl, tag);
         }
-        else if(dl->index >= 2) {
-            qsort(dl->list, dl->index, sizeof(vtxlist_t), SortSprites);
+
+        if(dl->index >= 2 && !dl->sorted) {
+            SortDrawList(dl, tag);
         }
 
         tail = &dl->list[dl->index];
@@ -156,7 +250,7 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
 
             // setup texture ID
             if(tag == DLT_SPRITE) {
-                int flags = ((visspritelist_t*)head->data)->spr->flags;
+                int flags = ((visspritelist_t*)head->data)->thing.flags;
 
                 // textid in sprites contains hack that stores palette index data
                 palette = head->texid >> 24;
@@ -198,7 +292,12 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                 GL_UpdateEnvTexture(D_RGBA(l, l, l, 0xff));
             }
 
-            dglDrawGeometry(drawcount, drawVertex);
+            if(drawcount) {
+                dglDrawGeometry(drawcount, drawVertex);
+            }
+
+            // anything queued from the static batches shares this texture
+            R_FlushBatches();
 
             // count vertex size
             if(devparm) {
@@ -211,6 +310,30 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
     }
 }
 
+//
+// DL_SortDrawList
+// Puts a list in draw order without drawing it, for -headless
+//
+
+void DL_SortDrawList(int tag) {
+    drawlist_t *dl = &drawlist[tag];
+
+    if(dl->index >= 2) {
+        SortDrawList(dl, tag);
+    }
+
+    dl->sorted = true;
+}
+
+//
+// DL_ResetDrawList
+//
+
+void DL_ResetDrawList(int tag) {
+    drawlist[tag].index = 0;
+    drawlist[tag].sorted = false;
+}
+
 //
 // DL_GetDrawListSize
 //
@@ -248,7 +371,11 @@ void DL_BeginDrawList(dboolean t, dboolean a) {
 
 //
 // DL_Init
-// Intialize draw lists
+// Intialize draw lists. The world lists get room for everything the
+// level could add in one frame, since they are filled on the prep
+// thread where nothing may be allocated: each seg has up to three
+// pieces plus a switch quad for each, each subsector a floor (two
+// when liquid) and a ceiling.
 //
 
 void DL_Init(void) {
@@ -258,8 +385,30 @@ void DL_Init(void) {
     for(i = 0; i < NUMDRAWLISTS; i++) {
         dl = &drawlist[i];
 
+        switch(i) {
+        case DLT_WALL:
+            dl->max = numsegs * 6;
+            break;
+        case DLT_FLAT:
+            dl->max = numsubsectors * 3;
+            break;
+        case DLT_SPRITE:
+            dl->max = MAXVISSPRITES;
+            break;
+        default:
+            dl->max = 0;
+            break;
+        }
+
+        if(i != DLT_AMAP) {
+            GrowSortBuffers(i, dl->max);
+        }
+
+        // DL_AddVertexList grows the list when its last entry is taken
+        dl->max++;
+
         dl->index   = 0;
-        dl->max     = 1;
+        dl->sorted  = false;
         dl->list    = (vtxlist_t*) Z_Calloc(sizeof(vtxlist_t) * dl->max, PU_LEVEL, 0);
     }
 }
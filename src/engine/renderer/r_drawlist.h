@@ -51,12 +51,14 @@ typedef struct {
     dtexture    texid;
     int         flags;
     int         params;
+    int         batch;      // static batch slot, -1 if built into drawVertex
 } vtxlist_t;
 
 typedef struct {
     vtxlist_t   *list;
     int         index;
     int         max;
+    dboolean    sorted;     // already put in draw order by DL_SortDrawList
 } drawlist_t;
 
 extern drawlist_t drawlist[NUMDRAWLISTS];
@@ -72,7 +74,11 @@ vtxlist_t *DL_AddVertexList(drawlist_t *dl);
 int DL_GetDrawListSize(int tag);
 void DL_BeginDrawList(dboolean t, dboolean a);
 void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*));
+void DL_SortDrawList(int tag);
+void DL_ResetDrawList(int tag);
 void DL_RenderDrawList(void);
+void DL_RecordNextFrame(void);
+void DL_FinishRecording(void);
 void DL_Init(void);
 
 #endif
@@ -0,0 +1,116 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Draw list sort keys.
+// Entries are sorted by a 64-bit key with a stable LSD radix sort, so
+// entries with equal keys keep the order R_RenderBSPNode added them in
+// (front to back).
+//
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "r_drawsort.h"
+
+#define RADIXBITS   8
+#define RADIXSIZE   (1 << RADIXBITS)
+#define RADIXPASSES (64 / RADIXBITS)
+
+//
+// DL_WorldKey
+// Walls and flats: texture (with its drawlist flags) descending, then
+// glow params, so state changes only happen between runs
+//
+
+uint64_t DL_WorldKey(int texid, int params) {
+    return ((uint64_t)(~(dword)texid) << 32) | (dword)params;
+}
+
+//
+// DL_SpriteKey
+// Sprites: farthest first
+//
+
+uint64_t DL_SpriteKey(int dist) {
+    return (uint64_t)(~((dword)dist ^ 0x80000000)) << 32;
+}
+
+//
+// DL_RadixSort
+// Sorts keys in place; tmp must hold count entries
+//
+
+void DL_RadixSort(drawkey_t *keys, drawkey_t *tmp, int count) {
+    int counts[RADIXPASSES][RADIXSIZE];
+    drawkey_t *src;
+    drawkey_t *dst;
+    drawkey_t *swap;
+    int pass;
+    int i;
+
+    if(count < 2) {
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+
+    for(i = 0; i < count; i++) {
+        uint64_t key = keys[i].key;
+
+        for(pass = 0; pass < RADIXPASSES; pass++) {
+            counts[pass][(key >> (pass * RADIXBITS)) & (RADIXSIZE - 1)]++;
+        }
+    }
+
+    src = keys;
+    dst = tmp;
+
+    for(pass = 0; pass < RADIXPASSES; pass++) {
+        int *c = counts[pass];
+        int shift = pass * RADIXBITS;
+        int sum = 0;
+
+        // every key has the same digit here
+        if(c[(src[0].key >> shift) & (RADIXSIZE - 1)] == count) {
+            continue;
+        }
+
+        for(i = 0; i < RADIXSIZE; i++) {
+            int n = c[i];
+
+            c[i] = sum;
+            sum += n;
+        }
+
+        for(i = 0; i < count; i++) {
+            dst[c[(src[i].key >> shift) & (RADIXSIZE - 1)]++] = src[i];
+        }
+
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if(src != keys) {
+        memcpy(keys, src, count * sizeof(drawkey_t));
+    }
+}
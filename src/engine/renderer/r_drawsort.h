@@ -0,0 +1,42 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _R_DRAWSORT_H_
+#define _R_DRAWSORT_H_
+
+#include <stdint.h>
+
+#include "doomtype.h"
+
+//
+// Sort key for a draw list entry; index is the entry's position in the list
+//
+typedef struct {
+    uint64_t    key;
+    int         index;
+} drawkey_t;
+
+uint64_t DL_WorldKey(int texid, int params);
+uint64_t DL_SpriteKey(int dist);
+void DL_RadixSort(drawkey_t *keys, drawkey_t *tmp, int count);
+
+#endif
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "r_drawsort.h"
+
+namespace {
+  // DLT_WALL, DLT_FLAT and DLT_SPRITE from r_drawlist.h
+  enum { wall, flat, sprite };
+
+  // The fields of vtxlist_t/visspritelist_t the old comparators looked at
+  struct Entry {
+      int texid;
+      int params;
+      int dist;
+  };
+
+  struct Frame {
+      std::vector<Entry> lists[3];
+  };
+
+  //
+  // Read drawlists.txt as written by the "dumpdrawlists" command.
+  //
+  std::vector<Frame> load_frames(const char *path)
+  {
+      std::ifstream file(path);
+      std::vector<Frame> frames;
+      std::string line;
+
+      while (std::getline(file, line)) {
+          if (line == "frame") {
+              frames.emplace_back();
+              continue;
+          }
+
+          std::istringstream ss(line);
+          int tag;
+          Entry e;
+          if (frames.empty() || !(ss >> tag >> e.texid >> e.params >> e.dist) || tag < 0 || tag > sprite)
+              continue;
+
+          frames.back().lists[tag].push_back(e);
+      }
+
+      return frames;
+  }
+
+  //
+  // Without a recording, fake a dense view: a few thousand walls and flats
+  // spread over ~150 textures, some glowing, and a few hundred sprites.
+  //
+  std::vector<Frame> synthetic_frames()
+  {
+      std::mt19937 rng(1234);
+      std::vector<Frame> frames(64);
+
+      for (auto &f : frames) {
+          for (int i = 0; i < 3000; ++i) {
+              int flags = (rng() % 8 == 0) ? 1 : 0;
+              f.lists[wall].push_back({ (flags << 16) | int(rng() % 150), flags ? int(rng() % 255) : 0, 0 });
+          }
+          for (int i = 0; i < 1500; ++i) {
+              f.lists[flat].push_back({ int(rng() % 60), 0, 0 });
+          }
+          for (int i = 0; i < 300; ++i) {
+              f.lists[sprite].push_back({ int(rng() % 400), 0, int(rng() % (4096 << 16)) });
+          }
+      }
+
+      return frames;
+  }
+
+  // The entry qsort moved around in DL_ProcessDrawList: 32 bytes of vtxlist_t
+  struct OldEntry {
+      void *data;
+      void *callback;
+      int texid;
+      int flags;
+      int params;
+      int pad;
+  };
+
+  int old_sort_world(const void *a, const void *b)
+  {
+      return static_cast<const OldEntry *>(b)->texid - static_cast<const OldEntry *>(a)->texid;
+  }
+
+  int old_sort_sprites(const void *a, const void *b)
+  {
+      auto xa = static_cast<const Entry *>(static_cast<const OldEntry *>(a)->data);
+      auto xb = static_cast<const Entry *>(static_cast<const OldEntry *>(b)->data);
+      return xb->dist - xa->dist;
+  }
+
+  uint64_t key_of(int tag, const Entry &e)
+  {
+      return tag == sprite ? DL_SpriteKey(e.dist) : DL_WorldKey(e.texid, e.params);
+  }
+
+  std::vector<int> radix_order(int tag, const std::vector<Entry> &list)
+  {
+      std::vector<drawkey_t> keys(list.size()), tmp(list.size());
+      for (size_t i = 0; i < list.size(); ++i) {
+          keys[i].key = key_of(tag, list[i]);
+          keys[i].index = i;
+      }
+
+      DL_RadixSort(keys.data(), tmp.data(), keys.size());
+
+      std::vector<int> order;
+      for (auto &k : keys) order.push_back(k.index);
+      return order;
+  }
+}
+
+TEST(DrawSort, matches_stable_sort)
+{
+    for (auto &f : synthetic_frames()) {
+        for (int tag : { wall, flat, sprite }) {
+            auto &list = f.lists[tag];
+
+            std::vector<int> expect(list.size());
+            for (size_t i = 0; i < list.size(); ++i) expect[i] = i;
+            std::stable_sort(expect.begin(), expect.end(),
+                             [&](int a, int b) { return key_of(tag, list[a]) < key_of(tag, list[b]); });
+
+            ASSERT_EQ(expect, radix_order(tag, list));
+        }
+    }
+}
+
+TEST(DrawSort, order)
+{
+    std::vector<Entry> list = {
+        { 5, 0, -10 }, { 7, 3, 100 }, { 5, 0, 100 }, { 7, 1, 0 }, { 0x10005, 9, 50 }
+    };
+
+    // textures descending, glow params grouped, ties kept in list order
+    ASSERT_EQ(std::vector<int>({ 4, 3, 1, 0, 2 }), radix_order(wall, list));
+
+    // farthest sprite first, equal distances in list order
+    ASSERT_EQ(std::vector<int>({ 1, 2, 4, 3, 0 }), radix_order(sprite, list));
+}
+
+//
+// Sorts the frames recorded in DRAWLIST_TRACE (see "dumpdrawlists"), or
+// synthetic ones, with the old qsort path and with radix sorted keys.
+//
+TEST(DrawSort, bench)
+{
+    auto path = std::getenv("DRAWLIST_TRACE");
+    auto frames = path ? load_frames(path) : synthetic_frames();
+    ASSERT_FALSE(frames.empty());
+
+    const int repeat = 20;
+    double old_ms = 0, new_ms = 0;
+    size_t entries = 0;
+
+    for (auto &f : frames) {
+        for (int tag : { wall, flat, sprite }) {
+            auto &list = f.lists[tag];
+            std::vector<OldEntry> old(list.size());
+            std::vector<OldEntry> scratch(list.size());
+            std::vector<drawkey_t> keys(list.size()), tmp(list.size());
+            entries += list.size();
+
+            for (size_t i = 0; i < list.size(); ++i) {
+                old[i] = { &list[i], nullptr, list[i].texid, 0, list[i].params, 0 };
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeat; ++r) {
+                auto sorted = old;
+                std::qsort(sorted.data(), sorted.size(), sizeof(OldEntry),
+                           tag == sprite ? old_sort_sprites : old_sort_world);
+            }
+            auto mid = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeat; ++r) {
+                auto sorted = old;
+                for (size_t i = 0; i < list.size(); ++i) {
+                    keys[i].key = key_of(tag, list[i]);
+                    keys[i].index = i;
+                }
+                DL_RadixSort(keys.data(), tmp.data(), keys.size());
+                for (size_t i = 0; i < list.size(); ++i) scratch[i] = sorted[keys[i].index];
+                std::copy(scratch.begin(), scratch.end(), sorted.begin());
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            old_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+            new_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+        }
+    }
+
+    std::cout << frames.size() << " frames, " << entries << " entries x" << repeat
+              << ": qsort " << old_ms << " ms, radix " << new_ms << " ms\n";
+}
@@ -27,6 +27,9 @@
 
 #include <math.h>
 #include <t_bsp.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -46,8 +49,10 @@
 #include "z_zone.h"
 #include "con_console.h"
 #include "r_drawlist.h"
+#include "r_batch.h"
 #include "gl_draw.h"
 #include "g_actions.h"
+#include "g_demo.h"
 
 int             skytexture;
 
@@ -80,6 +85,20 @@ unsigned int    glBindCalls = 0;
 
 dboolean        bRenderSky = false;
 
+//
+// The view is snapshotted at the end of each frame and its draw lists
+// are built on the prep thread while the game runs the next tic, then
+// drawn by the next R_RenderPlayerView. R_PrepShutdown stops the thread.
+//
+static std::thread              *prepthread = NULL;
+static std::mutex               *prepmutex = NULL;
+static std::condition_variable  *prepcond = NULL;
+static dboolean                 prepbusy = false;   // guarded by prepmutex
+static dboolean                 prepquit = false;   // guarded by prepmutex
+static dboolean                 prepready = false;
+static player_t                 *prepplayer = NULL;
+static int                      prepgametic = 0;
+
 FloatProperty r_fov("r_fov", "Field of view angle", 74.0f);
 BoolProperty r_fillmode("r_fillmode", "", true);
 BoolProperty r_uniformtime("r_uniformtime", "", false);
@@ -92,6 +111,7 @@ BoolProperty r_drawtrace("r_drawtrace", "", false);
 BoolProperty r_rendersprites("r_rendersprites", "", true);
 BoolProperty r_drawfill("r_drawfill", "", false);
 BoolProperty r_skybox("r_skybox", "", false);
+BoolProperty r_prepthread("r_prepthread", "Build the next view on its own thread while the game runs", true);
 
 IntProperty r_colorscale("r_colorscale", "", 0, 0,
                          [](const IntProperty&, int, int&)
@@ -138,6 +158,14 @@ static CMD(Wireframe) {
     R_DrawWireframe(b);
 }
 
+//
+// CMD_DumpDrawLists
+//
+
+static CMD(DumpDrawLists) {
+    DL_RecordNextFrame();
+}
+
 //
 // R_PointToAngle
 // To get a global angle from cartesian coordinates,
@@ -299,8 +327,10 @@ void R_Init(void) {
 
     GL_InitTextures();
     GL_ResetTextures();
+    Draw_Init();
 
     G_AddCommand("wireframe", CMD_Wireframe, 0);
+    G_AddCommand("dumpdrawlists", CMD_DumpDrawLists, 0);
 }
 
 //
@@ -353,8 +383,10 @@ void R_SetupLevel(void) {
     R_RefreshBrightness();
 
     DL_Init();
+    R_BuildLevelBatches();
 
     bRenderSky = true;
+    prepready = false;
 }
 
 //
@@ -365,12 +397,21 @@ void R_SetupLevel(void) {
 void R_PrecacheLevel(void) {
     char *texturepresent;
     char *spritepresent;
+    char *spritelumps;
+    int *texturelist;
+    int *spritelist;
+    int numtexturelist;
+    int numspritelist;
     int    i;
     int j;
     int    p;
-    int num;
     mobj_t* mo;
 
+    // nothing to upload to (-headless)
+    if(!usingGL) {
+        return;
+    }
+
     CON_DPrintf("--------R_PrecacheLevel--------\n");
     GL_DumpTextures();
 
@@ -392,41 +433,50 @@ void R_PrecacheLevel(void) {
         }
     }
 
-    num = 0;
+    //
+    // pull in the rest of the frames of animations the level uses.
+    // Bit 1 marks a texture the level uses, bit 2 a frame pulled in for
+    // one; a texture can be both, and any frame can be the one used.
+    // TODO - add support for precaching palettes
+    //
+    for(p = 0; p < numanimdef; p++) {
+        if(animdefs[p].palette) {
+            continue;
+        }
 
-    for(i = 0; i < numtextures; i++) {
-        if(texturepresent[i]) {
-            GL_BindWorldTexture(i, 0, 0);
-            num++;
+        for(j = 0; j < animdefs[p].frames; j++) {
+            if(texturepresent[animdefs[p].texnum + j] & 1) {
+                break;
+            }
+        }
 
-            for(p = 0; p < numanimdef; p++) {
-                auto l = wad::find(animdefs[p].name);
-                int lump = l->section_index();
+        if(j == animdefs[p].frames) {
+            continue;
+        }
 
-                if(lump != i) {
-                    continue;
-                }
+        for(j = 0; j < animdefs[p].frames; j++) {
+            texturepresent[animdefs[p].texnum + j] |= 2;
+        }
+    }
 
-                //
-                // TODO - add support for precaching palettes
-                //
-                if(!animdefs[p].palette) {
-                    for(j = 1; j < animdefs[p].frames; j++) {
-                        GL_BindWorldTexture(i + j, 0, 0);
-                        num++;
-                    }
-                }
-            }
+    texturelist = (int*)Z_Alloca(numtextures * sizeof(int));
+    numtexturelist = 0;
+
+    for(i = 0; i < numtextures; i++) {
+        if(texturepresent[i]) {
+            texturelist[numtexturelist++] = i;
         }
     }
 
-    CON_DPrintf("%i world textures cached\n", num);
+    CON_DPrintf("%i world textures cached\n", numtexturelist);
 
     for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
         spritepresent[mo->sprite] = 1;
     }
 
-    num = 0;
+    spritelist = (int*)Z_Alloca(numsprtex * sizeof(int));
+    spritelumps = (char*)Z_Alloca(numsprtex);
+    numspritelist = 0;
 
     //
     // TODO - add support for precaching palettes
@@ -440,24 +490,22 @@ void R_PrecacheLevel(void) {
 
             for(k = 0; k < sprdef->numframes; k++) {
                 spriteframe_t *sprframe;
-                int p;
 
                 sprframe = &sprdef->spriteframes[k];
-                if(sprframe->rotate) {
-                    for(p = 0; p < 8; p++) {
-                        GL_BindSpriteTexture(sprframe->lump[p], 0);
-                        num++;
+                for(p = 0; p < (sprframe->rotate ? 8 : 1); p++) {
+                    // mirrored rotations share a lump
+                    if(!spritelumps[sprframe->lump[p]]) {
+                        spritelumps[sprframe->lump[p]] = 1;
+                        spritelist[numspritelist++] = sprframe->lump[p];
                     }
                 }
-                else {
-                    GL_BindSpriteTexture(sprframe->lump[0], 0);
-                    num++;
-                }
             }
         }
     }
 
-    CON_DPrintf("%i sprites cached\n", num);
+    GL_PrecacheTextures(texturelist, numtexturelist, spritelist, numspritelist);
+
+    CON_DPrintf("%i sprites cached\n", numspritelist);
 
     if(GLAD_GL_ARB_multitexture) {
         GL_SetTextureUnit(1, true);
@@ -486,9 +534,9 @@ void R_SetupFrame(player_t *player) {
     //
     // reset list indexes
     //
-    drawlist[DLT_WALL].index = 0;
-    drawlist[DLT_FLAT].index = 0;
-    drawlist[DLT_SPRITE].index = 0;
+    DL_ResetDrawList(DLT_WALL);
+    DL_ResetDrawList(DLT_FLAT);
+    DL_ResetDrawList(DLT_SPRITE);
 
     renderplayer = player;
 
@@ -524,8 +572,6 @@ void R_SetupFrame(player_t *player) {
 
     viewcos[0]  = F2D3D(dcos(viewangle));
     viewcos[1]  = F2D3D(dcos(viewpitch - ANG90));
-
-    D_IncValidCount();
 }
 
 //
@@ -559,16 +605,49 @@ fixed_t R_Interpolate(fixed_t ticframe, fixed_t updateframe, dboolean enable) {
 
 //
 // R_InterpolateSectors
+// Takes the heights the view is built from. frame_z1[1] and frame_z2[1]
+// belong to the renderer; the game only writes the current heights.
 //
 
-static void R_InterpolateSectors(void) {
+static void R_InterpolateSectors(dboolean enable) {
     int i;
 
     for(i = 0; i < numsectors; i++) {
         sector_t* s = &sectors[i];
 
-        s->frame_z1[1] = R_Interpolate(s->floorheight, s->frame_z1[0], 1);
-        s->frame_z2[1] = R_Interpolate(s->ceilingheight, s->frame_z2[0], 1);
+        s->frame_z1[1] = R_Interpolate(s->floorheight, s->frame_z1[0], enable);
+        s->frame_z2[1] = R_Interpolate(s->ceilingheight, s->frame_z2[0], enable);
+    }
+}
+
+//
+// R_SnapshotSurfaces
+// Copies the textures, flags and light levels the game changes at
+// runtime into the frame_ fields the prep thread reads instead
+//
+
+static void R_SnapshotSurfaces(void) {
+    int i;
+
+    for(i = 0; i < numsectors; i++) {
+        sector_t* s = &sectors[i];
+
+        s->frame_floorpic = s->floorpic;
+        s->frame_ceilingpic = s->ceilingpic;
+        s->frame_lightlevel = s->lightlevel;
+        s->frame_flags = s->flags;
+    }
+
+    for(i = 0; i < numsides; i++) {
+        side_t* s = &sides[i];
+
+        s->frame_toptexture = s->toptexture;
+        s->frame_bottomtexture = s->bottomtexture;
+        s->frame_midtexture = s->midtexture;
+    }
+
+    for(i = 0; i < numlines; i++) {
+        lines[i].frame_flags = lines[i].flags;
     }
 }
 
@@ -806,11 +885,176 @@ static void R_DrawContextWall(line_t* line) {
     GL_SetState(GLSTATE_BLEND, 0);
 }
 
+//
+// R_PrepView
+// The CPU side of a frame: walks the BSP to build the draw lists and
+// sorts them. Reads only the snapshot taken by R_SnapshotView and the
+// level geometry, and never allocates; runs on the prep thread.
+//
+
+static void R_PrepView(void) {
+    uint64_t phasetic;
+
+    phasetic = timingdemo ? I_GetTimeUS() : 0;
+    R_RenderBSP();
+    phasetic = G_TimeDemoPhase(TDP_BSP, phasetic);
+
+    if(r_rendersprites) {
+        R_SetupSprites();
+    }
+
+    DL_SortDrawList(DLT_WALL);
+    DL_SortDrawList(DLT_FLAT);
+    DL_SortDrawList(DLT_SPRITE);
+    G_TimeDemoPhase(TDP_DRAWLIST, phasetic);
+}
+
+//
+// R_PrepThread
+//
+
+static void R_PrepThread(void) {
+    std::unique_lock<std::mutex> lock(*prepmutex);
+
+    while(1) {
+        prepcond->wait(lock, [] { return prepbusy || prepquit; });
+
+        if(prepquit) {
+            return;
+        }
+
+        lock.unlock();
+        R_PrepView();
+        lock.lock();
+
+        prepbusy = false;
+        prepcond->notify_all();
+    }
+}
+
+//
+// R_PrepThreaded
+// Starts the prep thread the first time it is wanted
+//
+
+static dboolean R_PrepThreaded(void) {
+    if(!r_prepthread || std::thread::hardware_concurrency() < 2) {
+        return false;
+    }
+
+    if(!prepthread) {
+        prepmutex = new std::mutex;
+        prepcond = new std::condition_variable;
+        prepthread = new std::thread(R_PrepThread);
+    }
+
+    return true;
+}
+
+//
+// R_PrepFinish
+// Waits for the view being prepared. Call before changing anything the
+// prep thread reads: the level, the frustum or the draw lists.
+//
+
+void R_PrepFinish(void) {
+    if(prepmutex) {
+        std::unique_lock<std::mutex> lock(*prepmutex);
+        prepcond->wait(lock, [] { return !prepbusy; });
+    }
+
+    R_MarkMappedLines();
+}
+
+//
+// R_PrepShutdown
+// Waits for the view being prepared, then stops the prep thread
+//
+
+void R_PrepShutdown(void) {
+    R_PrepFinish();
+
+    if(!prepthread) {
+        return;
+    }
+
+    prepmutex->lock();
+    prepquit = true;
+    prepmutex->unlock();
+    prepcond->notify_all();
+
+    prepthread->join();
+
+    delete prepthread;
+    delete prepcond;
+    delete prepmutex;
+    prepthread = NULL;
+    prepcond = NULL;
+    prepmutex = NULL;
+    prepquit = false;
+    prepready = false;
+}
+
+//
+// R_SnapshotView
+// Takes everything the prep thread needs: the view, the frustum, the
+// interpolated sector heights, the surfaces the game changes and the
+// things
+//
+
+static void R_SnapshotView(player_t *player) {
+    R_ClearSprites();
+    R_SetupFrame(player);
+
+    if(usingGL) {
+        R_SetViewMatrix();
+    }
+
+    R_SetViewClipping(R_FrustumAngle());
+    R_InterpolateSectors(*i_interpolateframes);
+    R_SnapshotSurfaces();
+    R_SnapshotThings();
+
+    prepplayer = player;
+    prepgametic = gametic;
+    prepready = true;
+}
+
+//
+// R_PrepStart
+// Snapshots the view and builds it, on the prep thread unless wait is set
+//
+
+static void R_PrepStart(player_t *player, dboolean wait) {
+    R_SnapshotView(player);
+
+    if(wait || !R_PrepThreaded()) {
+        R_PrepView();
+        R_MarkMappedLines();
+        return;
+    }
+
+    prepmutex->lock();
+    prepbusy = true;
+    prepmutex->unlock();
+    prepcond->notify_all();
+}
+
 //
 // R_RenderPlayerView
+// Draws the view prepared during the last tic, then starts on the next
+// one. The frame shown is one behind what R_SnapshotView would take now;
+// a view that is missing or more than a tic old is built on the spot.
 //
 
 void R_RenderPlayerView(player_t *player) {
+    R_PrepFinish();
+
+    if(!prepready || prepplayer != player ||
+            (prepgametic != gametic && prepgametic != gametic - 1)) {
+        R_PrepStart(player, true);
+    }
+
     if(!r_fillmode) {
         dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
@@ -819,16 +1063,6 @@ void R_RenderPlayerView(player_t *player) {
         renderTic = I_GetTimeMS();
     }
 
-    //
-    // clear sprite list
-    //
-    R_ClearSprites();
-
-    //
-    // setup draw frame
-    //
-    R_SetupFrame(player);
-
     //
     // check for t-junction cracks
     //
@@ -857,28 +1091,6 @@ void R_RenderPlayerView(player_t *player) {
     //
     NetUpdate();
 
-    //
-    // setup clipping
-    //
-    R_SetViewClipping(R_FrustumAngle());
-
-    //
-    // interpolate moving sectors before draw
-    //
-    if(i_interpolateframes) {
-        R_InterpolateSectors();
-    }
-
-    //
-    // traverse BSP for rendering
-    //
-    R_RenderBSPNode(numnodes-1);
-
-    //
-    // check for new console commands
-    //
-    NetUpdate();
-
     //
     // render world
     //
@@ -916,6 +1128,16 @@ void R_RenderPlayerView(player_t *player) {
         R_DrawReadDisk();
     }
 
+    //
+    // start on the next frame while the game runs
+    //
+    if(R_PrepThreaded()) {
+        R_PrepStart(player, false);
+    }
+    else {
+        prepready = false;
+    }
+
     if(devparm) {
         renderTic = (I_GetTimeMS() - renderTic);
     }
@@ -925,3 +1147,14 @@ void R_RenderPlayerView(player_t *player) {
     //
     NetUpdate();
 }
+
+//
+// R_PrepPlayerView
+// The CPU side of R_RenderPlayerView without touching GL. Used by
+// -headless, where the view is built while the next tic runs.
+//
+
+void R_PrepPlayerView(player_t *player) {
+    R_PrepFinish();
+    R_PrepStart(player, false);
+}
@@ -65,6 +65,7 @@ extern BoolProperty r_drawtrace;
 
 void R_Init(void);
 void R_RenderPlayerView(player_t *player);
+void R_PrepPlayerView(player_t *player);
 subsector_t *R_PointInSubsector(fixed_t x, fixed_t y);
 angle_t R_PointToAngle2(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2);
 angle_t R_PointToAngle(fixed_t x, fixed_t y);//note difference from sw version
@@ -78,7 +79,11 @@ void R_SetViewOffset(int offset);
 void R_DrawWireframe(dboolean enable);    //villsa
 void R_SetViewMatrix(void);
 void R_RenderWorld(void);
+void R_RenderBSP(void);
 void R_RenderBSPNode(int bspnum);
+void R_MarkMappedLines(void);
 void R_AllocSubsectorBuffer(void);
+void R_PrepFinish(void);
+void R_PrepShutdown(void);
 
 #endif
@@ -31,11 +31,10 @@
 #include "r_local.h"
 #include "r_sky.h"
 #include "r_drawlist.h"
+#include "r_batch.h"
 
-extern BoolProperty i_interpolateframes;
 extern BoolProperty r_texturecombiner;
 extern BoolProperty r_fog;
-extern BoolProperty r_rendersprites;
 extern BoolProperty st_flashoverlay;
 
 //
@@ -56,6 +55,10 @@ static dboolean ProcessWalls(vtxlist_t* vl, int* drawcount) {
         return false;
     }
 
+    if(R_BatchWall(vl, &drawVertex[*drawcount])) {
+        return true;
+    }
+
     dglTriangle(*drawcount + 0, *drawcount + 1, *drawcount + 2);
     dglTriangle(*drawcount + 3, *drawcount + 2, *drawcount + 1);
 
@@ -77,6 +80,10 @@ static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
     sector_t* sector;
     int count;
 
+    if(R_BatchFlat(vl)) {
+        return true;
+    }
+
     ss      = (subsector_t*)vl->data;
     leaf    = &leafs[ss->leaf];
     sector  = ss->sector;
@@ -109,19 +116,10 @@ static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
         v->y = F2D3D(leaf->vertex->y);
 
         if(vl->flags & DLF_CEILING) {
-            if(i_interpolateframes) {
-                v->z = F2D3D(sector->frame_z2[1]);
-            } else {
-                v->z = F2D3D(sector->ceilingheight);
-            }
+            v->z = F2D3D(sector->frame_z2[1]);
         }
         else {
-            if(i_interpolateframes) {
-                v->z = F2D3D(sector->frame_z1[1]);
-            }
-            else {
-                v->z = F2D3D(sector->floorheight);
-            }
+            v->z = F2D3D(sector->frame_z1[1]);
         }
 
         v->tu = F2D3D((leaf->vertex->x >> 6) - tx);
@@ -174,20 +172,14 @@ static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
 
 static dboolean ProcessSprites(vtxlist_t* vl, int* drawcount) {
     visspritelist_t* vis;
-    mobj_t* mobj;
 
     vis = (visspritelist_t*)vl->data;
-    mobj = vis->spr;
-
-    if(!mobj) {
-        return false;
-    }
 
     if(!vl->callback(vis, &drawVertex[*drawcount])) {
         return false;
     }
 
-    GL_SetState(GLSTATE_CULL, !(mobj->flags & MF_RENDERLASER));
+    GL_SetState(GLSTATE_CULL, !(vis->thing.flags & MF_RENDERLASER));
 
     dglTriangle(*drawcount + 0, *drawcount + 1, *drawcount + 2);
     dglTriangle(*drawcount + 3, *drawcount + 2, *drawcount + 1);
@@ -343,10 +335,6 @@ void R_RenderWorld(void) {
         spriteRenderTic = I_GetTimeMS();
     }
 
-    if(r_rendersprites) {
-        R_SetupSprites();
-    }
-
     dglDepthMask(GL_FALSE);
     DL_ProcessDrawList(DLT_SPRITE, ProcessSprites);
 
@@ -364,5 +352,8 @@ void R_RenderWorld(void) {
 
     // villsa 12152013 - make sure we're using the default blend function
     dglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    R_BatchFrameEnd();
+    DL_FinishRecording();
 }
 
@@ -362,7 +362,7 @@ static void R_DrawSkyboxCloud(void) {
     // bind cloud texture and set blending
     //
     GL_SetTextureUnit(0, true);
-    GL_BindGfxTexture(wad::find(skypicnum)->lump_name().data(), false);
+    GL_BindGfx(skypicnum, false);
     GL_SetState(GLSTATE_BLEND, 1);
 
     //
@@ -447,7 +447,7 @@ static void R_DrawSimpleSky(int lump, int offset) {
     int gfxLmp;
     float row;
 
-    gfxLmp = GL_BindGfxTexture(wad::find(lump)->lump_name().data(), true);
+    gfxLmp = GL_BindGfx(lump, true);
     height = gfxheight[gfxLmp];
     lumpheight = gfxorigheight[gfxLmp];
 
@@ -486,7 +486,7 @@ static void R_DrawVoidSky(void) {
 
 static void R_DrawTitleSky(void) {
     R_DrawSimpleSky(skypicnum, 240);
-    Draw_GfxImage(63, 25, sky->backdrop, D_RGBA(255, 255, 255, logoAlpha), false);
+    Draw_Gfx(63, 25, skybackdropnum, D_RGBA(255, 255, 255, logoAlpha), false);
 }
 
 //
@@ -498,7 +498,7 @@ static void R_DrawClouds(void) {
     vtx_t v[4];
 
     GL_SetTextureUnit(0, true);
-    GL_BindGfxTexture(wad::find(skypicnum)->lump_name().data(), false);
+    GL_BindGfx(skypicnum, false);
 
     pos = (TRUEANGLES(viewangle) / 360.0f) * 2.0f;
 
@@ -812,7 +812,7 @@ void R_DrawSky(void) {
             }
             else {
                 GL_SetTextureUnit(0, true);
-                GL_BindGfxTexture(wad::find(skypicnum)->lump_name().data(), true);
+                GL_BindGfx(skypicnum, true);
 
                 //
                 // drawer will assume that the texture's
@@ -845,7 +845,7 @@ void R_DrawSky(void) {
                 float base;
 
                 GL_SetTextureUnit(0, true);
-                l = GL_BindGfxTexture(wad::find(skybackdropnum)->lump_name().data(), true);
+                l = GL_BindGfx(skybackdropnum, true);
 
                 //
                 // handle the case for non-powers of 2 texture
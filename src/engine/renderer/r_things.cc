@@ -36,14 +36,13 @@
 #include "r_drawlist.h"
 #include "p_local.h"
 #include "r_clipper.h"
+#include "r_cull.h"
 #include "m_misc.h"
 #include "con_console.h"
 #include <imp/Wad>
 
 #include <stdlib.h>
 
-#define MAX_SPRITES    1024
-
 spritedef_t     *spriteinfo;
 int             numsprites;
 
@@ -51,8 +50,22 @@ spriteframe_t   sprtemp[29];
 int             maxframe;
 const char*     spritename;
 
-static visspritelist_t visspritelist[MAX_SPRITES];
+static visspritelist_t visspritelist[MAXVISSPRITES];
 static visspritelist_t *vissprite = NULL;
+static dboolean spriteoverflow = false;
+
+// every thing in the level as of the last R_SnapshotThings, grouped
+// by subsector: subsector i owns thingviews[subthings[i]] up to
+// thingviews[subthings[i + 1]]
+static thingview_t *thingviews = NULL;
+static int numthingviews = 0;
+static int maxthingviews = 0;
+static int *subthings = NULL;
+static int *subcursor = NULL;
+static int maxsubthings = 0;
+
+// sprite section index of BOLTA0, drawn for MF_RENDERLASER things
+static int laserspritenum = 0;
 
 extern IntProperty m_regionblood;
 extern BoolProperty st_flashoverlay;
@@ -144,6 +157,11 @@ void R_InitSprites(const char** namelist) {
 
     numsprites = check-namelist;
 
+    auto laser = wad::find_index(wad::Section::sprites, "BOLTA0");
+    if(laser.have_value()) {
+        laserspritenum = (int)*laser;
+    }
+
     if(!numsprites) {
         return;
     }
@@ -242,28 +260,129 @@ void R_InitSprites(const char** namelist) {
 }
 
 //
-// R_AddSprites
+// R_SnapshotThings
+// Copies what R_AddSprites needs of every thing, so the view can be
+// built while the game runs the next tic. Main thread only.
 //
 
-void R_AddSprites(subsector_t *sub) {
+void R_SnapshotThings(void) {
+    dboolean interpolate = *i_interpolateframes;
     mobj_t* thing;
+    int count;
+    int i;
 
-    // Handle all things in sector.
-    for(thing = sub->sector->thinglist; thing; thing = thing->snext) {
-        if(thing->subsector != sub) { // don't add sprite if it doesn't belong in this subsector
-            continue;
+    if(spriteoverflow) {
+        CON_Warnf("R_AddSprites: Sprite overflow");
+        spriteoverflow = false;
+    }
+
+    if(numsubsectors + 1 > maxsubthings) {
+        maxsubthings = numsubsectors + 1;
+        subthings = (int*)Z_Realloc(subthings, maxsubthings * sizeof(int), PU_STATIC, NULL);
+        subcursor = (int*)Z_Realloc(subcursor, maxsubthings * sizeof(int), PU_STATIC, NULL);
+    }
+
+    dmemset(subthings, 0, (numsubsectors + 1) * sizeof(int));
+    count = 0;
+
+    for(i = 0; i < numsectors; i++) {
+        for(thing = sectors[i].thinglist; thing; thing = thing->snext) {
+            if(thing->flags & MF_NOSECTOR) {
+                continue;
+            }
+
+            subthings[(thing->subsector - subsectors) + 1]++;
+            count++;
         }
+    }
 
-        if(thing->flags & MF_NOSECTOR) {
-            continue;
+    if(count > maxthingviews) {
+        maxthingviews = count * 2;
+        thingviews = (thingview_t*)Z_Realloc(thingviews,
+                                             maxthingviews * sizeof(thingview_t), PU_STATIC, NULL);
+    }
+
+    for(i = 0; i < numsubsectors; i++) {
+        subthings[i + 1] += subthings[i];
+        subcursor[i] = subthings[i];
+    }
+
+    // walking each sector's list keeps the order R_AddSprites used to
+    // find things in
+    for(i = 0; i < numsectors; i++) {
+        for(thing = sectors[i].thinglist; thing; thing = thing->snext) {
+            thingview_t* tv;
+
+            if(thing->flags & MF_NOSECTOR) {
+                continue;
+            }
+
+            tv = &thingviews[subcursor[thing->subsector - subsectors]++];
+
+            tv->x = thing->x;
+            tv->y = thing->y;
+            tv->z = thing->z;
+            tv->ix = R_Interpolate(thing->x, thing->frame_x, interpolate);
+            tv->iy = R_Interpolate(thing->y, thing->frame_y, interpolate);
+            tv->iz = R_Interpolate(thing->z, thing->frame_z, interpolate);
+            tv->radius = thing->radius;
+            tv->height = thing->height;
+            tv->angle = thing->angle;
+            tv->type = thing->type;
+            tv->sprite = thing->sprite;
+            tv->frame = thing->frame;
+            tv->flags = thing->flags;
+            tv->alpha = thing->alpha;
+            tv->palette = thing->player ? thing->player->palette : thing->info->palette;
+            tv->sector = thing->subsector->sector;
+            tv->player = thing->player;
+            tv->haslaser = false;
+
+            // cameras and player's self are an exception
+            // unless viewing self from camera
+            tv->hidden = (thing->type == MT_PLAYER && thing->player == renderplayer &&
+                          renderplayer->cameratarget == renderplayer->mo);
+
+            if((thing->flags & MF_RENDERLASER) && thing->extradata) {
+                laser_t* laser = (laser_t*)thing->extradata;
+
+                tv->haslaser = true;
+                tv->laser[0] = laser->x1;
+                tv->laser[1] = laser->y1;
+                tv->laser[2] = laser->z1;
+                tv->laser[3] = laser->x2;
+                tv->laser[4] = laser->y2;
+                tv->laser[5] = laser->z2;
+                tv->laserangle = laser->angle;
+            }
         }
+    }
+
+    numthingviews = count;
+}
+
+//
+// R_AddSprites
+//
 
-        if(vissprite - visspritelist >= MAX_SPRITES) {
-            CON_Warnf("R_AddSprites: Sprite overflow");
+void R_AddSprites(subsector_t *sub) {
+    int i;
+    int end;
+
+    if(!subthings) {
+        return;
+    }
+
+    i = subthings[sub - subsectors];
+    end = subthings[(sub - subsectors) + 1];
+
+    for(; i < end; i++) {
+        if(vissprite - visspritelist >= MAXVISSPRITES) {
+            spriteoverflow = true;
             return;
         }
 
-        vissprite->spr = thing;
+        vissprite->thing = thingviews[i];
         vissprite++;
     }
 }
@@ -286,9 +405,9 @@ static void R_AddVisSprite(visspritelist_t* vissprite) {
     angle_t         ang;
     int             spritenum;
     int             rot;
-    mobj_t*         thing;
+    thingview_t*    thing;
 
-    thing = vissprite->spr;
+    thing = &vissprite->thing;
 
     if(thing->sprite == SPR_SPOT &&
             !(thing->flags & MF_RENDERLASER)) {
@@ -296,7 +415,7 @@ static void R_AddVisSprite(visspritelist_t* vissprite) {
     }
 
     if(thing->flags & MF_RENDERLASER) {
-        spritenum = wad::find("BOLTA0")->section_index();
+        spritenum = laserspritenum;
     }
     else {
         sprdef = &spriteinfo[thing->sprite];
@@ -339,7 +458,7 @@ static dboolean R_GenerateSpritePlane(void *data, vtx_t* vertex) {
     int             rot;
     float           dx1;
     float           dx2;
-    mobj_t*         thing;
+    thingview_t*    thing;
     float           offs;
     float           dy1;
     float           dy2;
@@ -349,7 +468,7 @@ static dboolean R_GenerateSpritePlane(void *data, vtx_t* vertex) {
     float           z2;
 
 
-    thing = vissprite->spr;
+    thing = &vissprite->thing;
     x = vissprite->x;
     y = vissprite->y;
 
@@ -386,7 +505,7 @@ static dboolean R_GenerateSpritePlane(void *data, vtx_t* vertex) {
     }
     else {
         R_LightToVertex(vertex,
-                        thing->subsector->sector->colors[LIGHT_THING], 4);
+                        thing->sector->colors[LIGHT_THING], 4);
     }
 
     vertex[0].a = vertex[1].a = vertex[2].a = vertex[3].a = thing->alpha;
@@ -469,22 +588,19 @@ static dboolean R_GenerateLaserPlane(void *data, vtx_t* vertex) {
     float           z;
     float           dx1;
     float           dx2;
-    mobj_t*         thing;
-    laser_t*        laser;
+    thingview_t*    thing;
     float           s;
     float           c;
     int             spritenum;
 
-    thing = vissprite->spr;
+    thing = &vissprite->thing;
 
     // must have data present
-    if(!thing->extradata) {
+    if(!thing->haslaser) {
         return false;
     }
 
-    laser = (laser_t*)thing->extradata;
-
-    spritenum = wad::find("BOLTA0")->section_index();
+    spritenum = laserspritenum;
 
     dglSetVertexColor(vertex, D_RGBA(255, 0, 0, thing->alpha), 4);
 
@@ -495,15 +611,15 @@ static dboolean R_GenerateLaserPlane(void *data, vtx_t* vertex) {
     vertex[2].tv = vertex[3].tv = 0;
 
     // get angles
-    s = F2D3D(dsin(laser->angle + ANG90));
-    c = F2D3D(dcos(laser->angle + ANG90));
+    s = F2D3D(dsin(thing->laserangle + ANG90));
+    c = F2D3D(dcos(thing->laserangle + ANG90));
 
     // setup vertex coordinates
 
     // start of laser
-    x = F2D3D(laser->x1);
-    y = F2D3D(laser->y1);
-    z = F2D3D(laser->z1);
+    x = F2D3D(thing->laser[0]);
+    y = F2D3D(thing->laser[1]);
+    z = F2D3D(thing->laser[2]);
 
     dx1 = -spritetopoffset[spritenum];
     dx2 = dx1 + (float)spriteheight[spritenum];
@@ -517,9 +633,9 @@ static dboolean R_GenerateLaserPlane(void *data, vtx_t* vertex) {
     vertex[0].z = vertex[2].z = z;
 
     // end of laser
-    x = F2D3D(laser->x2);
-    y = F2D3D(laser->y2);
-    z = F2D3D(laser->z2);
+    x = F2D3D(thing->laser[3]);
+    y = F2D3D(thing->laser[4]);
+    z = F2D3D(thing->laser[5]);
 
     vertex[1].x = x + (c * dx1);
     vertex[1].y = y + (s * dx1);
@@ -542,30 +658,30 @@ static dboolean R_GenerateLaserPlane(void *data, vtx_t* vertex) {
 
 static void AddSpriteDrawlist(drawlist_t *dl, visspritelist_t *vis, int texid) {
     vtxlist_t *list;
-    mobj_t* mobj;
+    thingview_t* thing;
 
     list = DL_AddVertexList(dl);
     list->data = (visspritelist_t*)vis;
 
-    if(vis->spr->flags & MF_RENDERLASER) {
+    if(vis->thing.flags & MF_RENDERLASER) {
         list->callback = R_GenerateLaserPlane;
     }
     else {
         list->callback = R_GenerateSpritePlane;
     }
 
-    mobj = vis->spr;
+    thing = &vis->thing;
 
-    if(mobj->subsector->sector->lightlevel) {
+    if(thing->sector->frame_lightlevel) {
         // add sprite's gamma glow values as a flag
 
         list->flags |= DLF_GLOW;
-        list->params = mobj->subsector->sector->lightlevel;
+        list->params = thing->sector->frame_lightlevel;
     }
 
     // hack to include info on palette indexes
     list->texid =
-        (texid | ((mobj->player ? mobj->player->palette : mobj->info->palette) << 24)
+        (texid | (thing->palette << 24)
          | (list->flags << 16));
 }
 
@@ -574,39 +690,36 @@ static void AddSpriteDrawlist(drawlist_t *dl, visspritelist_t *vis, int texid) {
 //
 
 void R_SetupSprites(void) {
-    dboolean interpolate = *i_interpolateframes;
     visspritelist_t *vis;
 
     for(vis = vissprite - 1; vis >= visspritelist; vis--) {
+        thingview_t* thing = &vis->thing;
+
         // Avoid from having the torch poles and fire from z-fighting
-        if(vis->spr->type >= MT_PROP_POLEBASELONG &&
-                vis->spr->type <= MT_PROP_FIREYELLOW) {
-            angle_t ang = R_PointToAngle(vis->spr->x - viewx, vis->spr->y - viewy);
+        if(thing->type >= MT_PROP_POLEBASELONG &&
+                thing->type <= MT_PROP_FIREYELLOW) {
+            angle_t ang = R_PointToAngle(thing->x - viewx, thing->y - viewy);
 
             // fire sprites are moved away from view while torches are moved towards view
-            if(vis->spr->type >= MT_PROP_FIREBLUE && vis->spr->type <= MT_PROP_FIREYELLOW) {
+            if(thing->type >= MT_PROP_FIREBLUE && thing->type <= MT_PROP_FIREYELLOW) {
                 ang += ANG180;
             }
 
             // move a bit further towards view
-            vis->x = F2D3D(vis->spr->x - FixedMul(FLOATTOFIXED(1.5), dcos(ang)));
-            vis->y = F2D3D(vis->spr->y - FixedMul(FLOATTOFIXED(1.5), dsin(ang)));
-            vis->z = F2D3D(R_Interpolate(vis->spr->z, vis->spr->frame_z, interpolate));
+            vis->x = F2D3D(thing->x - FixedMul(FLOATTOFIXED(1.5), dcos(ang)));
+            vis->y = F2D3D(thing->y - FixedMul(FLOATTOFIXED(1.5), dsin(ang)));
+            vis->z = F2D3D(thing->iz);
         }
         else {  // normal vis sprite process
-            vis->x = F2D3D(R_Interpolate(vis->spr->x, vis->spr->frame_x, interpolate));
-            vis->y = F2D3D(R_Interpolate(vis->spr->y, vis->spr->frame_y, interpolate));
-            vis->z = F2D3D(R_Interpolate(vis->spr->z, vis->spr->frame_z, interpolate));
+            vis->x = F2D3D(thing->ix);
+            vis->y = F2D3D(thing->iy);
+            vis->z = F2D3D(thing->iz);
         }
 
         vis->dist = (int)((vis->x - fviewx) * viewcos[0] +
                           (vis->y - fviewy) * viewsin[0]) / 2;
 
-        // cameras and player's self are an exception
-        // unless viewing self from camera
-        if((vis->spr->type == MT_PLAYER) &&
-                ((vis->spr->player == renderplayer) &&
-                 (renderplayer->cameratarget == renderplayer->mo))) {
+        if(thing->hidden) {
             continue;
         }
 
@@ -758,7 +871,7 @@ void R_DrawThingBBox(void) {
     float   z1;
     float   z2;
     int     i;
-    mobj_t* thing;
+    thingview_t* thing;
 
 #define DRAWBBOXPOLY(b1, b2, z) \
     dglVertex3f(bbox[b1], bbox[b2], z)
@@ -792,7 +905,7 @@ void R_DrawThingBBox(void) {
     dglDepthRange(0.0f, 0.0f);
 
     for(i = 0; i < (vissprite - visspritelist); i++) {
-        thing = visspritelist[i].spr;
+        thing = &visspritelist[i].thing;
 
         if(thing->player && thing->player->cameratarget == thing->player->mo) {
             continue;
@@ -30,15 +30,46 @@
 #include "d_player.h"
 #include "gl_main.h"
 
+#define MAXVISSPRITES   1024
+
+//
+// What the renderer needs of a thing, copied by R_SnapshotThings so the
+// frame can be built and drawn after the mobj has moved on or been freed
+//
+typedef struct {
+    fixed_t     x;
+    fixed_t     y;
+    fixed_t     z;
+    fixed_t     ix;         // interpolated position
+    fixed_t     iy;
+    fixed_t     iz;
+    fixed_t     radius;
+    fixed_t     height;
+    angle_t     angle;
+    int         type;
+    int         sprite;
+    int         frame;
+    dword       flags;
+    int         alpha;
+    int         palette;
+    sector_t*   sector;
+    player_t*   player;
+    dboolean    hidden;     // the view's own player
+    dboolean    haslaser;
+    fixed_t     laser[6];   // x1, y1, z1, x2, y2, z2
+    angle_t     laserangle;
+} thingview_t;
+
 typedef struct {
-    mobj_t* spr;
-    fixed_t dist;
-    float   x;
-    float   y;
-    float   z;
+    thingview_t thing;
+    fixed_t     dist;
+    float       x;
+    float       y;
+    float       z;
 } visspritelist_t;
 
 void R_InitSprites(const char** namelist);
+void R_SnapshotThings(void);
 void R_AddSprites(subsector_t *sub);
 void R_SetupSprites(void);
 void R_ClearSprites(void);
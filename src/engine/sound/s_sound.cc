@@ -108,12 +108,12 @@ int S_AdjustSoundParams(fixed_t x, fixed_t y, int* vol, int* sep);
 //
 
 void S_Init(void) {
-    if(M_CheckParm("-nosound")) {
+    if(M_CheckParm("-nosound") || headless) {
         nosound = true;
         CON_DPrintf("Sounds disabled\n");
     }
 
-    if(M_CheckParm("-nomusic")) {
+    if(M_CheckParm("-nomusic") || headless) {
         nomusic = true;
         CON_DPrintf("Music disabled\n");
     }
@@ -184,8 +184,6 @@ void S_StopMusic(void) {
 //
 
 void S_ResetSound(void) {
-    int i;
-
     if(nosound && nomusic) {
         return;
     }
@@ -194,9 +192,7 @@ void S_ResetSound(void) {
 
     // villsa 12282013 - make sure we clear all sound sources
     // during level transition
-    for(i = 0; i < I_GetMaxChannels(); i++) {
-        I_RemoveSoundSource(i);
-    }
+    I_RemoveSoundSource(NULL);
 }
 
 //
@@ -244,18 +240,7 @@ int S_GetActiveSounds(void) {
 //
 
 void S_RemoveOrigin(mobj_t* origin) {
-    int     channels;
-    mobj_t* source;
-    int     i;
-
-    channels = I_GetMaxChannels();
-
-    for(i = 0; i < channels; i++) {
-        source = (mobj_t*)I_GetSoundSource(i);
-        if(origin == source) {
-            I_RemoveSoundSource(i);
-        }
-    }
+    I_RemoveSoundSource((sndsrc_t*)origin);
 }
 
 //
@@ -110,6 +110,8 @@ static byte             st_flash_g;
 static byte             st_flash_b;
 static byte             st_flash_a;
 static int              st_jmessages[ST_JMESSAGES];   // japan-specific messages
+static int              st_statusgfx;
+static int              st_crosshairgfx;
 static dboolean         st_hasjmsg = false;
 static dboolean         st_wpndisplay_show;
 static byte             st_wpndisplay_alpha;
@@ -570,7 +572,7 @@ static void ST_DrawStatus(void) {
     const rcolor color = D_RGBA(0x68, 0x68, 0x68, 0x90);
 
     GL_SetState(GLSTATE_BLEND, 1);
-    lump = GL_BindGfxTexture("STATUS", true);
+    lump = GL_BindGfx(st_statusgfx, true);
 
     width = (float)gfxwidth[lump];
     height = (float)gfxheight[lump];
@@ -672,7 +674,7 @@ void ST_DrawCrosshair(int x, int y, int slot, byte scalefactor, rcolor color) {
 
     index = slot - 1;
 
-    GL_BindGfxTexture("CRSHAIRS", true);
+    GL_BindGfx(st_crosshairgfx, true);
     GL_SetState(GLSTATE_BLEND, 1);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
@@ -694,7 +696,7 @@ void ST_DrawCrosshair(int x, int y, int slot, byte scalefactor, rcolor color) {
 static void ST_DrawJMessage(int pic) {
     int lump = st_jmessages[pic];
 
-    GL_BindGfxTexture(wad::find(lump)->lump_name().data(), true);
+    GL_BindGfx(lump, true);
     GL_SetState(GLSTATE_BLEND, 1);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
@@ -1083,9 +1085,11 @@ void ST_Init(void) {
     // setup crosshairs
 
     st_crosshairs = 0;
+    st_statusgfx = GL_GfxLump("STATUS");
+    st_crosshairgfx = GL_GfxLump("CRSHAIRS");
 
-    if(auto lump = wad::find("CRSHAIRS")) {
-        st_crosshairs = (gfxwidth[lump->section_index()] / ST_CROSSHAIRSIZE);
+    if(st_crosshairgfx >= 0) {
+        st_crosshairs = (gfxwidth[st_crosshairgfx] / ST_CROSSHAIRSIZE);
     }
 
     dmgmarkers.next = dmgmarkers.prev = &dmgmarkers;
@@ -1096,9 +1100,7 @@ void ST_Init(void) {
         char name[9];
 
         sprintf(name, "JPMSG%02d", i + 1);
-        st_jmessages[i] = -1;
-        if (auto lump = wad::find(name))
-            st_jmessages[i] = lump->section_index();
+        st_jmessages[i] = GL_GfxLump(name);
 
         if(st_jmessages[i] != -1) {
             st_hasjmsg = true;
@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
 
 #include "SDL.h"
 #include "fluidsynth.h"
@@ -49,21 +50,6 @@
 // 20120203 villsa - cvar for soundfont location
 StringProperty s_soundfont("s_soundfont", "doomsnd.sf2 location", "doomsnd.sf2"_sv);
 
-//
-// Mutex
-//
-static SDL_mutex *lock = NULL;
-#define MUTEX_LOCK()    SDL_mutexP(lock);
-#define MUTEX_UNLOCK()  SDL_mutexV(lock);
-
-//
-// Semaphore stuff
-//
-
-static SDL_sem *semaphore = NULL;
-#define SEMAPHORE_LOCK()    if(SDL_SemWait(semaphore) == 0) {
-#define SEMAPHORE_UNLOCK()  SDL_SemPost(semaphore); }
-
 // 20120205 villsa - bool to determine if sequencer is ready or not
 static dboolean seqready = false;
 
@@ -77,11 +63,16 @@ static dboolean seqready = false;
 #define MIDI_SET_TEMPO  0x51
 #define MIDI_SEQUENCER  0x7f
 
+#define SEQ_SAMPLERATE  44100
+#define SEQ_QUEUESIZE   256     // must be a power of two
+#define SEQ_POSTWAIT    100     // ms the game waits for a free slot
+#define SEQ_MAXSOURCES  512     // must be a power of two
+
 //
 // MIDI DATA DEFINITIONS
 //
 // These data should not be modified outside the
-// audio thread unless they're being initialized
+// audio callback unless they're being initialized
 //
 
 typedef struct {
@@ -108,13 +99,11 @@ typedef struct {
 // SEQUENCER CHANNEL
 //
 // Active channels play sound or whatever
-// is being fed from the midi reader. This
-// is where communication between the audio
-// thread and the game could get dangerous
-// as they both need to access and modify
-// data. In order to avoid this, certain
-// properties have been divided up for
-// both the audio thread and game code only
+// is being fed from the midi reader. Channels
+// are only started and stopped by the audio
+// callback; the game asks for that through
+// the command queue, and sets volume and pan
+// through chanmix
 //
 
 typedef enum {
@@ -134,17 +123,14 @@ typedef struct {
     // used primarily by normal sounds
     byte        id;
 
-    // these are both accessed by the
-    // audio thread and the game code
-    // and should lock and unlock
-    // the mutex whenever these need
-    // to be modified..
+    // set when the channel starts; volume and
+    // pan are then taken from chanmix
     float       volume;
     byte        pan;
-    sndsrc_t*   origin;
+    unsigned int handle;
     int         depth;
 
-    // accessed by the audio thread only
+    // accessed by the audio callback only
     byte        key;
     byte        velocity;
     byte*       pos;
@@ -158,42 +144,55 @@ typedef struct {
     chanstate_e state;
     dboolean    paused;
 
-    // read by audio thread but only
-    // modified by game code
+    // set by the audio callback when a stop
+    // command arrives
     dboolean    stop;
-    float       basevol;
 } channel_t;
 
 static channel_t playlist[MIDI_CHANNELS];   // channels active in sequencer
 
+//
+// the only channel state shared between the game and the
+// audio callback. chanhandles holds the handle of the sound
+// a channel is playing (0 if none) and is only written by
+// the callback. chanmix holds the volume and pan the game
+// last set for a handle and is only written by the game;
+// the callback ignores it once the channel has moved on
+// to another sound
+//
+
+static std::atomic<unsigned int> chanhandles[MIDI_CHANNELS];
+static std::atomic<uint64_t> chanmix[MIDI_CHANNELS];
+
+#define CHANMIX(handle, vol, pan) \
+    (((uint64_t)(handle) << 32) | ((uint64_t)((vol) & 0xffff) << 8) | (byte)(pan))
+
+//
+// SOUND SOURCES
+//
+// game side only. each started sound gets a handle and its
+// origin is kept here, so the audio callback never sees a
+// game pointer. a handle's slot is reused SEQ_MAXSOURCES
+// sounds later, after which the sound has no origin
+//
+
+typedef struct {
+    unsigned int    handle;
+    sndsrc_t*       origin;
+} soundsource_t;
+
+static soundsource_t soundsources[SEQ_MAXSOURCES];
+static unsigned int soundserial = 0;
+
 //
 // DOOM SEQUENCER
 //
 // the backbone of the sequencer system. handles
 // global volume and panning for all sounds/tracks
 // and holds the allocated list of midi songs.
-// all data is modified through the game and read
-// by the audio thread.
-//
-
-typedef int seqsignal_e;
-enum {
-    SEQ_SIGNAL_IDLE     = 0,    // idles. does nothing
-    SEQ_SIGNAL_SHUTDOWN,        // signal the sequencer to shutdown, cleaning up anything in the process
-    SEQ_SIGNAL_READY,           // sequencer will read and play any midi track fed to it
-    SEQ_SIGNAL_RESET,
-    SEQ_SIGNAL_PAUSE,
-    SEQ_SIGNAL_RESUME,
-    SEQ_SIGNAL_STOPALL,
-    SEQ_SIGNAL_SETGAIN,         // signal the sequencer to update output gain
-    MAXSIGNALTYPES
-};
-
-typedef union {
-    sndsrc_t*   valsrc;
-    int         valint;
-    float       valfloat;
-} seqmessage_t;
+// the songs are run from the audio callback,
+// using the count of samples rendered as its clock
+//
 
 typedef struct {
     // library specific stuff. should never
@@ -202,9 +201,12 @@ typedef struct {
     fluid_synth_t*          synth;
     fluid_audio_driver_t*   driver;
     int                     sfont_id; // 20120112 bkw: needs to be signed
-    SDL_Thread*             thread;
     dword                   playtime;
 
+    // sample clock, only advanced by the audio callback
+    uint64_t                samples;
+    int                     samplerate;
+
     dword                   voices;
 
     // tweakable settings for the sequencer
@@ -215,33 +217,51 @@ typedef struct {
     song_t*                 songs;
     int                     nsongs;
 
-    seqmessage_t            message[3];
-
-    // game code signals the sequencer to do stuff. game will
-    // wait (while loop) until the audio thread signals itself
-    // to be ready again
-    // MP2E 12102013 - Only change using Seq_SetStatus
-    seqsignal_e             signal;
-
     // 20120316 villsa - gain property (tweakable)
     float                   gain;
 } doomseq_t;
 
 static doomseq_t doomseq = {0};   // doom sequencer
 
-typedef void(*eventhandler)(doomseq_t*, channel_t*);
-typedef int(*signalhandler)(doomseq_t*);
-
 //
-// Audio_Play
+// SEQUENCER COMMANDS
 //
-// Callback for SDL
+// the game posts its requests to a single producer,
+// single consumer ring. the audio callback drains
+// it before rendering each block, so neither side
+// ever waits on the other
 //
-static void Audio_Play(void *user, Uint8 *stream, int len)
-{
-    fluid_synth_t *synth = (fluid_synth_t *) user;
-    fluid_synth_write_s16(synth, len / (2 * sizeof(short)) , stream, 0, 2, stream, 1, 2);
-}
+
+typedef enum {
+    SEQ_CMD_STARTSOUND,
+    SEQ_CMD_STARTMUSIC,
+    SEQ_CMD_STOPSOUND,
+    SEQ_CMD_RESET,
+    SEQ_CMD_PAUSE,
+    SEQ_CMD_RESUME,
+    SEQ_CMD_STOPALL,
+    SEQ_CMD_SETGAIN,
+    MAXSEQCOMMANDS
+} seqcmd_e;
+
+typedef struct {
+    seqcmd_e    type;
+    int         id;
+    unsigned int handle;
+    int         volume;
+    int         pan;
+    int         reverb;
+    float       gain;
+} seqcommand_t;
+
+static seqcommand_t seqqueue[SEQ_QUEUESIZE];
+static std::atomic<unsigned int> seqhead(0);    // only written by the game
+static std::atomic<unsigned int> seqtail(0);    // only written by the audio callback
+static dboolean seqstalled = false;             // game side; the callback isn't emptying it
+static int seqdropped = 0;                      // commands lost while stalled
+
+typedef void(*eventhandler)(doomseq_t*, channel_t*);
+typedef void(*commandhandler)(doomseq_t*, seqcommand_t*);
 
 //
 // Seq_SetGain
@@ -283,33 +303,10 @@ static double Song_GetTimeDivision(song_t* song) {
     return (double)song->tempo / (double)song->delta / 1000.0;
 }
 
-//
-// Seq_SetStatus
-//
-
-static void Seq_SetStatus(doomseq_t* seq, int status) {
-    MUTEX_LOCK()
-    seq->signal = status;
-    MUTEX_UNLOCK()
-}
-
-//
-// Seq_WaitOnSignal
-//
-
-/*static void Seq_WaitOnSignal(doomseq_t* seq)
-{
-    while(1)
-    {
-        if(seq->signal == SEQ_SIGNAL_READY)
-            break;
-    }
-}*/
-
 //
 // Chan_SetMusicVolume
 //
-// Should be set by the audio thread
+// Should be set by the audio callback
 //
 
 static void Chan_SetMusicVolume(doomseq_t* seq, channel_t* chan) {
@@ -323,7 +320,7 @@ static void Chan_SetMusicVolume(doomseq_t* seq, channel_t* chan) {
 //
 // Chan_SetSoundVolume
 //
-// Should be set by the audio thread
+// Should be set by the audio callback
 //
 
 static void Chan_SetSoundVolume(doomseq_t* seq, channel_t* chan) {
@@ -457,9 +454,10 @@ static dboolean Chan_RemoveTrackFromPlaylist(doomseq_t* seq, channel_t* chan) {
     chan->paused    = false;
     chan->stop      = false;
     chan->volume    = 0.0f;
-    chan->basevol   = 0.0f;
     chan->pan       = 0;
-    chan->origin    = NULL;
+    chan->handle    = 0;
+
+    chanhandles[chan - playlist].store(0, std::memory_order_release);
 
     seq->voices--;
 
@@ -496,9 +494,8 @@ static channel_t* Song_AddTrackToPlaylist(doomseq_t* seq, song_t* song, track_t*
             playlist[i].id          = 0x0f + i;
 
             playlist[i].volume      = 127.0f;
-            playlist[i].basevol     = 127.0f;
             playlist[i].pan         = 64;
-            playlist[i].origin      = NULL;
+            playlist[i].handle      = 0;
             playlist[i].depth       = 0;
             playlist[i].starttime   = 0;
             playlist[i].curtime     = 0;
@@ -690,30 +687,83 @@ static const eventhandler seqeventlist[7] = {
 };
 
 //
-// Signal_Idle
+// Cmd_StartSound
+//
+
+static void Cmd_StartSound(doomseq_t* seq, seqcommand_t* cmd) {
+    song_t* song;
+    channel_t* chan;
+    int i;
+
+    song = &seq->songs[cmd->id];
+    for(i = 0; i < song->ntracks; i++) {
+        chan = Song_AddTrackToPlaylist(seq, song, &song->tracks[i]);
+
+        if(chan == NULL) {
+            break;
+        }
+
+        chan->volume = (float)cmd->volume;
+        chan->pan = (byte)(cmd->pan >> 1);
+        chan->handle = cmd->handle;
+        chan->depth = cmd->reverb;
+
+        chanhandles[chan - playlist].store(cmd->handle, std::memory_order_release);
+    }
+}
+
+//
+// Cmd_StartMusic
 //
 
-static int Signal_Idle(doomseq_t* seq) {
-    return 0;
+static void Cmd_StartMusic(doomseq_t* seq, seqcommand_t* cmd) {
+    song_t* song;
+    channel_t* chan;
+    int i;
+
+    song = &seq->songs[cmd->id];
+    for(i = 0; i < song->ntracks; i++) {
+        chan = Song_AddTrackToPlaylist(seq, song, &song->tracks[i]);
+
+        if(chan == NULL) {
+            break;
+        }
+
+        chan->volume = seq->musicvolume;
+    }
 }
 
 //
-// Signal_Shutdown
+// Cmd_StopSound
 //
 
-static int Signal_Shutdown(doomseq_t* seq) {
-    return -1;
+static void Cmd_StopSound(doomseq_t* seq, seqcommand_t* cmd) {
+    song_t* song;
+    channel_t* c;
+    int i;
+
+    song = cmd->id >= 0 ? &seq->songs[cmd->id] : NULL;
+    for(i = 0; i < MIDI_CHANNELS; i++) {
+        c = &playlist[i];
+
+        if(!c->song) {
+            continue;
+        }
+
+        if(song == c->song || (cmd->handle && c->handle == cmd->handle)) {
+            c->stop = true;
+        }
+    }
 }
 
 //
-// Signal_StopAll
+// Cmd_StopAll
 //
 
-static int Signal_StopAll(doomseq_t* seq) {
+static void Cmd_StopAll(doomseq_t* seq, seqcommand_t* cmd) {
     channel_t* c;
     int i;
 
-    SEMAPHORE_LOCK()
     for(i = 0; i < MIDI_CHANNELS; i++) {
         c = &playlist[i];
 
@@ -721,34 +771,26 @@ static int Signal_StopAll(doomseq_t* seq) {
             Chan_RemoveTrackFromPlaylist(seq, c);
         }
     }
-    SEMAPHORE_UNLOCK()
-
-    Seq_SetStatus(seq, SEQ_SIGNAL_READY);
-    return 1;
 }
 
 //
-// Signal_Reset
+// Cmd_Reset
 //
 
-static int Signal_Reset(doomseq_t* seq) {
+static void Cmd_Reset(doomseq_t* seq, seqcommand_t* cmd) {
     fluid_synth_system_reset(seq->synth);
-
-    Seq_SetStatus(seq, SEQ_SIGNAL_READY);
-    return 1;
 }
 
 //
-// Signal_Pause
+// Cmd_Pause
 //
 // Pause all currently playing songs
 //
 
-static int Signal_Pause(doomseq_t* seq) {
+static void Cmd_Pause(doomseq_t* seq, seqcommand_t* cmd) {
     int i;
     channel_t* c;
 
-    SEMAPHORE_LOCK()
     for(i = 0; i < MIDI_CHANNELS; i++) {
         c = &playlist[i];
 
@@ -757,23 +799,18 @@ static int Signal_Pause(doomseq_t* seq) {
             Chan_StopTrack(seq, c);
         }
     }
-    SEMAPHORE_UNLOCK()
-
-    Seq_SetStatus(seq, SEQ_SIGNAL_READY);
-    return 1;
 }
 
 //
-// Signal_Resume
+// Cmd_Resume
 //
 // Resume all songs that were paused
 //
 
-static int Signal_Resume(doomseq_t* seq) {
+static void Cmd_Resume(doomseq_t* seq, seqcommand_t* cmd) {
     int i;
     channel_t* c;
 
-    SEMAPHORE_LOCK()
     for(i = 0; i < MIDI_CHANNELS; i++) {
         c = &playlist[i];
 
@@ -782,37 +819,84 @@ static int Signal_Resume(doomseq_t* seq) {
             fluid_synth_noteon(seq->synth, c->track->channel, c->key, c->velocity);
         }
     }
-    SEMAPHORE_UNLOCK()
+}
 
-    Seq_SetStatus(seq, SEQ_SIGNAL_READY);
-    return 1;
+//
+// Cmd_SetGain
+//
+
+static void Cmd_SetGain(doomseq_t* seq, seqcommand_t* cmd) {
+    seq->gain = cmd->gain;
+    Seq_SetGain(seq);
 }
 
+static const commandhandler seqcommandlist[MAXSEQCOMMANDS] = {
+    Cmd_StartSound,
+    Cmd_StartMusic,
+    Cmd_StopSound,
+    Cmd_Reset,
+    Cmd_Pause,
+    Cmd_Resume,
+    Cmd_StopAll,
+    Cmd_SetGain
+};
+
 //
-// Signal_UpdateGain
+// Seq_PostCommand
+//
+// Game side of the command queue. If the audio callback has
+// fallen a whole queue behind, waits up to SEQ_POSTWAIT ms
+// for it to catch up. A command still without a slot is
+// dropped and counted; the waiting stops until the callback
+// is running again so a dead device can't stall the game
 //
 
-static int Signal_UpdateGain(doomseq_t* seq) {
-    SEMAPHORE_LOCK()
+static void Seq_PostCommand(seqcommand_t* cmd) {
+    unsigned int head = seqhead.load(std::memory_order_relaxed);
+    Uint32 start = SDL_GetTicks();
 
-    Seq_SetGain(seq);
+    while(head - seqtail.load(std::memory_order_acquire) >= SEQ_QUEUESIZE) {
+        if(seqstalled || SDL_GetTicks() - start >= SEQ_POSTWAIT) {
+            if(!seqstalled) {
+                CON_Warnf("Seq_PostCommand: audio callback stalled, dropping commands\n");
+                seqstalled = true;
+            }
+
+            seqdropped++;
+            return;
+        }
+
+        SDL_Delay(1);
+    }
 
-    SEMAPHORE_UNLOCK()
+    if(seqstalled) {
+        CON_Warnf("Seq_PostCommand: audio callback back, %i commands were dropped\n", seqdropped);
+        seqstalled = false;
+        seqdropped = 0;
+    }
 
-    Seq_SetStatus(seq, SEQ_SIGNAL_READY);
-    return 1;
+    seqqueue[head & (SEQ_QUEUESIZE - 1)] = *cmd;
+    seqhead.store(head + 1, std::memory_order_release);
 }
 
-static const signalhandler seqsignallist[MAXSIGNALTYPES] = {
-    Signal_Idle,
-    Signal_Shutdown,
-    NULL,
-    Signal_Reset,
-    Signal_Pause,
-    Signal_Resume,
-    Signal_StopAll,
-    Signal_UpdateGain
-};
+//
+// Seq_RunCommands
+//
+// Audio side of the command queue
+//
+
+static void Seq_RunCommands(doomseq_t* seq) {
+    unsigned int tail = seqtail.load(std::memory_order_relaxed);
+    unsigned int head = seqhead.load(std::memory_order_acquire);
+
+    for(; tail != head; tail++) {
+        seqcommand_t* cmd = &seqqueue[tail & (SEQ_QUEUESIZE - 1)];
+
+        seqcommandlist[cmd->type](seq, cmd);
+    }
+
+    seqtail.store(tail, std::memory_order_release);
+}
 
 //
 // Chan_CheckState
@@ -878,7 +962,13 @@ static void Chan_RunSong(doomseq_t* seq, channel_t* chan, dword msecs) {
     //
     while(chan->state != CHAN_STATE_ENDED) {
         if(chan->song->type == 0) {
-            chan->volume = chan->basevol;
+            uint64_t mix = chanmix[chan - playlist].load(std::memory_order_relaxed);
+
+            if((unsigned int)(mix >> 32) == chan->handle) {
+                chan->volume = (float)((mix >> 8) & 0xffff);
+                chan->pan = (byte)mix;
+            }
+
             Chan_SetSoundVolume(seq, chan);
         }
         else {
@@ -949,7 +1039,6 @@ static void Seq_RunSong(doomseq_t* seq, dword msecs) {
 
     seq->playtime = msecs;
 
-    SEMAPHORE_LOCK()
     for(i = 0; i < MIDI_CHANNELS; i++) {
         chan = &playlist[i];
 
@@ -964,7 +1053,85 @@ static void Seq_RunSong(doomseq_t* seq, dword msecs) {
             Chan_RunSong(seq, chan, msecs);
         }
     }
-    SEMAPHORE_UNLOCK()
+}
+
+//
+// Seq_GetTime
+//
+// Milliseconds of audio rendered so far. Starts at 1 since
+// a channel's starttime of 0 means it hasn't run yet
+//
+
+static dword Seq_GetTime(doomseq_t* seq) {
+    return (dword)(seq->samples * 1000 / seq->samplerate) + 1;
+}
+
+//
+// Seq_GetNextEvent
+//
+// Number of frames, up to max, until the next midi event
+// of any playing channel is due
+//
+
+static int Seq_GetNextEvent(doomseq_t* seq, int max) {
+    uint64_t next;
+    uint64_t due;
+    dword msecs;
+    channel_t* chan;
+    int i;
+
+    next = seq->samples + max;
+
+    for(i = 0; i < MIDI_CHANNELS; i++) {
+        chan = &playlist[i];
+
+        if(!chan->song || chan->stop || chan->state != CHAN_STATE_READY) {
+            continue;
+        }
+
+        // the sample at which Seq_GetTime reaches starttime + nexttic
+        msecs = chan->starttime + chan->nexttic - 1;
+        due = ((uint64_t)msecs * seq->samplerate + 999) / 1000;
+
+        if(due < next) {
+            next = due;
+        }
+    }
+
+    if(next <= seq->samples) {
+        return 1;
+    }
+
+    return (int)(next - seq->samples);
+}
+
+//
+// Audio_Play
+//
+// Callback for SDL. Runs any queued commands, then renders the
+// block in pieces, running the midi events due at the start
+// of each piece so they land on the right sample
+//
+
+static void Audio_Play(void *user, Uint8 *stream, int len) {
+    doomseq_t* seq = (doomseq_t*)user;
+    short* out = (short*)stream;
+    int frames = len / (2 * sizeof(short));
+
+    Seq_RunCommands(seq);
+
+    while(frames > 0) {
+        int count;
+
+        Seq_RunSong(seq, Seq_GetTime(seq));
+
+        count = Seq_GetNextEvent(seq, frames);
+        fluid_synth_write_s16(seq->synth, count, out, 0, 2, out, 1, 2);
+
+        out += count * 2;
+        frames -= count;
+        seq->samples += count;
+    }
 }
 
 //
@@ -1043,7 +1210,7 @@ static bool Seq_RegisterSongs(doomseq_t* seq) {
         auto& lump = *opt;
         song_t* song;
 
-        auto bytes = lump.as_bytes();
+        auto bytes = lump.as_view();
         auto memory = new char[bytes.size()];
         std::copy(bytes.begin(), bytes.end(), memory);
         song = &seq->songs[i++];
@@ -1085,20 +1252,11 @@ static bool Seq_RegisterSongs(doomseq_t* seq) {
 //
 
 static void Seq_Shutdown(doomseq_t* seq) {
-    //
-    // signal the sequencer to shut down
-    //
-    Seq_SetStatus(seq, SEQ_SIGNAL_SHUTDOWN);
-
-    //
-    // wait until the audio thread is finished
-    //
-    SDL_WaitThread(seq->thread, NULL);
-
     //
     // prevent calls to Audio_Play()
     //
     SDL_CloseAudio();
+    seqready = false;
 
     //
     // fluidsynth cleanup stuff
@@ -1111,58 +1269,6 @@ static void Seq_Shutdown(doomseq_t* seq) {
     seq->settings = NULL;
 }
 
-//
-// Thread_PlayerHandler
-//
-// Main routine of the audio thread
-//
-
-static int SDLCALL Thread_PlayerHandler(void *param) {
-    doomseq_t* seq = (doomseq_t*)param;
-    long start = SDL_GetTicks();
-    long delay = 0;
-    int status;
-    dword count = 0;
-    signalhandler signal;
-
-    while(1) {
-        //
-        // check status of the sequencer
-        //
-        signal = seqsignallist[seq->signal];
-
-        if(signal) {
-            status = signal(seq);
-
-            if(status == 0) {
-                // villsa 12292013 - add a delay here so we don't
-                // thrash the loop while idling
-                SDL_Delay(1);
-                continue;
-            }
-
-            if(status == -1) {
-                return 1;
-            }
-        }
-
-        //
-        // play some songs
-        //
-        Seq_RunSong(seq, SDL_GetTicks() - start);
-        count++;
-
-        // try to avoid incremental time de-syncs
-        delay = count - (SDL_GetTicks() - start);
-
-        if(delay > 0) {
-            SDL_Delay(delay);
-        }
-    }
-
-    return 0;
-}
-
 //
 // I_InitSequencer
 //
@@ -1173,49 +1279,16 @@ void I_InitSequencer(void) {
 
     CON_DPrintf("--------Initializing Software Synthesizer--------\n");
 
-    //
-    // init mutex
-    //
-    lock = SDL_CreateMutex();
-    if(lock == NULL) {
-        CON_Warnf("I_InitSequencer: failed to create mutex");
-        return;
-    }
-
-    //
-    // init semaphore
-    //
-    semaphore = SDL_CreateSemaphore(1);
-    if(semaphore == NULL) {
-        CON_Warnf("I_InitSequencer: failed to create semaphore");
-        return;
-    }
-
     dmemset(&doomseq, 0, sizeof(doomseq_t));
 
-    //
-    // init sequencer thread
-    //
-
-    // villsa 12292013 - I can't guarantee that this will resolve
-    // the issue of the titlemap/intermission/finale music to be
-    // off-sync when uncapped framerates are enabled but for some
-    // reason, calling SDL_GetTicks before initalizing the thread
-    // will reduce the chances of it happening
-    SDL_GetTicks();
-
-    doomseq.thread = SDL_CreateThread(Thread_PlayerHandler, "SynthPlayer", &doomseq);
-    if(doomseq.thread == NULL) {
-        CON_Warnf("I_InitSequencer: failed to create audio thread");
-        return;
-    }
-
     //
     // init settings
     //
     doomseq.settings = new_fluid_settings();
+    doomseq.samplerate = SEQ_SAMPLERATE;
     Seq_SetConfig(&doomseq, "synth.midi-channels", 0x10 + MIDI_CHANNELS);
     Seq_SetConfig(&doomseq, "synth.polyphony", 256);
+    fluid_settings_setnum(doomseq.settings, "synth.sample-rate", doomseq.samplerate);
 
     //
     // init synth
@@ -1254,7 +1327,6 @@ void I_InitSequencer(void) {
     //
     doomseq.gain = 1.0f;
 
-    Seq_SetStatus(&doomseq, SEQ_SIGNAL_READY);
     Seq_SetGain(&doomseq);
     Seq_SetReverb(&doomseq, 0.65f, 0.0f, 2.0f, 1.0f);
 
@@ -1287,11 +1359,11 @@ void I_InitSequencer(void) {
     SDL_AudioSpec spec;
 
     spec.format = AUDIO_S16;
-    spec.freq = 44100;
+    spec.freq = doomseq.samplerate;
     spec.samples = 4096;
     spec.channels = 2;
     spec.callback = Audio_Play;
-    spec.userdata = doomseq.synth;
+    spec.userdata = &doomseq;
 
     SDL_OpenAudio(&spec, NULL);
     SDL_PauseAudio(SDL_FALSE);
@@ -1321,19 +1393,33 @@ int I_GetVoiceCount(void) {
 //
 
 sndsrc_t* I_GetSoundSource(int c) {
-    if(playlist[c].song == NULL) {
+    unsigned int handle = chanhandles[c].load(std::memory_order_acquire);
+    soundsource_t* src;
+
+    if(!handle) {
         return NULL;
     }
 
-    return playlist[c].origin;
+    src = &soundsources[handle & (SEQ_MAXSOURCES - 1)];
+    return src->handle == handle ? src->origin : NULL;
 }
 
 //
 // I_RemoveSoundSource
 //
+// Forgets origin for every sound it started, including ones
+// still waiting in the command queue. A NULL origin forgets
+// all of them
+//
+
+void I_RemoveSoundSource(sndsrc_t* origin) {
+    int i;
 
-void I_RemoveSoundSource(int c) {
-    playlist[c].origin = NULL;
+    for(i = 0; i < SEQ_MAXSOURCES; i++) {
+        if(!origin || soundsources[i].origin == origin) {
+            soundsources[i].origin = NULL;
+        }
+    }
 }
 
 //
@@ -1341,11 +1427,13 @@ void I_RemoveSoundSource(int c) {
 //
 
 void I_UpdateChannel(int c, int volume, int pan) {
-    channel_t* chan;
+    unsigned int handle = chanhandles[c].load(std::memory_order_acquire);
 
-    chan            = &playlist[c];
-    chan->basevol   = (float)volume;
-    chan->pan       = (byte)(pan >> 1);
+    if(!handle) {
+        return;
+    }
+
+    chanmix[c].store(CHANMIX(handle, volume, pan >> 1), std::memory_order_relaxed);
 }
 
 //
@@ -1383,8 +1471,9 @@ void I_ResetSound(void) {
         return;
     }
 
-    Seq_SetStatus(&doomseq, SEQ_SIGNAL_RESET);
-    //Seq_WaitOnSignal(&doomseq);
+    seqcommand_t cmd = { SEQ_CMD_RESET };
+
+    Seq_PostCommand(&cmd);
 }
 
 //
@@ -1396,8 +1485,9 @@ void I_PauseSound(void) {
         return;
     }
 
-    Seq_SetStatus(&doomseq, SEQ_SIGNAL_PAUSE);
-    //Seq_WaitOnSignal(&doomseq);
+    seqcommand_t cmd = { SEQ_CMD_PAUSE };
+
+    Seq_PostCommand(&cmd);
 }
 
 //
@@ -1409,8 +1499,9 @@ void I_ResumeSound(void) {
         return;
     }
 
-    Seq_SetStatus(&doomseq, SEQ_SIGNAL_RESUME);
-    //Seq_WaitOnSignal(&doomseq);
+    seqcommand_t cmd = { SEQ_CMD_RESUME };
+
+    Seq_PostCommand(&cmd);
 }
 
 //
@@ -1422,10 +1513,10 @@ void I_SetGain(float db) {
         return;
     }
 
-    doomseq.gain = db;
+    seqcommand_t cmd = { SEQ_CMD_SETGAIN };
 
-    Seq_SetStatus(&doomseq, SEQ_SIGNAL_SETGAIN);
-    //Seq_WaitOnSignal(&doomseq);
+    cmd.gain = db;
+    Seq_PostCommand(&cmd);
 }
 
 //
@@ -1433,26 +1524,14 @@ void I_SetGain(float db) {
 //
 
 void I_StartMusic(int mus_id) {
-    song_t* song;
-    channel_t* chan;
-    int i;
+    seqcommand_t cmd = { SEQ_CMD_STARTMUSIC };
 
     if(!seqready) {
         return;
     }
 
-    SEMAPHORE_LOCK()
-    song = &doomseq.songs[mus_id];
-    for(i = 0; i < song->ntracks; i++) {
-        chan = Song_AddTrackToPlaylist(&doomseq, song, &song->tracks[i]);
-
-        if(chan == NULL) {
-            break;
-        }
-
-        chan->volume = doomseq.musicvolume;
-    }
-    SEMAPHORE_UNLOCK()
+    cmd.id = mus_id;
+    Seq_PostCommand(&cmd);
 }
 
 //
@@ -1460,24 +1539,29 @@ void I_StartMusic(int mus_id) {
 //
 
 void I_StopSound(sndsrc_t* origin, int sfx_id) {
-    song_t* song;
-    channel_t* c;
+    seqcommand_t cmd = { SEQ_CMD_STOPSOUND };
     int i;
 
     if(!seqready) {
         return;
     }
 
-    SEMAPHORE_LOCK()
-    song = &doomseq.songs[sfx_id];
-    for(i = 0; i < MIDI_CHANNELS; i++) {
-        c = &playlist[i];
+    cmd.id = sfx_id;
+    Seq_PostCommand(&cmd);
 
-        if(song == c->song || (origin && c->origin == origin)) {
-            c->stop = true;
+    if(!origin) {
+        return;
+    }
+
+    // and everything origin is playing, by handle
+    cmd.id = -1;
+
+    for(i = 0; i < SEQ_MAXSOURCES; i++) {
+        if(soundsources[i].origin == origin) {
+            cmd.handle = soundsources[i].handle;
+            Seq_PostCommand(&cmd);
         }
     }
-    SEMAPHORE_UNLOCK()
 }
 
 //
@@ -1485,9 +1569,7 @@ void I_StopSound(sndsrc_t* origin, int sfx_id) {
 //
 
 void I_StartSound(int sfx_id, sndsrc_t* origin, int volume, int pan, int reverb) {
-    song_t* song;
-    channel_t* chan;
-    int i;
+    seqcommand_t cmd = { SEQ_CMD_STARTSOUND };
 
     if(!seqready) {
         return;
@@ -1497,20 +1579,17 @@ void I_StartSound(int sfx_id, sndsrc_t* origin, int volume, int pan, int reverb)
         return;
     }
 
-    SEMAPHORE_LOCK()
-    song = &doomseq.songs[sfx_id];
-    for(i = 0; i < song->ntracks; i++) {
-        chan = Song_AddTrackToPlaylist(&doomseq, song, &song->tracks[i]);
+    if(!++soundserial) {
+        soundserial++;
+    }
 
-        if(chan == NULL) {
-            break;
-        }
+    soundsources[soundserial & (SEQ_MAXSOURCES - 1)].handle = soundserial;
+    soundsources[soundserial & (SEQ_MAXSOURCES - 1)].origin = origin;
 
-        chan->volume = (float)volume;
-        chan->pan = (byte)(pan >> 1);
-        chan->origin = origin;
-        chan->depth = reverb;
-    }
-    SEMAPHORE_UNLOCK()
+    cmd.id = sfx_id;
+    cmd.handle = soundserial;
+    cmd.volume = volume;
+    cmd.pan = pan;
+    cmd.reverb = reverb;
+    Seq_PostCommand(&cmd);
 }
-
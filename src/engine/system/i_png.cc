@@ -88,8 +88,8 @@ gfx::Image I_ReadImage(int lump, dboolean palette, dboolean nopack, double alpha
         gfx::Palette newpal;
         if (auto pl = wad::find(palname))
         {
-            auto bytes = pl->as_bytes();
-            gfx::Rgb *pallump = reinterpret_cast<gfx::Rgb *>(&bytes[0]);
+            auto bytes = pl->as_view();
+            auto pallump = reinterpret_cast<const gfx::Rgb *>(bytes.data());
             newpal = *pal;
 
             // swap out current palette with the new one
@@ -138,3 +138,74 @@ void *I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
 
     return retval;
 }
+
+//
+// I_PNGReadInfo
+// Reads the size and grAb offsets from the chunks ahead of the image
+// data without inflating anything. Lumps that aren't PNGs are decoded.
+//
+
+static dword I_PNGReadBE32(const byte* p) {
+    return ((dword)p[0] << 24) | ((dword)p[1] << 16) | ((dword)p[2] << 8) | p[3];
+}
+
+void I_PNGReadInfo(int lump, int* w, int* h, int* offset) {
+    static const byte magic[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    auto l = wad::find(lump);
+    auto view = l->as_view();
+    const byte* data = reinterpret_cast<const byte*>(view.data());
+    size_t size = view.size();
+    size_t pos;
+    dboolean header = false;
+    int width = 0;
+    int height = 0;
+    int x = 0;
+    int y = 0;
+
+    if(size >= 8 && !memcmp(data, magic, 8)) {
+        // chunks: length, type, data, crc
+        for(pos = 8; pos + 8 <= size; ) {
+            dword length = I_PNGReadBE32(data + pos);
+            const byte* type = data + pos + 4;
+            const byte* chunk = data + pos + 8;
+
+            if(length > size - pos - 8) {
+                break;
+            }
+
+            // libpng only sees chunks up to the image data
+            if(!memcmp(type, "IDAT", 4) || !memcmp(type, "IEND", 4)) {
+                break;
+            }
+
+            if(!memcmp(type, "IHDR", 4) && length >= 8) {
+                width = I_PNGReadBE32(chunk);
+                height = I_PNGReadBE32(chunk + 4);
+                header = true;
+            }
+            else if(!memcmp(type, "grAb", 4) && length >= 8) {
+                x = (int)I_PNGReadBE32(chunk);
+                y = (int)I_PNGReadBE32(chunk + 4);
+            }
+
+            pos += 12 + length;
+        }
+    }
+
+    if(!header || width < 1 || width > 0xffff || height < 1 || height > 0xffff) {
+        free(I_PNGReadData(lump, true, true, false, w, h, offset, 0));
+        return;
+    }
+
+    if(offset) {
+        offset[0] = x;
+        offset[1] = y;
+    }
+
+    if(w) {
+        *w = width;
+    }
+    if(h) {
+        *h = height;
+    }
+}
@@ -32,4 +32,6 @@ Image I_ReadImage(int lump, dboolean palette, dboolean nopack, double alpha, int
 void *I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
                     int* w, int* h, int* offset, int palindex);
 
+void I_PNGReadInfo(int lump, int* w, int* h, int* offset);
+
 #endif // __I_PNG_H__
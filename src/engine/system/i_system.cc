@@ -47,6 +47,8 @@
 #include "i_system.h"
 #include "i_audio.h"
 #include "gl_draw.h"
+#include "p_saveg.h"
+#include "r_main.h"
 
 BoolProperty i_interpolateframes("i_interpolateframes", "", false);
 
@@ -257,6 +259,19 @@ int I_GetTimeMS(void) {
     return ticks - basetime;
 }
 
+//
+// I_GetTimeUS
+//
+// Microseconds from the high resolution counter, for profiling
+//
+
+uint64_t I_GetTimeUS(void) {
+    uint64_t count = SDL_GetPerformanceCounter();
+    uint64_t freq = SDL_GetPerformanceFrequency();
+
+    return (count / freq) * 1000000 + (count % freq) * 1000000 / freq;
+}
+
 //
 // I_GetRandomTimeSeed
 //
@@ -275,7 +290,10 @@ void I_Init(void) {
     //I_SpawnLauncher(hwndMain);
 #endif
 
-    I_InitVideo();
+    if(!headless) {
+        I_InitVideo();
+    }
+
     I_InitClockRate();
 }
 
@@ -289,6 +307,9 @@ void I_Error(const char* string, ...) {
 
     I_ShutdownSound();
 
+    // exit() with the save thread still joinable would terminate
+    P_FlushSaveGame();
+
     va_start(va, string);
     vsprintf(buff, string, va);
     va_end(va);
@@ -332,6 +353,8 @@ void I_Quit(void) {
     }
 
     M_SaveDefaults();
+    P_FlushSaveGame();
+    R_PrepShutdown();
 
 #ifdef USESYSCONSOLE
     // I_DestroySysConsole();
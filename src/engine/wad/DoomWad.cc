@@ -1,5 +1,4 @@
 #include <fstream>
-#include <sstream>
 #include "WadFormat.hh"
 
 namespace {
@@ -27,35 +26,21 @@ namespace {
   struct Info {
       size_t filepos;
       size_t size;
-      std::istringstream cache;
 
       Info(size_t filepos, size_t size):
           filepos(filepos),
           size(size) {}
   };
 
-  class DoomLump : public wad::BasicLump {
-      std::istringstream &stream_;
-
-  public:
-      DoomLump(size_t lump_id, std::istringstream& stream):
-          wad::BasicLump(lump_id),
-          stream_(stream) {}
-
-      std::istream& stream() override
-      { return stream_; }
-
-      String as_bytes() override
-      { return stream_.str(); }
-  };
-
   class DoomFormat : public wad::Format {
       std::ifstream stream_;
+      wad::MappedFile file_;
       Vector<Info> table_;
 
   public:
       DoomFormat(StringView path):
-          stream_(path, std::ios::binary)
+          stream_(path, std::ios::binary),
+          file_(path)
       {
           stream_.exceptions(stream_.failbit | stream_.badbit);
       }
@@ -115,17 +100,8 @@ namespace {
 
       UniquePtr<wad::BasicLump> find(size_t lump_id, size_t mount_id) override
       {
-          std::istringstream ss;
           auto& info = table_[mount_id];
-
-          if (info.size && !info.cache.str().size()) {
-              stream_.seekg(info.filepos);
-              String str(info.size, 0);
-              stream_.read(&str[0], info.size);
-              info.cache.str(std::move(str));
-          }
-
-          return std::make_unique<DoomLump>(lump_id, info.cache);
+          return std::make_unique<wad::ViewLump>(lump_id, file_.view(info.filepos, info.size));
       }
   };
 }
@@ -0,0 +1,71 @@
+#include <fstream>
+#include "WadFormat.hh"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+wad::MappedFile::MappedFile(StringView path)
+{
+    // the view needn't end in a NUL
+    auto cpath = path.to_string();
+
+#ifdef _WIN32
+    auto file = CreateFileA(cpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            if (auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+                data_ = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                size_ = static_cast<size_t>(size.QuadPart);
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = open(cpath.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const char *>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if (data_)
+        return;
+
+    // Couldn't map it, so just read the whole thing.
+    std::ifstream file(cpath, std::ios::binary);
+    if (!file.is_open())
+        return;
+
+    fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+}
+
+wad::MappedFile::~MappedFile()
+{
+    if (!data_ || data_ == fallback_.data())
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(const_cast<char *>(data_), size_);
+#endif
+}
@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <cassert>
 #include "WadFormat.hh"
+#include "md5.h"
+#include <sys/stat.h>
 
 namespace {
   wad::Format::loader loaders_[] {
@@ -14,11 +16,17 @@ namespace {
 
   Vector<UniquePtr<wad::Format>> mounts_;
 
+  Vector<String> mount_paths_;
+
   Vector<wad::LumpInfo> lumps_;
 
   Array<Vector<wad::LumpInfo*>, wad::num_sections> sections_;
 
   app::StringParam iwad_path_("iwad");
+
+  IntProperty w_lumpcache("w_lumpcache", "Size of the decompressed lump cache in kilobytes", 32768);
+
+  wad::LumpCache lump_cache_;
 }
 
 StringView wad::BasicLump::lump_name() const
@@ -40,6 +48,13 @@ String wad::BasicLump::as_bytes()
     return { std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>() };
 }
 
+ArrayView<char> wad::BasicLump::as_view()
+{
+    if (bytes_.empty())
+        bytes_ = as_bytes();
+    return { bytes_.data(), bytes_.size() };
+}
+
 gfx::Image wad::BasicLump::as_image()
 {
     auto& s = stream();
@@ -50,6 +65,105 @@ gfx::Image wad::BasicLump::as_image()
 gfx::Image wad::Lump::as_image()
 { return data_->as_image(); }
 
+wad::LumpCache& wad::lump_cache()
+{ return lump_cache_; }
+
+wad::CacheStats wad::cache_stats()
+{ return lump_cache_.stats(); }
+
+String wad::checksum()
+{
+    // MD5_Update takes an unsigned length, so feed it in pieces
+    constexpr size_t piece = 1 << 20;
+    md5_context_t md5;
+    md5_digest_t digest;
+
+    MD5_Init(&md5);
+    for (auto& path : mount_paths_) {
+        MappedFile file(path);
+        for (size_t offset = 0; offset < file.size(); offset += piece) {
+            auto view = file.view(offset, std::min(piece, file.size() - offset));
+            MD5_Update(&md5, reinterpret_cast<const byte *>(view.data()), view.size());
+        }
+    }
+    MD5_Final(digest, &md5);
+
+    return { reinterpret_cast<const char *>(digest), sizeof digest };
+}
+
+String wad::stamp()
+{
+    md5_context_t md5;
+    md5_digest_t digest;
+
+    MD5_Init(&md5);
+    for (auto& path : mount_paths_) {
+        struct stat st {};
+        int64 size, mtime;
+
+        stat(path.c_str(), &st);
+        size = st.st_size;
+        mtime = st.st_mtime;
+
+        MD5_Update(&md5, reinterpret_cast<const byte *>(path.data()), path.size() + 1);
+        MD5_Update(&md5, reinterpret_cast<const byte *>(&size), sizeof size);
+        MD5_Update(&md5, reinterpret_cast<const byte *>(&mtime), sizeof mtime);
+    }
+    MD5_Final(digest, &md5);
+
+    return { reinterpret_cast<const char *>(digest), sizeof digest };
+}
+
+SharedPtr<const String> wad::LumpCache::get(size_t lump_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(lump_id);
+    if (it == entries_.end()) {
+        stats_.misses++;
+        return nullptr;
+    }
+
+    stats_.hits++;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.data;
+}
+
+void wad::LumpCache::put(size_t lump_id, SharedPtr<const String> data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t budget = static_cast<size_t>(std::max(*w_lumpcache, 0)) << 10;
+
+    // Lumps bigger than the whole cache aren't worth keeping
+    if (data->size() > budget || entries_.count(lump_id))
+        return;
+
+    evict_(budget - data->size());
+
+    lru_.push_front(lump_id);
+    stats_.bytes += data->size();
+    entries_[lump_id] = { std::move(data), lru_.begin() };
+}
+
+void wad::LumpCache::evict_(size_t budget)
+{
+    while (stats_.bytes > budget && !lru_.empty()) {
+        auto it = entries_.find(lru_.back());
+        stats_.bytes -= it->second.data->size();
+        stats_.evictions++;
+        entries_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+wad::CacheStats wad::LumpCache::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.entries = entries_.size();
+    return stats;
+}
+
 void wad::init()
 {
     if (iwad_path_ && !wad::mount(iwad_path_.get())) {
@@ -80,6 +194,7 @@ bool wad::mount(StringView path)
         if (auto f = l(path)) {
             format = f.get();
             mounts_.emplace_back(std::move(f));
+            mount_paths_.emplace_back(path.to_string());
             break;
         }
     }
@@ -122,19 +237,41 @@ void wad::merge()
     }
 }
 
+namespace {
+  Vector<wad::LumpInfo>::iterator find_info_(StringView name)
+  {
+      auto it = std::lower_bound(lumps_.begin(), lumps_.end(), name,
+                                 [](const wad::LumpInfo& a, const StringView& b) {
+                                     return a.lump_name < b;
+                                 });
+
+      if (it == lumps_.end() || it->lump_name != name)
+          return lumps_.end();
+
+      return it;
+  }
+}
+
 bool wad::have_lump(StringView name)
 {
-    return wad::find(name).have_value();
+    return find_info_(name) != lumps_.end();
+}
+
+Optional<std::size_t> wad::find_index(Section section, StringView name)
+{
+    auto it = find_info_(name);
+
+    if (it == lumps_.end() || it->section != section)
+        return nullopt;
+
+    return it->section_index;
 }
 
 Optional<wad::Lump> wad::find(StringView name)
 {
-    auto it = std::lower_bound(lumps_.begin(), lumps_.end(), name,
-                               [](const LumpInfo& a, const StringView& b) {
-                                   return a.lump_name < b;
-                               });
+    auto it = find_info_(name);
 
-    if (it == lumps_.end() || it->lump_name != name)
+    if (it == lumps_.end())
         return nullopt;
 
     const auto& mount = mounts_[it->mount];
@@ -1,4 +1,9 @@
 #include <imp/Wad>
+#include <istream>
+#include <list>
+#include <mutex>
+#include <streambuf>
+#include <unordered_map>
 
 namespace imp {
   namespace wad {
@@ -34,6 +39,128 @@ namespace imp {
         virtual UniquePtr<BasicLump> find(std::size_t lump_id, std::size_t mount_id) = 0;
     };
 
+    /*!
+     * Read-only memory mapping of a whole file. Falls back to reading the
+     * file into memory if the platform won't map it.
+     */
+    class MappedFile {
+        const char *data_ {};
+        std::size_t size_ {};
+        String fallback_;
+
+    public:
+        MappedFile(StringView path);
+
+        MappedFile(const MappedFile&) = delete;
+
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool is_open() const
+        { return data_ != nullptr; }
+
+        std::size_t size() const
+        { return size_; }
+
+        /*! View a range of the file, or throw if it's out of bounds */
+        ArrayView<char> view(std::size_t offset, std::size_t size) const
+        {
+            if (offset > size_ || size > size_ - offset)
+                throw "Lump extends past the end of the file";
+            return { data_ + offset, size };
+        }
+    };
+
+    /*!
+     * istream buffer over a view, so that lumps can be read as streams
+     * without being copied.
+     */
+    class ViewBuf : public std::streambuf {
+    public:
+        ViewBuf(ArrayView<char> view)
+        {
+            auto p = const_cast<char *>(view.data());
+            setg(p, p, p + view.size());
+        }
+
+    protected:
+        pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode) override
+        {
+            char *base;
+            switch (dir) {
+            case std::ios::beg: base = eback(); break;
+            case std::ios::cur: base = gptr(); break;
+            default:            base = egptr(); break;
+            }
+
+            if (base + off < eback() || base + off > egptr())
+                return pos_type(off_type(-1));
+
+            setg(eback(), base + off, egptr());
+            return pos_type(gptr() - eback());
+        }
+
+        pos_type seekpos(pos_type pos, std::ios::openmode mode) override
+        { return seekoff(off_type(pos), std::ios::beg, mode); }
+    };
+
+    /*!
+     * A lump whose data already sits in memory, either in a mapped file or
+     * in a shared buffer that the lump keeps alive.
+     */
+    class ViewLump : public BasicLump {
+        SharedPtr<const String> owner_;
+        ArrayView<char> view_;
+        ViewBuf buf_;
+        std::istream stream_;
+
+    public:
+        ViewLump(std::size_t lump_id, ArrayView<char> view, SharedPtr<const String> owner = nullptr):
+            BasicLump(lump_id),
+            owner_(std::move(owner)),
+            view_(view),
+            buf_(view),
+            stream_(&buf_) {}
+
+        std::istream& stream() override
+        { return stream_; }
+
+        String as_bytes() override
+        { return { view_.data(), view_.size() }; }
+
+        ArrayView<char> as_view() override
+        { return view_; }
+    };
+
+    /*!
+     * Bounded LRU of decompressed lumps, keyed by lump index. Entries are
+     * reference counted, so evicting one never pulls data out from under a
+     * Lump that is still using it.
+     */
+    class LumpCache {
+        struct Entry {
+            SharedPtr<const String> data;
+            std::list<std::size_t>::iterator lru;
+        };
+
+        std::mutex mutex_;
+        std::unordered_map<std::size_t, Entry> entries_;
+        std::list<std::size_t> lru_;
+        CacheStats stats_ {};
+
+        void evict_(std::size_t budget);
+
+    public:
+        SharedPtr<const String> get(std::size_t lump_id);
+
+        void put(std::size_t lump_id, SharedPtr<const String> data);
+
+        CacheStats stats();
+    };
+
+    LumpCache& lump_cache();
+
     UniquePtr<Format> doom_loader(StringView);
     UniquePtr<Format> zip_loader(StringView);
     UniquePtr<Format> rom_loader(StringView);
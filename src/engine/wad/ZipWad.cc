@@ -4,7 +4,6 @@
 
 #include <fstream>
 #include <zlib.h>
-#include <sstream>
 #include "WadFormat.hh"
 
 namespace {
@@ -123,32 +122,47 @@ namespace {
       bool compressed;
       size_t filepos;
       size_t size;
+      size_t compressed_size;
       wad::Section section;
   };
 
-  class ZipLump : public wad::BasicLump {
-      std::istringstream stream_;
+  SharedPtr<const String> _inflate(ArrayView<char> data, size_t size)
+  {
+      auto cache = std::make_shared<String>(size, 0);
+      z_stream zs {};
 
-  public:
-      ZipLump(size_t lump_id, std::istringstream stream):
-          wad::BasicLump(lump_id),
-          stream_(std::move(stream)) {}
+      zs.next_in = reinterpret_cast<byte*>(const_cast<char*>(data.data()));
+      zs.avail_in = static_cast<uInt>(data.size());
+      zs.next_out = reinterpret_cast<byte*>(&(*cache)[0]);
+      zs.avail_out = static_cast<uInt>(size);
+      zs.zalloc = [](voidpf, uInt items, uInt size) -> voidpf { return malloc(items * size); };
+      zs.zfree = [](voidpf, voidpf address) { free(address); };
 
-      std::istream& stream() override
-      { return stream_; }
+      auto code = inflateInit2(&zs, -MAX_WBITS);
+      if (code == Z_OK)
+          code = inflate(&zs, Z_FINISH);
 
-      String as_bytes() override
-      { return stream_.str(); }
-  };
+      inflateEnd(&zs);
+
+      if (code != Z_OK && code != Z_STREAM_END)
+          throw "invalid inflate stream";
+
+      if (zs.avail_out != 0)
+          throw "truncated deflate stream";
+
+      return cache;
+  }
 
   class ZipFormat : public wad::Format {
       std::ifstream stream_;
+      wad::MappedFile file_;
       std::vector<ZipInfo> infos_;
       size_t central_dir_pos_ {};
 
   public:
-      ZipFormat(std::ifstream &&stream):
-          stream_(std::move(stream)) {}
+      ZipFormat(std::ifstream &&stream, StringView path):
+          stream_(std::move(stream)),
+          file_(path) {}
 
       Vector<wad::LumpInfo> read_all() override
       {
@@ -203,7 +217,7 @@ namespace {
                   auto name = _normalize(filename.substr(loc)).substr(0, 8);
                   auto index = infos_.size();
 
-                  infos_.push_back({ entry.method == 8, entry.local_offset, entry.uncompressed, section });
+                  infos_.push_back({ entry.method == 8, entry.local_offset, entry.uncompressed, entry.compressed, section });
                   lumps.emplace_back(name, section, index);
               } else {
                   break;
@@ -215,54 +229,34 @@ namespace {
 
       UniquePtr<wad::BasicLump> find(size_t lump_index, size_t zip_index) override
       {
-		  stream_.exceptions(stream_.failbit | stream_.eofbit | stream_.badbit);
           assert(zip_index < infos_.size());
           auto& info = infos_[zip_index];
+          auto& cache = wad::lump_cache();
 
-          char sig[4];
-          stream_.seekg(info.filepos);
-          stream_.read(sig, 4);
-          if (memcmp(sig, _local_file_sig, 4) != 0)
+          // Deflated lumps are only ever inflated once while they stay cached
+          if (info.compressed) {
+              if (auto bytes = cache.get(lump_index))
+                  return std::make_unique<wad::ViewLump>(lump_index, ArrayView<char> { bytes->data(), bytes->size() }, bytes);
+          }
+
+          auto local = file_.view(info.filepos, 4 + sizeof(LocalFileHeader));
+          if (memcmp(local.data(), _local_file_sig, 4) != 0)
               throw "Not a LocalFileHeader";
 
           LocalFileHeader header;
-          read_into(stream_, header);
-
-          stream_.seekg(header.name_length + header.extra_length, std::ios::cur);
-
-          String cache(header.uncompressed, 0);
-          z_stream zs {};
-          char buffer[32] {};
-
-		  /* inflateInit2 expects zs to be initialised prior to being called. -.- */
-		  stream_.read(buffer, sizeof(buffer));
-		  zs.next_in = reinterpret_cast<byte*>(buffer);
-		  zs.avail_in = sizeof(buffer);
-		  zs.next_out = reinterpret_cast<byte*>(&cache[0]);
-		  zs.avail_out = header.uncompressed;
-		  zs.zalloc = [](voidpf, uInt items, uInt size) -> voidpf { return malloc(items * size); };
-		  zs.zfree = [](voidpf, voidpf address) { free(address); };
-
-          auto code = inflateInit2(&zs, -MAX_WBITS);
-
-          do {
-              if (zs.avail_in == 0) {
-                  stream_.read(buffer, sizeof(buffer));
-                  zs.next_in = reinterpret_cast<byte*>(buffer);
-                  zs.avail_in = sizeof(buffer);
-              }
-              code = inflate(&zs, Z_SYNC_FLUSH);
-          } while(code == Z_OK && zs.avail_out);
+          memcpy(&header, local.data() + 4, sizeof(header));
 
-          inflateEnd(&zs);
+          // The sizes in the local header may be zero if the ZIP uses data descriptors,
+          // so use the ones from the central directory.
+          auto data_pos = info.filepos + local.size() + header.name_length + header.extra_length;
 
-          if (code != Z_OK && code != Z_STREAM_END)
-              throw "invalid inflate stream";
+          if (!info.compressed)
+              return std::make_unique<wad::ViewLump>(lump_index, file_.view(data_pos, info.size));
 
-          if (zs.avail_out != 0)
-              throw "truncated deflate stream";
+          auto bytes = _inflate(file_.view(data_pos, info.compressed_size), info.size);
+          cache.put(lump_index, bytes);
 
-          return std::make_unique<ZipLump>(lump_index, std::istringstream { std::move(cache) });
+          return std::make_unique<wad::ViewLump>(lump_index, ArrayView<char> { bytes->data(), bytes->size() }, bytes);
       }
   };
 }
@@ -280,5 +274,5 @@ UniquePtr<wad::Format> wad::zip_loader(StringView name)
     if (memcmp(signature, _local_file_sig, 4) != 0 && memcmp(signature, _end_of_dir_sig, 4) != 0)
         return nullptr;
 
-    return std::make_unique<ZipFormat>(std::move(file));
+    return std::make_unique<ZipFormat>(std::move(file), name);
 }
@@ -29,41 +29,44 @@ static const char rcsid[] =
     "$Id: DeflateN64.c 922 2011-08-13 00:49:06Z svkaiser $";
 #endif
 
+#include <string.h>
+
 #include "wadgen.h"
+#include "deflate-N64.h"
+
+#define TABLESIZE	1280
+#define WINDOWSIZE	0x558F	// sum of the distance ranges in array05, plus 64
 
+//
+// All of the decoder's state lives here, so any number of lumps can be
+// decompressed at once. The sizes are what the N64 code actually touches
+// of the buffers it carved out of its heap.
+//
 typedef struct {
 	int var0;
 	int var1;
-	int var2;
-	int var3;
 	byte *write;
 	byte *writePos;
+	byte *writeEnd;
 	byte *read;
 	byte *readPos;
-	int null1;
-	int null2;
+	byte *readEnd;
+	bool error;
+
+	alignas(4) byte DecodeTable[TABLESIZE * 4];
+	alignas(4) byte array01[TABLESIZE * 2];	// 0x800B3660
+	alignas(4) byte array05[16];	// 0x8005D8A0
+	alignas(4) byte tableVar01[0x48];	// 0x800B2250
+	byte window[WINDOWSIZE];
 } decoder_t;
 
-static decoder_t decoder;
-
-#define OVERFLOWCHECK		0x7FFFFFFF
-
-#define TABLESIZE	1280
-byte DecodeTable[TABLESIZE * 4];
-
-byte array01[0xFFFFFF];		// 0x800B3660
-byte array05[0xFFFFFF];		// 0x8005D8A0
-byte tableVar01[0xFFFFFF];	// 0x800B2250
-
-int allocPtr[0xFFFFFF];
-
 //**************************************************************
 //**************************************************************
 //      Deflate_InitDecodeTable
 //**************************************************************
 //**************************************************************
 
-void Deflate_InitDecodeTable(void)
+static void Deflate_InitDecodeTable(decoder_t *d)
 {
 	int v[2];
 	int a[4];
@@ -74,26 +77,24 @@ void Deflate_InitDecodeTable(void)
 	byte *a3p;
 	byte *v0p;
 
-	*(signed short *)array05 = 0x04;
-	*(signed short *)(array05 + 2) = 0x06;
-	*(signed short *)(array05 + 4) = 0x08;
-	*(signed short *)(array05 + 6) = 0x0A;
-	*(signed short *)(array05 + 8) = 0x0C;
-	*(signed short *)(array05 + 10) = 0x0E;
+	*(signed short *)d->array05 = 0x04;
+	*(signed short *)(d->array05 + 2) = 0x06;
+	*(signed short *)(d->array05 + 4) = 0x08;
+	*(signed short *)(d->array05 + 6) = 0x0A;
+	*(signed short *)(d->array05 + 8) = 0x0C;
+	*(signed short *)(d->array05 + 10) = 0x0E;
 
-	*(signed short *)(tableVar01 + 0x34) = 0x558F;
+	*(signed short *)(d->tableVar01 + 0x34) = 0x558F;
 
-	*(int *)(tableVar01 + 0x3C) = 3;
-	*(int *)(tableVar01 + 0x40) = 0;
-	*(int *)(tableVar01 + 0x44) = 0;
+	*(int *)(d->tableVar01 + 0x3C) = 3;
+	*(int *)(d->tableVar01 + 0x40) = 0;
+	*(int *)(d->tableVar01 + 0x44) = 0;
 
-	decoder.var0 = 0;
-	decoder.var1 = 0;
-	decoder.var2 = 0;
-	decoder.var3 = 0;
+	d->var0 = 0;
+	d->var1 = 0;
 
-	a0p = (array01 + 4);
-	v1p = (byte *) (DecodeTable + 0x9E4);
+	a0p = (d->array01 + 4);
+	v1p = (byte *) (d->DecodeTable + 0x9E4);
 
 	v[0] = 2;
 
@@ -110,8 +111,8 @@ void Deflate_InitDecodeTable(void)
 
 	} while (++v[0] < 1258);
 
-	a1p = (byte *) (DecodeTable + 0x4F2);
-	a0p = (byte *) (DecodeTable + 2);
+	a1p = (byte *) (d->DecodeTable + 0x4F2);
+	a0p = (byte *) (d->DecodeTable + 2);
 
 	v[1] = 2;
 	a[2] = 3;
@@ -128,19 +129,19 @@ void Deflate_InitDecodeTable(void)
 
 	} while (a[2] < 1259);
 
-	*(int *)tableVar01 = 0;
-	v[1] = (1 << *(signed short *)(array05));
-	*(int *)(tableVar01 + 0x18) = (v[1] - 1);
+	*(int *)d->tableVar01 = 0;
+	v[1] = (1 << *(signed short *)(d->array05));
+	*(int *)(d->tableVar01 + 0x18) = (v[1] - 1);
 
-	*(int *)(tableVar01 + 4) = v[1];
-	v[1] += (1 << *(signed short *)(array05 + 2));
-	*(int *)(tableVar01 + 0x1C) = (v[1] - 1);
+	*(int *)(d->tableVar01 + 4) = v[1];
+	v[1] += (1 << *(signed short *)(d->array05 + 2));
+	*(int *)(d->tableVar01 + 0x1C) = (v[1] - 1);
 
 	v[0] = 2;
-	a2p = (array05 + (v[0] << 1));
+	a2p = (d->array05 + (v[0] << 1));
 
 	a[0] = (v[0] << 2);
-	a1p = (tableVar01 + a[0]);
+	a1p = (d->tableVar01 + a[0]);
 
 	*(signed short *)a1p = v[1];
 
@@ -151,9 +152,9 @@ void Deflate_InitDecodeTable(void)
 	*(int *)(a1p + 8) = v[1];
 
 #ifdef _MSC_VER
-	(int *)a3p = (int *)((byte *) (tableVar01 + 0x18) + a[0]);
+	(int *)a3p = (int *)((byte *) (d->tableVar01 + 0x18) + a[0]);
 #else
-	a3p = ((byte *) (tableVar01 + 0x18) + a[0]);
+	a3p = ((byte *) (d->tableVar01 + 0x18) + a[0]);
 #endif
 	*(int *)a3p = (v[1] - 1);
 
@@ -165,7 +166,7 @@ void Deflate_InitDecodeTable(void)
 	*(int *)(a3p + 8) = (v[1] - 1);
 	*(int *)(a3p + 0xc) = (v[1] - 1);
 
-	v0p = (byte *) (tableVar01 + 0x30);
+	v0p = (byte *) (d->tableVar01 + 0x30);
 
 	*(int *)v0p = (v[1] - 1);
 	*(int *)(v0p + 4) = ((v[1] - 1) + 64);
@@ -177,12 +178,15 @@ void Deflate_InitDecodeTable(void)
 //**************************************************************
 //**************************************************************
 
-byte Deflate_GetDecodeByte(void)
+static byte Deflate_GetDecodeByte(decoder_t *d)
 {
-	if (!((decoder.readPos - decoder.read) < OVERFLOWCHECK))
-		return -1;
+	// running off the end means the lump is corrupt; stop decoding
+	if (d->readPos >= d->readEnd) {
+		d->error = true;
+		return 0;
+	}
 
-	return *decoder.readPos++;
+	return *d->readPos++;
 }
 
 //**************************************************************
@@ -191,22 +195,22 @@ byte Deflate_GetDecodeByte(void)
 //**************************************************************
 //**************************************************************
 
-int Deflate_DecodeScan(void)
+static int Deflate_DecodeScan(decoder_t *d)
 {
 	int resultbyte;
 
-	resultbyte = decoder.var0;
+	resultbyte = d->var0;
 
-	decoder.var0 = (resultbyte - 1);
+	d->var0 = (resultbyte - 1);
 	if ((resultbyte < 1)) {
-		resultbyte = Deflate_GetDecodeByte();
+		resultbyte = Deflate_GetDecodeByte(d);
 
-		decoder.var1 = resultbyte;
-		decoder.var0 = 7;
+		d->var1 = resultbyte;
+		d->var0 = 7;
 	}
 
-	resultbyte = (0 < (decoder.var1 & 0x80));
-	decoder.var1 = (decoder.var1 << 1);
+	resultbyte = (0 < (d->var1 & 0x80));
+	d->var1 = (d->var1 << 1);
 
 	return resultbyte;
 }
@@ -217,36 +221,36 @@ int Deflate_DecodeScan(void)
 //**************************************************************
 //**************************************************************
 
-void Deflate_CheckTable(int a0, int a1, int a2)
+static void Deflate_CheckTable(decoder_t *d, int a0, int a1, int a2)
 {
 	int i = 0;
 	byte *t7p;
 	byte *v0p;
 	int idByte1;
 	int idByte2;
-	byte *tablePtr = (byte *) (DecodeTable + 0x9E0);
+	byte *tablePtr = (byte *) (d->DecodeTable + 0x9E0);
 
 	idByte1 = (a0 << 1);
 
 	do {
 		idByte2 = *(signed short *)(tablePtr + idByte1);
 
-		t7p = (array01 + (idByte2 << 1));
+		t7p = (d->array01 + (idByte2 << 1));
 		*(signed short *)t7p =
-		    (*(signed short *)(array01 + (a1 << 1)) +
-		     *(signed short *)(array01 + idByte1));
+		    (*(signed short *)(d->array01 + (a1 << 1)) +
+		     *(signed short *)(d->array01 + idByte1));
 
 		a0 = idByte2;
 
 		if (idByte2 != 1) {
 			idByte1 = *(signed short *)(tablePtr + (idByte2 << 1));
 			idByte2 =
-			    *(signed short *)(DecodeTable + (idByte1 << 1));
+			    *(signed short *)(d->DecodeTable + (idByte1 << 1));
 
 			a1 = idByte2;
 
 			if (a0 == idByte2)
-				a1 = *(signed short *)((DecodeTable + 0x4F0) +
+				a1 = *(signed short *)((d->DecodeTable + 0x4F0) +
 						       (idByte1 << 1));
 		}
 
@@ -254,12 +258,12 @@ void Deflate_CheckTable(int a0, int a1, int a2)
 
 	} while (a0 != 1);
 
-	if (*(signed short *)(array01 + 2) != 0x7D0)
+	if (*(signed short *)(d->array01 + 2) != 0x7D0)
 		return;
 
-	*(signed short *)(array01 + 2) >>= 1;
+	*(signed short *)(d->array01 + 2) >>= 1;
 
-	v0p = (byte *) (array01 + 4);
+	v0p = (byte *) (d->array01 + 4);
 
 	do {
 		*(signed short *)(v0p + 6) >>= 1;
@@ -279,7 +283,7 @@ void Deflate_CheckTable(int a0, int a1, int a2)
 //**************************************************************
 //**************************************************************
 
-void Deflate_DecodeByte(int a0)
+static void Deflate_DecodeByte(decoder_t *d, int a0)
 {
 	int v[2];
 	int a[4];
@@ -292,10 +296,10 @@ void Deflate_DecodeByte(int a0)
 	byte *s3p;
 	byte *a1p;
 
-	s4p = array01;
+	s4p = d->array01;
 	v[0] = (a0 << 1);
 
-	s2p = (byte *) (DecodeTable + 0x9E0);
+	s2p = (byte *) (d->DecodeTable + 0x9E0);
 
 	v1p = (s4p + v[0]);
 	s[5] = 1;
@@ -310,21 +314,21 @@ void Deflate_DecodeByte(int a0)
 
 	s1p = (s2p + v[1]);
 
-	s6p = (byte *) DecodeTable;
+	s6p = (byte *) d->DecodeTable;
 
 	a[3] = (*(signed short *)s1p << 1);
 	a[1] = *(signed short *)(s6p + a[3]);
-	s3p = (byte *) (DecodeTable + 0x4F0);
+	s3p = (byte *) (d->DecodeTable + 0x4F0);
 
 	if (a[2] == a[1]) {
 		a[1] = *(signed short *)(s3p + a[3]);
 		a[0] = a[2];
-		Deflate_CheckTable(a[0], a[1], a[2]);
+		Deflate_CheckTable(d, a[0], a[1], a[2]);
 		a[3] = (*(signed short *)s1p << 1);
 	} else {
 		a[0] = a[2];
-		Deflate_CheckTable(a[0], a[1], a[2]);
-		s3p = (byte *) (DecodeTable + 0x4F0);
+		Deflate_CheckTable(d, a[0], a[1], a[2]);
+		s3p = (byte *) (d->DecodeTable + 0x4F0);
 		a[3] = (*(signed short *)s1p << 1);
 	}
 
@@ -363,7 +367,7 @@ void Deflate_DecodeByte(int a0)
 			a[0] = s[0];
 			a[1] = a[2];
 
-			Deflate_CheckTable(a[0], a[1], a[2]);
+			Deflate_CheckTable(d, a[0], a[1], a[2]);
 			s1p = (s2p + (s[0] << 1));
 		}
 
@@ -382,21 +386,21 @@ void Deflate_DecodeByte(int a0)
 //**************************************************************
 //**************************************************************
 
-int Deflate_StartDecodeByte(void)
+static int Deflate_StartDecodeByte(decoder_t *d)
 {
 	int lookup = 1;		// $s0
-	byte *tablePtr1 = DecodeTable;	// $s2
-	byte *tablePtr2 = (byte *) (DecodeTable + 0x4F0);	// $s1
+	byte *tablePtr1 = d->DecodeTable;	// $s2
+	byte *tablePtr2 = (byte *) (d->DecodeTable + 0x4F0);	// $s1
 
 	while (lookup < 0x275) {
-		if (Deflate_DecodeScan() == 0)
+		if (Deflate_DecodeScan(d) == 0)
 			lookup = *(signed short *)(tablePtr1 + (lookup << 1));
 		else
 			lookup = *(signed short *)(tablePtr2 + (lookup << 1));
 	}
 
 	lookup = (lookup + (signed short)0xFD8B);
-	Deflate_DecodeByte(lookup);
+	Deflate_DecodeByte(d, lookup);
 
 	return lookup;
 }
@@ -407,7 +411,7 @@ int Deflate_StartDecodeByte(void)
 //**************************************************************
 //**************************************************************
 
-int Deflate_RescanByte(int byte)
+static int Deflate_RescanByte(decoder_t *d, int byte)
 {
 	int i = 0;		// $s1
 	int shift = 1;		// $s0
@@ -417,7 +421,7 @@ int Deflate_RescanByte(int byte)
 		return resultbyte;
 
 	do {
-		if (!(Deflate_DecodeScan() == 0))
+		if (!(Deflate_DecodeScan(d) == 0))
 			resultbyte |= shift;
 
 		i++;
@@ -433,15 +437,14 @@ int Deflate_RescanByte(int byte)
 //**************************************************************
 //**************************************************************
 
-void Deflate_WriteOutput(byte outByte)
+static void Deflate_WriteOutput(decoder_t *d, byte outByte)
 {
-	if (!((decoder.writePos - decoder.write) < OVERFLOWCHECK)) {
-		//I_Error("Overflowed output buffer");
-		WGen_Complain("Overflowed output buffer");
+	if (d->writePos >= d->writeEnd) {
+		d->error = true;
 		return;
 	}
 
-	*decoder.writePos++ = outByte;
+	*d->writePos++ = outByte;
 }
 
 //**************************************************************
@@ -450,8 +453,10 @@ void Deflate_WriteOutput(byte outByte)
 //**************************************************************
 //**************************************************************
 
-void Deflate_Decompress(byte * input, byte * output)
+bool Deflate_Decompress(byte * input, int insize, byte * output, int outsize)
 {
+	decoder_t decoder;
+	decoder_t *d = &decoder;
 	int v[2];
 	int a[4];
 	int s[10];
@@ -471,42 +476,42 @@ void Deflate_Decompress(byte * input, byte * output)
 	byte *t2p;
 	byte *t4p;
 
-	Deflate_InitDecodeTable();
-	incrBit = 0;
-
-	decoder.read = input;
-	decoder.readPos = input;
+	memset(d, 0, sizeof(decoder_t));
 
-	decoder.null1 = 0x7FFFFFFF;
+	Deflate_InitDecodeTable(d);
+	incrBit = 0;
 
-	decoder.write = output;
-	decoder.writePos = output;
+	d->read = input;
+	d->readPos = input;
+	d->readEnd = input + insize;
 
-	tablePtr1 = (byte *) (tableVar01 + 0x34);
+	d->write = output;
+	d->writePos = output;
+	d->writeEnd = output + outsize;
 
-	decoder.null2 = 0x7FFFFFFF;
+	tablePtr1 = (byte *) (d->tableVar01 + 0x34);
 
 //	a1p = tablePtr1;
 	a[2] = 1;
 	a[3] = 0;
 	// Z_Alloc(a[0], a1p, a[2], a[3]);
 
-	s4p = (byte *) allocPtr;
+	s4p = d->window;
 
-	v[0] = Deflate_StartDecodeByte();
+	v[0] = Deflate_StartDecodeByte(d);
 
 	at = 256;
 	s[0] = v[0];
 
 	// GhostlyDeath <May 14, 2010> -- loc_8002E058 is part of a while loop
-	while (v[0] != at) {
+	while (v[0] != at && !d->error) {
 		at = (v[0] < 256);
 		v[0] = 62;
 
 		// GhostlyDeath <May 15, 2010> -- loc_8002E094 is an if statement
 		if (at != 0) {
 			a[0] = (s[0] & 0xff);
-			Deflate_WriteOutput((byte) a[0]);
+			Deflate_WriteOutput(d, (byte) a[0]);
 
 			t8p = s4p;
 			t9p = (t8p + incrBit);
@@ -537,7 +542,7 @@ void Deflate_Decompress(byte * input, byte * output)
 
 			mul = s[5] * v[0];
 
-			a[0] = *(signed short *)(array05 + t[4]);
+			a[0] = *(signed short *)(d->array05 + t[4]);
 
 			t[3] = mul;
 
@@ -545,10 +550,10 @@ void Deflate_Decompress(byte * input, byte * output)
 			s[8] += (signed short)0xFF02;	// addiu   $fp, 0xFF02
 			s[3] = s[8];	// move    $s3, $fp
 
-			v[0] = Deflate_RescanByte(a[0]);
+			v[0] = Deflate_RescanByte(d, a[0]);
 
 			t[5] = (s[5] << 2);
-			t[6] = *(int *)(tableVar01 + t[5]);
+			t[6] = *(int *)(d->tableVar01 + t[5]);
 			s[1] = incrBit;
 
 			t[7] = (t[6] + v[0]);
@@ -563,14 +568,19 @@ void Deflate_Decompress(byte * input, byte * output)
 				t[8] = *(int *)tablePtr1;
 				s[0] = (a[0] + t[8]);
 			}
+			// the distance can't reach back past the window
+			if (s[0] < 0 || s[0] >= *(int *)tablePtr1) {
+				d->error = true;
+				break;
+			}
 			// GhostlyDeath <May 15, 2010> -- loc_8002E184 is an if
 			if (s[8] > 0)
 				// GhostlyDeath <May 15, 2010> -- loc_8002E12C is a while loop (jump back from end)
-				while (s[2] != s[3]) {
+				while (s[2] != s[3] && !d->error) {
 					t9p = s4p;
 					t1p = (t9p + s[0]);
 					a[0] = *(byte *) t1p;	// lbu  input, 0($t1)
-					Deflate_WriteOutput((byte) a[0]);
+					Deflate_WriteOutput(d, (byte) a[0]);
 
 					v0p = s4p;
 					s[2] += 1;
@@ -604,7 +614,7 @@ void Deflate_Decompress(byte * input, byte * output)
 				incrBit -= v[1];
 		}
 
-		v[0] = Deflate_StartDecodeByte();
+		v[0] = Deflate_StartDecodeByte(d);
 
 		at = 256;
 		s[0] = v[0];
@@ -612,4 +622,6 @@ void Deflate_Decompress(byte * input, byte * output)
 
 	a[1] = *(int *)s4p;
 	// Z_Free();
+
+	return !d->error;
 }
@@ -1,6 +1,7 @@
 #ifndef _WADGEN_DEFLATE_H_
 #define _WADGEN_DEFLATE_H_
 
-void Deflate_Decompress(byte * input, byte * output);
+// Returns false if the lump is corrupt or doesn't fit in outsize bytes
+bool Deflate_Decompress(byte * input, int insize, byte * output, int outsize);
 
 #endif
@@ -91,6 +91,27 @@ static uint Level_HashTextureName(const char *str)
 	return hash % 65536;
 }
 
+//**************************************************************
+//**************************************************************
+//      Level_HashTexture
+//
+//      Hashes a texture's name without its compression bit. The rom
+//      directory is left alone, since other lumps are still being
+//      decompressed from it while the levels are converted.
+//**************************************************************
+//**************************************************************
+
+static uint Level_HashTexture(int tstart, int texture)
+{
+	char name[9];
+
+	strncpy(name, romWadFile.lump[tstart + texture].name, 8);
+	name[8] = '\0';
+	name[0] &= 0x7f;
+
+	return Level_HashTextureName(name);
+}
+
 //**************************************************************
 //**************************************************************
 //      Level_HashSidedefs
@@ -104,28 +125,9 @@ static void Level_HashSidedefs(cache data, int size)
 	uint i;
 
 	for (i = 0; i < (size / sizeof(mapsidedef_t)); i++, sd++) {
-		char *name;
-
-		name = romWadFile.lump[tstart + sd->bottomtexture].name;
-
-		if (name[0] & 0x80)
-			name[0] -= (char)0x80;
-
-		sd->bottomtexture = Level_HashTextureName(name);
-
-		name = romWadFile.lump[tstart + sd->midtexture].name;
-
-		if (name[0] & 0x80)
-			name[0] -= (char)0x80;
-
-		sd->midtexture = Level_HashTextureName(name);
-
-		name = romWadFile.lump[tstart + sd->toptexture].name;
-
-		if (name[0] & 0x80)
-			name[0] -= (char)0x80;
-
-		sd->toptexture = Level_HashTextureName(name);
+		sd->bottomtexture = Level_HashTexture(tstart, sd->bottomtexture);
+		sd->midtexture = Level_HashTexture(tstart, sd->midtexture);
+		sd->toptexture = Level_HashTexture(tstart, sd->toptexture);
 	}
 }
 
@@ -142,21 +144,8 @@ static void Level_HashSectors(cache data, int size)
 	uint i;
 
 	for (i = 0; i < (size / sizeof(mapsector_t)); i++, ss++) {
-		char *name;
-
-		name = romWadFile.lump[tstart + ss->ceilingpic].name;
-
-		if (name[0] & 0x80)
-			name[0] -= (char)0x80;
-
-		ss->ceilingpic = Level_HashTextureName(name);
-
-		name = romWadFile.lump[tstart + ss->floorpic].name;
-
-		if (name[0] & 0x80)
-			name[0] -= (char)0x80;
-
-		ss->floorpic = Level_HashTextureName(name);
+		ss->ceilingpic = Level_HashTexture(tstart, ss->ceilingpic);
+		ss->floorpic = Level_HashTexture(tstart, ss->floorpic);
 	}
 }
 
@@ -202,20 +191,6 @@ void Level_GetMapWad(int num)
 #endif
 
 	levelData[num] = buffer;
-}
 
-//**************************************************************
-//**************************************************************
-//      Level_Setup
-//**************************************************************
-//**************************************************************
-
-void Level_Setup(void)
-{
-	int i;
-
-	for (i = 0; i < MAXLEVELWADS; i++) {
-		Level_GetMapWad(i);
-		WGen_UpdateProgress("Decompressing MAP%02d...", i);
-	}
+	WGen_UpdateProgress("Decompressing MAP%02d...", num);
 }
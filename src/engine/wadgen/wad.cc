@@ -75,7 +75,7 @@ int pngsize;
 //**************************************************************
 //**************************************************************
 
-void Wad_Decompress(byte * input, byte * output)
+bool Wad_Decompress(byte * input, int insize, byte * output, int outsize)
 {
 	int getidbyte = 0;
 	int len;
@@ -83,15 +83,24 @@ void Wad_Decompress(byte * input, byte * output)
 	int i;
 	byte *source;
 	int idbyte = 0;
+	byte *inend = input + insize;
+	byte *outstart = output;
+	byte *outend = output + outsize;
 
 	/*idbyte plays an important role, it specifies whenever something is compressed or
 	   decompressed by shifting the bits and finding out if there is a 0 or 1. */
 	while (1) {
-		if (!getidbyte)
+		if (!getidbyte) {
+			if (input >= inend)
+				return false;
 			idbyte = *input++;
+		}
 		getidbyte = (getidbyte + 1) & 7;	/*assign a new idbyte every 8th loop */
 
 		if (idbyte & 1) {
+			if (inend - input < 2)
+				return false;
+
 			/*begin decompressing and get position */
 			pos = *input++ << 4;
 			pos = pos | (*input >> 4);
@@ -104,16 +113,26 @@ void Wad_Decompress(byte * input, byte * output)
 			if (len == 1)
 				break;
 
+			/*the string has to be inside what was output so far, and fit */
+			if (source < outstart || outend - output < len)
+				return false;
+
 			/*copy what bytes that have been outputed so far */
 			for (i = 0; i < len; i++)
 				*output++ = *source++;
-		} else
+		} else {
+			if (input >= inend || output >= outend)
+				return false;
+
 			*output++ = *input++;	/*not compressed, just output the byte as is. */
+		}
 
 		/*shift to next bit and begin the check at the beginning */
 		idbyte = idbyte >> 1;
 
 	}
+
+	return true;
 }
 
 //**************************************************************
@@ -178,32 +197,44 @@ int Wad_GetLumpNum(const char *name)
 void *Wad_GetLump(char *name, bool dcmpType)
 {
 	byte *data;
-	byte *dmpLmp;		/*Decompression buffer */
+	byte *input;
+	int insize;
+	bool ok;
 	int lump = Wad_GetLumpNum(name);
+	lump_t *l = &romWadFile.lump[lump];
+
+	/*Lump data runs to the end of the rom at most */
+	input = romWadData + l->filepos;
+	insize = (int)(RomFile.length - (input - RomFile.data));
+
+	if (l->filepos < 0 || l->size < 0 || insize < 0)
+		WGen_Complain("Wad_GetLump: %.8s is outside of the rom", name);
+
+	data = (byte*) malloc(l->size);
 
-	data = (byte*) malloc(romWadFile.lump[lump].size);
-	memcpy(data, romWadData + romWadFile.lump[lump].filepos,
-	       romWadFile.lump[lump].size);
+	if (data == NULL) {
+		WGen_Complain
+		    ("Wad_GetLump: Couldn't allocate %u bytes from %s\n",
+		     l->size, l->name);
+	}
 
-	/*Parse compressed lump */
-	if (romWadFile.lump[lump].name[0] & 0x80) {
-		dmpLmp = (byte *) malloc(romWadFile.lump[lump].size);
+	/*Parse compressed lump; the directory holds the decompressed size */
+	if (l->name[0] & 0x80) {
 		if (dcmpType)
-			Deflate_Decompress(data, dmpLmp);
+			ok = Deflate_Decompress(input, insize, data, l->size);
 		else
-			Wad_Decompress(data, dmpLmp);
+			ok = Wad_Decompress(input, insize, data, l->size);
 
-		memcpy(data, dmpLmp, romWadFile.lump[lump].size);
-		free(dmpLmp);
+		if (!ok)
+			WGen_Complain("Wad_GetLump: %.8s is corrupt", name);
 
 		return data;
 	}
 
-	if (data == NULL) {
-		WGen_Complain
-		    ("Wad_GetLump: Couldn't allocate %u bytes from %s\n",
-		     romWadFile.lump[lump].size, romWadFile.lump[lump].name);
-	}
+	if (l->size > insize)
+		WGen_Complain("Wad_GetLump: %.8s is outside of the rom", name);
+
+	memcpy(data, input, l->size);
 
 	return data;
 }
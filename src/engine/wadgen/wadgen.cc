@@ -36,11 +36,30 @@
 #include <stdarg.h>
 #include <i_system.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #define MAX_ARGS 256
 char *ArgBuffer[MAX_ARGS + 1];
 
 void WGen_ShutDownApplication(void);
 
+// WGen_Printf can be called from any of the WGen_RunJobs workers
+static std::mutex printlock;
+
+// WGen_Complain can't exit from a worker while the others are still
+// converting; it unwinds the job instead and the error is reported
+// once they are all done
+struct WGen_JobFailed {};
+
+static thread_local bool inworker = false;
+static std::mutex failurelock;
+static std::string failure;
+
 //**************************************************************
 //**************************************************************
 //      WGen_AddDigest
@@ -61,6 +80,54 @@ void WGen_AddDigest(char *name, int lump, int size)
 	MD5_UpdateInt32(&md5_context, size);
 }
 
+//**************************************************************
+//**************************************************************
+//      WGen_RunJobs
+//
+//      Runs the jobs on as many threads as there are cores and waits
+//      for all of them to finish. Jobs are started in list order, so
+//      put the slowest ones first.
+//**************************************************************
+//**************************************************************
+
+static void WGen_RunJobs(const std::vector<std::function<void()>> &jobs)
+{
+	std::atomic<size_t> next { 0 };
+	std::vector<std::thread> workers;
+	size_t count = std::thread::hardware_concurrency();
+	size_t i;
+
+	if (count < 1)
+		count = 1;
+	if (count > jobs.size())
+		count = jobs.size();
+
+	for (i = 0; i < count; i++) {
+		workers.emplace_back([&] {
+			size_t j;
+
+			inworker = true;
+
+			try {
+				while ((j = next++) < jobs.size())
+					jobs[j]();
+			}
+			catch (const WGen_JobFailed &) {
+				// stop handing out jobs; the rest finish what they have
+				next = jobs.size();
+			}
+		});
+	}
+
+	for (auto &worker : workers)
+		worker.join();
+
+	if (!failure.empty()) {
+		WGen_Printf("ERROR: %s", failure.c_str());
+		exit(1);
+	}
+}
+
 //**************************************************************
 //**************************************************************
 //      WGen_Process
@@ -82,13 +149,24 @@ void WGen_Process(char *path)
 	char *outFile;
 	md5_digest_t digest;
 
+	std::vector<std::function<void()>> jobs;
+
 	Rom_Open(path);
 
-	Sound_Setup();
-	Sprite_Setup();
-	Gfx_Setup();
-	Texture_Setup();
-	Level_Setup();
+	// Everything is converted out of the rom at once. Each step only
+	// reads the rom and writes its own tables. Sprites and sounds are
+	// the longest single jobs so they start first; the maps are split
+	// up one per job.
+	jobs.push_back(Sprite_Setup);
+	jobs.push_back(Sound_Setup);
+
+	for (i = 0; i < MAXLEVELWADS; i++)
+		jobs.push_back([i] { Level_GetMapWad(i); });
+
+	jobs.push_back(Texture_Setup);
+	jobs.push_back(Gfx_Setup);
+
+	WGen_RunJobs(jobs);
 
 	Wad_CreateOutput();
 
@@ -206,6 +284,8 @@ void WGen_Printf(const char *s, ...)
 	vsprintf(msg, s, v);
 	va_end(v);
 
+	std::lock_guard<std::mutex> lock(printlock);
+
 #ifdef _WIN32
 	I_Printf("%s\n", msg); //Print to launcher console in Windows
 #else
@@ -227,6 +307,17 @@ void WGen_Complain(const char *fmt, ...)
 	va_start(va, fmt);
 	vsprintf(buff, fmt, va);
 	va_end(va);
+
+	if (inworker) {
+		std::lock_guard<std::mutex> lock(failurelock);
+
+		// the first error is the one worth reporting
+		if (failure.empty())
+			failure = buff;
+
+		throw WGen_JobFailed();
+	}
+
 	WGen_Printf("ERROR: %s", buff);
 	exit(1);
 }
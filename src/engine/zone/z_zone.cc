@@ -35,19 +35,83 @@
 #include "doomstat.h"
 
 #define ZONEID    0x1d4a11
+#define FREEID    0x1d4a1f
 //#define ZONEFILE
 
+//
+// Every block still carries a memblock_t header so that the user
+// back-pointer, tag and ZONEID checks work the same way no matter where
+// the memory came from. Small requests are rounded up to a size class
+// and recycled through per-class free lists instead of going back to
+// the system. PU_LEVEL and PU_LEVSPEC blocks are carved out of
+// bump-pointer arenas that are thrown away wholesale by Z_FreeTags.
+//
+
 typedef struct memblock_s memblock_t;
 
 struct memblock_s {
     int id; // = ZONEID
     int tag;
-    int size;
+    int size;       // size requested by the caller
+    int capacity;   // usable bytes following the header
+    int sizeclass;  // free list index, or -1 if too big for one
+    int flags;
     void **user;
     memblock_t *prev;
     memblock_t *next;
 };
 
+enum {
+    MBF_ARENA   = 0x1,  // memory belongs to a level arena
+    MBF_LINKED  = 0x2   // block is in allocated_blocks
+};
+
+#define ZONE_ALIGN(x)       (((x) + 15) & ~15)
+
+static const int zone_classsizes[] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+    768, 1024, 1536, 2048, 3072, 4096, 6144, 8192
+};
+
+#define NUMSIZECLASSES      (int)(sizeof(zone_classsizes) / sizeof(zone_classsizes[0]))
+#define MAXCLASSSIZE        8192
+
+// size class lookup, indexed by (size + 15) >> 4
+static signed char zone_sizeclass[(MAXCLASSSIZE >> 4) + 1];
+
+//
+// Arena chunks. Standard sized chunks are kept around after a level
+// ends and reused by the next one; anything bigger gets a chunk of its
+// own which is returned to the system on reset.
+//
+
+#define ARENA_CHUNKSIZE     (1 << 20)
+#define ARENA_BIGBLOCK      (ARENA_CHUNKSIZE >> 2)
+
+typedef struct arenachunk_s arenachunk_t;
+
+struct arenachunk_s {
+    arenachunk_t *next;
+    int size;
+    int used;
+};
+
+#define ARENA_CHUNKHEADER   ZONE_ALIGN((int)sizeof(arenachunk_t))
+
+typedef struct {
+    arenachunk_t *chunks;   // first chunk is the one being carved
+    arenachunk_t *spare;    // emptied chunks waiting to be reused
+    memblock_t *freelist[NUMSIZECLASSES];
+} arena_t;
+
+#define Z_IsArenaTag(tag)   ((tag) == PU_LEVEL || (tag) == PU_LEVSPEC)
+
+static arena_t arenas[PU_MAX];
+static memblock_t *freeblocks[NUMSIZECLASSES];
+static int tag_usage[PU_MAX];
+
+static dboolean Z_IsPoolItem(void *ptr);
+
 #ifdef ZONEFILE
 
 static FILE *zonelog;
@@ -86,7 +150,8 @@ static void Z_LogPuts(const char *msg) {
 
 #endif
 
-// Linked list of allocated blocks for each tag type
+// Linked list of allocated blocks for each tag type. Arena blocks are
+// only linked when they have an owner that needs clearing.
 
 static memblock_t *allocated_blocks[PU_MAX];
 
@@ -96,6 +161,11 @@ static memblock_t *allocated_blocks[PU_MAX];
 //
 
 static void Z_InsertBlock(memblock_t *block) {
+    if(block->flags & MBF_ARENA && block->user == NULL) {
+        return;
+    }
+
+    block->flags |= MBF_LINKED;
     block->prev = NULL;
     block->next = allocated_blocks[block->tag];
     allocated_blocks[block->tag] = block;
@@ -111,6 +181,12 @@ static void Z_InsertBlock(memblock_t *block) {
 //
 
 static void Z_RemoveBlock(memblock_t *block) {
+    if(!(block->flags & MBF_LINKED)) {
+        return;
+    }
+
+    block->flags &= ~MBF_LINKED;
+
     // Unlink from list
     if(block->prev == NULL) {
         allocated_blocks[block->tag] = block->next;    // Start of list
@@ -124,12 +200,225 @@ static void Z_RemoveBlock(memblock_t *block) {
     }
 }
 
+//
+// Z_SizeClass
+// Returns the free list index for a request, or -1 if it is too big.
+//
+
+static int Z_SizeClass(int size) {
+    if(size > MAXCLASSSIZE) {
+        return -1;
+    }
+
+    return zone_sizeclass[(size + 15) >> 4];
+}
+
+//
+// Z_ReleaseFreeLists
+// Hand every recycled system block back to the system.
+//
+
+static void Z_ReleaseFreeLists(void) {
+    int i;
+
+    for(i = 0; i < NUMSIZECLASSES; i++) {
+        while(freeblocks[i] != NULL) {
+            memblock_t *next = freeblocks[i]->next;
+
+            free(freeblocks[i]);
+            freeblocks[i] = next;
+        }
+    }
+}
+
+//
+// Z_ArenaChunk
+// Get an empty chunk that can hold at least size bytes, preferring a
+// spare one left over from a previous level.
+//
+
+static arenachunk_t *Z_ArenaChunk(arena_t *arena, int size) {
+    arenachunk_t **link;
+    arenachunk_t *chunk;
+
+    for(link = &arena->spare; *link != NULL; link = &(*link)->next) {
+        if((*link)->size >= size) {
+            chunk = *link;
+            *link = chunk->next;
+            chunk->used = 0;
+            return chunk;
+        }
+    }
+
+    if(size < ARENA_CHUNKSIZE) {
+        size = ARENA_CHUNKSIZE;
+    }
+
+    chunk = (arenachunk_t*)malloc(ARENA_CHUNKHEADER + size);
+
+    if(chunk == NULL) {
+        return NULL;
+    }
+
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+//
+// Z_ArenaAlloc
+// Bump-allocate size bytes (header included) from an arena.
+//
+
+static memblock_t *Z_ArenaAlloc(arena_t *arena, int size) {
+    arenachunk_t *chunk = arena->chunks;
+    memblock_t *block;
+
+    if(chunk == NULL || chunk->used + size > chunk->size) {
+        if(!(chunk = Z_ArenaChunk(arena, size))) {
+            return NULL;
+        }
+
+        //
+        // Big blocks get a chunk of their own which is filled right
+        // away, so keep carving the current one.
+        //
+        if(size >= ARENA_BIGBLOCK && arena->chunks != NULL) {
+            chunk->next = arena->chunks->next;
+            arena->chunks->next = chunk;
+        }
+        else {
+            chunk->next = arena->chunks;
+            arena->chunks = chunk;
+        }
+    }
+
+    block = (memblock_t*)((byte*)chunk + ARENA_CHUNKHEADER + chunk->used);
+    chunk->used += size;
+
+    return block;
+}
+
+//
+// Z_ArenaReset
+// Throw away everything in an arena. Individual blocks are never
+// visited, only whole chunks.
+//
+
+static void Z_ArenaReset(arena_t *arena) {
+    arenachunk_t *chunk;
+    arenachunk_t *next;
+
+    for(chunk = arena->chunks; chunk != NULL; chunk = next) {
+        next = chunk->next;
+
+        if(chunk->size > ARENA_CHUNKSIZE) {
+            free(chunk);
+            continue;
+        }
+
+        chunk->next = arena->spare;
+        arena->spare = chunk;
+    }
+
+    arena->chunks = NULL;
+    dmemset(arena->freelist, 0, sizeof(arena->freelist));
+}
+
+//
+// Z_AllocBlock
+// Get a block with room for at least reserve bytes. Does not fill in
+// the id, tag or user fields.
+//
+
+static memblock_t *Z_AllocBlock(int reserve, int tag) {
+    memblock_t **freelist = NULL;
+    memblock_t *block;
+    int sizeclass;
+    int capacity;
+
+    sizeclass = Z_SizeClass(reserve);
+
+    if(sizeclass >= 0) {
+        capacity = zone_classsizes[sizeclass];
+        freelist = Z_IsArenaTag(tag) ? &arenas[tag].freelist[sizeclass] : &freeblocks[sizeclass];
+
+        if(*freelist != NULL) {
+            block = *freelist;
+            *freelist = block->next;
+
+            block->flags &= MBF_ARENA;
+            return block;
+        }
+    }
+    else {
+        capacity = ZONE_ALIGN(reserve);
+    }
+
+    if(Z_IsArenaTag(tag)) {
+        block = Z_ArenaAlloc(&arenas[tag], sizeof(memblock_t) + capacity);
+    }
+    else {
+        block = (memblock_t*)malloc(sizeof(memblock_t) + capacity);
+    }
+
+    if(block == NULL) {
+        return NULL;
+    }
+
+    block->capacity = capacity;
+    block->sizeclass = sizeclass;
+    block->flags = Z_IsArenaTag(tag) ? MBF_ARENA : 0;
+
+    return block;
+}
+
+//
+// Z_ReleaseBlock
+// Return an unlinked block to its free list. Arena blocks that are too
+// big for one simply stay put until the arena is reset.
+//
+
+static void Z_ReleaseBlock(memblock_t *block) {
+    block->id = FREEID;
+    block->user = NULL;
+
+    if(block->sizeclass >= 0) {
+        memblock_t **freelist;
+
+        if(block->flags & MBF_ARENA) {
+            freelist = &arenas[block->tag].freelist[block->sizeclass];
+        }
+        else {
+            freelist = &freeblocks[block->sizeclass];
+        }
+
+        block->next = *freelist;
+        *freelist = block;
+    }
+    else if(!(block->flags & MBF_ARENA)) {
+        free(block);
+    }
+}
+
 //
 // Z_Init
 //
 
 void Z_Init(void) {
+    int i;
+    int c;
+
     dmemset(allocated_blocks, 0, sizeof(allocated_blocks));
+    dmemset(tag_usage, 0, sizeof(tag_usage));
+
+    for(i = 0, c = 0; i <= (MAXCLASSSIZE >> 4); i++) {
+        while(zone_classsizes[c] < (i << 4)) {
+            c++;
+        }
+
+        zone_sizeclass[i] = c;
+    }
 
 #ifdef ZONEFILE
     atexit(Z_CloseLogFile); // exit handler
@@ -160,8 +449,10 @@ void (Z_Free)(void* ptr, const char *file, int line) {
 
     Z_RemoveBlock(block);
 
-    // Free back to system
-    free(block);
+    tag_usage[block->tag] -= block->size;
+
+    // Free back to its free list or the system
+    Z_ReleaseBlock(block);
 
 #ifdef ZONEFILE
     Z_LogPrintf("* Z_Free(ptr=%p, file=%s:%d)\n", ptr, file, line);
@@ -215,19 +506,40 @@ static dboolean Z_ClearCache(int size) {
         Z_RemoveBlock(block);
 
         remaining -= block->size;
+        tag_usage[PU_CACHE] -= block->size;
 
         if(block->user) {
             *block->user = NULL;
         }
 
-        free(block);
+        Z_ReleaseBlock(block);
 
         block = next_block;
     }
 
+    // make sure the memory really goes back to the system
+    Z_ReleaseFreeLists();
+
     return true;
 }
 
+//
+// Z_NewBlock
+// Allocate a block, purging the cache if the system is out of memory.
+//
+
+static memblock_t *Z_NewBlock(int reserve, int tag) {
+    memblock_t *block;
+
+    if(!(block = Z_AllocBlock(reserve, tag))) {
+        if(Z_ClearCache(sizeof(memblock_t) + reserve)) {
+            block = Z_AllocBlock(reserve, tag);
+        }
+    }
+
+    return block;
+}
+
 //
 // Z_Malloc
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
@@ -246,17 +558,9 @@ void *(Z_Malloc)(int size, int tag, void *user, const char *file, int line) {
         I_Error("Z_Malloc: an owner is required for purgable blocks (%s:%d)", file, line);
     }
 
-    // Malloc a block of the required size
+    // Get a block of the required size
 
-    newblock = NULL;
-
-    if(!(newblock = (memblock_t*)malloc(sizeof(memblock_t) + size))) {
-        if(Z_ClearCache(sizeof(memblock_t) + size)) {
-            newblock = (memblock_t*)malloc(sizeof(memblock_t) + size);
-        }
-    }
-
-    if(!newblock) {
+    if(!(newblock = Z_NewBlock(size, tag))) {
         I_Error("Z_Malloc: failed on allocation of %u bytes (%s:%d)", size, file, line);
     }
 
@@ -269,6 +573,8 @@ void *(Z_Malloc)(int size, int tag, void *user, const char *file, int line) {
 
     Z_InsertBlock(newblock);
 
+    tag_usage[tag] += size;
+
     data = (unsigned char*)newblock;
     result = data + sizeof(memblock_t);
 
@@ -277,7 +583,7 @@ void *(Z_Malloc)(int size, int tag, void *user, const char *file, int line) {
     }
 
 #ifdef ZONEFILE
-    Z_LogPrintf("* %p = Z_Malloc(size=%lu, tag=%d, user=%p, source=%s:%d)\n",
+    Z_LogPrintf("* %p = Z_Malloc(size=%d, tag=%d, user=%p, source=%s:%d)\n",
                 result, size, tag, user, file, line);
 #endif
 
@@ -323,16 +629,44 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
     Z_RemoveBlock(block);
 
     origsize = block->size;
-    block->next = NULL;
-    block->prev = NULL;
+    tag_usage[block->tag] -= origsize;
 
     if(block->user) {
         *block->user = NULL;
     }
 
-    if(!(newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + size))) {
-        if(Z_ClearCache(sizeof(memblock_t) + size)) {
-            newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + size);
+    if(size <= block->capacity &&
+            (block->flags & MBF_ARENA ? tag == block->tag : !Z_IsArenaTag(tag))) {
+        // still fits where it is
+        newblock = block;
+    }
+    else if(block->sizeclass < 0 && !(block->flags & MBF_ARENA) && !Z_IsArenaTag(tag) &&
+            Z_SizeClass(size) < 0) {
+        // big system blocks can be resized by the system
+        if(!(newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + ZONE_ALIGN(size)))) {
+            if(Z_ClearCache(sizeof(memblock_t) + size)) {
+                newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + ZONE_ALIGN(size));
+            }
+        }
+
+        if(newblock) {
+            newblock->capacity = ZONE_ALIGN(size);
+        }
+    }
+    else {
+        int reserve = size;
+
+        //
+        // Arena blocks that move leave a hole behind until the level
+        // ends, so give growing blocks some headroom.
+        //
+        if(Z_IsArenaTag(tag) && size > origsize && Z_SizeClass(size) < 0) {
+            reserve = MAX(size, origsize * 2);
+        }
+
+        if((newblock = Z_NewBlock(reserve, tag))) {
+            dmemcpy((byte*)newblock + sizeof(memblock_t), ptr, MIN(origsize, size));
+            Z_ReleaseBlock(block);
         }
     }
 
@@ -347,6 +681,8 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
 
     Z_InsertBlock(newblock);
 
+    tag_usage[tag] += size;
+
     data = (unsigned char*)newblock;
     result = data + sizeof(memblock_t);
 
@@ -360,7 +696,7 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
     }
 
 #ifdef ZONEFILE
-    Z_LogPrintf("* %p = Z_Realloc(ptr=%p, n=%lu, tag=%d, user=%p, source=%s:%d)\n",
+    Z_LogPrintf("* %p = Z_Realloc(ptr=%p, n=%d, tag=%d, user=%p, source=%s:%d)\n",
                 result, ptr, size, tag, user, file, line);
 #endif
 
@@ -378,7 +714,10 @@ void (Z_FreeTags)(int lowtag, int hightag, const char *file, int line) {
         memblock_t *block;
         memblock_t *next;
 
-        // Free all in this chain
+        //
+        // Free all in this chain. For the arena tags this only holds
+        // blocks with an owner and blocks retagged from elsewhere.
+        //
 
         for(block = allocated_blocks[i]; block != NULL;) {
             next = block->next;
@@ -393,7 +732,11 @@ void (Z_FreeTags)(int lowtag, int hightag, const char *file, int line) {
                 *block->user = NULL;
             }
 
-            free(block);
+            block->flags &= ~MBF_LINKED;
+
+            if(!(block->flags & MBF_ARENA)) {
+                Z_ReleaseBlock(block);
+            }
 
             // Jump to the next in the chain
 
@@ -402,6 +745,12 @@ void (Z_FreeTags)(int lowtag, int hightag, const char *file, int line) {
 
         // This chain is empty now
         allocated_blocks[i] = NULL;
+        tag_usage[i] = 0;
+
+        // Everything else goes with the arena
+        if(Z_IsArenaTag(i)) {
+            Z_ArenaReset(&arenas[i]);
+        }
     }
 
 #ifdef ZONEFILE
@@ -452,6 +801,11 @@ char *(Z_Strdupa)(const char *s, const char *file, int line) {
 void (Z_Touch)(void *ptr, const char *file, int line) {
     memblock_t *block;
 
+    // pooled objects (see Z_PoolAlloc) carry their own header
+    if(Z_IsPoolItem(ptr)) {
+        return;
+    }
+
     block = (memblock_t*)((byte*)ptr - sizeof(memblock_t));
 
     if(block->id != ZONEID) {
@@ -513,6 +867,27 @@ void (Z_CheckHeap)(const char *file, int line) {
         }
     }
 
+    //
+    // Check the free lists
+    //
+    for(i = 0; i < NUMSIZECLASSES; ++i) {
+        int j;
+
+        for(block = freeblocks[i]; block != NULL; block = block->next) {
+            if(block->id != FREEID || block->sizeclass != i) {
+                I_Error("Z_CheckHeap: Free list corrupted! (%s:%d)", file, line);
+            }
+        }
+
+        for(j = 0; j < PU_MAX; ++j) {
+            for(block = arenas[j].freelist[i]; block != NULL; block = block->next) {
+                if(block->id != FREEID || block->sizeclass != i) {
+                    I_Error("Z_CheckHeap: Arena free list corrupted! (%s:%d)", file, line);
+                }
+            }
+        }
+    }
+
 #ifdef ZONEFILE
     Z_LogPrintf("* Z_CheckHeap(file=%s:%d)\n", file, line);
 #endif
@@ -553,12 +928,23 @@ void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line) {
         I_Error("Z_ChangeTag: an owner is required for purgable blocks (%s:%d)", file, line);
     }
 
+    if(tag == block->tag) {
+        return;
+    }
+
+    // arena memory can't outlive its level, nor be handed to another arena
+    if(block->flags & MBF_ARENA) {
+        I_Error("Z_ChangeTag: can't retag a block from a level arena (%s:%d)", file, line);
+    }
+
     //
     // Remove the block from its current list, and rehook it into
     // its new list.
     //
     Z_RemoveBlock(block);
+    tag_usage[block->tag] -= block->size;
     block->tag = tag;
+    tag_usage[block->tag] += block->size;
     Z_InsertBlock(block);
 
 #ifdef ZONEFILE
@@ -572,18 +958,11 @@ void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line) {
 //
 
 int Z_TagUsage(int tag) {
-    int bytes = 0;
-    memblock_t *block;
-
     if(tag < 0 || tag >= PU_MAX) {
         I_Error("Z_TagUsage: tag out of range: %i", tag);
     }
 
-    for(block = allocated_blocks[tag]; block != NULL; block = block->next) {
-        bytes += block->size;
-    }
-
-    return bytes;
+    return tag_usage[tag];
 }
 
 //
@@ -593,14 +972,264 @@ int Z_TagUsage(int tag) {
 int Z_FreeMemory(void) {
     int bytes = 0;
     int i;
-    memblock_t *block;
 
     for(i = 0; i < PU_MAX; i++) {
-        for(block = allocated_blocks[i]; block != NULL; block = block->next) {
-            bytes += block->size;
-        }
+        bytes += tag_usage[i];
     }
 
     return bytes;
 }
 
+//
+// Fixed size pools for thinkers and mobjs.
+//
+// Items of one size are packed into slabs carved out of the level
+// arena, with a free list per slab. Allocation always comes from the
+// lowest slab with a free slot, so live objects stay dense and the
+// thinker and mobj lists walk mostly contiguous memory. The slabs go
+// away with PU_LEVEL; the pool notices its slab table was cleared and
+// starts over.
+//
+
+#define POOLID          0x1d4a2c
+#define POOLFREEID      0x1d4a2d
+#define POOL_SLABSIZE   0x4000
+#define POOL_MAXSIZE    1024
+#define NUMPOOLS        (POOL_MAXSIZE >> 4)
+
+typedef struct {
+    int id;     // POOLID, or POOLFREEID while on a free list
+    int pool;
+    int slab;
+    int pad;
+} poolitem_t;
+
+typedef struct {
+    byte *base;
+    void *freelist;     // next pointer is kept in the item body
+    int numfree;
+} poolslab_t;
+
+typedef struct {
+    int stride;         // header plus rounded item size
+    int perslab;
+    int numslabs;
+    int maxslabs;
+    int firstfree;      // lowest slab that may have a free slot
+    poolslab_t *slabs;  // PU_LEVEL, cleared by Z_FreeTags
+} pool_t;
+
+static pool_t pools[NUMPOOLS];
+
+//
+// Every slab's address range, sorted by base, so a pointer can be
+// placed in a slab without reading memory in front of it
+//
+
+typedef struct {
+    byte *base;
+    byte *end;
+    int pool;
+} slabrange_t;
+
+static slabrange_t *slabranges = NULL;   // PU_LEVEL, cleared by Z_FreeTags
+static int numslabranges = 0;
+static int maxslabranges = 0;
+
+//
+// Z_AddSlabRange
+//
+
+static void Z_AddSlabRange(byte *base, byte *end, int index) {
+    int i;
+
+    if(slabranges == NULL) {
+        numslabranges = 0;
+        maxslabranges = 0;
+    }
+
+    if(numslabranges == maxslabranges) {
+        maxslabranges = maxslabranges ? maxslabranges * 2 : 64;
+        slabranges = (slabrange_t*)(Z_Realloc)(slabranges, maxslabranges * sizeof(slabrange_t),
+                                               PU_LEVEL, &slabranges, __FILE__, __LINE__);
+    }
+
+    for(i = numslabranges; i > 0 && slabranges[i - 1].base > base; i--) {
+        slabranges[i] = slabranges[i - 1];
+    }
+
+    slabranges[i].base = base;
+    slabranges[i].end = end;
+    slabranges[i].pool = index;
+    numslabranges++;
+}
+
+//
+// Z_IsPoolItem
+//
+
+static dboolean Z_IsPoolItem(void *ptr) {
+    byte *p = (byte*)ptr;
+    slabrange_t *range;
+    int lo;
+    int hi;
+
+    if(slabranges == NULL || numslabranges == 0 || p < slabranges[0].base) {
+        return false;
+    }
+
+    // last range starting at or below p
+    lo = 0;
+    hi = numslabranges - 1;
+
+    while(lo < hi) {
+        int mid = (lo + hi + 1) >> 1;
+
+        if(slabranges[mid].base <= p) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    range = &slabranges[lo];
+
+    if(p >= range->end ||
+            (p - range->base) % pools[range->pool].stride != (int)sizeof(poolitem_t)) {
+        return false;
+    }
+
+    return ((poolitem_t*)ptr - 1)->id == POOLID;
+}
+
+//
+// Z_PoolNewSlab
+//
+
+static poolslab_t *Z_PoolNewSlab(pool_t *pool, int index) {
+    poolslab_t *slab;
+    byte *item;
+    void **link;
+    int i;
+
+    if(pool->numslabs == pool->maxslabs) {
+        pool->maxslabs = pool->maxslabs ? pool->maxslabs * 2 : 16;
+        pool->slabs = (poolslab_t*)(Z_Realloc)(pool->slabs, pool->maxslabs * sizeof(poolslab_t),
+                                               PU_LEVEL, &pool->slabs, __FILE__, __LINE__);
+    }
+
+    slab = &pool->slabs[pool->numslabs];
+    slab->base = (byte*)(Z_Malloc)(pool->stride * pool->perslab, PU_LEVEL, NULL, __FILE__, __LINE__);
+    slab->numfree = pool->perslab;
+    Z_AddSlabRange(slab->base, slab->base + pool->stride * pool->perslab, index);
+
+    // thread the free list in address order
+    link = &slab->freelist;
+    for(i = 0, item = slab->base; i < pool->perslab; i++, item += pool->stride) {
+        poolitem_t *header = (poolitem_t*)item;
+
+        header->id = POOLFREEID;
+        header->pool = index;
+        header->slab = pool->numslabs;
+
+        *link = item + sizeof(poolitem_t);
+        link = (void**)*link;
+    }
+    *link = NULL;
+
+    pool->numslabs++;
+    return slab;
+}
+
+//
+// Z_PoolAlloc
+// Returns a zeroed PU_LEVEL object; release it with Z_PoolFree
+//
+
+void *(Z_PoolAlloc)(int size, const char *file, int line) {
+    pool_t *pool;
+    poolslab_t *slab;
+    poolitem_t *header;
+    void *ptr;
+    int index;
+
+    if(size <= 0 || size > POOL_MAXSIZE) {
+        I_Error("Z_PoolAlloc: bad size %i (%s:%d)", size, file, line);
+    }
+
+    index = (size - 1) >> 4;
+    pool = &pools[index];
+
+    // a new level freed the slabs
+    if(pool->slabs == NULL) {
+        pool->numslabs = 0;
+        pool->maxslabs = 0;
+        pool->firstfree = 0;
+    }
+
+    if(!pool->stride) {
+        pool->stride = (int)sizeof(poolitem_t) + ((index + 1) << 4);
+        pool->perslab = MAX(POOL_SLABSIZE / pool->stride, 1);
+    }
+
+    while(pool->firstfree < pool->numslabs && !pool->slabs[pool->firstfree].numfree) {
+        pool->firstfree++;
+    }
+
+    if(pool->firstfree == pool->numslabs) {
+        slab = Z_PoolNewSlab(pool, index);
+    }
+    else {
+        slab = &pool->slabs[pool->firstfree];
+    }
+
+    ptr = slab->freelist;
+    slab->freelist = *(void**)ptr;
+    slab->numfree--;
+
+    header = (poolitem_t*)ptr - 1;
+    header->id = POOLID;
+
+#ifdef ZONEFILE
+    Z_LogPrintf("* Z_PoolAlloc(ptr=%p, size=%d, file=%s:%d)\n",
+                ptr, size, file, line);
+#endif
+
+    return dmemset(ptr, 0, pool->stride - sizeof(poolitem_t));
+}
+
+//
+// Z_PoolFree
+//
+
+void (Z_PoolFree)(void *ptr, const char *file, int line) {
+    poolitem_t *header;
+    pool_t *pool;
+    poolslab_t *slab;
+
+    if(ptr == NULL) {
+        return;
+    }
+
+    if(!Z_IsPoolItem(ptr)) {
+        I_Error("Z_PoolFree: freed a pointer without POOLID (%s:%d)", file, line);
+    }
+
+    header = (poolitem_t*)ptr - 1;
+    pool = &pools[header->pool];
+    slab = &pool->slabs[header->slab];
+
+    header->id = POOLFREEID;
+    *(void**)ptr = slab->freelist;
+    slab->freelist = ptr;
+    slab->numfree++;
+
+    if(header->slab < pool->firstfree) {
+        pool->firstfree = header->slab;
+    }
+
+#ifdef ZONEFILE
+    Z_LogPrintf("* Z_PoolFree(ptr=%p, file=%s:%d)\n", ptr, file, line);
+#endif
+}
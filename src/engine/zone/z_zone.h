@@ -74,6 +74,8 @@ void (Z_FreeAlloca)(const char *file, int line);
 void (Z_CheckHeap)(const char *,int);      // killough 3/22/98: add file/line info
 int (Z_CheckTag)(void *,const char *,int);
 void (Z_Touch)(void *ptr, const char *, int);
+void*   (Z_PoolAlloc)(int size, const char *, int);
+void (Z_PoolFree)(void *ptr, const char *, int);
 
 #define Z_Free(a)           (Z_Free)        (a,      __FILE__,__LINE__)
 #define Z_FreeTags(a,b)     (Z_FreeTags)    (a,b,    __FILE__,__LINE__)
@@ -88,6 +90,8 @@ void (Z_Touch)(void *ptr, const char *, int);
 #define Z_CheckTag(a)       (Z_CheckTag)    (a,      __FILE__,__LINE__)
 #define Z_Touch(a)          (Z_Touch)       (a,      __FILE__,__LINE__)
 #define Z_FreeAlloca()      (Z_FreeAlloca)  (        __FILE__,__LINE__)
+#define Z_PoolAlloc(a)      (Z_PoolAlloc)   (a,      __FILE__,__LINE__)
+#define Z_PoolFree(a)       (Z_PoolFree)    (a,      __FILE__,__LINE__)
 
 #define strdup(s)           (Z_Strdup) (s, PU_STATIC,0,__FILE__,__LINE__)
 
@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "z_zone.h"
+
+namespace {
+  struct ZoneTest : ::testing::Test {
+      void SetUp() override
+      { Z_Init(); }
+
+      void TearDown() override
+      { Z_FreeTags(PU_STATIC, PU_CACHE); }
+  };
+
+  //
+  // The allocator this zone replaced: one malloc per block, pushed onto a
+  // doubly linked list per tag, with Z_FreeTags walking every block.
+  //
+  class LegacyZone {
+      struct Block {
+          int tag;
+          int size;
+          void **user;
+          Block *prev;
+          Block *next;
+      };
+
+      Block *lists_[PU_MAX] {};
+
+      void unlink(Block *b)
+      {
+          if (b->prev) b->prev->next = b->next; else lists_[b->tag] = b->next;
+          if (b->next) b->next->prev = b->prev;
+      }
+
+      void link(Block *b)
+      {
+          b->prev = nullptr;
+          b->next = lists_[b->tag];
+          if (b->next) b->next->prev = b;
+          lists_[b->tag] = b;
+      }
+
+  public:
+      void *malloc(int size, int tag, void *user)
+      {
+          auto b = static_cast<Block *>(std::malloc(sizeof(Block) + size));
+          b->tag = tag;
+          b->size = size;
+          b->user = static_cast<void **>(user);
+          link(b);
+          auto ptr = static_cast<void *>(b + 1);
+          if (user) *b->user = ptr;
+          return ptr;
+      }
+
+      void *realloc(void *ptr, int size, int tag, void *user)
+      {
+          auto b = static_cast<Block *>(ptr) - 1;
+          unlink(b);
+          b = static_cast<Block *>(std::realloc(b, sizeof(Block) + size));
+          b->tag = tag;
+          b->size = size;
+          b->user = static_cast<void **>(user);
+          link(b);
+          return b + 1;
+      }
+
+      void free(void *ptr)
+      {
+          auto b = static_cast<Block *>(ptr) - 1;
+          if (b->user) *b->user = nullptr;
+          unlink(b);
+          std::free(b);
+      }
+
+      void free_tags(int lowtag, int hightag)
+      {
+          for (int i = lowtag; i <= hightag; ++i) {
+              for (auto b = lists_[i]; b != nullptr;) {
+                  auto next = b->next;
+                  if (b->user) *b->user = nullptr;
+                  std::free(b);
+                  b = next;
+              }
+              lists_[i] = nullptr;
+          }
+      }
+  };
+
+  struct TraceOp {
+      enum { malloc, realloc, free, free_tags } op;
+      int id;
+      int size;
+      int tag;
+  };
+
+  //
+  // Read a zonelog.txt written by a ZONEFILE build, mapping the logged
+  // pointers to slot numbers so the trace can be replayed anywhere.
+  //
+  std::vector<TraceOp> load_trace(const char *path)
+  {
+      std::ifstream file(path);
+      std::unordered_map<std::string, int> ids;
+      std::vector<TraceOp> trace;
+      std::string line;
+      int nextid = 0;
+      char ptr[32], old[32];
+      int size, tag, lo, hi;
+
+      while (std::getline(file, line)) {
+          auto msg = line.c_str() + line.find("* ");
+
+          if (sscanf(msg, "* %31s = Z_Malloc(size=%d, tag=%d", ptr, &size, &tag) == 3) {
+              ids[ptr] = nextid;
+              trace.push_back({ TraceOp::malloc, nextid++, size, tag });
+          } else if (sscanf(msg, "* %31s = Z_Realloc(ptr=%31[^,], n=%d, tag=%d", ptr, old, &size, &tag) == 4) {
+              auto it = ids.find(old);
+              if (it == ids.end()) continue;
+              int id = it->second;
+              ids.erase(it);
+              ids[ptr] = id;
+              trace.push_back({ TraceOp::realloc, id, size, tag });
+          } else if (sscanf(msg, "* Z_Free(ptr=%31[^,]", ptr) == 1) {
+              auto it = ids.find(ptr);
+              if (it == ids.end()) continue;
+              trace.push_back({ TraceOp::free, it->second, 0, 0 });
+              ids.erase(it);
+          } else if (sscanf(msg, "* Z_FreeTags(lowtag=%d, hightag=%d", &lo, &hi) == 2) {
+              trace.push_back({ TraceOp::free_tags, 0, lo, hi });
+          }
+      }
+
+      return trace;
+  }
+
+  //
+  // Without a recorded trace, fake a few level loads: lots of small level
+  // and thinker allocations, some mid-level churn, and a growing array.
+  //
+  std::vector<TraceOp> synthetic_trace()
+  {
+      std::mt19937 rng(1234);
+      std::vector<TraceOp> trace;
+      int nextid = 0;
+
+      for (int level = 0; level < 8; ++level) {
+          std::vector<int> live;
+          int grow = nextid++;
+          trace.push_back({ TraceOp::malloc, grow, 16, PU_LEVEL });
+
+          for (int i = 0; i < 40000; ++i) {
+              int tag = (rng() & 1) ? PU_LEVEL : PU_LEVSPEC;
+              int size = 16 + rng() % 240;
+              trace.push_back({ TraceOp::malloc, nextid, size, tag });
+              live.push_back(nextid++);
+
+              if (i % 4 == 0 && !live.empty()) {
+                  auto j = rng() % live.size();
+                  trace.push_back({ TraceOp::free, live[j], 0, 0 });
+                  live[j] = live.back();
+                  live.pop_back();
+              }
+
+              if (i % 64 == 0) {
+                  trace.push_back({ TraceOp::realloc, grow, 16 * (i / 64 + 2), PU_LEVEL });
+              }
+          }
+
+          trace.push_back({ TraceOp::free_tags, 0, PU_LEVEL, PU_PURGELEVEL - 1 });
+      }
+
+      return trace;
+  }
+
+  template <class Malloc, class Realloc, class Free, class FreeTags>
+  double replay(const std::vector<TraceOp> &trace, Malloc m, Realloc r, Free f, FreeTags ft)
+  {
+      std::vector<void *> slots;
+      for (auto &op : trace) {
+          if (op.op != TraceOp::free_tags && op.id >= (int) slots.size()) slots.resize(op.id + 1);
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      for (auto &op : trace) {
+          switch (op.op) {
+          case TraceOp::malloc:
+              slots[op.id] = m(op.size, op.tag, &slots[op.id]);
+              break;
+          case TraceOp::realloc:
+              if (slots[op.id]) slots[op.id] = r(slots[op.id], op.size, op.tag, &slots[op.id]);
+              break;
+          case TraceOp::free:
+              if (slots[op.id]) f(slots[op.id]);
+              break;
+          case TraceOp::free_tags:
+              ft(op.size, op.tag);
+              break;
+          }
+      }
+      ft(PU_STATIC, PU_CACHE);
+      auto end = std::chrono::steady_clock::now();
+
+      return std::chrono::duration<double, std::milli>(end - start).count();
+  }
+}
+
+TEST_F(ZoneTest, free_tags_clears_user)
+{
+    void *level = nullptr;
+    void *levspec = nullptr;
+    void *stat = nullptr;
+
+    Z_Malloc(64, PU_LEVEL, &level);
+    Z_Malloc(20000, PU_LEVSPEC, &levspec);
+    Z_Malloc(64, PU_STATIC, &stat);
+    ASSERT_NE(nullptr, level);
+    ASSERT_NE(nullptr, levspec);
+
+    Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+    ASSERT_EQ(nullptr, level);
+    ASSERT_EQ(nullptr, levspec);
+    ASSERT_NE(nullptr, stat);
+    ASSERT_EQ(0, Z_TagUsage(PU_LEVEL));
+    ASSERT_EQ(64, Z_TagUsage(PU_STATIC));
+}
+
+TEST_F(ZoneTest, free_clears_user)
+{
+    void *owner = nullptr;
+
+    Z_Malloc(32, PU_CACHE, &owner);
+    ASSERT_NE(nullptr, owner);
+    Z_Free(owner);
+    ASSERT_EQ(nullptr, owner);
+}
+
+TEST_F(ZoneTest, realloc_keeps_contents)
+{
+    for (int tag : { PU_STATIC, PU_LEVEL }) {
+        auto p = static_cast<unsigned char *>(Z_Malloc(100, tag, nullptr));
+        for (int i = 0; i < 100; ++i) p[i] = i;
+
+        p = static_cast<unsigned char *>(Z_Realloc(p, 50000, tag, nullptr));
+        for (int i = 0; i < 100; ++i) ASSERT_EQ(i, p[i]);
+        for (int i = 100; i < 50000; ++i) ASSERT_EQ(0, p[i]);
+
+        p = static_cast<unsigned char *>(Z_Realloc(p, 10, PU_LEVSPEC, nullptr));
+        for (int i = 0; i < 10; ++i) ASSERT_EQ(i, p[i]);
+        ASSERT_EQ(PU_LEVSPEC, Z_CheckTag(p));
+        Z_Free(p);
+    }
+}
+
+TEST_F(ZoneTest, freed_blocks_are_recycled)
+{
+    for (int tag : { PU_STATIC, PU_LEVEL, PU_LEVSPEC }) {
+        void *a = Z_Malloc(40, tag, nullptr);
+        Z_Free(a);
+        void *b = Z_Malloc(48, tag, nullptr);
+        ASSERT_EQ(a, b);
+        Z_Free(b);
+    }
+    Z_CheckHeap();
+}
+
+TEST_F(ZoneTest, change_tag)
+{
+    void *owner = nullptr;
+
+    Z_Malloc(128, PU_STATIC, &owner);
+    Z_ChangeTag(owner, PU_CACHE);
+    ASSERT_EQ(128, Z_TagUsage(PU_CACHE));
+    Z_ChangeTag(owner, PU_LEVEL);
+    Z_FreeTags(PU_LEVEL, PU_LEVEL);
+    ASSERT_EQ(nullptr, owner);
+}
+
+TEST_F(ZoneTest, pool_reuses_lowest_slot)
+{
+    std::vector<unsigned char *> items;
+    for (int i = 0; i < 500; ++i) {
+        auto p = static_cast<unsigned char *>(Z_PoolAlloc(200));
+        for (int j = 0; j < 200; ++j) ASSERT_EQ(0, p[j]);
+        std::fill(p, p + 200, 0xff);
+        Z_Touch(p);
+        items.push_back(p);
+    }
+
+    // freed items are handed out again before any later slab is touched
+    Z_PoolFree(items[300]);
+    Z_PoolFree(items[10]);
+    ASSERT_EQ(items[10], Z_PoolAlloc(200));
+    ASSERT_EQ(items[300], Z_PoolAlloc(200));
+
+    // everything goes away with the level and the pool starts over
+    Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+    ASSERT_EQ(0, Z_TagUsage(PU_LEVEL));
+    auto p = static_cast<unsigned char *>(Z_PoolAlloc(200));
+    for (int j = 0; j < 200; ++j) ASSERT_EQ(0, p[j]);
+    Z_PoolFree(p);
+}
+
+TEST_F(ZoneTest, touch_tells_pool_items_from_blocks)
+{
+    // zone blocks on either side of a slab are still checked as blocks
+    void *before = Z_Malloc(64, PU_LEVEL, nullptr);
+    void *item = Z_PoolAlloc(100);
+    void *after = Z_Malloc(64, PU_LEVEL, nullptr);
+
+    Z_Touch(before);
+    Z_Touch(item);
+    Z_Touch(after);
+
+    Z_PoolFree(item);
+    ASSERT_EQ(item, Z_PoolAlloc(100));
+    Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+
+    // the slab table went with the level
+    void *block = Z_Malloc(64, PU_LEVEL, nullptr);
+    Z_Touch(block);
+}
+
+//
+// Replays the trace named by ZONE_TRACE (a zonelog.txt from a ZONEFILE
+// build), or a synthetic one, through both allocators.
+//
+TEST_F(ZoneTest, bench_trace)
+{
+    auto path = std::getenv("ZONE_TRACE");
+    auto trace = path ? load_trace(path) : synthetic_trace();
+    ASSERT_FALSE(trace.empty());
+
+    LegacyZone legacy;
+    double old_ms = replay(trace,
+                           [&](int s, int t, void *u) { return legacy.malloc(s, t, u); },
+                           [&](void *p, int s, int t, void *u) { return legacy.realloc(p, s, t, u); },
+                           [&](void *p) { legacy.free(p); },
+                           [&](int lo, int hi) { legacy.free_tags(lo, hi); });
+
+    double new_ms = replay(trace,
+                           [](int s, int t, void *u) { return Z_Malloc(s, t, u); },
+                           [](void *p, int s, int t, void *u) { return Z_Realloc(p, s, t, u); },
+                           [](void *p) { Z_Free(p); },
+                           [](int lo, int hi) { Z_FreeTags(lo, hi); });
+
+    std::cout << trace.size() << " ops: legacy zone " << old_ms << " ms, arena zone " << new_ms << " ms\n";
+}